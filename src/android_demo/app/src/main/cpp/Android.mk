@@ -33,6 +33,8 @@ LOCAL_MODULE     := hdlc-lib
 # Source files for this library including JNI
 LOCAL_SRC_FILES  := $(HDLC_SRC) hdlc_jni_wrapper.c
 LOCAL_LDLIBS     := -llog -landroid
+# No periodic timer wake-ups on an idle link, to save battery
+LOCAL_CFLAGS     += -DHDLC_TICKLESS
 
 # Path include for library
 LOCAL_C_INCLUDES += $(HDLC_PATH)/ports/java
@@ -84,6 +84,22 @@ static_assert(YAHDLC_MAX_FRAME_LEN == HDLC_MAX_FRAME_LEN, "Max frame len mismatc
 static void send_sabm_frame(hdlc_intdata_t *hu);
 static void reset(hdlc_intdata_t *hi, hdlc_reset_cause_t cause);
 
+#ifdef HDLC_TICKLESS
+// In tickless mode the retransmission timer only runs while frames are
+// outstanding or a reset is in progress. When the link is idle only the
+// keep-alive timer is running, so there are no periodic wake-ups.
+static void restart_timer(hdlc_intdata_t *hi)
+{
+    if (!hi->dlc.tx_outstanding && hi->dlc.state >= RST_COMPLETE) {
+        hdlc_os_start_keep_alive_timer(&hi->ext);
+    } else {
+        hdlc_os_start_timer(&hi->ext);
+    }
+}
+#else
+#define restart_timer(hi) hdlc_os_start_timer(&(hi)->ext)
+#endif
+
 static void hdlc_reset(hdlc_intdata_t *hi)
 {
     memset(&hi->dlc, 0, sizeof(hi->dlc));
@@ -404,7 +420,7 @@ static void rx_ack(hdlc_intdata_t *hi, uint8_t ack_seq_no)
 
     assert(hi->dlc.tx_outstanding || hi->dlc.last_tx == NULL);
 
-    hdlc_os_start_timer(&hi->ext);
+    restart_timer(hi);
     if (!hi->dlc.tx_outstanding) {
         if (hi->dlc.ack_pending) {
             log_info("send pending ACK %d", hi->dlc.expected_rx_seq_no);
@@ -467,7 +483,7 @@ void hdlc_os_timeout(hdlc_data_t *h)
 
     if (hi->dlc.state == RST_COMPLETE_WAIT) {
         hi->dlc.state = RST_COMPLETE;
-        hdlc_os_start_timer(&hi->ext);
+        restart_timer(hi);
         hdlc_os_exit_critical_section(&hi->ext);
         hdlc_connected_cb(&hi->ext);
         return;
@@ -484,7 +500,12 @@ void hdlc_os_timeout(hdlc_data_t *h)
         tx_data_frame(hi, txe);
         hi->dlc.retransmit_on_ack = 1;
     } else {
+#ifdef HDLC_TICKLESS
+        // Nothing outstanding, so this was the keep-alive timer
+        hi->dlc.keep_alive_counter = HDLC_KEEP_ALIVE_CNT;
+#else
         hi->dlc.keep_alive_counter++;
+#endif
         if (hi->dlc.keep_alive_counter == HDLC_KEEP_ALIVE_CNT) {
             log_info("send keep-alive");
             struct txq_entry *txe = HDLC_OS_MALLOC(sizeof(struct txq_entry));
@@ -495,7 +516,7 @@ void hdlc_os_timeout(hdlc_data_t *h)
             hdlc_stat.tx_keep_alive++;
         }
     }
-    hdlc_os_start_timer(&hi->ext);
+    restart_timer(hi);
     hdlc_os_exit_critical_section(&hi->ext);
 }
 
@@ -592,6 +613,13 @@ void hdlc_os_rx(hdlc_data_t *h, const uint8_t *buf, uint32_t count)
             goto label_continue;
         }
 
+#ifdef HDLC_TICKLESS
+        // Link is alive. Postpone keep-alive.
+        if (!hi->dlc.tx_outstanding && hi->dlc.state >= RST_COMPLETE) {
+            hdlc_os_start_keep_alive_timer(&hi->ext);
+        }
+#endif
+
         switch (hi->yahdlc.control.frame) {
         case YAHDLC_FRAME_DATA: {
             int in_order = hi->dlc.expected_rx_seq_no == hi->yahdlc.control.send_seq_no;
@@ -649,6 +677,9 @@ void hdlc_os_rx(hdlc_data_t *h, const uint8_t *buf, uint32_t count)
             if (hi->dlc.state == RST_REQUIRED) {
                 log_info("Got UA/SABM. TX reset complete");
                 hi->dlc.state = RST_COMPLETE;
+#ifdef HDLC_TICKLESS
+                restart_timer(hi);
+#endif
                 hdlc_os_exit_critical_section(&hi->ext);
                 hdlc_connected_cb(&hi->ext);
             } else {
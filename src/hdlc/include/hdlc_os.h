@@ -125,6 +125,19 @@ void hdlc_os_start_timer(hdlc_data_t *hdlc);
 /// hdlc_os_start_timer().
 void hdlc_os_stop_timer(hdlc_data_t *hdlc);
 
+#ifdef HDLC_TICKLESS
+/// Called by hdlc to (re)start the timer with a keep-alive timeout. Only used
+/// when HDLC_TICKLESS is defined.
+///
+/// In tickless mode the retransmission timer is only running while frames are
+/// outstanding. When the link is idle, this is called instead, and the timer
+/// must expire after `HDLC_KEEP_ALIVE_CNT` times the timeout used by
+/// hdlc_os_start_timer(). Expiry is signalled with hdlc_os_timeout() like for
+/// the retransmission timer. The timer is restarted by either function, i.e.
+/// there is only a single timer.
+void hdlc_os_start_keep_alive_timer(hdlc_data_t *hdlc);
+#endif
+
 /// Called by integration when retransmission timer expires.
 ///
 /// Note, that the function will call hdlc_os_exit_critical_section(),
@@ -153,7 +166,8 @@ void hdlc_os_exit_critical_section(hdlc_data_t *hdlc);
 
 #ifndef HDLC_KEEP_ALIVE_CNT
 /// Number of timeouts with no data transmission before sending keep-alive
-/// packet.
+/// packet. With HDLC_TICKLESS, this is the keep-alive timeout in units of the
+/// retransmission timeout.
 ///
 /// Thus detection of broken link takes `(HDLC_KEEP_ALIVE_CNT +
 /// HDLC_RETRANSMIT_CNT)` * hdlc_os_start_timer() time
@@ -77,10 +77,12 @@
 typedef struct hdlc_instance_t {
     hdlc_data_t *hdlc;
     uint32_t instance_id;
-    struct itimerspec its_start;
-    struct itimerspec its_stop;
     pthread_t timer_thread;
     pthread_mutex_t hdlc_mutex;
+    // Retransmission timer state, see hdlc_os_start_timer()
+    pthread_mutex_t timer_mutex;
+    uint64_t timer_deadline_ns; // CLOCK_MONOTONIC. 0 when stopped
+    uint64_t timer_armed_ns;    // Expiry of kernel timer. 0 when not armed
     int8_t shutdown;
     int timeout_fd;
 } hdlc_instance_t;
@@ -99,15 +101,14 @@ void hdlc_java_init(uint32_t instance_id)
     inst->shutdown = 0;
     if (inst->hdlc == NULL) {
         log_info("hdlc instance %d initializing", instance_id);
-        inst->its_start.it_value.tv_nsec = JAVA_HDLC_TIMEOUT_MS * 1000000;
         inst->instance_id = instance_id;
 
-        if (pthread_mutex_init(&inst->hdlc_mutex, NULL) != 0) {
+        if (pthread_mutex_init(&inst->hdlc_mutex, NULL) != 0 || pthread_mutex_init(&inst->timer_mutex, NULL) != 0) {
             log_fatal("mutex init has failed");
             exit(1);
         }
 
-        inst->timeout_fd = timerfd_create(CLOCK_REALTIME, 0);
+        inst->timeout_fd = timerfd_create(CLOCK_MONOTONIC, 0);
         if (inst->timeout_fd == -1) {
             perror("timerfd_create");
             exit(1);
@@ -133,6 +134,36 @@ void hdlc_java_stop(uint32_t instance_id)
     hdlc_os_stop_timer(inst->hdlc);
 }
 
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Must be called with inst->timer_mutex held
+static void timer_arm(hdlc_instance_t *inst, uint64_t expiry_ns)
+{
+    struct itimerspec its = {
+        .it_value.tv_sec = expiry_ns / 1000000000,
+        .it_value.tv_nsec = expiry_ns % 1000000000,
+    };
+    if (timerfd_settime(inst->timeout_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+        perror("timerfd_settime");
+    }
+    inst->timer_armed_ns = expiry_ns;
+}
+
+static void timer_start(hdlc_instance_t *inst, uint64_t timeout_ns)
+{
+    pthread_mutex_lock(&inst->timer_mutex);
+    inst->timer_deadline_ns = monotonic_ns() + timeout_ns;
+    if (!inst->timer_armed_ns || inst->timer_deadline_ns < inst->timer_armed_ns) {
+        timer_arm(inst, inst->timer_deadline_ns);
+    }
+    pthread_mutex_unlock(&inst->timer_mutex);
+}
+
 static void *timer_thread_func(void *ptr)
 {
     hdlc_instance_t *inst = (hdlc_instance_t *)ptr;
@@ -144,7 +175,19 @@ static void *timer_thread_func(void *ptr)
             exit(1);
         }
 
-        if (inst->shutdown == 1) {
+        // The kernel timer may have been armed for an earlier deadline than the
+        // current one, or the timer may have been stopped meanwhile.
+        pthread_mutex_lock(&inst->timer_mutex);
+        inst->timer_armed_ns = 0;
+        int expired = inst->timer_deadline_ns && inst->timer_deadline_ns <= monotonic_ns();
+        if (expired) {
+            inst->timer_deadline_ns = 0;
+        } else if (inst->timer_deadline_ns) {
+            timer_arm(inst, inst->timer_deadline_ns);
+        }
+        pthread_mutex_unlock(&inst->timer_mutex);
+
+        if (!expired || inst->shutdown == 1) {
             continue;
         }
 
@@ -154,25 +197,34 @@ static void *timer_thread_func(void *ptr)
             // This is possible during startup if hdlc_init() has not yet
             // returned. Try again later.
             log_warn("hdlc not initialized (timeout)");
-            hdlc_os_start_timer(inst->hdlc);
+            timer_start(inst, JAVA_HDLC_TIMEOUT_MS * 1000000ULL);
         }
     }
 }
 
+// hdlc restarts the timer on every ACK, so in order not to do a
+// timerfd_settime() syscall per frame, the deadline is only stored in memory.
+// The kernel timer is re-armed when the deadline moves earlier than the armed
+// expiry, or when the timer fires before the deadline.
 void hdlc_os_start_timer(hdlc_data_t *hdlc)
 {
-    hdlc_instance_t *inst = (hdlc_instance_t *)hdlc->user_data;
-    if (timerfd_settime(inst->timeout_fd, 0, &inst->its_start, NULL) == -1) {
-        perror("timerfd_settime (start)");
-    }
+    timer_start((hdlc_instance_t *)hdlc->user_data, JAVA_HDLC_TIMEOUT_MS * 1000000ULL);
 }
 
+#ifdef HDLC_TICKLESS
+void hdlc_os_start_keep_alive_timer(hdlc_data_t *hdlc)
+{
+    timer_start((hdlc_instance_t *)hdlc->user_data, HDLC_KEEP_ALIVE_CNT * JAVA_HDLC_TIMEOUT_MS * 1000000ULL);
+}
+#endif
+
+// The kernel timer is left running. It is ignored when it fires.
 void hdlc_os_stop_timer(hdlc_data_t *hdlc)
 {
     hdlc_instance_t *inst = (hdlc_instance_t *)hdlc->user_data;
-    if (timerfd_settime(inst->timeout_fd, 0, &inst->its_stop, NULL) == -1) {
-        perror("timerfd_settime (stop)");
-    }
+    pthread_mutex_lock(&inst->timer_mutex);
+    inst->timer_deadline_ns = 0;
+    pthread_mutex_unlock(&inst->timer_mutex);
 }
 
 void hdlc_os_enter_critical_section(hdlc_data_t *hdlc)
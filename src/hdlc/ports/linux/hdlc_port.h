@@ -65,7 +65,26 @@ extern unsigned stress_test_hdlc_keep_alive_cnt;
 #include "log/log.h"
 #include <sys/queue.h>
 
+#ifdef LINUX_HDLC_RT
+// Real-time profile. hdlc allocations are served from a pool preallocated by
+// hdlc_linux_init().
+#include <stddef.h>
+void *hdlc_linux_malloc(size_t size);
+void hdlc_linux_free(void *ptr);
+#define HDLC_OS_MALLOC(wanted_size) hdlc_linux_malloc(wanted_size)
+#define HDLC_OS_FREE(free_ptr) hdlc_linux_free(free_ptr)
+
+// hdlc logs several info and debug messages per frame. Strip them at compile
+// time, so only warnings and errors remain.
+#undef log_trace
+#undef log_debug
+#undef log_info
+#define log_trace(...) ((void)0)
+#define log_debug(...) ((void)0)
+#define log_info(...) ((void)0)
+#else
 #define HDLC_OS_MALLOC(wanted_size) malloc(wanted_size)
 #define HDLC_OS_FREE(free_ptr) free(free_ptr)
+#endif
 
 #endif // _HDLC_PORT_H_
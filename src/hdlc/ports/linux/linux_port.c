@@ -51,19 +51,23 @@
  *                                                                             *
  *                                                                             *
  *******************************************************************************/
+#define _GNU_SOURCE // pthread_attr_setaffinity_np()
+#include <asm/termbits.h> // struct termios2, BOTHER. Do not mix with <termios.h>
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/serial.h>
+#include <poll.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/timerfd.h>
 #include <sys/types.h>
-#include <termios.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -71,6 +75,9 @@
 #include "hdlc/include/hdlc_os.h"
 #include "hdlc_port.h"
 #include "linux_port.h"
+#ifdef LINUX_HDLC_RT
+#include "hdlc/dlc/dlc.h" // struct txq_entry
+#endif
 
 #define SIG SIGRTMIN
 
@@ -81,44 +88,148 @@ enum rx_thread_running_t rx_thread_running;
 
 int hdlc_socket = -1;
 
-static struct itimerspec its_start = {
-    .it_value.tv_sec = 0,
-    .it_value.tv_nsec = 0, // set in init
-    .it_interval.tv_sec = 0,
-    .it_interval.tv_nsec = 0,
-};
-static struct itimerspec its_stop = {
-    .it_value.tv_sec = 0,
-    .it_value.tv_nsec = 0,
-    .it_interval.tv_sec = 0,
-    .it_interval.tv_nsec = 0,
-};
+// Timeout of poll() in rx thread. Set by serial_open_config(). -1 is infinite.
+static int rx_poll_timeout_ms = -1;
+
 static int timeout_fd;
 
+// Retransmission timer state. hdlc restarts the timer on every ACK, so in order
+// not to do a timerfd_settime() syscall per frame, the deadline is only stored
+// in memory. The kernel timer is re-armed when the deadline moves earlier than
+// the armed expiry, or when the timer fires before the deadline.
+static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t timer_deadline_ns; // CLOCK_MONOTONIC. 0 when stopped
+static uint64_t timer_armed_ns;    // Expiry of kernel timer. 0 when not armed
+
 static void *timer_thread_func(void *ptr);
 
+static struct hdlc_linux_rt_config rt_config = HDLC_LINUX_RT_CONFIG_DEFAULT;
+
+#ifdef LINUX_HDLC_RT
+// Pool of tx queue entries, the only allocation hdlc does per frame. Entries
+// are allocated by the application thread calling hdlc_send_frame() and freed
+// by the rx thread, hence the mutex. Acked entries leave the tx queue under
+// the hdlc mutex, but are only freed after it is released (rx_ack_cleanup()),
+// so up to a whole queue of them may still be held when the application sees
+// room in the queue.
+#define RT_POOL_SIZE (2 * LINUX_HDLC_RT_TXQ_SIZE)
+union rt_block {
+    union rt_block *next;
+    struct txq_entry txe;
+};
+static union rt_block rt_pool[RT_POOL_SIZE];
+static union rt_block *rt_pool_free;
+static unsigned rt_pool_free_count;
+static pthread_mutex_t rt_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void rt_pool_init(void)
+{
+    rt_pool_free = NULL;
+    for (int i = RT_POOL_SIZE - 1; i >= 0; i--) {
+        rt_pool[i].next = rt_pool_free;
+        rt_pool_free = &rt_pool[i];
+    }
+    rt_pool_free_count = RT_POOL_SIZE;
+}
+
+unsigned hdlc_linux_rt_pool_available(void)
+{
+    pthread_mutex_lock(&rt_pool_mutex);
+    unsigned n = rt_pool_free_count;
+    pthread_mutex_unlock(&rt_pool_mutex);
+    return n;
+}
+
+// Larger allocations, i.e. the hdlc instance, are only done by hdlc_init() and
+// use malloc().
+void *hdlc_linux_malloc(size_t size)
+{
+    if (size <= sizeof(union rt_block)) {
+        pthread_mutex_lock(&rt_pool_mutex);
+        union rt_block *b = rt_pool_free;
+        if (b) {
+            rt_pool_free = b->next;
+            rt_pool_free_count--;
+        }
+        pthread_mutex_unlock(&rt_pool_mutex);
+        if (b) {
+            return b;
+        }
+        log_warn("tx queue pool exhausted (%d entries)", RT_POOL_SIZE);
+    }
+    return malloc(size);
+}
+
+void hdlc_linux_free(void *ptr)
+{
+    union rt_block *b = ptr;
+    if (b >= rt_pool && b < rt_pool + RT_POOL_SIZE) {
+        pthread_mutex_lock(&rt_pool_mutex);
+        b->next = rt_pool_free;
+        rt_pool_free = b;
+        rt_pool_free_count++;
+        pthread_mutex_unlock(&rt_pool_mutex);
+    } else {
+        free(ptr);
+    }
+}
+#endif
+
+void hdlc_linux_set_rt_config(const struct hdlc_linux_rt_config *cfg)
+{
+    rt_config = *cfg;
+}
+
+// Create thread with SCHED_FIFO priority and CPU affinity, if configured
+static void create_thread(pthread_t *thread, void *(*func)(void *), int priority, int cpu)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (priority > 0) {
+        struct sched_param param = {.sched_priority = priority};
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+    if (cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+    }
+    int ret = pthread_create(thread, &attr, func, NULL);
+    if (ret != 0) {
+        // EPERM if not allowed to use SCHED_FIFO, EINVAL if CPU does not exist
+        log_fatal("pthread_create: %s", strerror(ret));
+        exit(1);
+    }
+    pthread_attr_destroy(&attr);
+}
+
 // This port only supports single instance of hdlc. This instance data must be
 // used on all calls to hdlc functions. It will be valid after hdlc_linux_init().
 hdlc_data_t *hdlc;
 
 void hdlc_linux_init()
 {
-    its_start.it_value.tv_nsec = LINUX_HDLC_TIMEOUT_MS * 1000000;
-
     if (pthread_mutex_init(&hdlc_mutex, NULL) != 0) {
         log_fatal("mutex init has failed");
         exit(1);
     }
 
-    timeout_fd = timerfd_create(CLOCK_REALTIME, 0);
+    timeout_fd = timerfd_create(CLOCK_MONOTONIC, 0);
     if (timeout_fd == -1) {
         perror("timerfd_create");
         exit(1);
     }
-    if (pthread_create(&timer_thread, NULL, timer_thread_func, NULL) != 0) {
-        perror("pthread_create");
+    if (rt_config.mlock && mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+        perror("mlockall");
         exit(1);
     }
+#ifdef LINUX_HDLC_RT
+    rt_pool_init();
+#endif
+    create_thread(&timer_thread, timer_thread_func, rt_config.timer_priority, rt_config.timer_cpu);
 
     hdlc = hdlc_init(NULL);
 }
@@ -128,21 +239,32 @@ void *rx_thread_func(void *ptr)
     uint8_t buf[HDLC_MAX_FRAME_LEN];
     rx_thread_running = RX_THREAD_RUNNING;
     while (1) {
-        // Use select to block until data is available (because socket is O_NONBLOCK)
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(hdlc_socket, &readfds);
-        int ret = select(hdlc_socket + 1, &readfds, NULL, NULL, NULL);
+        // Use poll to block until data is available (because socket is O_NONBLOCK)
+        struct pollfd pfd = {.fd = hdlc_socket, .events = POLLIN};
+        int ret = poll(&pfd, 1, rx_poll_timeout_ms);
         if (ret == -1) {
-            perror("select");
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
             exit(1);
         }
-        assert(ret == 1);
-        assert(FD_ISSET(hdlc_socket, &readfds));
+        if (ret == 0) {
+            // Poll timeout. When batching reads with VMIN > 1, poll() does not
+            // report the serial device readable until VMIN bytes are buffered,
+            // so the tail of a burst is collected here.
+            int pending = 0;
+            if (ioctl(hdlc_socket, FIONREAD, &pending) == -1 || pending == 0) {
+                continue;
+            }
+        }
 
         // Read data from socket
         ret = read(hdlc_socket, buf, sizeof(buf));
         if (ret == -1) {
+            if (errno == EAGAIN) {
+                continue;
+            }
             // Peer process exited, maybe normal script termination
             log_warn("Connection lost");
             perror("read");
@@ -160,7 +282,12 @@ void *rx_thread_func(void *ptr)
         }
 #endif
 
-        hdlc_os_rx(hdlc, buf, ret);
+        if (hdlc) {
+            hdlc_os_rx(hdlc, buf, ret);
+        } else {
+            // Only if start_rx_thread() was called before hdlc_linux_init()
+            log_warn("hdlc not initialized (rx)");
+        }
     }
 
     rx_thread_running = RX_THREAD_STOPPED;
@@ -172,10 +299,7 @@ void start_rx_thread(int socket)
 {
     hdlc_socket = socket;
     rx_thread_running = RX_THREAD_INIT;
-    if (pthread_create(&rx_thread, NULL, rx_thread_func, NULL) != 0) {
-        perror("pthread_create");
-        exit(1);
-    }
+    create_thread(&rx_thread, rx_thread_func, rt_config.rx_priority, rt_config.rx_cpu);
 
     // Poll for rx_thread to start to avoid some races
     while (rx_thread_running == RX_THREAD_INIT) {
@@ -222,6 +346,27 @@ void run_threads()
     pthread_join(rx_thread, NULL);
 }
 
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Must be called with timer_mutex held
+static void timer_arm(uint64_t expiry_ns)
+{
+    struct itimerspec its = {
+        .it_value.tv_sec = expiry_ns / 1000000000,
+        .it_value.tv_nsec = expiry_ns % 1000000000,
+    };
+    if (timerfd_settime(timeout_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+        perror("timerfd_settime");
+        exit(1);
+    }
+    timer_armed_ns = expiry_ns;
+}
+
 static void *timer_thread_func(void *ptr)
 {
     while (1) {
@@ -232,6 +377,21 @@ static void *timer_thread_func(void *ptr)
             exit(1);
         }
 
+        // The kernel timer may have been armed for an earlier deadline than the
+        // current one, or the timer may have been stopped meanwhile.
+        pthread_mutex_lock(&timer_mutex);
+        timer_armed_ns = 0;
+        bool expired = timer_deadline_ns && timer_deadline_ns <= monotonic_ns();
+        if (expired) {
+            timer_deadline_ns = 0;
+        } else if (timer_deadline_ns) {
+            timer_arm(timer_deadline_ns);
+        }
+        pthread_mutex_unlock(&timer_mutex);
+        if (!expired) {
+            continue;
+        }
+
         if (hdlc) {
             hdlc_os_timeout(hdlc);
         } else {
@@ -243,20 +403,34 @@ static void *timer_thread_func(void *ptr)
     }
 }
 
-void hdlc_os_start_timer(hdlc_data_t *_hdlc)
+static void timer_start(uint64_t timeout_ns)
 {
-    if (timerfd_settime(timeout_fd, 0, &its_start, NULL) == -1) {
-        perror("timerfd_settime (start)");
-        exit(1);
+    pthread_mutex_lock(&timer_mutex);
+    timer_deadline_ns = monotonic_ns() + timeout_ns;
+    if (!timer_armed_ns || timer_deadline_ns < timer_armed_ns) {
+        timer_arm(timer_deadline_ns);
     }
+    pthread_mutex_unlock(&timer_mutex);
 }
 
+void hdlc_os_start_timer(hdlc_data_t *_hdlc)
+{
+    timer_start(LINUX_HDLC_TIMEOUT_MS * 1000000ULL);
+}
+
+#ifdef HDLC_TICKLESS
+void hdlc_os_start_keep_alive_timer(hdlc_data_t *_hdlc)
+{
+    timer_start(HDLC_KEEP_ALIVE_CNT * LINUX_HDLC_TIMEOUT_MS * 1000000ULL);
+}
+#endif
+
+// The kernel timer is left running. It is ignored when it fires.
 void hdlc_os_stop_timer(hdlc_data_t *_hdlc)
 {
-    if (timerfd_settime(timeout_fd, 0, &its_stop, NULL) == -1) {
-        perror("timerfd_settime (stop)");
-        exit(1);
-    }
+    pthread_mutex_lock(&timer_mutex);
+    timer_deadline_ns = 0;
+    pthread_mutex_unlock(&timer_mutex);
 }
 
 void hdlc_os_enter_critical_section(hdlc_data_t *hdlc)
@@ -271,22 +445,62 @@ void hdlc_os_exit_critical_section(hdlc_data_t *hdlc)
 
 int serial_open(const char *serial_device)
 {
-    int fd = open(serial_device, O_RDWR);
+    struct serial_config cfg = SERIAL_CONFIG_DEFAULT;
+    return serial_open_config(serial_device, &cfg);
+}
+
+// Enable ASYNC_LOW_LATENCY, which on most USB-serial adapters lowers the
+// latency timer to 1 ms. Not all drivers support this, so failure is only
+// logged.
+static void serial_set_low_latency(int fd)
+{
+    struct serial_struct ss;
+    if (ioctl(fd, TIOCGSERIAL, &ss) == -1) {
+        log_warn("TIOCGSERIAL not supported: %s", strerror(errno));
+        return;
+    }
+    ss.flags |= ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &ss) == -1) {
+        log_warn("ASYNC_LOW_LATENCY not supported: %s", strerror(errno));
+    }
+}
+
+int serial_open_config(const char *serial_device, const struct serial_config *cfg)
+{
+    // A baud rate of 0 hangs up the line
+    if (cfg->baud == 0) {
+        errno = EINVAL;
+        perror("serial baud rate");
+        exit(1);
+    }
+
+    // With a poll timeout the rx thread may read less than VMIN bytes, which
+    // would block on a blocking descriptor.
+    int flags = O_RDWR;
+    if (cfg->poll_timeout_ms >= 0) {
+        flags |= O_NONBLOCK;
+    }
+    int fd = open(serial_device, flags);
     if (fd < 0) {
         perror("open serial port");
         exit(1);
     }
 
-    struct termios tty;
-    if (tcgetattr(fd, &tty) < 0) {
-        perror("tcgetattr");
+    // termios2 allows arbitrary baud rates through BOTHER, e.g. 921600, 2M, 3M.
+    struct termios2 tty;
+    if (ioctl(fd, TCGETS2, &tty) < 0) {
+        perror("TCGETS2");
         exit(1);
     }
     tty.c_cflag &= ~PARENB;                                                      // Clear parity bit
     tty.c_cflag &= ~CSIZE;                                                       // Clear all the size bits
     tty.c_cflag |= CS8;                                                          // 8 bits per byte
     tty.c_cflag &= ~CSTOPB;                                                      // Clear stop field, only one stop bit used in communication
-    tty.c_cflag &= ~CRTSCTS;                                                     // Disable RTS/CTS hardware flow control
+    if (cfg->rtscts) {
+        tty.c_cflag |= CRTSCTS;                                                  // Enable RTS/CTS hardware flow control
+    } else {
+        tty.c_cflag &= ~CRTSCTS;                                                 // Disable RTS/CTS hardware flow control
+    }
     tty.c_cflag |= CREAD | CLOCAL;                                               // Turn on READ & ignore ctrl lines
     tty.c_lflag &= ~ICANON;                                                      // Disable canonical mode (waiting for line feed)
     tty.c_lflag &= ~ECHO;                                                        // Disable echo
@@ -297,12 +511,24 @@ int serial_open(const char *serial_device)
     tty.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL); // Disable any special handling of received bytes
     tty.c_oflag &= ~OPOST;                                                       // Prevent special interpretation of output bytes (e.g. newline chars)
     tty.c_oflag &= ~ONLCR;                                                       // Prevent conversion of newline to carriage return/line feed
-    tty.c_cc[VTIME] = 0;                                                         // No blocking, return immediately with what is available
-    tty.c_cc[VMIN] = 1;                                                          // No blocking, return immediately as soon as any data is available
-    cfsetispeed(&tty, B460800);
-    cfsetospeed(&tty, B460800);
-    if (tcsetattr(fd, TCSANOW, &tty) < 0) {
-        perror("tcsetattr");
+    tty.c_cc[VTIME] = cfg->vtime;                                                // Inter-byte timeout after first byte, 1/10 s
+    tty.c_cc[VMIN] = cfg->vmin;                                                  // Minimum number of bytes before read() (and poll()) returns
+    tty.c_cflag &= ~CBAUD;                                                       // Baud rate given in c_ispeed/c_ospeed
+    tty.c_cflag &= ~(CBAUD << IBSHIFT);
+    tty.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tty.c_ispeed = cfg->baud;
+    tty.c_ospeed = cfg->baud;
+    if (ioctl(fd, TCSETS2, &tty) < 0) {
+        perror("TCSETS2");
+    }
+
+    // The driver may round the baud rate to what the hardware supports
+    if (ioctl(fd, TCGETS2, &tty) == 0 && tty.c_ospeed != cfg->baud) {
+        log_warn("baud rate %u requested, got %u", cfg->baud, tty.c_ospeed);
+    }
+
+    if (cfg->low_latency) {
+        serial_set_low_latency(fd);
     }
 
     // Set exclusive access
@@ -311,5 +537,7 @@ int serial_open(const char *serial_device)
         exit(1);
     }
 
+    rx_poll_timeout_ms = cfg->poll_timeout_ms;
+
     return fd;
 }
@@ -58,6 +58,7 @@
 // instead of hdlc user_data pointer.
 
 #include "hdlc/include/hdlc_os.h"
+#include <stdbool.h>
 
 #if defined STRESS_TEST
 extern unsigned stress_test_hdlc_timeout_ms;
@@ -66,6 +67,13 @@ extern unsigned stress_test_hdlc_timeout_ms;
 #define LINUX_HDLC_TIMEOUT_MS 200
 #endif
 
+#if defined LINUX_HDLC_RT && !defined LINUX_HDLC_RT_TXQ_SIZE
+// Tx queue limit of the real-time profile. The application must keep
+// hdlc_tx_queue_size below this. Twice as many entries are preallocated, for
+// acked entries not yet freed; beyond that allocation falls back to malloc().
+#define LINUX_HDLC_RT_TXQ_SIZE 64
+#endif
+
 enum rx_thread_running_t {
     RX_THREAD_INIT,
     RX_THREAD_RUNNING,
@@ -74,6 +82,32 @@ enum rx_thread_running_t {
 
 extern enum rx_thread_running_t rx_thread_running;
 
+// Real-time settings for the threads of the port. See
+// hdlc_linux_set_rt_config().
+struct hdlc_linux_rt_config {
+    // Lock all current and future memory with mlockall() in hdlc_linux_init().
+    bool mlock;
+    // SCHED_FIFO priority (1-99) of rx and timer thread. 0 for default
+    // scheduling.
+    int rx_priority;
+    int timer_priority;
+    // CPU to pin rx and timer thread to. -1 for no pinning.
+    int rx_cpu;
+    int timer_cpu;
+};
+
+#define HDLC_LINUX_RT_CONFIG_DEFAULT \
+    { .mlock = false, .rx_priority = 0, .timer_priority = 0, .rx_cpu = -1, .timer_cpu = -1 }
+
+// Must be called before hdlc_linux_init() and start_rx_thread() to take
+// effect. Failure to apply the settings is fatal.
+void hdlc_linux_set_rt_config(const struct hdlc_linux_rt_config *cfg);
+
+#ifdef LINUX_HDLC_RT
+// Number of free entries in the preallocated tx queue pool
+unsigned hdlc_linux_rt_pool_available(void);
+#endif
+
 void start_rx_thread(int socket);
 void run_threads();
 void hdlc_linux_init();
@@ -92,7 +126,40 @@ extern hdlc_data_t *hdlc;
 
 extern int hdlc_socket;
 
+// Serial device configuration used by serial_open_config().
+struct serial_config {
+    // Baud rate. Any rate supported by the driver, e.g. 460800, 921600,
+    // 2000000 or 3000000.
+    uint32_t baud;
+    // Enable RTS/CTS hardware flow control.
+    bool rtscts;
+    // Request ASYNC_LOW_LATENCY from the driver. On USB-serial adapters this
+    // typically lowers the latency timer from 16 ms to 1 ms.
+    bool low_latency;
+    // Read batching policy. read() returns when `vmin` bytes are available, or
+    // when the line has been idle for `vtime` 1/10 seconds after a byte if
+    // `vtime` > 0. With `vtime` > 0 poll() wakes the rx thread at the first
+    // byte, and the read then blocks in the kernel until the batch is complete
+    // or the line is idle, so an idle line costs no wakeups. With `vtime` == 0
+    // poll() will not wake the rx thread until `vmin` bytes are buffered.
+    uint8_t vmin;
+    uint8_t vtime;
+    // Timeout for poll() in the rx thread in ms, -1 to wait forever. If >= 0 the
+    // device is opened O_NONBLOCK (so `vtime` has no effect), and any buffered
+    // data is read on timeout. This bounds the latency of the last frame of a
+    // burst below `vtime`, at the cost of a wakeup per timeout while idle.
+    int poll_timeout_ms;
+};
+
+// Configuration used by serial_open(). One wakeup per received chunk.
+#define SERIAL_CONFIG_DEFAULT \
+    { .baud = 460800, .rtscts = false, .low_latency = false, .vmin = 1, .vtime = 0, .poll_timeout_ms = -1 }
+
 // Helper function to open serial device, and configure baud rate etc.
 int serial_open(const char *serial_device);
 
+// As serial_open(), but with explicit configuration. The rx thread started by
+// start_rx_thread() uses `cfg->poll_timeout_ms`.
+int serial_open_config(const char *serial_device, const struct serial_config *cfg);
+
 #endif // _LINUX_PORT_H_
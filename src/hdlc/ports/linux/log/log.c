@@ -50,8 +50,9 @@ static void stdout_callback(log_Event *ev)
 {
     char buf[32];
     // buf[strftime(buf, sizeof(buf), "%H:%M:%S", ev->time)] = '\0';
-    struct tm *ltime = localtime(&ev->tv.tv_sec);
-    sprintf(buf, "%d:%2.2d:%2.2d.%3.3d", ltime->tm_hour, ltime->tm_min, ltime->tm_sec, (int)(ev->tv.tv_usec / 1000));
+    struct tm ltime;
+    localtime_r(&ev->tv.tv_sec, &ltime);
+    sprintf(buf, "%d:%2.2d:%2.2d.%3.3d", ltime.tm_hour, ltime.tm_min, ltime.tm_sec, (int)(ev->tv.tv_usec / 1000));
 
 #ifdef LOG_USE_COLOR
     fprintf(
@@ -71,8 +72,9 @@ static void stdout_callback(log_Event *ev)
 static void file_callback(log_Event *ev)
 {
     char buf[64];
-    struct tm *ltime = localtime(&ev->tv.tv_sec);
-    sprintf(buf, "%d:%2.2d:%2.2d.%3.3d", ltime->tm_hour, ltime->tm_min, ltime->tm_sec, (int)(ev->tv.tv_usec / 1000));
+    struct tm ltime;
+    localtime_r(&ev->tv.tv_sec, &ltime);
+    sprintf(buf, "%d:%2.2d:%2.2d.%3.3d", ltime.tm_hour, ltime.tm_min, ltime.tm_sec, (int)(ev->tv.tv_usec / 1000));
     fprintf(
         ev->udata, "%s %-5s %s:%d: ",
         buf, level_strings[ev->level], ev->file, ev->line);
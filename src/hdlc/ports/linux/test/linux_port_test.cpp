@@ -0,0 +1,314 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : linux_port_test.cpp                                          *
+ *                                                                             *
+ * Description  : Test of Linux port. A simulated peer is connected through a  *
+ *              : socketpair.                                                  *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE linux_port
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C" {
+#include "hdlc/include/hdlc.h"
+#include "hdlc/yahdlc/yahdlc.h"
+#include "linux_port.h"
+}
+
+// Number of timerfd_settime() calls made by the port. Counted by linking with
+// -Wl,--wrap=timerfd_settime
+static std::atomic<unsigned> timerfd_settime_calls;
+
+extern "C" int __real_timerfd_settime(int fd, int flags, const struct itimerspec *new_value, struct itimerspec *old_value);
+extern "C" int __wrap_timerfd_settime(int fd, int flags, const struct itimerspec *new_value, struct itimerspec *old_value)
+{
+    timerfd_settime_calls++;
+    return __real_timerfd_settime(fd, flags, new_value, old_value);
+}
+
+// Number of timer expiries passed on to hdlc. Counted by linking with
+// -Wl,--wrap=hdlc_os_timeout
+static std::atomic<unsigned> hdlc_os_timeout_calls;
+
+extern "C" void __real_hdlc_os_timeout(hdlc_data_t *h);
+extern "C" void __wrap_hdlc_os_timeout(hdlc_data_t *h)
+{
+    hdlc_os_timeout_calls++;
+    __real_hdlc_os_timeout(h);
+}
+
+// Number of malloc() calls from hdlc and the port. Counted by linking with
+// -Wl,--wrap=malloc
+static std::atomic<unsigned> malloc_calls;
+
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__wrap_malloc(size_t size)
+{
+    malloc_calls++;
+    return __real_malloc(size);
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// hdlc callbacks
+static std::atomic<bool> connected;
+static std::atomic<unsigned> frames_sent;
+static std::atomic<unsigned> resets;
+
+extern "C" void hdlc_frame_sent_cb(hdlc_data_t *, const uint8_t *, uint32_t) { frames_sent++; }
+extern "C" void hdlc_recv_frame_cb(hdlc_data_t *, uint8_t *, uint32_t) {}
+extern "C" void hdlc_reset_cb(hdlc_data_t *, hdlc_reset_cause_t) { resets++; }
+extern "C" void hdlc_connected_cb(hdlc_data_t *) { connected = true; }
+
+// Simulated peer. Answers SABM with UA and acknowledges all data frames,
+// unless peer_drop_acks is set.
+static int peer_fd;
+static std::atomic<bool> peer_drop_acks;
+static std::atomic<unsigned> peer_data_frames;
+static std::atomic<uint64_t> peer_prev_data_ns, peer_last_data_ns;
+
+static void peer_send(yahdlc_frame_t type, uint8_t recv_seq_no)
+{
+    yahdlc_control_t ctrl = {};
+    ctrl.frame = type;
+    ctrl.recv_seq_no = recv_seq_no;
+    char buf[YAHDLC_MAX_ENCODED_LEN];
+    unsigned int len;
+    BOOST_REQUIRE_EQUAL(yahdlc_frame_data(&ctrl, NULL, 0, buf, &len), 0);
+    BOOST_REQUIRE_EQUAL(write(peer_fd, buf, len), (ssize_t)len);
+}
+
+static void *peer_thread_func(void *)
+{
+    static char frame[YAHDLC_DEST_LEN];
+    yahdlc_state_t state;
+    yahdlc_get_data_reset_with_state(&state);
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(peer_fd, buf, sizeof(buf))) > 0) {
+        const char *p = buf;
+        unsigned int count = n;
+        while (count) {
+            unsigned int frame_len;
+            int res = yahdlc_get_data_with_state(&state, p, count, frame, &frame_len);
+            if (res == -ENOMSG) {
+                break;
+            } else if (res < 0) {
+                res = frame_len;
+            } else if (state.control.frame == YAHDLC_FRAME_SABM) {
+                peer_send(YAHDLC_FRAME_UA, 0);
+            } else if (state.control.frame == YAHDLC_FRAME_DATA) {
+                peer_prev_data_ns = peer_last_data_ns.load();
+                peer_last_data_ns = now_ns();
+                peer_data_frames++;
+                if (!peer_drop_acks) {
+                    peer_send(YAHDLC_FRAME_ACK, (state.control.send_seq_no + 1) & 7);
+                }
+            }
+            p += res;
+            count -= res;
+        }
+    }
+    return NULL;
+}
+
+template <typename Pred> static bool wait_for(Pred pred, unsigned timeout_ms)
+{
+    uint64_t end = now_ns() + timeout_ms * 1000000ULL;
+    while (!pred()) {
+        if (now_ns() > end) {
+            return false;
+        }
+        usleep(100);
+    }
+    return true;
+}
+
+// Connects the port to the simulated peer once for all test cases
+struct LinkFixture {
+    LinkFixture()
+    {
+        log_set_level(LOG_WARN);
+
+        int sv[2];
+        BOOST_REQUIRE_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+        peer_fd = sv[1];
+        pthread_t peer_thread;
+        pthread_create(&peer_thread, NULL, peer_thread_func, NULL);
+
+#ifdef LINUX_HDLC_RT
+        // Priority is not configured, because SCHED_FIFO needs privileges
+        struct hdlc_linux_rt_config rt = HDLC_LINUX_RT_CONFIG_DEFAULT;
+        rt.rx_cpu = rt.timer_cpu = sched_getcpu();
+        hdlc_linux_set_rt_config(&rt);
+#endif
+        // As the demos, so the rx thread never sees hdlc before hdlc_init()
+        hdlc_linux_init();
+        start_rx_thread(sv[0]);
+        BOOST_REQUIRE(wait_for([] { return connected.load(); }, 2000));
+    }
+};
+BOOST_TEST_GLOBAL_FIXTURE(LinkFixture);
+
+BOOST_AUTO_TEST_CASE(timerSyscallsPerFrame)
+{
+    static const uint8_t frame[64] = {};
+    const unsigned num_frames = 5000;
+
+    unsigned sent_before = frames_sent;
+    unsigned calls_before = timerfd_settime_calls;
+    uint64_t start = now_ns();
+    for (unsigned i = 0; i < num_frames; i++) {
+        BOOST_REQUIRE(wait_for([] { return hdlc->hdlc_tx_queue_size < 8; }, 2000));
+        BOOST_REQUIRE_EQUAL(hdlc_send_frame(hdlc, frame, sizeof(frame)), HDLC_SUCCESS);
+    }
+    BOOST_REQUIRE(wait_for([&] { return frames_sent - sent_before == num_frames; }, 5000));
+    unsigned calls = timerfd_settime_calls - calls_before;
+
+    BOOST_TEST_MESSAGE(num_frames << " frames in " << (now_ns() - start) / 1000000 << " ms: "
+                                  << calls << " timerfd_settime() calls");
+    BOOST_CHECK_EQUAL(resets.load(), 0u);
+    BOOST_CHECK_LT(calls, num_frames / 50);
+}
+
+// Retransmission must happen one timeout after the frame was sent, also when
+// the kernel timer was armed for an earlier deadline.
+BOOST_AUTO_TEST_CASE(timerRetransmitTimeout)
+{
+    static const uint8_t frame[64] = {};
+
+    unsigned sent_before = frames_sent;
+    unsigned rx_before = peer_data_frames;
+    peer_drop_acks = true;
+    BOOST_REQUIRE_EQUAL(hdlc_send_frame(hdlc, frame, sizeof(frame)), HDLC_SUCCESS);
+    BOOST_REQUIRE(wait_for([&] { return peer_data_frames - rx_before == 2; }, 5 * LINUX_HDLC_TIMEOUT_MS));
+    peer_drop_acks = false;
+
+    uint64_t retransmit_ms = (peer_last_data_ns - peer_prev_data_ns) / 1000000;
+    BOOST_TEST_MESSAGE("retransmission after " << retransmit_ms << " ms");
+    BOOST_CHECK_GE(retransmit_ms, LINUX_HDLC_TIMEOUT_MS - 1);
+    BOOST_CHECK_LT(retransmit_ms, 2 * LINUX_HDLC_TIMEOUT_MS);
+
+    BOOST_REQUIRE(wait_for([&] { return frames_sent - sent_before == 1; }, 5 * LINUX_HDLC_TIMEOUT_MS));
+    BOOST_CHECK_EQUAL(resets.load(), 0u);
+}
+
+// The idle link must send a keep-alive every HDLC_KEEP_ALIVE_CNT timeouts. With
+// HDLC_TICKLESS there must be no periodic timer expiries in between.
+BOOST_AUTO_TEST_CASE(timerIdleKeepAlive)
+{
+    const unsigned keep_alive_ms = HDLC_KEEP_ALIVE_CNT * LINUX_HDLC_TIMEOUT_MS;
+
+    // Synchronize to a keep-alive. The counters are read a while after each
+    // keep-alive, well within its retransmission timeout, so the arming of
+    // that timeout is counted at the end and not at the start.
+    const unsigned settle_us = LINUX_HDLC_TIMEOUT_MS * 1000 / 4;
+    unsigned rx = peer_data_frames;
+    BOOST_REQUIRE(wait_for([&] { return peer_data_frames != rx; }, 2 * keep_alive_ms));
+    usleep(settle_us);
+    rx = peer_data_frames;
+    uint64_t start = peer_last_data_ns;
+    unsigned timeouts_before = hdlc_os_timeout_calls;
+    unsigned calls_before = timerfd_settime_calls;
+
+    BOOST_REQUIRE(wait_for([&] { return peer_data_frames != rx; }, 2 * keep_alive_ms));
+    usleep(settle_us);
+    uint64_t interval_ms = (peer_last_data_ns - start) / 1000000;
+    unsigned timeouts = hdlc_os_timeout_calls - timeouts_before;
+    unsigned calls = timerfd_settime_calls - calls_before;
+
+    BOOST_TEST_MESSAGE("keep-alive interval " << interval_ms << " ms: " << timeouts << " timeouts, "
+                                              << calls << " timerfd_settime() calls");
+    BOOST_CHECK_GE(interval_ms, keep_alive_ms - 1);
+    BOOST_CHECK_LT(interval_ms, keep_alive_ms + 2 * LINUX_HDLC_TIMEOUT_MS);
+#ifdef HDLC_TICKLESS
+    BOOST_CHECK_EQUAL(timeouts, 1u);
+    BOOST_CHECK_LE(calls, 2u);
+#else
+    BOOST_CHECK_GE(timeouts, (unsigned)HDLC_KEEP_ALIVE_CNT);
+#endif
+    BOOST_CHECK_EQUAL(resets.load(), 0u);
+}
+
+#ifdef LINUX_HDLC_RT
+// No allocations in hdlc or the port in steady state traffic
+BOOST_AUTO_TEST_CASE(rtNoAllocations)
+{
+    static const uint8_t frame[64] = {};
+    const unsigned num_frames = 5000;
+
+    unsigned sent_before = frames_sent;
+    unsigned malloc_before = malloc_calls;
+    for (unsigned i = 0; i < num_frames; i++) {
+        // Acked entries are returned to the pool after hdlc_tx_queue_size is
+        // decremented, so the queue size does not tell if one is free
+        BOOST_REQUIRE(wait_for([] { return hdlc_linux_rt_pool_available() > 0; }, 2000));
+        BOOST_REQUIRE_EQUAL(hdlc_send_frame(hdlc, frame, sizeof(frame)), HDLC_SUCCESS);
+    }
+    BOOST_REQUIRE(wait_for([&] { return frames_sent - sent_before == num_frames; }, 5000));
+
+    BOOST_CHECK_EQUAL(malloc_calls - malloc_before, 0u);
+    BOOST_CHECK_EQUAL(resets.load(), 0u);
+}
+#endif
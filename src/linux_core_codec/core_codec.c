@@ -58,14 +58,22 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "core_codec.h"
+#include "_generated/mdif_fast.h"
+#include "mdif_arena.h"
+#include "mdif_buf.h"
+#include "mdif_const_msg.h"
 
 /*******************************************************************************
  *                               Macro definitions
  *******************************************************************************/
 // See the output *.pb-c.h from input *.proto file.
 
+// Max nesting of WrapperMsgInd, to bound the recursion on malformed messages
+#define WRAPPER_MAX_DEPTH 8
+
 /*******************************************************************************
  *                      Enumerations/Type definitions/Structs
  *******************************************************************************/
@@ -78,6 +86,8 @@
 /*******************************************************************************
  *                             Local variables/const
  *******************************************************************************/
+// Current nesting of decode_core_wrapper_payload()
+static __thread unsigned wrapper_depth;
 
 /*******************************************************************************
  *                           Local Function prototypes
@@ -94,90 +104,235 @@
 /**
  * Encodes a Core Get Device Info request message.
  *
- * This function constructs a Core Get Device Info request message and returns
- * the encoded message along with its size.
+ * This function copies the constant encoding of a Core Get Device Info request
+ * message and returns the encoded message along with its size.
  *
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
  */
 uint8_t *encode_core_get_device_info_req(uint32_t *size) {
-    // Construct the payload
-    Mdif__Core__GetDeviceInfoReq get_device_info_req = MDIF__CORE__GET_DEVICE_INFO_REQ__INIT;
-
-    // Construct the message
-    Mdif__Core__CoreMsg core_msg = MDIF__CORE__CORE_MSG__INIT;
-    core_msg.msg_case            = MDIF__CORE__CORE_MSG__MSG_GET_DEVICE_INFO_REQ;
-    core_msg.get_device_info_req = &get_device_info_req;
-
-    // Memory allocation sizing
-    *size        = mdif__core__core_msg__get_packed_size(&core_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__core__core_msg__pack(&core_msg, msg);
-    return msg;
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_GET_DEVICE_INFO_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
 }
 
 /**
  * Encodes a Core Get Battery Status request message.
  *
- * This function constructs a Core Get Battery Status request message and
- * returns the encoded message along with its size.
+ * This function copies the constant encoding of a Core Get Battery Status
+ * request message and returns the encoded message along with its size.
  *
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
  */
 uint8_t *encode_core_get_battery_status_req(uint32_t *size)
 {
-    // Construct the payload
-    Mdif__Core__GetBatteryStatusReq get_battery_status_req = MDIF__CORE__GET_BATTERY_STATUS_REQ__INIT;
-
-    // Construct the message
-    Mdif__Core__CoreMsg core_msg    = MDIF__CORE__CORE_MSG__INIT;
-    core_msg.msg_case               = MDIF__CORE__CORE_MSG__MSG_GET_BATTERY_STATUS_REQ;
-    core_msg.get_battery_status_req = &get_battery_status_req;
-
-    // Memory allocation sizing
-    *size        = mdif__core__core_msg__get_packed_size(&core_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__core__core_msg__pack(&core_msg, msg);
-    return msg;
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_GET_BATTERY_STATUS_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
 }
 
 /**
  * Encodes a Core Reset request message.
  *
- * This function constructs a Core Reset request message and returns the encoded
- * message along with its size.
+ * This function copies the constant encoding of a Core Reset request message
+ * and returns the encoded message along with its size.
  *
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
  */
 uint8_t *encode_core_reset_req(uint32_t *size)
 {
-    // Construct the payload
-    Mdif__Core__ResetReq reset_req = MDIF__CORE__RESET_REQ__INIT;
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_RESET_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
+
+/**
+ * Encodes a Core Ping request message.
+ *
+ * This function copies the constant encoding of a Core Ping request message and
+ * returns the encoded message along with its size. Useful for polling device
+ * health.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_core_ping_req(uint32_t *size)
+{
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_PING_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
+
+/**
+ * Encodes a Core Get IP Config request message.
+ *
+ * This function copies the constant encoding of a Core Get IP Config request
+ * message and returns the encoded message along with its size.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_core_get_ip_config_req(uint32_t *size)
+{
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_GET_IP_CONFIG_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
+
+/**
+ * Encodes a Core Compass Calibrate request message.
+ *
+ * This function copies the constant encoding of a Core Compass Calibrate
+ * request message and returns the encoded message along with its size.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_core_compass_calibrate_req(uint32_t *size)
+{
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_COMPASS_CALIBRATE_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
+
+/**
+ * Encodes a Core Compass Calibration Store request message.
+ *
+ * This function copies the constant encoding of a Core Compass Calibration
+ * Store request message and returns the encoded message along with its size.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_core_compass_calibration_store_req(uint32_t *size)
+{
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_COMPASS_CALIBRATION_STORE_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
+
+/**
+ * Encodes a Core Get Accessories List request message.
+ *
+ * This function copies the constant encoding of a Core Get Accessories List
+ * request message and returns the encoded message along with its size.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_core_get_accessories_list_req(uint32_t *size)
+{
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__CORE__CORE_MSG__MSG_GET_ACCESSORIES_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
+
+/**
+ * Encodes a Core GNSS and compass stream request message.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @param enable Start or stop the stream.
+ * @param period_ms Period of the stream, 250 to 1000 ms.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_pack().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_core_gnss_compass_stream_req(uint32_t *size, bool enable, uint32_t period_ms) {
+    Mdif__Core__GnssCompassStreamReq req = MDIF__CORE__GNSS_COMPASS_STREAM_REQ__INIT;
+    req.enable = enable;
+    req.period = period_ms;
 
-    // Construct the message
     Mdif__Core__CoreMsg core_msg = MDIF__CORE__CORE_MSG__INIT;
-    core_msg.msg_case            = MDIF__CORE__CORE_MSG__MSG_RESET_REQ;
-    core_msg.reset_req           = &reset_req;
-
-    // Memory allocation sizing
-    *size        = mdif__core__core_msg__get_packed_size(&core_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__core__core_msg__pack(&core_msg, msg);
-    return msg;
+    core_msg.msg_case = MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_REQ;
+    core_msg.gnss_compass_stream_req = &req;
+
+    // Packed into a pool buffer, with headroom for the TCP length prefix
+    return mdif_buf_pack(&core_msg.base, size);
 }
 
 /****************************************************
  * Client receives and decodes messages from device *
  ****************************************************/
 
+/**
+ * Decode a Core Wrapper indication and the message it carries.
+ *
+ * The indication is decoded in place by mdif_fast_decode(), so the payload
+ * points into the receive buffer and is passed to decode_mdif_msg() without a
+ * copy. A payload that is itself a Wrapper indication is decoded the same way.
+ *
+ * @param ind The decoded indication. Valid during the call only.
+ * @return The result of decoding the payload, or DECODE_ERR_OTHER if wrappers
+ *         are nested too deep.
+ */
+decode_rtn_t decode_core_wrapper_msg_ind(const struct mdif_fast_wrapper_msg_ind *ind) {
+    printf("Decode WRAPPER_MSG_IND\n");
+    printf("    sender=%.*s\n", (int)ind->sender.len, ind->sender.data);
+    printf("    receiver=%.*s\n", (int)ind->receiver.len, ind->receiver.data);
+    printf("    status=%d\n", ind->status);
+    printf("    payload=%u bytes\n\n", ind->payload.len);
+
+    return decode_core_wrapper_payload(ind->payload.data, ind->payload.len);
+}
+
+/**
+ * Decode the message carried by a Core Wrapper indication.
+ *
+ * Also used for payloads forwarded by mdif_wrapper_route(), which does not
+ * decode the indication itself.
+ *
+ * @param payload The wrapped MDIF message.
+ * @param size Size of the wrapped message.
+ * @return The result of decode_mdif_msg(), or DECODE_ERR_OTHER if wrappers
+ *         are nested too deep.
+ */
+decode_rtn_t decode_core_wrapper_payload(const uint8_t *payload, uint32_t size) {
+    if (wrapper_depth == WRAPPER_MAX_DEPTH) {
+        printf("    ERROR wrappers nested too deep\n\n");
+        return DECODE_ERR_OTHER;
+    }
+    wrapper_depth++;
+    decode_rtn_t rtn = decode_mdif_msg(payload, size);
+    wrapper_depth--;
+    return rtn;
+}
+
+/**
+ * Check if the message being decoded was carried by a Wrapper indication, i.e.
+ * is from another device on the daisy chain.
+ *
+ * @return true while decode_core_wrapper_payload() is decoding.
+ */
+bool decode_core_wrapped(void) {
+    return wrapper_depth > 0;
+}
+
 /**
  * Decode a Core Message from a binary buffer.
  *
@@ -193,11 +348,14 @@ uint8_t *encode_core_reset_req(uint32_t *size)
  *         for other decoding errors.
  */
 decode_rtn_t decode_core(const uint8_t *buf, uint32_t size) {
-    Mdif__Core__CoreMsg *core_msg = mdif__core__core_msg__unpack(NULL, size, buf);
+    // Unpacked into the arena, released below instead of free_unpacked()
+    mdif_arena_mark_t mark = mdif_arena_mark();
+    Mdif__Core__CoreMsg *core_msg = mdif__core__core_msg__unpack(mdif_arena(), size, buf);
 
     // Was unpack successful?
     if (core_msg == NULL) {
         printf("    ERROR payload doesn't decode\n\n");
+        mdif_arena_release(mark);
         return DECODE_ERR_NO_DECODER;
     }
 
@@ -257,13 +415,51 @@ decode_rtn_t decode_core(const uint8_t *buf, uint32_t size) {
         break;
     }
 
+    case MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_RES: {
+        printf("Decode GNSS_COMPASS_STREAM_RES\n");
+        printf("    status=%d\n", core_msg->gnss_compass_stream_res->status);
+        if (core_msg->gnss_compass_stream_res->status != MDIF__COMMON__STATUS__SUCCESS) {
+            printf("    error_string=%s\n", core_msg->gnss_compass_stream_res->error_string);
+        }
+        break;
+    }
+
+    case MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_IND: {
+        const Mdif__Core__GnssStatus *gnss = core_msg->gnss_compass_stream_ind->gnss_status;
+        const Mdif__Core__CompassHeading *compass = core_msg->gnss_compass_stream_ind->compass_heading;
+        printf("Decode GNSS_COMPASS_STREAM_IND\n");
+        if (gnss) {
+            printf("    pos_valid=%d lat=%.7f lon=%.7f hmsl=%.1f hacc=%.1f num_sv=%u\n", gnss->pos_valid,
+                   gnss->pos_lat, gnss->pos_lon, gnss->pos_hmsl, gnss->pos_hacc, gnss->num_sv);
+        }
+        if (compass) {
+            printf("    compass=%.1f calibrated=%d\n", compass->heading, compass->calibrated);
+        }
+        break;
+    }
+
+    case MDIF__CORE__CORE_MSG__MSG_WRAPPER_MSG_IND: {
+        // Only when mdif_fast_decode() gave up, e.g. on fields added in newer
+        // firmware. The payload is then a copy in the arena.
+        Mdif__Core__WrapperMsgInd *wrapper = core_msg->wrapper_msg_ind;
+        struct mdif_fast_wrapper_msg_ind ind = {
+            .receiver = {(const uint8_t *)wrapper->receiver, strlen(wrapper->receiver)},
+            .sender = {(const uint8_t *)wrapper->sender, strlen(wrapper->sender)},
+            .status = wrapper->status,
+            .length = wrapper->length,
+            .payload = {wrapper->payload.data, wrapper->payload.len},
+        };
+        rtn = decode_core_wrapper_msg_ind(&ind);
+        break;
+    }
+
     default:
         printf("Core message not decoded: %u", core_msg->msg_case);
         rtn = DECODE_ERR_OTHER;
         break;
     }
 
-    mdif__core__core_msg__free_unpacked(core_msg, NULL);
+    mdif_arena_release(mark);
 
     printf("\n");
 
@@ -51,6 +51,7 @@
  *                                                                             *
  *                                                                             *
  *******************************************************************************/
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "_generated/mdif/core/core.pb-c.h"
@@ -62,8 +63,23 @@ typedef enum {
     DECODE_ERR_OTHER
 } decode_rtn_t;
 
+struct mdif_fast_wrapper_msg_ind;
+
 uint8_t *encode_core_get_device_info_req(uint32_t *size);
 uint8_t *encode_core_reset_req(uint32_t *size);
 uint8_t *encode_core_get_battery_status_req(uint32_t *size);
+uint8_t *encode_core_ping_req(uint32_t *size);
+uint8_t *encode_core_get_ip_config_req(uint32_t *size);
+uint8_t *encode_core_compass_calibrate_req(uint32_t *size);
+uint8_t *encode_core_compass_calibration_store_req(uint32_t *size);
+uint8_t *encode_core_get_accessories_list_req(uint32_t *size);
+uint8_t *encode_core_gnss_compass_stream_req(uint32_t *size, bool enable, uint32_t period_ms);
+
+decode_rtn_t decode_core(const uint8_t *buf, uint32_t size);
+decode_rtn_t decode_core_wrapper_msg_ind(const struct mdif_fast_wrapper_msg_ind *ind);
+decode_rtn_t decode_core_wrapper_payload(const uint8_t *payload, uint32_t size);
+bool decode_core_wrapped(void);
 
-decode_rtn_t decode_core(const uint8_t *buf, uint32_t size);
\ No newline at end of file
+// Implemented by the application, see codec.c. Used to decode the payload of a
+// WrapperMsgInd.
+decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size);
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : core_codec_test.c                                            *
+ *                                                                             *
+ * Description  : Test of constant core request encodings against protobuf-c.  *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "core_codec.h"
+#include "mdif_buf.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Compare encoder with protobuf-c packing of a CoreMsg holding an empty Req in
+// oneof member `member`. The Req initializer is given last, as the protobuf-c
+// INIT macros contain commas.
+#define CHECK_CORE(encoder, Req, member, msg_case_val, ...)         \
+    do {                                                            \
+        Req req                  = __VA_ARGS__;                     \
+        Mdif__Core__CoreMsg msg  = MDIF__CORE__CORE_MSG__INIT;      \
+        msg.msg_case             = msg_case_val;                    \
+        msg.member               = &req;                            \
+        fails += check(#encoder, encoder, &msg.base);               \
+    } while (0)
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// The wrapper payload decoder of the application, not used by the encoders
+decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size) {
+    return DECODE_ERR_NO_DECODER;
+}
+
+static int check(const char *name, uint8_t *(*encode)(uint32_t *), const ProtobufCMessage *msg) {
+    uint8_t ref[16];
+    size_t ref_len = protobuf_c_message_pack(msg, ref);
+    uint32_t size;
+    uint8_t *buf = encode(&size);
+    int ok = size == ref_len && memcmp(buf, ref, size) == 0;
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    mdif_buf_free(buf);
+    return !ok;
+}
+
+int main(void) {
+    int fails = 0;
+
+    CHECK_CORE(encode_core_get_device_info_req, Mdif__Core__GetDeviceInfoReq, get_device_info_req,
+               MDIF__CORE__CORE_MSG__MSG_GET_DEVICE_INFO_REQ, MDIF__CORE__GET_DEVICE_INFO_REQ__INIT);
+    CHECK_CORE(encode_core_get_battery_status_req, Mdif__Core__GetBatteryStatusReq, get_battery_status_req,
+               MDIF__CORE__CORE_MSG__MSG_GET_BATTERY_STATUS_REQ, MDIF__CORE__GET_BATTERY_STATUS_REQ__INIT);
+    CHECK_CORE(encode_core_reset_req, Mdif__Core__ResetReq, reset_req,
+               MDIF__CORE__CORE_MSG__MSG_RESET_REQ, MDIF__CORE__RESET_REQ__INIT);
+    CHECK_CORE(encode_core_ping_req, Mdif__Core__PingReq, ping_req,
+               MDIF__CORE__CORE_MSG__MSG_PING_REQ, MDIF__CORE__PING_REQ__INIT);
+    CHECK_CORE(encode_core_get_ip_config_req, Mdif__Core__GetIpConfigReq, get_ip_config_req,
+               MDIF__CORE__CORE_MSG__MSG_GET_IP_CONFIG_REQ, MDIF__CORE__GET_IP_CONFIG_REQ__INIT);
+    CHECK_CORE(encode_core_compass_calibrate_req, Mdif__Core__CompassCalibrateReq, compass_calibrate_req,
+               MDIF__CORE__CORE_MSG__MSG_COMPASS_CALIBRATE_REQ, MDIF__CORE__COMPASS_CALIBRATE_REQ__INIT);
+    CHECK_CORE(encode_core_compass_calibration_store_req, Mdif__Core__CompassCalibrationStoreReq,
+               compass_calibration_store_req, MDIF__CORE__CORE_MSG__MSG_COMPASS_CALIBRATION_STORE_REQ,
+               MDIF__CORE__COMPASS_CALIBRATION_STORE_REQ__INIT);
+    CHECK_CORE(encode_core_get_accessories_list_req, Mdif__Core__GetAccessoriesListReq, get_accessories_req,
+               MDIF__CORE__CORE_MSG__MSG_GET_ACCESSORIES_REQ, MDIF__CORE__GET_ACCESSORIES_LIST_REQ__INIT);
+
+    return fails ? 1 : 0;
+}
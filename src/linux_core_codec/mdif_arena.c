@@ -0,0 +1,167 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_arena.c                                                 *
+ *                                                                             *
+ * Description  : Per thread arena allocator for unpacking MDIF messages.      *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "mdif_arena.h"
+
+/*******************************************************************************
+ *                      Enumerations/Type definitions/Structs
+ *******************************************************************************/
+// Allocation that did not fit in the buffer
+struct overflow {
+    struct overflow *next;
+    alignas(max_align_t) uint8_t data[];
+};
+
+struct arena {
+    // MDIF_ARENA_SIZE bytes, allocated by the first allocation of the thread
+    uint8_t *buf;
+    size_t used;
+    // Newest first
+    struct overflow *overflow;
+    uint32_t n_overflow;
+};
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+static __thread struct arena arena;
+
+// Frees the buffer of an exiting thread
+static pthread_key_t buf_key;
+static pthread_once_t buf_key_once = PTHREAD_ONCE_INIT;
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static void *arena_alloc(void *allocator_data, size_t size);
+static void arena_free(void *allocator_data, void *pointer);
+
+static __thread ProtobufCAllocator allocator = {
+    .alloc = arena_alloc,
+    .free = arena_free,
+};
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static void make_buf_key(void) {
+    pthread_key_create(&buf_key, free);
+}
+
+// The buffer of the thread. NULL if it can not be allocated, in which case all
+// allocations fall back to malloc().
+static uint8_t *arena_buf(struct arena *a) {
+    if (!a->buf) {
+        pthread_once(&buf_key_once, make_buf_key);
+        // malloc() aligns for max_align_t
+        a->buf = malloc(MDIF_ARENA_SIZE);
+        if (a->buf) {
+            pthread_setspecific(buf_key, a->buf);
+        }
+    }
+    return a->buf;
+}
+
+static void *arena_alloc(void *allocator_data, size_t size) {
+    struct arena *a = allocator_data;
+    size_t start = (a->used + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+    if (start + size <= MDIF_ARENA_SIZE && arena_buf(a)) {
+        a->used = start + size;
+        return a->buf + start;
+    }
+
+    struct overflow *o = malloc(sizeof(*o) + size);
+    if (!o) {
+        return NULL;
+    }
+    o->next = a->overflow;
+    a->overflow = o;
+    a->n_overflow++;
+    return o->data;
+}
+
+// Memory is only returned by mdif_arena_release()
+static void arena_free(void *allocator_data, void *pointer) {
+}
+
+ProtobufCAllocator *mdif_arena(void) {
+    // allocator_data must point to this thread's arena, and a static
+    // initializer of a __thread variable can not take the address of another.
+    allocator.allocator_data = &arena;
+    return &allocator;
+}
+
+mdif_arena_mark_t mdif_arena_mark(void) {
+    return (mdif_arena_mark_t)arena.n_overflow << 32 | arena.used;
+}
+
+void mdif_arena_release(mdif_arena_mark_t mark) {
+    uint32_t n_overflow = mark >> 32;
+    while (arena.n_overflow > n_overflow) {
+        struct overflow *o = arena.overflow;
+        arena.overflow = o->next;
+        arena.n_overflow--;
+        free(o);
+    }
+    arena.used = (uint32_t)mark;
+}
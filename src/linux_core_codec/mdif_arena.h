@@ -0,0 +1,96 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_arena.h                                                 *
+ *                                                                             *
+ * Description  : Per thread arena allocator for unpacking MDIF messages.      *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_ARENA_H
+#define _MDIF_ARENA_H
+
+// protobuf-c unpacking with the default allocator makes a malloc() for every
+// submessage, string and repeated field, and free_unpacked() walks the message
+// again to free them. The arena instead hands out memory from a per thread
+// buffer by bumping a pointer, and everything is released at once:
+//
+//   mdif_arena_mark_t mark = mdif_arena_mark();
+//   Mdif__Core__CoreMsg *msg = mdif__core__core_msg__unpack(mdif_arena(), size, buf);
+//   ...
+//   mdif_arena_release(mark); // Instead of free_unpacked()
+//
+// Marks nest, so a decoder may unpack an embedded message with its own mark
+// while the outer message is in use. Allocations that do not fit in the buffer
+// fall back to malloc() and are freed by the release.
+//
+// The buffer is allocated by the first allocation of each thread, so threads
+// that never unpack cost no memory, and freed when the thread exits.
+
+#include <stdint.h>
+
+#include <protobuf-c/protobuf-c.h>
+
+#ifndef MDIF_ARENA_SIZE
+// Size of each thread's buffer. Large enough for any MDIF indication.
+#define MDIF_ARENA_SIZE (64 * 1024)
+#endif
+
+// Allocator using the calling thread's arena
+ProtobufCAllocator *mdif_arena(void);
+
+// Position in the buffer and number of malloc() fallbacks
+typedef uint64_t mdif_arena_mark_t;
+
+// Current position of the calling thread's arena
+mdif_arena_mark_t mdif_arena_mark(void);
+
+// Release everything allocated by the calling thread since `mark`
+void mdif_arena_release(mdif_arena_mark_t mark);
+
+#endif // _MDIF_ARENA_H
@@ -0,0 +1,336 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_bcast.c                                                 *
+ *                                                                             *
+ * Description  : Broadcast of received MDIF messages to subscriber threads.   *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mdif_bcast.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Messages read between updates of the cursor of a subscriber, so the
+// producer may reuse their space while a long batch is handled
+#define CURSOR_BATCH 16
+#define FIELD_SET_WORDS (int)(sizeof(struct mdif_field_set) / sizeof(uint64_t))
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static void *sub_thread(void *arg);
+static bool lagging(const struct mdif_bcast *b, uint64_t cursor, uint64_t head);
+static uint64_t wait_head(struct mdif_bcast *b, uint64_t pos);
+static void notify(struct mdif_bcast *b);
+static inline void cpu_relax(void);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+int mdif_bcast_init(struct mdif_bcast *b, uint32_t n_slots, uint32_t data_size) {
+    memset(b, 0, sizeof(*b));
+    if (n_slots == 0 || (n_slots & (n_slots - 1)) || data_size == 0 || (data_size & (data_size - 1))) {
+        errno = EINVAL;
+        return -1;
+    }
+    b->slots = calloc(n_slots, sizeof(*b->slots));
+    b->data = malloc(data_size);
+    if (!b->slots || !b->data) {
+        free(b->slots);
+        free(b->data);
+        errno = ENOMEM;
+        return -1;
+    }
+    b->mask = n_slots - 1;
+    b->data_mask = data_size - 1;
+    pthread_mutex_init(&b->lock, NULL);
+    return 0;
+}
+
+void mdif_bcast_free(struct mdif_bcast *b) {
+    pthread_mutex_lock(&b->lock);
+    atomic_store(&b->closed, true);
+    notify(b);
+    for (int i = 0; i < MDIF_BCAST_MAX_SUBSCRIBERS; i++) {
+        if (atomic_load(&b->subs[i].active)) {
+            pthread_join(b->subs[i].thread, NULL);
+        }
+    }
+    pthread_mutex_unlock(&b->lock);
+    pthread_mutex_destroy(&b->lock);
+    free(b->slots);
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+int mdif_bcast_subscribe(struct mdif_bcast *b, const struct mdif_field_set *fields,
+                         const struct mdif_field_set *keep, mdif_bcast_handler_t handler, void *ctx) {
+    pthread_mutex_lock(&b->lock);
+    int sub = -1;
+    for (int i = 0; i < MDIF_BCAST_MAX_SUBSCRIBERS && sub < 0; i++) {
+        if (!atomic_load(&b->subs[i].active)) {
+            sub = i;
+        }
+    }
+    if (sub < 0) {
+        pthread_mutex_unlock(&b->lock);
+        errno = EBUSY;
+        return -1;
+    }
+    struct mdif_bcast_sub *s = &b->subs[sub];
+    s->b = b;
+    s->handler = handler;
+    s->ctx = ctx;
+    s->skipped = 0;
+    if (fields) {
+        s->filter = *fields;
+    } else {
+        memset(&s->filter, 0xff, sizeof(s->filter));
+    }
+    if (keep) {
+        s->keep = *keep;
+    } else {
+        memset(&s->keep, 0, sizeof(s->keep));
+    }
+    // Never removed, subscribers stay until mdif_bcast_free()
+    for (int i = 0; i < FIELD_SET_WORDS; i++) {
+        __atomic_fetch_or(&b->wanted.bits[i], s->filter.bits[i], __ATOMIC_RELAXED);
+    }
+
+    // The producer may see the subscriber active before its cursor is set.
+    // Cursor 0 then holds the producer back until it is, rather than letting
+    // it overwrite messages the subscriber is about to read. All seq_cst, so
+    // a producer that did not see the subscriber active has published the
+    // slot at the head read here, and sees it active on its next publish.
+    atomic_store(&s->cursor, 0);
+    atomic_store(&s->active, true);
+    atomic_store(&s->cursor, atomic_load(&b->head));
+    int err = pthread_create(&s->thread, NULL, sub_thread, s);
+    if (err) {
+        atomic_store(&s->active, false);
+    }
+    pthread_mutex_unlock(&b->lock);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return sub;
+}
+
+int mdif_bcast_publish(struct mdif_bcast *b, const uint8_t *buf, uint32_t size) {
+    uint32_t data_size = b->data_mask + 1;
+    if (size > data_size) {
+        b->dropped++;
+        errno = EMSGSIZE;
+        return -1;
+    }
+    // Only the producer writes the counters, so no atomic increment is needed
+    uint32_t field = mdif_msg_field(buf, size);
+    uint32_t f = field > MDIF_MAX_FIELD ? 0 : field;
+    __atomic_store_n(&b->received[f], b->received[f] + 1, __ATOMIC_RELAXED);
+    if (!((__atomic_load_n(&b->wanted.bits[f / 64], __ATOMIC_RELAXED) >> (f % 64)) & 1)) {
+        __atomic_store_n(&b->skipped[f], b->skipped[f] + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    uint64_t head = atomic_load_explicit(&b->head, memory_order_relaxed);
+
+    // Oldest message not read by all subscribers
+    uint64_t min = head;
+    for (int i = 0; i < MDIF_BCAST_MAX_SUBSCRIBERS; i++) {
+        struct mdif_bcast_sub *s = &b->subs[i];
+        if (atomic_load(&s->active)) {
+            uint64_t cursor = atomic_load(&s->cursor);
+            min = cursor < min ? cursor : min;
+        }
+    }
+
+    // Messages are contiguous in data, so skip to the start at the end
+    uint64_t pos = b->data_pos;
+    uint32_t off = pos & b->data_mask;
+    if (data_size - off < size) {
+        pos += data_size - off;
+    }
+    if (head - min > b->mask || (min < head && pos + size - b->slots[min & b->mask].pos > data_size)) {
+        b->dropped++;
+        errno = EAGAIN;
+        return -1;
+    }
+
+    memcpy(b->data + (pos & b->data_mask), buf, size);
+    struct mdif_bcast_slot *slot = &b->slots[head & b->mask];
+    slot->pos = pos;
+    slot->size = size;
+    slot->field = field;
+    b->data_pos = pos + size;
+    atomic_store(&b->head, head + 1);
+    notify(b);
+    return 0;
+}
+
+void mdif_bcast_counters(const struct mdif_bcast *b, uint32_t field, uint64_t *received, uint64_t *skipped) {
+    uint32_t f = field > MDIF_MAX_FIELD ? 0 : field;
+    *received = __atomic_load_n(&b->received[f], __ATOMIC_RELAXED);
+    *skipped = __atomic_load_n(&b->skipped[f], __ATOMIC_RELAXED);
+}
+
+int mdif_bcast_sub_counters(const struct mdif_bcast *b, int sub, uint64_t *lag, uint64_t *skipped) {
+    if (sub < 0 || sub >= MDIF_BCAST_MAX_SUBSCRIBERS || !atomic_load(&b->subs[sub].active)) {
+        errno = EINVAL;
+        return -1;
+    }
+    const struct mdif_bcast_sub *s = &b->subs[sub];
+    uint64_t cursor = atomic_load(&s->cursor);
+    uint64_t head = atomic_load(&b->head);
+    *lag = head > cursor ? head - cursor : 0;
+    *skipped = __atomic_load_n(&s->skipped, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static void *sub_thread(void *arg) {
+    struct mdif_bcast_sub *s = arg;
+    struct mdif_bcast *b = s->b;
+    uint64_t cursor = atomic_load(&s->cursor);
+    // Messages before it are skipped, unless kept
+    uint64_t skip_to = cursor;
+    for (;;) {
+        uint64_t head = wait_head(b, cursor);
+        if (head == cursor) {
+            // Closed
+            break;
+        }
+        if (lagging(b, cursor, head)) {
+            skip_to = head;
+        }
+        for (; cursor < head; cursor++) {
+            const struct mdif_bcast_slot *slot = &b->slots[cursor & b->mask];
+            if (mdif_field_set_has(&s->filter, slot->field)) {
+                if (cursor < skip_to && !mdif_field_set_has(&s->keep, slot->field)) {
+                    __atomic_store_n(&s->skipped, s->skipped + 1, __ATOMIC_RELAXED);
+                } else {
+                    s->handler(b->data + (slot->pos & b->data_mask), slot->size, s->ctx);
+                    // The producer went on during the handler
+                    head = atomic_load_explicit(&b->head, memory_order_acquire);
+                    if (cursor + 1 < head && lagging(b, cursor + 1, head)) {
+                        skip_to = head;
+                    }
+                }
+            }
+            if (cursor % CURSOR_BATCH == CURSOR_BATCH - 1) {
+                atomic_store_explicit(&s->cursor, cursor + 1, memory_order_release);
+            }
+        }
+        atomic_store_explicit(&s->cursor, cursor, memory_order_release);
+    }
+    return NULL;
+}
+
+// Whether a subscriber at `cursor`, before `head`, is more than half the ring
+// behind, in messages or bytes
+static bool lagging(const struct mdif_bcast *b, uint64_t cursor, uint64_t head) {
+    if (head - cursor > (b->mask + 1) / 2) {
+        return true;
+    }
+    const struct mdif_bcast_slot *first = &b->slots[cursor & b->mask];
+    const struct mdif_bcast_slot *last = &b->slots[(head - 1) & b->mask];
+    return last->pos + last->size - first->pos > (b->data_mask + 1) / 2;
+}
+
+// Wait until head differs from `pos`. Returns head, or `pos` if closed.
+static uint64_t wait_head(struct mdif_bcast *b, uint64_t pos) {
+    uint64_t head;
+    for (int i = 0; i < MDIF_BCAST_SPIN; i++) {
+        head = atomic_load_explicit(&b->head, memory_order_acquire);
+        if (head != pos) {
+            return head;
+        }
+        cpu_relax();
+    }
+    for (;;) {
+        atomic_fetch_add(&b->waiters, 1);
+        uint32_t seq = atomic_load(&b->futex);
+        head = atomic_load(&b->head);
+        if (head != pos || atomic_load(&b->closed)) {
+            atomic_fetch_sub(&b->waiters, 1);
+            return head;
+        }
+        syscall(SYS_futex, &b->futex, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+        atomic_fetch_sub(&b->waiters, 1);
+    }
+}
+
+// Called after publishing head or closing. The seq_cst ordering pairs with
+// wait_head(), so either the waiter sees the change, or we see the waiter.
+static void notify(struct mdif_bcast *b) {
+    atomic_fetch_add(&b->futex, 1);
+    if (atomic_load(&b->waiters)) {
+        syscall(SYS_futex, &b->futex, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
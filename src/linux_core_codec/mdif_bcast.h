@@ -0,0 +1,178 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_bcast.h                                                 *
+ *                                                                             *
+ * Description  : Broadcast of received MDIF messages to subscriber threads.   *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_BCAST_H
+#define _MDIF_BCAST_H
+
+// Single producer, multi consumer broadcast ring. The receiving thread
+// publishes each message once, copying it into the ring, and every subscriber
+// reads it in place from its own thread, in parallel with the others and with
+// the receiving thread. Each subscriber has its own read cursor, and a filter
+// by field number of the message, i.e. by message type, see mdif_router.
+// Messages no subscriber wants are not published, so they are neither copied
+// nor decoded. Messages received and skipped are counted per type.
+//
+// The producer does not overwrite messages before all subscribers have read
+// them, and never waits: a message that does not fit is not published, and
+// counted in `dropped`. Subscribers wait by spinning briefly, then on a
+// futex, so a busy subscriber picks up messages without syscalls.
+//
+// So that a slow subscriber does not hold the producer back, and make it drop
+// messages for all subscribers, each subscriber tracks its lag. When it is
+// more than half the ring behind, in messages or bytes, it skips ahead to the
+// newest message published, without calling its handler for the messages in
+// between. Messages in its `keep` set, e.g. responses, are still handled.
+// Skipped messages are counted per subscriber, see mdif_bcast_sub_counters().
+// The producer only waits for the message a subscriber is handling, and for
+// kept messages.
+//
+// No protobuf dependency.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mdif_router.h"
+
+#define MDIF_BCAST_MAX_SUBSCRIBERS 8
+#ifndef MDIF_BCAST_SPIN
+// Number of polls of an empty ring before sleeping
+#define MDIF_BCAST_SPIN 2000
+#endif
+
+// Called from the thread of the subscriber with each message matching its
+// filter. `buf` is only valid during the call.
+typedef void (*mdif_bcast_handler_t)(const uint8_t *buf, uint32_t size, void *ctx);
+
+struct mdif_bcast;
+
+struct mdif_bcast_slot {
+    uint64_t pos; // Of the message in data, free running
+    uint32_t size;
+    uint32_t field;
+};
+
+struct mdif_bcast_sub {
+    // Next message to read. Written by the subscriber, read by the producer.
+    _Alignas(64) _Atomic uint64_t cursor;
+    _Atomic bool active;
+    // Messages of the filter skipped while lagging, written by the subscriber
+    uint64_t skipped;
+    struct mdif_bcast *b;
+    pthread_t thread;
+    mdif_bcast_handler_t handler;
+    void *ctx;
+    struct mdif_field_set filter;
+    // Messages never skipped
+    struct mdif_field_set keep;
+};
+
+struct mdif_bcast {
+    // Number of messages published
+    _Alignas(64) _Atomic uint64_t head;
+    // Incremented on publish, subscribers sleep on it
+    _Atomic uint32_t futex;
+    _Atomic uint32_t waiters;
+    _Atomic bool closed;
+    // Producer state
+    _Alignas(64) uint64_t data_pos;
+    uint64_t dropped;
+    // Fields wanted by any subscriber
+    struct mdif_field_set wanted;
+    // By field number, see mdif_bcast_counters()
+    uint64_t received[MDIF_MAX_FIELD + 1];
+    uint64_t skipped[MDIF_MAX_FIELD + 1];
+    uint32_t mask;      // Number of slots - 1
+    uint32_t data_mask; // Size of data - 1
+    struct mdif_bcast_slot *slots;
+    uint8_t *data;
+    pthread_mutex_t lock; // Serializes subscribe and close
+    struct mdif_bcast_sub subs[MDIF_BCAST_MAX_SUBSCRIBERS];
+};
+
+// Allocate a ring of `n_slots` messages and `data_size` bytes, both powers of
+// 2. Returns -1 with errno set on failure.
+int mdif_bcast_init(struct mdif_bcast *b, uint32_t n_slots, uint32_t data_size);
+
+// Stop the subscriber threads and free the ring. The producer must have
+// stopped publishing.
+void mdif_bcast_free(struct mdif_bcast *b);
+
+// Start a subscriber thread calling `handler` with the messages with a field
+// number in `fields`, or all messages if `fields` is NULL. It gets the
+// messages published from now on. Messages in `keep` are handled also when
+// the subscriber lags, and may hold the producer back; NULL for none. Returns
+// the number of the subscriber, or -1 with errno set on failure, e.g. EBUSY
+// if there are MDIF_BCAST_MAX_SUBSCRIBERS.
+int mdif_bcast_subscribe(struct mdif_bcast *b, const struct mdif_field_set *fields,
+                         const struct mdif_field_set *keep, mdif_bcast_handler_t handler, void *ctx);
+
+// Publish a message, copying it into the ring, unless no subscriber wants it.
+// Returns -1 with errno EAGAIN if a subscriber is too far behind, or EMSGSIZE
+// if it can never fit. Producer only.
+int mdif_bcast_publish(struct mdif_bcast *b, const uint8_t *buf, uint32_t size);
+
+// Number of messages with field number `field` received by
+// mdif_bcast_publish(), and of those skipped because no subscriber wanted
+// them. From any thread.
+void mdif_bcast_counters(const struct mdif_bcast *b, uint32_t field, uint64_t *received, uint64_t *skipped);
+
+// Number of messages published and not yet read by subscriber `sub`, give or
+// take a batch, and of the messages of its filter it skipped because it
+// lagged. From any thread. Returns -1 with errno EINVAL if there is no such
+// subscriber.
+int mdif_bcast_sub_counters(const struct mdif_bcast *b, int sub, uint64_t *lag, uint64_t *skipped);
+
+#endif // _MDIF_BCAST_H
@@ -0,0 +1,193 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_bcast_test.c                                            *
+ *                                                                             *
+ * Description  : Test of mdif_bcast with a slow subscriber: it skips ahead,   *
+ *              : keeps the messages it must not lose, and does not hold back  *
+ *              : the others.                                                  *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mdif_bcast.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define MESSAGES 4000
+// Field numbers of the messages, one in KEEP_EVERY is kept
+#define FIELD_IND 10
+#define FIELD_KEPT 11
+#define KEEP_EVERY 50
+// Field not subscribed to by the filtered subscriber
+#define FIELD_OTHER 12
+// Time the slow subscriber takes per message, and between messages published
+#define SLOW_US 500
+#define PUBLISH_US 20
+
+/*******************************************************************************
+ *                      Enumerations/Type definitions/Structs
+ *******************************************************************************/
+struct counts {
+    uint32_t handled;
+    uint32_t kept;
+    uint32_t out_of_order;
+    uint32_t next;
+    int delay_us;
+};
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Messages are a length delimited field with the sequence number
+static uint32_t make_msg(uint8_t *buf, uint32_t field, uint32_t seq) {
+    buf[0] = field << 3 | 2;
+    buf[1] = sizeof(seq);
+    memcpy(buf + 2, &seq, sizeof(seq));
+    return 2 + sizeof(seq);
+}
+
+static void handler(const uint8_t *buf, uint32_t size, void *ctx) {
+    struct counts *c = ctx;
+    uint32_t seq;
+    memcpy(&seq, buf + 2, sizeof(seq));
+    // Skipped messages leave gaps, but never go back
+    c->out_of_order += seq < c->next;
+    c->next = seq + 1;
+    c->handled++;
+    c->kept += mdif_msg_field(buf, size) == FIELD_KEPT;
+    if (c->delay_us) {
+        usleep(c->delay_us);
+    }
+}
+
+int main(void) {
+    int fails = 0;
+    struct mdif_bcast b;
+    struct counts fast = {0};
+    struct counts slow = {.delay_us = SLOW_US};
+    struct mdif_field_set keep = {0};
+    mdif_field_set_add(&keep, FIELD_KEPT);
+
+    mdif_bcast_init(&b, 64, 4096);
+    int fast_sub = mdif_bcast_subscribe(&b, NULL, NULL, handler, &fast);
+    int slow_sub = mdif_bcast_subscribe(&b, NULL, &keep, handler, &slow);
+    CHECK("subscribers numbered", fast_sub == 0 && slow_sub == 1);
+
+    uint8_t buf[16];
+    uint32_t published = 0;
+    for (uint32_t seq = 0; seq < MESSAGES; seq++) {
+        uint32_t field = seq % KEEP_EVERY == 0 ? FIELD_KEPT : FIELD_IND;
+        published += mdif_bcast_publish(&b, buf, make_msg(buf, field, seq)) == 0;
+        usleep(PUBLISH_US);
+    }
+    // Let the subscribers catch up
+    uint64_t lag = 1, skipped = 0;
+    for (int i = 0; i < 1000 && lag; i++) {
+        usleep(1000);
+        uint64_t fast_lag, fast_skipped;
+        mdif_bcast_sub_counters(&b, fast_sub, &fast_lag, &fast_skipped);
+        mdif_bcast_sub_counters(&b, slow_sub, &lag, &skipped);
+        lag += fast_lag;
+    }
+    printf("slow subscriber handled %u, skipped %lu\n", slow.handled, (unsigned long)skipped);
+    CHECK("subscribers caught up", lag == 0);
+    CHECK("no message dropped", published == MESSAGES && b.dropped == 0);
+    CHECK("fast subscriber got all in order", fast.handled == MESSAGES && fast.out_of_order == 0);
+    CHECK("slow subscriber skipped ahead", skipped > 0 && slow.handled + skipped == MESSAGES);
+    CHECK("slow subscriber got all kept", slow.kept == MESSAGES / KEEP_EVERY);
+    CHECK("slow subscriber in order", slow.out_of_order == 0);
+    CHECK("no such subscriber", mdif_bcast_sub_counters(&b, 2, &lag, &skipped) == -1);
+    uint64_t received;
+    mdif_bcast_counters(&b, FIELD_IND, &received, &skipped);
+    CHECK("received counted by type", received == MESSAGES - MESSAGES / KEEP_EVERY && skipped == 0);
+    mdif_bcast_counters(&b, FIELD_KEPT, &received, &skipped);
+    CHECK("received counted by type, kept", received == MESSAGES / KEEP_EVERY && skipped == 0);
+    mdif_bcast_free(&b);
+
+    // Types no subscriber wants are counted and skipped, without being copied
+    // into the ring
+    struct counts filtered = {0};
+    struct mdif_field_set fields = {0};
+    mdif_field_set_add(&fields, FIELD_IND);
+    mdif_bcast_init(&b, 64, 4096);
+    int filtered_sub = mdif_bcast_subscribe(&b, &fields, NULL, handler, &filtered);
+    int good = 1;
+    for (uint32_t seq = 0; seq < 30; seq++) {
+        // Every third is empty, i.e. of unknown type
+        uint32_t size = seq % 3 == 2 ? 0 : make_msg(buf, seq % 3 == 0 ? FIELD_IND : FIELD_OTHER, seq);
+        good &= mdif_bcast_publish(&b, buf, size) == 0;
+    }
+    CHECK("unwanted types published without error", good);
+    CHECK("only wanted types copied into ring", atomic_load(&b.head) == 10);
+    lag = 1;
+    for (int i = 0; i < 1000 && lag; i++) {
+        usleep(1000);
+        mdif_bcast_sub_counters(&b, filtered_sub, &lag, &skipped);
+    }
+    CHECK("filtered subscriber got only its types", filtered.handled == 10 && filtered.out_of_order == 0);
+    mdif_bcast_counters(&b, FIELD_IND, &received, &skipped);
+    CHECK("wanted type received, not skipped", received == 10 && skipped == 0);
+    mdif_bcast_counters(&b, FIELD_OTHER, &received, &skipped);
+    CHECK("unwanted type received and skipped", received == 10 && skipped == 10);
+    mdif_bcast_counters(&b, 0, &received, &skipped);
+    CHECK("unknown type counted as field 0", received == 10 && skipped == 10);
+    mdif_bcast_counters(&b, FIELD_KEPT, &received, &skipped);
+    CHECK("type not received", received == 0 && skipped == 0);
+    mdif_bcast_free(&b);
+    return fails ? 1 : 0;
+}
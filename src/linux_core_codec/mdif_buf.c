@@ -0,0 +1,183 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_buf.c                                                   *
+ *                                                                             *
+ * Description  : Pool of message buffers for encoding MDIF messages.          *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <endian.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mdif_buf.h"
+
+/*******************************************************************************
+ *                      Enumerations/Type definitions/Structs
+ *******************************************************************************/
+// ProtobufCBuffer appending to a slot. Packing continues after overflow but
+// nothing more is written.
+struct slot_writer {
+    ProtobufCBuffer base;
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+};
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+static uint8_t pool[MDIF_BUF_SLOTS][MDIF_BUF_SLOT_SIZE] __attribute__((aligned(64)));
+
+// Stack of free slot indexes
+static uint16_t free_slots[MDIF_BUF_SLOTS];
+static unsigned n_free;
+static bool pool_initialized;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static void slot_append(ProtobufCBuffer *buffer, size_t len, const uint8_t *data) {
+    struct slot_writer *w = (struct slot_writer *)buffer;
+    if (w->len + len <= w->cap) {
+        memcpy(w->data + w->len, data, len);
+    }
+    w->len += len;
+}
+
+static uint8_t *slot_get(void) {
+    uint8_t *slot = NULL;
+    pthread_mutex_lock(&pool_mutex);
+    if (!pool_initialized) {
+        for (unsigned i = 0; i < MDIF_BUF_SLOTS; i++) {
+            free_slots[i] = i;
+        }
+        n_free = MDIF_BUF_SLOTS;
+        pool_initialized = true;
+    }
+    if (n_free) {
+        slot = pool[free_slots[--n_free]];
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    return slot;
+}
+
+static bool in_pool(const uint8_t *p) {
+    // Compared as integers, as &pool[MDIF_BUF_SLOTS][0] indexes past the array
+    uintptr_t start = (uintptr_t)pool;
+    return (uintptr_t)p >= start && (uintptr_t)p < start + sizeof(pool);
+}
+
+uint8_t *mdif_buf_pack(const ProtobufCMessage *msg, uint32_t *size) {
+    uint8_t *slot = slot_get();
+    if (slot) {
+        struct slot_writer w = {
+            .base.append = slot_append,
+            .data = slot + MDIF_BUF_HEADROOM,
+            .cap = MDIF_BUF_SLOT_SIZE - MDIF_BUF_HEADROOM,
+        };
+        protobuf_c_message_pack_to_buffer(msg, &w.base);
+        if (w.len <= w.cap) {
+            *size = w.len;
+            return w.data;
+        }
+        mdif_buf_free(w.data);
+    }
+
+    // Too large for a slot, or pool empty
+    *size = protobuf_c_message_get_packed_size(msg);
+    uint8_t *p = malloc(MDIF_BUF_HEADROOM + *size);
+    if (!p) {
+        return NULL;
+    }
+    protobuf_c_message_pack(msg, p + MDIF_BUF_HEADROOM);
+    return p + MDIF_BUF_HEADROOM;
+}
+
+uint8_t *mdif_buf_copy(const uint8_t *msg, uint32_t len) {
+    uint8_t *p = NULL;
+    if (MDIF_BUF_HEADROOM + len <= MDIF_BUF_SLOT_SIZE) {
+        p = slot_get();
+    }
+    if (!p) {
+        p = malloc(MDIF_BUF_HEADROOM + len);
+        if (!p) {
+            return NULL;
+        }
+    }
+    memcpy(p + MDIF_BUF_HEADROOM, msg, len);
+    return p + MDIF_BUF_HEADROOM;
+}
+
+void mdif_buf_free(const uint8_t *buf) {
+    if (!buf) {
+        return;
+    }
+    uint8_t *p = (uint8_t *)buf - MDIF_BUF_HEADROOM;
+    if (!in_pool(p)) {
+        free(p);
+        return;
+    }
+    pthread_mutex_lock(&pool_mutex);
+    free_slots[n_free++] = (p - &pool[0][0]) / MDIF_BUF_SLOT_SIZE;
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+uint8_t *mdif_buf_prefix(uint8_t *buf, uint32_t size) {
+    uint32_t le = htole32(size);
+    memcpy(buf - MDIF_BUF_HEADROOM, &le, MDIF_BUF_HEADROOM);
+    return buf - MDIF_BUF_HEADROOM;
+}
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_buf.h                                                   *
+ *                                                                             *
+ * Description  : Pool of message buffers for encoding MDIF messages.          *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_BUF_H
+#define _MDIF_BUF_H
+
+// Encoded messages are packed into slots of a fixed pool instead of a buffer
+// malloc()'ed per message. Each buffer has MDIF_BUF_HEADROOM bytes before the
+// message, so the TCP length prefix can be written in place and prefix and
+// message sent as one contiguous write, see mdif_buf_prefix().
+//
+// Buffers are returned with mdif_buf_free(), e.g. from hdlc_frame_sent_cb(),
+// from any thread. Messages larger than a slot, or packed while the pool is
+// empty, fall back to malloc() with the same headroom, so callers need not
+// care.
+
+#include <stdint.h>
+
+#include <protobuf-c/protobuf-c.h>
+
+// Room for the TCP length prefix
+#define MDIF_BUF_HEADROOM 4
+
+#ifndef MDIF_BUF_SLOT_SIZE
+// Size of each slot including headroom. Fits the largest HDLC frame.
+#define MDIF_BUF_SLOT_SIZE 2048
+#endif
+#ifndef MDIF_BUF_SLOTS
+#define MDIF_BUF_SLOTS 32
+#endif
+
+// Pack `msg` into a buffer from the pool. Returns the packed message, and its
+// length in `size`. Free with mdif_buf_free().
+uint8_t *mdif_buf_pack(const ProtobufCMessage *msg, uint32_t *size);
+
+// Copy an already encoded message, e.g. from mdif_const_msg.h, into a buffer
+// from the pool. Free with mdif_buf_free().
+uint8_t *mdif_buf_copy(const uint8_t *msg, uint32_t len);
+
+// Return buffer from mdif_buf_pack() or mdif_buf_copy() to the pool
+void mdif_buf_free(const uint8_t *buf);
+
+// Write the 32 bit little endian length prefix into the headroom of `buf`, and
+// return a pointer to it. The MDIF_BUF_HEADROOM + `size` bytes from there are
+// ready to send.
+uint8_t *mdif_buf_prefix(uint8_t *buf, uint32_t size);
+
+#endif // _MDIF_BUF_H
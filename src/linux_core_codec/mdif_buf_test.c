@@ -0,0 +1,188 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_buf_test.c                                              *
+ *                                                                             *
+ * Description  : Tests of mdif_buf: pool, malloc fallback and headroom        *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <endian.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mdif_buf.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Largest message fitting a slot
+#define SLOT_MSG_LEN (MDIF_BUF_SLOT_SIZE - MDIF_BUF_HEADROOM)
+#define THREADS 4
+#define THREAD_BUFS (MDIF_BUF_SLOTS / 3)
+#define THREAD_ITERATIONS 20000
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Calls of malloc() and free() by the calling thread
+static __thread unsigned n_malloc;
+static __thread unsigned n_free;
+
+static uint8_t msg[2 * MDIF_BUF_SLOT_SIZE];
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Linked with -Wl,--wrap=malloc,--wrap=free, to see the fallback
+void *__wrap_malloc(size_t size) {
+    n_malloc++;
+    return __real_malloc(size);
+}
+
+void __wrap_free(void *ptr) {
+    n_free += ptr != NULL;
+    __real_free(ptr);
+}
+
+// Prefix written into the headroom, with the message intact after it
+static int prefixed(uint8_t *buf, uint32_t len) {
+    uint8_t *p = mdif_buf_prefix(buf, len);
+    uint32_t prefix;
+    memcpy(&prefix, p, sizeof(prefix));
+    return p == buf - MDIF_BUF_HEADROOM && le32toh(prefix) == len && memcmp(p + MDIF_BUF_HEADROOM, msg, len) == 0;
+}
+
+// Copies and frees from several threads at once, together holding more
+// buffers than the pool has
+static void *churn(void *arg) {
+    uint8_t *bufs[THREAD_BUFS];
+    for (int i = 0; i < THREAD_ITERATIONS; i++) {
+        for (int j = 0; j < THREAD_BUFS; j++) {
+            bufs[j] = mdif_buf_copy(msg, 100);
+        }
+        for (int j = 0; j < THREAD_BUFS; j++) {
+            mdif_buf_free(bufs[j]);
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    int fails = 0;
+    for (size_t i = 0; i < sizeof(msg); i++) {
+        msg[i] = i * 7;
+    }
+
+    // Drain the pool
+    uint8_t *bufs[MDIF_BUF_SLOTS];
+    int good = 1;
+    n_malloc = 0;
+    for (int i = 0; i < MDIF_BUF_SLOTS; i++) {
+        uint32_t len = i == 0 ? SLOT_MSG_LEN : i;
+        bufs[i] = mdif_buf_copy(msg, len);
+        good &= bufs[i] && prefixed(bufs[i], len);
+    }
+    CHECK("pool slots copied with headroom", good);
+    CHECK("pool slots without malloc()", n_malloc == 0);
+
+    uint8_t *fallback = mdif_buf_copy(msg, 10);
+    CHECK("empty pool falls back to malloc()", fallback && n_malloc == 1);
+    CHECK("fallback has headroom", prefixed(fallback, 10));
+    n_free = 0;
+    mdif_buf_free(fallback);
+    CHECK("fallback freed with free()", n_free == 1);
+
+    n_malloc = 0;
+    uint8_t *large = mdif_buf_copy(msg, SLOT_MSG_LEN + 1);
+    CHECK("message larger than a slot from malloc()", large && n_malloc == 1);
+    CHECK("large message has headroom", prefixed(large, SLOT_MSG_LEN + 1));
+    mdif_buf_free(large);
+
+    n_free = 0;
+    for (int i = 0; i < MDIF_BUF_SLOTS; i++) {
+        mdif_buf_free(bufs[i]);
+    }
+    CHECK("slots returned without free()", n_free == 0);
+    mdif_buf_free(NULL);
+
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, churn, NULL);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // All slots are back after the threads
+    n_malloc = 0;
+    good = 1;
+    for (int i = 0; i < MDIF_BUF_SLOTS; i++) {
+        bufs[i] = mdif_buf_copy(msg, 100);
+        for (int j = 0; j < i; j++) {
+            good &= bufs[j] != bufs[i];
+        }
+    }
+    CHECK("all slots free after concurrent use", n_malloc == 0 && good);
+    for (int i = 0; i < MDIF_BUF_SLOTS; i++) {
+        mdif_buf_free(bufs[i]);
+    }
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_const_msg.h                                             *
+ *                                                                             *
+ * Description  : Constant encodings of parameterless MDIF requests.           *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_CONST_MSG_H
+#define _MDIF_CONST_MSG_H
+
+// A request without fields, e.g. StartReq or GetDeviceInfoReq, is encoded as
+// the tag of its oneof field in the component message followed by length 0.
+// It thus depends on nothing but the field number, which protobuf-c generates
+// as the msg_case enum value, so the encoding is computed by the compiler:
+//
+//   MDIF_EMPTY_MSG(req, MDIF__CORE__CORE_MSG__MSG_GET_DEVICE_INFO_REQ);
+//   // req[] is the encoding and req_len its length
+//
+// The test target of the demos compares each encoding with protobuf-c output.
+
+#include <stdint.h>
+
+// Tag of a length delimited field
+#define MDIF_TAG_LEN_DELIM(field) (((uint32_t)(field) << 3) | 2)
+
+// Encoded length. MDIF field numbers are below 2048, so the tag varint is 1 or
+// 2 bytes.
+#define MDIF_EMPTY_MSG_LEN(field) (MDIF_TAG_LEN_DELIM(field) < 0x80 ? 2 : 3)
+
+// Encoding, padded to 3 bytes
+#define MDIF_EMPTY_MSG_BYTES(field)                                                                  \
+    {                                                                                                \
+        MDIF_TAG_LEN_DELIM(field) < 0x80 ? MDIF_TAG_LEN_DELIM(field)                                 \
+                                         : ((MDIF_TAG_LEN_DELIM(field) & 0x7f) | 0x80),              \
+        MDIF_TAG_LEN_DELIM(field) < 0x80 ? 0 : MDIF_TAG_LEN_DELIM(field) >> 7,                       \
+        0,                                                                                           \
+    }
+
+// Define `name`[] with the encoding of an empty message in oneof field `field`,
+// and `name`_len with its length.
+#define MDIF_EMPTY_MSG(name, field)                                                                  \
+    _Static_assert((field) > 0 && (field) < 2048, #field " must be a field number below 2048");      \
+    static const uint8_t name[3] = MDIF_EMPTY_MSG_BYTES(field);                                      \
+    enum { name##_len = MDIF_EMPTY_MSG_LEN(field) }
+
+#endif // _MDIF_CONST_MSG_H
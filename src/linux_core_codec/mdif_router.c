@@ -0,0 +1,113 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_router.c                                                *
+ *                                                                             *
+ * Description  : Routing of MDIF messages to component decoders by field tag. *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include "mdif_router.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Wire type of embedded messages
+#define WIRETYPE_LENGTH_DELIMITED 2
+// A field number needs at most 5 varint bytes, and MDIF uses at most 2
+#define MAX_TAG_LEN 5
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Field number ranges allocated to each component, from the .proto files
+static const uint8_t field_component[MDIF_MAX_FIELD + 1] = {
+    [0x001 ... 0x01F] = MDIF_COMPONENT_CORE,
+    [0x020 ... 0x02F] = MDIF_COMPONENT_FWU,
+    [0x080 ... 0x09F] = MDIF_COMPONENT_RFS,
+    [0x0C0 ... 0x0DF] = MDIF_COMPONENT_RFE,
+    [0x100 ... 0x1FF] = MDIF_COMPONENT_CORE,
+};
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+uint32_t mdif_msg_field(const uint8_t *buf, uint32_t size) {
+    uint32_t tag = 0;
+    uint32_t len = size < MAX_TAG_LEN ? size : MAX_TAG_LEN;
+    for (uint32_t i = 0; i < len; i++) {
+        tag |= (uint32_t)(buf[i] & 0x7f) << (7 * i);
+        if (buf[i] < 0x80) {
+            if ((tag & 7) != WIRETYPE_LENGTH_DELIMITED) {
+                return 0;
+            }
+            return tag >> 3;
+        }
+    }
+    // Empty or truncated
+    return 0;
+}
+
+mdif_component_t mdif_field_component(uint32_t field) {
+    if (field > MDIF_MAX_FIELD) {
+        return MDIF_COMPONENT_UNKNOWN;
+    }
+    return field_component[field];
+}
+
+void mdif_field_set_add_component(struct mdif_field_set *set, mdif_component_t c) {
+    for (uint32_t field = 0; field <= MDIF_MAX_FIELD; field++) {
+        if (field_component[field] == c) {
+            mdif_field_set_add(set, field);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_router.h                                                *
+ *                                                                             *
+ * Description  : Routing of MDIF messages to component decoders by field tag. *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_ROUTER_H
+#define _MDIF_ROUTER_H
+
+#include <stdint.h>
+
+// Each component (core, fwu, rfs, rfe) wraps its messages in a oneof, and the
+// components use disjoint field number ranges. The first tag on the wire thus
+// tells which component message it is, without unpacking it. The router reads
+// that tag, so each message is unpacked once, by the right decoder.
+//
+// No protobuf dependency, so it may also be used where messages are only
+// forwarded.
+
+typedef enum {
+    MDIF_COMPONENT_UNKNOWN = 0,
+    MDIF_COMPONENT_CORE,
+    MDIF_COMPONENT_FWU,
+    MDIF_COMPONENT_RFS,
+    MDIF_COMPONENT_RFE,
+    MDIF_COMPONENT_COUNT
+} mdif_component_t;
+
+// Highest field number allocated to any component, see the .proto files
+#define MDIF_MAX_FIELD 0x1FF
+
+// Field number of the first field in `buf`, i.e. the oneof member. Returns 0 if
+// the message is empty, or does not start with a length delimited field.
+uint32_t mdif_msg_field(const uint8_t *buf, uint32_t size);
+
+// Component owning field number `field`
+mdif_component_t mdif_field_component(uint32_t field);
+
+// Component of the message in `buf`
+static inline mdif_component_t mdif_msg_component(const uint8_t *buf, uint32_t size)
+{
+    return mdif_field_component(mdif_msg_field(buf, size));
+}
+
+// Set of field numbers, i.e. message types, of any components. Fields above
+// MDIF_MAX_FIELD are treated as 0, like messages without a field.
+struct mdif_field_set {
+    uint64_t bits[MDIF_MAX_FIELD / 64 + 1];
+};
+
+static inline void mdif_field_set_add(struct mdif_field_set *set, uint32_t field)
+{
+    field = field > MDIF_MAX_FIELD ? 0 : field;
+    set->bits[field / 64] |= 1ull << (field % 64);
+}
+
+static inline int mdif_field_set_has(const struct mdif_field_set *set, uint32_t field)
+{
+    field = field > MDIF_MAX_FIELD ? 0 : field;
+    return (set->bits[field / 64] >> (field % 64)) & 1;
+}
+
+// Add all fields of component `c`
+void mdif_field_set_add_component(struct mdif_field_set *set, mdif_component_t c);
+
+#endif // _MDIF_ROUTER_H
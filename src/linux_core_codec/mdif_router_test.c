@@ -0,0 +1,163 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_router_test.c                                           *
+ *                                                                             *
+ * Description  : Tests of mdif_router: field number ranges of the components  *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <string.h>
+
+#include "mdif_router.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// First and last field of each range, and the fields just outside
+static const struct {
+    uint32_t field;
+    mdif_component_t component;
+} boundaries[] = {
+    {0x000, MDIF_COMPONENT_UNKNOWN},
+    {0x001, MDIF_COMPONENT_CORE},
+    {0x01F, MDIF_COMPONENT_CORE},
+    {0x020, MDIF_COMPONENT_FWU},
+    {0x02F, MDIF_COMPONENT_FWU},
+    {0x030, MDIF_COMPONENT_UNKNOWN},
+    {0x07F, MDIF_COMPONENT_UNKNOWN},
+    {0x080, MDIF_COMPONENT_RFS},
+    {0x09F, MDIF_COMPONENT_RFS},
+    {0x0A0, MDIF_COMPONENT_UNKNOWN},
+    {0x0BF, MDIF_COMPONENT_UNKNOWN},
+    {0x0C0, MDIF_COMPONENT_RFE},
+    {0x0DF, MDIF_COMPONENT_RFE},
+    {0x0E0, MDIF_COMPONENT_UNKNOWN},
+    {0x0FF, MDIF_COMPONENT_UNKNOWN},
+    {0x100, MDIF_COMPONENT_CORE},
+    {0x1FF, MDIF_COMPONENT_CORE},
+    {0x200, MDIF_COMPONENT_UNKNOWN},
+    {0xFFFFFFFF, MDIF_COMPONENT_UNKNOWN},
+};
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Tag of a length delimited field `field`, as protobuf encodes it
+static uint32_t put_tag(uint8_t *buf, uint32_t field) {
+    uint32_t tag = field << 3 | 2;
+    uint32_t n = 0;
+    while (tag >= 0x80) {
+        buf[n++] = tag | 0x80;
+        tag >>= 7;
+    }
+    buf[n++] = tag;
+    return n;
+}
+
+int main(void) {
+    int fails = 0;
+
+    int good = 1;
+    for (size_t i = 0; i < sizeof(boundaries) / sizeof(boundaries[0]); i++) {
+        if (mdif_field_component(boundaries[i].field) != boundaries[i].component) {
+            printf("field 0x%x: component %d, expected %d\n", boundaries[i].field,
+                   mdif_field_component(boundaries[i].field), boundaries[i].component);
+            good = 0;
+        }
+    }
+    CHECK("field ranges of core, fwu, rfs and rfe", good);
+
+    // Last oneof field of each component in the .proto files
+    CHECK("fwu field 0x26", mdif_field_component(0x26) == MDIF_COMPONENT_FWU);
+    CHECK("rfs field 0x97", mdif_field_component(0x97) == MDIF_COMPONENT_RFS);
+    CHECK("rfe field 0xC6", mdif_field_component(0xC6) == MDIF_COMPONENT_RFE);
+    CHECK("core field 257", mdif_field_component(257) == MDIF_COMPONENT_CORE);
+
+    // The first tag on the wire selects the component
+    uint8_t buf[8];
+    good = 1;
+    for (size_t i = 0; i < sizeof(boundaries) / sizeof(boundaries[0]); i++) {
+        uint32_t field = boundaries[i].field;
+        if (field == 0 || field > MDIF_MAX_FIELD) {
+            continue;
+        }
+        uint32_t n = put_tag(buf, field);
+        buf[n++] = 0; // Empty message
+        good &= mdif_msg_field(buf, n) == field && mdif_msg_component(buf, n) == boundaries[i].component;
+    }
+    CHECK("field read from one and two byte tags", good);
+
+    uint32_t n = put_tag(buf, 0x80);
+    CHECK("truncated tag is field 0", mdif_msg_field(buf, n - 1) == 0);
+    CHECK("empty message is field 0", mdif_msg_field(buf, 0) == 0);
+    buf[0] = 1 << 3 | 0; // Varint field 1
+    buf[1] = 1;
+    CHECK("field not length delimited is 0", mdif_msg_field(buf, 2) == 0);
+    memset(buf, 0x80, sizeof(buf));
+    CHECK("overlong tag is field 0", mdif_msg_field(buf, sizeof(buf)) == 0);
+    n = put_tag(buf, 0x300);
+    buf[n++] = 0;
+    CHECK("unknown field is unknown component",
+          mdif_msg_field(buf, n) == 0x300 && mdif_msg_component(buf, n) == MDIF_COMPONENT_UNKNOWN);
+
+    struct mdif_field_set set = {0};
+    mdif_field_set_add_component(&set, MDIF_COMPONENT_RFS);
+    CHECK("rfs set holds its range",
+          mdif_field_set_has(&set, 0x80) && mdif_field_set_has(&set, 0x9F) && !mdif_field_set_has(&set, 0x7F) &&
+              !mdif_field_set_has(&set, 0xA0) && !mdif_field_set_has(&set, 0));
+    mdif_field_set_add(&set, 0x300);
+    CHECK("field above max added as 0", mdif_field_set_has(&set, 0) && mdif_field_set_has(&set, 0x400));
+
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,459 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_rpc.c                                                   *
+ *                                                                             *
+ * Description  : Correlation of MDIF requests with their responses.           *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mdif_buf.h"
+#include "mdif_router.h"
+#include "mdif_rpc.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define SLOT_MASK (MDIF_RPC_WHEEL_SLOTS - 1)
+
+// Callbacks run after the lock is released, up to this many at a time
+#define DONE_BATCH 16
+
+// Requests sent after the lock is released, up to this many at a time
+#define SEND_BATCH 16
+
+// Request and response field numbers of an rpc
+#define RPC(req, res) [req].res_field = res, [res].req_field = req
+
+/*******************************************************************************
+ *                      Enumerations/Type definitions/Structs
+ *******************************************************************************/
+struct done {
+    mdif_rpc_cb_t cb;
+    void *ctx;
+    int err;
+};
+
+struct outgoing {
+    uint8_t *buf;
+    uint32_t size;
+};
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Response field of each request field and vice versa, from the services in
+// the .proto files. RFE has no service definition, so its pairs are taken from
+// RfeMsg.
+static const struct {
+    uint16_t req_field;
+    uint16_t res_field;
+} rpc_fields[MDIF_MAX_FIELD + 1] = {
+    // CoreService
+    RPC(0x001, 0x002), // Ping
+    RPC(0x003, 0x004), // Reset
+    RPC(0x005, 0x006), // GetDeviceInfo
+    RPC(0x007, 0x008), // GetBatteryStatus
+    RPC(0x009, 0x00A), // GetIpConfig
+    RPC(0x00B, 0x00C), // SetIpConfig
+    RPC(0x00D, 0x00E), // GnssCompassStream
+    RPC(0x010, 0x011), // CompassCalibrate
+    RPC(0x014, 0x015), // CompassCalibrationStore
+    RPC(0x01A, 0x01B), // GetAccessoriesList
+    RPC(0x01D, 0x01E), // SetPersistentSetting
+    RPC(0x100, 0x101), // GetPersistentSetting
+    // FwuService
+    RPC(0x020, 0x021), // FwuInit
+    RPC(0x022, 0x023), // FwuChunk
+    RPC(0x025, 0x026), // FwuAbort
+    // RfsService
+    RPC(0x080, 0x081), // Start
+    RPC(0x082, 0x083), // Stop
+    RPC(0x084, 0x085), // GetDronelist, deprecated and not in RfsService
+    RPC(0x086, 0x087), // GetDroneInfo
+    RPC(0x08B, 0x08C), // RemoteIdStream
+    RPC(0x08E, 0x08F), // Mute
+    RPC(0x090, 0x091), // State
+    RPC(0x093, 0x094), // WpLedIdentify, not in RfsService
+    RPC(0x095, 0x096), // GetSignalInterference
+    // RfeMsg
+    RPC(0x0C0, 0x0C1), // Start
+    RPC(0x0C2, 0x0C3), // Stop
+    RPC(0x0C4, 0x0C5), // GetStateInfo
+};
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static uint64_t monotonic_ms(void);
+static void *wheel_thread(void *arg);
+static void schedule(struct mdif_rpc_wheel *w, struct mdif_rpc_call *c, uint64_t now_ms);
+static bool send_pending(struct mdif_rpc *rpc);
+static void release(struct mdif_rpc_call *c, int err, struct done *done);
+static void run_done(const struct done *done, unsigned n);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+void mdif_rpc_wheel_init(struct mdif_rpc_wheel *w, uint32_t tick_ms) {
+    pthread_mutex_init(&w->lock, NULL);
+    w->tick_ms = tick_ms;
+    w->tick = monotonic_ms() / tick_ms;
+    for (int i = 0; i < MDIF_RPC_WHEEL_SLOTS; i++) {
+        LIST_INIT(&w->slots[i]);
+    }
+}
+
+int mdif_rpc_wheel_start(struct mdif_rpc_wheel *w) {
+    int err = pthread_create(&w->thread, NULL, wheel_thread, w);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+void mdif_rpc_wheel_advance(struct mdif_rpc_wheel *w, uint64_t now_ms) {
+    uint64_t target = now_ms / w->tick_ms;
+    struct done done[DONE_BATCH];
+    unsigned n = 0;
+
+    pthread_mutex_lock(&w->lock);
+    if (target > w->tick + MDIF_RPC_WHEEL_SLOTS) {
+        // Visit each slot once
+        w->tick = target - MDIF_RPC_WHEEL_SLOTS;
+    }
+    while (w->tick < target) {
+        struct mdif_rpc_slot *slot = &w->slots[++w->tick & SLOT_MASK];
+        struct mdif_rpc_call *c = LIST_FIRST(slot);
+        while (c) {
+            struct mdif_rpc_call *next = LIST_NEXT(c, slot);
+            if (c->deadline > target) {
+                // Due in a later revolution
+            } else if (c->buf == NULL && c->cb) {
+                // Sent but not answered. Keep its place in in_flight_q for
+                // another timeout, in case the response is just late.
+                done[n++] = (struct done){c->cb, c->ctx, ETIMEDOUT};
+                c->cb = NULL;
+                LIST_REMOVE(c, slot);
+                schedule(w, c, now_ms);
+            } else {
+                struct mdif_rpc *rpc = c->rpc;
+                if (c->cb) {
+                    release(c, ETIMEDOUT, &done[n++]);
+                } else {
+                    release(c, 0, NULL);
+                }
+                if (send_pending(rpc)) {
+                    // The slot may have changed while unlocked
+                    next = LIST_FIRST(slot);
+                }
+            }
+            if (n == DONE_BATCH) {
+                pthread_mutex_unlock(&w->lock);
+                run_done(done, n);
+                n = 0;
+                pthread_mutex_lock(&w->lock);
+                // The slot may have changed meanwhile
+                next = LIST_FIRST(slot);
+            }
+            c = next;
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+    run_done(done, n);
+}
+
+int mdif_rpc_init(struct mdif_rpc *rpc, struct mdif_rpc_wheel *w, unsigned max_in_flight, unsigned max_pending,
+                  mdif_rpc_send_t send, void *send_ctx) {
+    if (max_in_flight == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    unsigned ncalls = max_in_flight + max_pending;
+    rpc->calls = calloc(ncalls, sizeof(*rpc->calls));
+    if (!rpc->calls) {
+        return -1;
+    }
+    rpc->wheel = w;
+    rpc->send = send;
+    rpc->send_ctx = send_ctx;
+    rpc->sending = false;
+    rpc->max_in_flight = max_in_flight;
+    rpc->in_flight = 0;
+    rpc->used = 0;
+    TAILQ_INIT(&rpc->in_flight_q);
+    TAILQ_INIT(&rpc->pending);
+    TAILQ_INIT(&rpc->free);
+    for (unsigned i = 0; i < ncalls; i++) {
+        rpc->calls[i].rpc = rpc;
+        TAILQ_INSERT_TAIL(&rpc->free, &rpc->calls[i], q);
+    }
+    return 0;
+}
+
+void mdif_rpc_free(struct mdif_rpc *rpc) {
+    mdif_rpc_cancel(rpc);
+    free(rpc->calls);
+    rpc->calls = NULL;
+}
+
+int mdif_rpc_call(struct mdif_rpc *rpc, uint8_t *buf, uint32_t size, uint32_t timeout_ms, mdif_rpc_cb_t cb,
+                  void *ctx) {
+    uint32_t field = mdif_msg_field(buf, size);
+    if (field > MDIF_MAX_FIELD || !rpc_fields[field].res_field) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct mdif_rpc_wheel *w = rpc->wheel;
+    uint64_t now = monotonic_ms();
+
+    pthread_mutex_lock(&w->lock);
+    // There are max_pending calls more than max_in_flight, so when all are
+    // used, max_pending requests are queued.
+    struct mdif_rpc_call *c = TAILQ_FIRST(&rpc->free);
+    if (!c) {
+        pthread_mutex_unlock(&w->lock);
+        errno = EAGAIN;
+        return -1;
+    }
+    TAILQ_REMOVE(&rpc->free, c, q);
+    rpc->used++;
+    c->timeout = (timeout_ms + w->tick_ms - 1) / w->tick_ms;
+    c->req_field = field;
+    c->in_flight = false;
+    c->buf = buf;
+    c->size = size;
+    c->cb = cb;
+    c->ctx = ctx;
+    schedule(w, c, now);
+    TAILQ_INSERT_TAIL(&rpc->pending, c, q);
+    send_pending(rpc);
+    pthread_mutex_unlock(&w->lock);
+    return 0;
+}
+
+bool mdif_rpc_response(struct mdif_rpc *rpc, const uint8_t *buf, uint32_t size) {
+    uint32_t field = mdif_msg_field(buf, size);
+    if (field > MDIF_MAX_FIELD || !rpc_fields[field].req_field) {
+        return false;
+    }
+    uint32_t req_field = rpc_fields[field].req_field;
+
+    pthread_mutex_lock(&rpc->wheel->lock);
+    struct mdif_rpc_call *c;
+    TAILQ_FOREACH(c, &rpc->in_flight_q, q) {
+        if (c->req_field == req_field) {
+            break;
+        }
+    }
+    if (!c) {
+        pthread_mutex_unlock(&rpc->wheel->lock);
+        return false;
+    }
+    struct done done = {0};
+    release(c, 0, c->cb ? &done : NULL);
+    send_pending(rpc);
+    pthread_mutex_unlock(&rpc->wheel->lock);
+    if (done.cb) {
+        done.cb(buf, size, 0, done.ctx);
+    }
+    // A late response to a request that timed out was still a response
+    return true;
+}
+
+void mdif_rpc_cancel(struct mdif_rpc *rpc) {
+    struct done done[DONE_BATCH];
+
+    pthread_mutex_lock(&rpc->wheel->lock);
+    // Callbacks may issue new requests, which are not cancelled
+    unsigned left = rpc->used;
+    while (left) {
+        unsigned n = 0;
+        while (left && n < DONE_BATCH) {
+            struct mdif_rpc_call *c = TAILQ_FIRST(&rpc->in_flight_q);
+            if (!c) {
+                c = TAILQ_FIRST(&rpc->pending);
+            }
+            if (!c) {
+                break;
+            }
+            release(c, ECANCELED, c->cb ? &done[n++] : NULL);
+            left--;
+        }
+        pthread_mutex_unlock(&rpc->wheel->lock);
+        run_done(done, n);
+        pthread_mutex_lock(&rpc->wheel->lock);
+        if (n == 0) {
+            break;
+        }
+    }
+    // Requests issued by the callbacks
+    send_pending(rpc);
+    pthread_mutex_unlock(&rpc->wheel->lock);
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void *wheel_thread(void *arg) {
+    struct mdif_rpc_wheel *w = arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (1) {
+        next.tv_nsec += (long)w->tick_ms * 1000000;
+        next.tv_sec += next.tv_nsec / 1000000000;
+        next.tv_nsec %= 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+        }
+        mdif_rpc_wheel_advance(w, monotonic_ms());
+    }
+    return NULL;
+}
+
+// Put call on the wheel, `c->timeout` ticks from now. Must be called with the
+// wheel lock held.
+static void schedule(struct mdif_rpc_wheel *w, struct mdif_rpc_call *c, uint64_t now_ms) {
+    // Rounded up, and never in a slot already passed
+    c->deadline = (now_ms + w->tick_ms - 1) / w->tick_ms + c->timeout;
+    if (c->deadline <= w->tick) {
+        c->deadline = w->tick + 1;
+    }
+    LIST_INSERT_HEAD(&w->slots[c->deadline & SLOT_MASK], c, slot);
+}
+
+// Send queued requests while there is room. Must be called with the wheel
+// lock held, which is released while sending. Returns true if it was released.
+//
+// Calls are moved to in_flight_q under the lock, and their requests are sent
+// in that order by the one thread that has set `sending`. A thread finding it
+// set leaves its requests to that thread, so the order responses are matched
+// in is the order the device receives the requests.
+static bool send_pending(struct mdif_rpc *rpc) {
+    struct mdif_rpc_wheel *w = rpc->wheel;
+    struct mdif_rpc_call *c;
+    while (rpc->in_flight < rpc->max_in_flight && (c = TAILQ_FIRST(&rpc->pending))) {
+        TAILQ_REMOVE(&rpc->pending, c, q);
+        TAILQ_INSERT_TAIL(&rpc->in_flight_q, c, q);
+        c->in_flight = true;
+        rpc->in_flight++;
+    }
+    if (rpc->sending) {
+        return false;
+    }
+
+    bool unlocked = false;
+    rpc->sending = true;
+    while (1) {
+        struct outgoing out[SEND_BATCH];
+        unsigned n = 0;
+        TAILQ_FOREACH(c, &rpc->in_flight_q, q) {
+            if (c->buf) {
+                out[n++] = (struct outgoing){c->buf, c->size};
+                c->buf = NULL;
+                if (n == SEND_BATCH) {
+                    break;
+                }
+            }
+        }
+        if (n == 0) {
+            break;
+        }
+        pthread_mutex_unlock(&w->lock);
+        for (unsigned i = 0; i < n; i++) {
+            rpc->send(out[i].buf, out[i].size, rpc->send_ctx);
+        }
+        pthread_mutex_lock(&w->lock);
+        unlocked = true;
+    }
+    rpc->sending = false;
+    return unlocked;
+}
+
+// Remove call from the wheel and its queue, and return it to the free list.
+// Its callback is stored in `done`, if not NULL, to be called after the lock
+// is released. Must be called with the wheel lock held.
+static void release(struct mdif_rpc_call *c, int err, struct done *done) {
+    struct mdif_rpc *rpc = c->rpc;
+    LIST_REMOVE(c, slot);
+    if (c->in_flight) {
+        TAILQ_REMOVE(&rpc->in_flight_q, c, q);
+        rpc->in_flight--;
+    } else {
+        TAILQ_REMOVE(&rpc->pending, c, q);
+    }
+    // Not sent yet
+    if (c->buf) {
+        mdif_buf_free(c->buf);
+        c->buf = NULL;
+    }
+    if (done) {
+        *done = (struct done){c->cb, c->ctx, err};
+    }
+    c->cb = NULL;
+    TAILQ_INSERT_TAIL(&rpc->free, c, q);
+    rpc->used--;
+}
+
+// Call callbacks of calls that failed
+static void run_done(const struct done *done, unsigned n) {
+    for (unsigned i = 0; i < n; i++) {
+        done[i].cb(NULL, 0, done[i].err, done[i].ctx);
+    }
+}
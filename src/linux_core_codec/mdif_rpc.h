@@ -0,0 +1,172 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_rpc.h                                                   *
+ *                                                                             *
+ * Description  : Correlation of MDIF requests with their responses.           *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_RPC_H
+#define _MDIF_RPC_H
+
+// Each request in the CoreService, RfsService and FwuService definitions, and
+// the RFE req/res pairs, has its own response message type. A device answers
+// requests of one type in order, so a response is matched to the oldest
+// outstanding request of its type. Requests of different types may thus be
+// pipelined, with no need to wait a round trip for each.
+//
+// Each request gets a callback, called with the response or on timeout.
+// Timeouts of all devices are kept on one shared timer wheel. The number of
+// requests in flight to each device is capped; further requests are queued
+// and sent when a response arrives.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+// Number of wheel slots, power of 2. Timeouts longer than a revolution just
+// stay in their slot for more than one revolution.
+#define MDIF_RPC_WHEEL_SLOTS 256
+
+// Called with the response, which is only valid during the call, and `err` 0.
+// Otherwise `res` is NULL and `err` is ETIMEDOUT, or ECANCELED from
+// mdif_rpc_cancel(). Called without locks held, so it may issue new requests.
+typedef void (*mdif_rpc_cb_t)(const uint8_t *res, uint32_t size, int err, void *ctx);
+
+// Send a request. Takes ownership of `buf`, from encode_*(), like
+// send_frame() in the demos. Called without locks held. The requests of a
+// device are sent by one thread at a time, in the order they are matched to
+// responses; requests issued meanwhile are sent by that thread.
+typedef void (*mdif_rpc_send_t)(uint8_t *buf, uint32_t size, void *ctx);
+
+struct mdif_rpc;
+
+struct mdif_rpc_call {
+    LIST_ENTRY(mdif_rpc_call) slot; // In a wheel slot while in use
+    TAILQ_ENTRY(mdif_rpc_call) q;   // In pending, in_flight or free
+    struct mdif_rpc *rpc;
+    uint64_t deadline; // Wheel tick
+    uint32_t timeout;  // Ticks
+    uint32_t req_field;
+    bool in_flight; // In in_flight_q, else in pending
+    // Request waiting to be sent, NULL once taken for sending
+    uint8_t *buf;
+    uint32_t size;
+    // NULL once timed out, see mdif_rpc_wheel_advance()
+    mdif_rpc_cb_t cb;
+    void *ctx;
+};
+
+LIST_HEAD(mdif_rpc_slot, mdif_rpc_call);
+TAILQ_HEAD(mdif_rpc_queue, mdif_rpc_call);
+
+// Timer wheel shared by the devices. Its lock also protects their calls.
+struct mdif_rpc_wheel {
+    pthread_mutex_t lock;
+    uint32_t tick_ms;
+    uint64_t tick; // Last tick expired
+    struct mdif_rpc_slot slots[MDIF_RPC_WHEEL_SLOTS];
+    pthread_t thread;
+};
+
+// Requests to one device
+struct mdif_rpc {
+    struct mdif_rpc_wheel *wheel;
+    mdif_rpc_send_t send;
+    void *send_ctx;
+    bool sending; // A thread is sending, see send_pending()
+    unsigned max_in_flight;
+    unsigned in_flight;
+    struct mdif_rpc_queue in_flight_q; // Sent or being sent, oldest first
+    struct mdif_rpc_queue pending;     // Waiting for a free in flight slot
+    struct mdif_rpc_queue free;
+    struct mdif_rpc_call *calls;
+    unsigned used; // Calls not in free
+};
+
+// Wheel with a resolution of `tick_ms`. Timeouts are rounded up to a tick.
+void mdif_rpc_wheel_init(struct mdif_rpc_wheel *w, uint32_t tick_ms);
+
+// Start a thread calling mdif_rpc_wheel_advance() every tick. Applications
+// with their own event loop may call mdif_rpc_wheel_advance() instead.
+// Returns -1 with errno set on error.
+int mdif_rpc_wheel_start(struct mdif_rpc_wheel *w);
+
+// Expire calls with a deadline up to `now_ms` (CLOCK_MONOTONIC). A request
+// that timed out after it was sent keeps its place for one more timeout, so a
+// late response is not taken for the response to a later request of its type.
+void mdif_rpc_wheel_advance(struct mdif_rpc_wheel *w, uint64_t now_ms);
+
+// Requests to a device, sent with `send`. At most `max_in_flight` are sent
+// before their responses, and `max_pending` more may be queued. Returns -1
+// with errno set on error.
+int mdif_rpc_init(struct mdif_rpc *rpc, struct mdif_rpc_wheel *w, unsigned max_in_flight, unsigned max_pending,
+                  mdif_rpc_send_t send, void *send_ctx);
+
+// Cancel all calls, and free the calls
+void mdif_rpc_free(struct mdif_rpc *rpc);
+
+// Send request `buf` of `size` bytes, from encode_*(), or queue it if
+// max_in_flight requests are outstanding. `cb` is called with the response, or
+// after `timeout_ms`. On success ownership of `buf` is taken. Returns -1 with
+// errno EINVAL if the message is not a request, or EAGAIN if too many requests
+// are queued.
+int mdif_rpc_call(struct mdif_rpc *rpc, uint8_t *buf, uint32_t size, uint32_t timeout_ms, mdif_rpc_cb_t cb,
+                  void *ctx);
+
+// Match a received message with the oldest outstanding request of its type,
+// and call its callback. Returns true if it was a response to a call. The
+// message is not consumed, it may be decoded as usual afterwards.
+bool mdif_rpc_response(struct mdif_rpc *rpc, const uint8_t *buf, uint32_t size);
+
+// Complete all calls with ECANCELED, e.g. when the connection is reset
+void mdif_rpc_cancel(struct mdif_rpc *rpc);
+
+#endif // _MDIF_RPC_H
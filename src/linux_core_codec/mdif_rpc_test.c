@@ -0,0 +1,244 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_rpc_test.c                                              *
+ *                                                                             *
+ * Description  : Test of request/response matching, timeouts and in flight    *
+ *              : cap of mdif_rpc.                                             *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "mdif_buf.h"
+#include "mdif_router.h"
+#include "mdif_rpc.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Field numbers of the requests and responses used, see rpc_fields in
+// mdif_rpc.c
+#define PING_REQ 0x001
+#define PING_RES 0x002
+#define RESET_REQ 0x003
+#define RESET_RES 0x004
+
+#define TICK_MS 10
+#define TIMEOUT_MS 100
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+static struct mdif_rpc_wheel wheel;
+
+// Fields of the requests sent, in order
+static uint32_t sent[16];
+static unsigned n_sent;
+static int sent_locked; // Sent with the wheel lock held
+static struct mdif_rpc *reissue; // Issue a reset request from send()
+
+// Callbacks, in order: the ctx of each call and its error
+static int done_id[16];
+static int done_err[16];
+static unsigned n_done;
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static int call(struct mdif_rpc *rpc, uint32_t field, int id);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Encoded message with an empty submessage in oneof field `field`
+static uint8_t *msg(uint32_t field, uint32_t *size) {
+    uint8_t enc[8];
+    uint32_t n = 0;
+    uint32_t tag = field << 3 | 2;
+    while (tag >= 0x80) {
+        enc[n++] = tag | 0x80;
+        tag >>= 7;
+    }
+    enc[n++] = tag;
+    enc[n++] = 0;
+    *size = n;
+    return mdif_buf_copy(enc, n);
+}
+
+static void send(uint8_t *buf, uint32_t size, void *ctx) {
+    if (pthread_mutex_trylock(&wheel.lock) == 0) {
+        pthread_mutex_unlock(&wheel.lock);
+    } else {
+        sent_locked++;
+    }
+    if (n_sent < sizeof(sent) / sizeof(sent[0])) {
+        sent[n_sent++] = mdif_msg_field(buf, size);
+    }
+    mdif_buf_free(buf);
+    if (reissue) {
+        struct mdif_rpc *rpc = reissue;
+        reissue = NULL;
+        call(rpc, RESET_REQ, 9);
+    }
+}
+
+static void done(const uint8_t *res, uint32_t size, int err, void *ctx) {
+    if (n_done < sizeof(done_id) / sizeof(done_id[0])) {
+        done_id[n_done] = (int)(intptr_t)ctx;
+        done_err[n_done++] = err;
+    }
+}
+
+static int call(struct mdif_rpc *rpc, uint32_t field, int id) {
+    uint32_t size;
+    uint8_t *buf = msg(field, &size);
+    int rtn = mdif_rpc_call(rpc, buf, size, TIMEOUT_MS, done, (void *)(intptr_t)id);
+    if (rtn == -1) {
+        mdif_buf_free(buf);
+    }
+    return rtn;
+}
+
+static bool respond(struct mdif_rpc *rpc, uint32_t field) {
+    uint32_t size;
+    uint8_t *buf = msg(field, &size);
+    bool matched = mdif_rpc_response(rpc, buf, size);
+    mdif_buf_free(buf);
+    return matched;
+}
+
+// Start over with a new wheel, at the current time
+static void reset(struct mdif_rpc *rpc, unsigned max_in_flight, unsigned max_pending) {
+    n_sent = 0;
+    n_done = 0;
+    mdif_rpc_wheel_init(&wheel, TICK_MS);
+    mdif_rpc_init(rpc, &wheel, max_in_flight, max_pending, send, NULL);
+}
+
+int main(void) {
+    int fails = 0;
+    struct mdif_rpc rpc;
+
+    // Responses are matched to the oldest request of their type
+    reset(&rpc, 4, 0);
+    call(&rpc, PING_REQ, 1);
+    call(&rpc, PING_REQ, 2);
+    call(&rpc, RESET_REQ, 3);
+    CHECK("fifo: all sent in order",
+          n_sent == 3 && sent[0] == PING_REQ && sent[1] == PING_REQ && sent[2] == RESET_REQ);
+    CHECK("fifo: match by type", respond(&rpc, RESET_RES) && n_done == 1 && done_id[0] == 3 && done_err[0] == 0);
+    respond(&rpc, PING_RES);
+    respond(&rpc, PING_RES);
+    CHECK("fifo: same type in order", n_done == 3 && done_id[1] == 1 && done_id[2] == 2);
+    CHECK("fifo: unsolicited response", !respond(&rpc, PING_RES) && n_done == 3);
+    CHECK("send without wheel lock", sent_locked == 0);
+    mdif_rpc_free(&rpc);
+
+    // send() may issue new requests, which are sent after its own
+    reset(&rpc, 4, 0);
+    reissue = &rpc;
+    call(&rpc, PING_REQ, 1);
+    CHECK("reissue: sent in order", n_sent == 2 && sent[0] == PING_REQ && sent[1] == RESET_REQ);
+    mdif_rpc_free(&rpc);
+
+    // At most max_in_flight are sent, and max_pending queued
+    reset(&rpc, 2, 2);
+    for (int i = 1; i <= 4; i++) {
+        call(&rpc, PING_REQ, i);
+    }
+    CHECK("cap: in flight", n_sent == 2);
+    CHECK("cap: pending full", call(&rpc, PING_REQ, 5) == -1 && errno == EAGAIN);
+    respond(&rpc, PING_RES);
+    CHECK("cap: queued sent on response", n_sent == 3 && n_done == 1 && done_id[0] == 1);
+    mdif_rpc_free(&rpc);
+    CHECK("cap: cancel on free", n_done == 4 && done_id[1] == 2 && done_err[1] == ECANCELED && done_id[3] == 4);
+
+    // A response arriving after the timeout is not taken for the response to
+    // a later request of its type
+    reset(&rpc, 3, 0);
+    uint64_t now = monotonic_ms();
+    call(&rpc, PING_REQ, 1);
+    call(&rpc, RESET_REQ, 2);
+    mdif_rpc_wheel_advance(&wheel, now + 2 * TIMEOUT_MS);
+    CHECK("late: timed out", n_done == 2 && done_err[0] == ETIMEDOUT && done_err[1] == ETIMEDOUT);
+    call(&rpc, PING_REQ, 3);
+    CHECK("late: sent after timed out call", n_sent == 3);
+    CHECK("late: response consumed", respond(&rpc, PING_RES) && n_done == 2);
+    respond(&rpc, PING_RES);
+    CHECK("late: next response matched", n_done == 3 && done_id[2] == 3 && done_err[2] == 0);
+    // The timed out reset keeps its place until a second timeout
+    mdif_rpc_wheel_advance(&wheel, now + 5 * TIMEOUT_MS);
+    CHECK("late: released after second timeout", !respond(&rpc, RESET_RES) && n_done == 3);
+    mdif_rpc_free(&rpc);
+
+    // Queued requests time out without being sent
+    reset(&rpc, 1, 2);
+    now = monotonic_ms();
+    call(&rpc, PING_REQ, 1);
+    call(&rpc, RESET_REQ, 2);
+    mdif_rpc_wheel_advance(&wheel, now + 2 * TIMEOUT_MS);
+    CHECK("pending: timed out unsent",
+          n_sent == 1 && n_done == 2 && done_err[0] == ETIMEDOUT && done_err[1] == ETIMEDOUT);
+    mdif_rpc_free(&rpc);
+
+    return fails ? 1 : 0;
+}
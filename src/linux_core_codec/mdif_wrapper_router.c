@@ -0,0 +1,286 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_wrapper_router.c                                        *
+ *                                                                             *
+ * Description  : Forwarding of WrapperMsgInd payloads to daisy chained        *
+ *              : devices.                                                     *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "linux_fast_decode/mdif_fast_wire.h"
+#include "mdif_wrapper_router.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// CoreMsg oneof members, see core.proto
+#define FIELD_DEVICE_ANNOUNCE_IND 22
+#define FIELD_DISCONNECT_IND      23
+#define FIELD_WRAPPER_MSG_IND     24
+// DeviceInfo.serial_number and DisconnectInd.serial_number
+#define FIELD_SERIAL_NUMBER 1
+// WrapperMsgInd.receiver and WrapperMsgInd.payload
+#define FIELD_RECEIVER 1
+#define FIELD_PAYLOAD  5
+
+#define WIRETYPE_VARINT           0
+#define WIRETYPE_FIXED64          1
+#define WIRETYPE_LENGTH_DELIMITED 2
+#define WIRETYPE_FIXED32          5
+
+#define SLOT_MASK (MDIF_WRAPPER_SLOTS - 1)
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static const uint8_t *skip_field(const uint8_t *p, const uint8_t *end, uint32_t wiretype);
+static bool find_strings(const uint8_t *p, const uint8_t *end, uint32_t field_a, struct mdif_fast_bytes *a,
+                         uint32_t field_b, struct mdif_fast_bytes *b);
+static uint32_t hash_serial(const uint8_t *s, uint32_t len);
+static struct mdif_wrapper_device *find(struct mdif_wrapper_router *r, const uint8_t *s, uint32_t len,
+                                        uint32_t hash);
+static int add_device(struct mdif_wrapper_router *r, const uint8_t *s, uint32_t len,
+                      mdif_wrapper_handler_t handler, void *ctx, bool replace);
+static int remove_serial(struct mdif_wrapper_router *r, const uint8_t *s, uint32_t len);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+void mdif_wrapper_router_init(struct mdif_wrapper_router *r, mdif_wrapper_handler_t handler, void *ctx) {
+    memset(r, 0, sizeof(*r));
+    r->handler = handler;
+    r->ctx = ctx;
+}
+
+mdif_wrapper_route_t mdif_wrapper_route(struct mdif_wrapper_router *r, const uint8_t *buf, uint32_t size) {
+    const uint8_t *end = buf + size;
+    uint64_t tag;
+    const uint8_t *p = mdif_fast_varint(buf, end, &tag);
+    if (!p || (tag & 7) != WIRETYPE_LENGTH_DELIMITED) {
+        return MDIF_WRAPPER_NOT_WRAPPER;
+    }
+    uint32_t field = tag >> 3;
+    if (field != FIELD_WRAPPER_MSG_IND && field != FIELD_DEVICE_ANNOUNCE_IND && field != FIELD_DISCONNECT_IND) {
+        return MDIF_WRAPPER_NOT_WRAPPER;
+    }
+    struct mdif_fast_bytes msg;
+    if (!mdif_fast_delim(p, end, &msg)) {
+        return field == FIELD_WRAPPER_MSG_IND ? MDIF_WRAPPER_MALFORMED : MDIF_WRAPPER_NOT_WRAPPER;
+    }
+    const uint8_t *msg_end = msg.data + msg.len;
+
+    if (field != FIELD_WRAPPER_MSG_IND) {
+        struct mdif_fast_bytes serial = {0};
+        if (find_strings(msg.data, msg_end, FIELD_SERIAL_NUMBER, &serial, 0, NULL) && serial.len) {
+            if (field == FIELD_DEVICE_ANNOUNCE_IND) {
+                // A device announced again keeps the handler bound to it
+                add_device(r, serial.data, serial.len, r->handler, r->ctx, false);
+            } else {
+                remove_serial(r, serial.data, serial.len);
+            }
+        }
+        return MDIF_WRAPPER_NOT_WRAPPER;
+    }
+
+    struct mdif_fast_bytes receiver = {0}, payload = {0};
+    if (!find_strings(msg.data, msg_end, FIELD_RECEIVER, &receiver, FIELD_PAYLOAD, &payload)) {
+        return MDIF_WRAPPER_MALFORMED;
+    }
+    struct mdif_wrapper_device *dev = find(r, receiver.data, receiver.len, hash_serial(receiver.data, receiver.len));
+    if (!dev || !dev->handler) {
+        return MDIF_WRAPPER_UNKNOWN;
+    }
+    dev->handler(dev->serial, payload.data, payload.len, dev->ctx);
+    return MDIF_WRAPPER_ROUTED;
+}
+
+int mdif_wrapper_router_bind(struct mdif_wrapper_router *r, const char *serial, mdif_wrapper_handler_t handler,
+                             void *ctx) {
+    return add_device(r, (const uint8_t *)serial, strlen(serial), handler, ctx, true);
+}
+
+int mdif_wrapper_router_remove(struct mdif_wrapper_router *r, const char *serial) {
+    return remove_serial(r, (const uint8_t *)serial, strlen(serial));
+}
+
+// Skip the value of a field with `wiretype`. Returns NULL if malformed.
+static const uint8_t *skip_field(const uint8_t *p, const uint8_t *end, uint32_t wiretype) {
+    uint64_t v;
+    struct mdif_fast_bytes b;
+    switch (wiretype) {
+    case WIRETYPE_VARINT:
+        return mdif_fast_varint(p, end, &v);
+    case WIRETYPE_FIXED64:
+        return end - p < 8 ? NULL : p + 8;
+    case WIRETYPE_LENGTH_DELIMITED:
+        return mdif_fast_delim(p, end, &b);
+    case WIRETYPE_FIXED32:
+        return end - p < 4 ? NULL : p + 4;
+    default:
+        // Groups are not used by MDIF
+        return NULL;
+    }
+}
+
+// Scan a message for up to two length delimited fields, skipping all others.
+// As protobuf, the last occurrence of a field wins. Returns false if the
+// message is malformed.
+static bool find_strings(const uint8_t *p, const uint8_t *end, uint32_t field_a, struct mdif_fast_bytes *a,
+                         uint32_t field_b, struct mdif_fast_bytes *b) {
+    while (p < end) {
+        uint64_t tag;
+        p = mdif_fast_varint(p, end, &tag);
+        if (!p) {
+            return false;
+        }
+        uint32_t field = tag >> 3, wiretype = tag & 7;
+        if (wiretype == WIRETYPE_LENGTH_DELIMITED && field == field_a) {
+            p = mdif_fast_delim(p, end, a);
+        } else if (wiretype == WIRETYPE_LENGTH_DELIMITED && b && field == field_b) {
+            p = mdif_fast_delim(p, end, b);
+        } else {
+            p = skip_field(p, end, wiretype);
+        }
+        if (!p) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// FNV-1a
+static uint32_t hash_serial(const uint8_t *s, uint32_t len) {
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < len; i++) {
+        h = (h ^ s[i]) * 16777619u;
+    }
+    return h;
+}
+
+// Open addressing with linear probing. The table is at most half full, so a
+// probe sequence is short and always ends at a free slot.
+static struct mdif_wrapper_device *find(struct mdif_wrapper_router *r, const uint8_t *s, uint32_t len,
+                                        uint32_t hash) {
+    if (len == 0 || len > MDIF_WRAPPER_SERIAL_MAX) {
+        return NULL;
+    }
+    for (uint32_t i = hash & SLOT_MASK;; i = (i + 1) & SLOT_MASK) {
+        struct mdif_wrapper_device *dev = &r->slots[i];
+        if (dev->len == 0) {
+            return NULL;
+        }
+        if (dev->hash == hash && dev->len == len && memcmp(dev->serial, s, len) == 0) {
+            return dev;
+        }
+    }
+}
+
+static int add_device(struct mdif_wrapper_router *r, const uint8_t *s, uint32_t len,
+                      mdif_wrapper_handler_t handler, void *ctx, bool replace) {
+    if (len == 0 || len > MDIF_WRAPPER_SERIAL_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    uint32_t hash = hash_serial(s, len);
+    struct mdif_wrapper_device *dev = find(r, s, len, hash);
+    if (dev) {
+        if (replace) {
+            dev->handler = handler;
+            dev->ctx = ctx;
+        }
+        return 0;
+    }
+    if (r->count == MDIF_WRAPPER_MAX_DEVICES) {
+        errno = ENOSPC;
+        return -1;
+    }
+    uint32_t i = hash & SLOT_MASK;
+    while (r->slots[i].len) {
+        i = (i + 1) & SLOT_MASK;
+    }
+    dev = &r->slots[i];
+    dev->hash = hash;
+    dev->len = len;
+    memcpy(dev->serial, s, len);
+    dev->serial[len] = '\0';
+    dev->handler = handler;
+    dev->ctx = ctx;
+    r->count++;
+    return 0;
+}
+
+// Removal shifts later entries of the probe sequence back into the freed slot,
+// so no tombstones are needed.
+static int remove_serial(struct mdif_wrapper_router *r, const uint8_t *s, uint32_t len) {
+    struct mdif_wrapper_device *dev = find(r, s, len, hash_serial(s, len));
+    if (!dev) {
+        errno = ENOENT;
+        return -1;
+    }
+    uint32_t hole = dev - r->slots;
+    for (uint32_t i = (hole + 1) & SLOT_MASK; r->slots[i].len; i = (i + 1) & SLOT_MASK) {
+        // Move entry i to the hole unless its home slot lies cyclically in
+        // (hole, i], in which case it must stay after its home.
+        uint32_t home = r->slots[i].hash & SLOT_MASK;
+        if (((i - home) & SLOT_MASK) >= ((i - hole) & SLOT_MASK)) {
+            r->slots[hole] = r->slots[i];
+            hole = i;
+        }
+    }
+    r->slots[hole].len = 0;
+    r->count--;
+    return 0;
+}
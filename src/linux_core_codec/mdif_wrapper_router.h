@@ -0,0 +1,118 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_wrapper_router.h                                        *
+ *                                                                             *
+ * Description  : Forwarding of WrapperMsgInd payloads to daisy chained        *
+ *              : devices.                                                     *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_WRAPPER_ROUTER_H
+#define _MDIF_WRAPPER_ROUTER_H
+
+#include <stdint.h>
+
+// Devices on a serial/HDLC daisy chain are addressed by serial number in a
+// WrapperMsgInd. The router reads only the tags of each core message: devices
+// are learned from DeviceAnnounceInd and forgotten on DisconnectInd, and the
+// payload of a WrapperMsgInd is passed to the handler of its receiver as a
+// view into the message, without unpacking or re-encoding it.
+//
+// No protobuf dependency. Not thread safe, use it from the receiving thread.
+
+// Longest serial number kept. Longer ones are not learned.
+#define MDIF_WRAPPER_SERIAL_MAX 31
+// Number of table slots, power of 2. At most half are used.
+#define MDIF_WRAPPER_SLOTS 64
+#define MDIF_WRAPPER_MAX_DEVICES (MDIF_WRAPPER_SLOTS / 2)
+
+// Called with the payload of a WrapperMsgInd for `receiver`. `payload` points
+// into the routed message and is only valid during the call.
+typedef void (*mdif_wrapper_handler_t)(const char *receiver, const uint8_t *payload, uint32_t size, void *ctx);
+
+struct mdif_wrapper_device {
+    uint32_t hash;
+    uint8_t len; // 0 if slot is free
+    char serial[MDIF_WRAPPER_SERIAL_MAX + 1];
+    mdif_wrapper_handler_t handler;
+    void *ctx;
+};
+
+// Zero initialized, apart from the handler, is a valid empty router
+struct mdif_wrapper_router {
+    // Handler of learned devices, until another is set by
+    // mdif_wrapper_router_bind(). May be NULL.
+    mdif_wrapper_handler_t handler;
+    void *ctx;
+    uint32_t count;
+    struct mdif_wrapper_device slots[MDIF_WRAPPER_SLOTS];
+};
+
+typedef enum {
+    MDIF_WRAPPER_NOT_WRAPPER = 0, // Not a WrapperMsgInd, decode it as usual
+    MDIF_WRAPPER_ROUTED,          // Payload passed to the receiver's handler
+    MDIF_WRAPPER_UNKNOWN,         // Receiver unknown, or has no handler
+    MDIF_WRAPPER_MALFORMED,       // Truncated or malformed WrapperMsgInd
+} mdif_wrapper_route_t;
+
+void mdif_wrapper_router_init(struct mdif_wrapper_router *r, mdif_wrapper_handler_t handler, void *ctx);
+
+// Route a core message. DeviceAnnounceInd and DisconnectInd update the device
+// table and, like all messages except WrapperMsgInd, return
+// MDIF_WRAPPER_NOT_WRAPPER so the caller still decodes them.
+mdif_wrapper_route_t mdif_wrapper_route(struct mdif_wrapper_router *r, const uint8_t *buf, uint32_t size);
+
+// Add device `serial`, or change its handler. Returns -1 with errno EINVAL if
+// the serial number is too long, or ENOSPC if the table is full.
+int mdif_wrapper_router_bind(struct mdif_wrapper_router *r, const char *serial, mdif_wrapper_handler_t handler,
+                             void *ctx);
+
+// Remove device `serial`. Returns -1 with errno ENOENT if not known.
+int mdif_wrapper_router_remove(struct mdif_wrapper_router *r, const char *serial);
+
+#endif // _MDIF_WRAPPER_ROUTER_H
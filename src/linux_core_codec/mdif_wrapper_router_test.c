@@ -0,0 +1,244 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_wrapper_router_test.c                                   *
+ *                                                                             *
+ * Description  : Tests of mdif_wrapper_router: routing, removal in a          *
+ *              : collision chain and a full table                             *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "mdif_wrapper_router.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// CoreMsg oneof members, see core.proto
+#define FIELD_DEVICE_ANNOUNCE_IND 22
+#define FIELD_DISCONNECT_IND      23
+#define FIELD_WRAPPER_MSG_IND     24
+
+#define SLOT_MASK (MDIF_WRAPPER_SLOTS - 1)
+// Home slot of the collision chain. The chain wraps around the end.
+#define CHAIN_HOME (MDIF_WRAPPER_SLOTS - 2)
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+static struct mdif_wrapper_router router;
+
+// Last payload routed
+static char routed_to[MDIF_WRAPPER_SERIAL_MAX + 1];
+static int routed;
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static void handler(const char *receiver, const uint8_t *payload, uint32_t size, void *ctx) {
+    strcpy(routed_to, receiver);
+    routed++;
+}
+
+// A length delimited field, with a one byte length
+static uint32_t put_field(uint8_t *buf, uint32_t field, const void *data, uint32_t len) {
+    uint32_t n = 0;
+    uint32_t tag = field << 3 | 2;
+    while (tag >= 0x80) {
+        buf[n++] = tag | 0x80;
+        tag >>= 7;
+    }
+    buf[n++] = tag;
+    buf[n++] = len;
+    memcpy(buf + n, data, len);
+    return n + len;
+}
+
+// CoreMsg with `field` set to a message with only the string `s` in field 1,
+// i.e. DeviceInfo.serial_number, DisconnectInd.serial_number or
+// WrapperMsgInd.receiver
+static uint32_t core_msg(uint8_t *buf, uint32_t field, const char *s) {
+    uint8_t inner[64];
+    uint32_t n = put_field(inner, 1, s, strlen(s));
+    if (field == FIELD_WRAPPER_MSG_IND) {
+        n += put_field(inner + n, 5, "\x08\x01", 2);
+    }
+    return put_field(buf, field, inner, n);
+}
+
+static mdif_wrapper_route_t route(uint32_t field, const char *s) {
+    uint8_t buf[80];
+    return mdif_wrapper_route(&router, buf, core_msg(buf, field, s));
+}
+
+// Routed to its own handler, i.e. found in the table
+static bool reachable(const char *serial) {
+    routed = 0;
+    return route(FIELD_WRAPPER_MSG_IND, serial) == MDIF_WRAPPER_ROUTED && routed == 1 &&
+           strcmp(routed_to, serial) == 0;
+}
+
+static int slot_of(const char *serial) {
+    for (int i = 0; i < MDIF_WRAPPER_SLOTS; i++) {
+        if (router.slots[i].len && strcmp(router.slots[i].serial, serial) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Home slot of a serial number, found by adding it to an empty router
+static uint32_t home_of(const char *serial) {
+    mdif_wrapper_router_init(&router, handler, NULL);
+    mdif_wrapper_router_bind(&router, serial, handler, NULL);
+    return router.slots[slot_of(serial)].hash & SLOT_MASK;
+}
+
+int main(void) {
+    int fails = 0;
+
+    mdif_wrapper_router_init(&router, handler, NULL);
+    CHECK("announced device is learned", route(FIELD_DEVICE_ANNOUNCE_IND, "SN1") == MDIF_WRAPPER_NOT_WRAPPER &&
+                                             router.count == 1 && reachable("SN1"));
+    CHECK("unknown receiver", route(FIELD_WRAPPER_MSG_IND, "SN2") == MDIF_WRAPPER_UNKNOWN);
+    CHECK("disconnected device is forgotten",
+          route(FIELD_DISCONNECT_IND, "SN1") == MDIF_WRAPPER_NOT_WRAPPER && router.count == 0 &&
+              route(FIELD_WRAPPER_MSG_IND, "SN1") == MDIF_WRAPPER_UNKNOWN);
+    uint8_t buf[80];
+    uint32_t n = core_msg(buf, FIELD_WRAPPER_MSG_IND, "SN1");
+    CHECK("truncated wrapper is malformed", mdif_wrapper_route(&router, buf, n - 1) == MDIF_WRAPPER_MALFORMED);
+    errno = 0;
+    CHECK("empty serial is not bound", mdif_wrapper_router_bind(&router, "", handler, NULL) == -1 && errno == EINVAL);
+    errno = 0;
+    CHECK("too long serial is not bound",
+          mdif_wrapper_router_bind(&router, "0123456789012345678901234567890123", handler, NULL) == -1 &&
+              errno == EINVAL);
+
+    // Three serial numbers with home CHAIN_HOME, and one with the next home,
+    // placed after them in the chain
+    char chain[4][16];
+    int found = 0;
+    for (int i = 0; found < 3 && i < 100000; i++) {
+        snprintf(chain[found], sizeof(chain[found]), "SN%d", i);
+        found += home_of(chain[found]) == CHAIN_HOME;
+    }
+    for (int i = 0; found < 4 && i < 100000; i++) {
+        snprintf(chain[found], sizeof(chain[found]), "SN%d", i);
+        found += home_of(chain[found]) == ((CHAIN_HOME + 1) & SLOT_MASK);
+    }
+    CHECK("colliding serial numbers found", found == 4);
+
+    mdif_wrapper_router_init(&router, handler, NULL);
+    for (int i = 0; i < 4; i++) {
+        mdif_wrapper_router_bind(&router, chain[i], handler, NULL);
+    }
+    bool good = true;
+    for (int i = 0; i < 4; i++) {
+        good &= slot_of(chain[i]) == ((CHAIN_HOME + i) & SLOT_MASK) && reachable(chain[i]);
+    }
+    CHECK("collisions are placed after their home, wrapping around", good);
+
+    // Removing the head shifts all back, the last one into the slot before
+    // its home
+    CHECK("remove head of chain", mdif_wrapper_router_remove(&router, chain[0]) == 0 && router.count == 3);
+    good = !reachable(chain[0]);
+    for (int i = 1; i < 4; i++) {
+        good &= slot_of(chain[i]) == ((CHAIN_HOME + i - 1) & SLOT_MASK) && reachable(chain[i]);
+    }
+    CHECK("chain shifted back after head removed", good);
+
+    // Removing the middle one shifts the last back to its home
+    CHECK("remove middle of chain", mdif_wrapper_router_remove(&router, chain[2]) == 0 && router.count == 2);
+    good = !reachable(chain[2]) && slot_of(chain[1]) == CHAIN_HOME &&
+           slot_of(chain[3]) == ((CHAIN_HOME + 1) & SLOT_MASK) && reachable(chain[1]) && reachable(chain[3]);
+    CHECK("last shifted back to its home", good);
+    errno = 0;
+    CHECK("removed twice", mdif_wrapper_router_remove(&router, chain[2]) == -1 && errno == ENOENT);
+
+    // Added again after the last. When the head is removed, the last stays at
+    // its home, and the one after it is shifted past it into the hole.
+    mdif_wrapper_router_bind(&router, chain[0], handler, NULL);
+    CHECK("remove head before entry at its home", mdif_wrapper_router_remove(&router, chain[1]) == 0);
+    good = slot_of(chain[3]) == ((CHAIN_HOME + 1) & SLOT_MASK) && slot_of(chain[0]) == CHAIN_HOME &&
+           reachable(chain[0]) && reachable(chain[3]) && router.count == 2;
+    CHECK("entry at its home is not moved before it", good);
+
+    // Full table
+    mdif_wrapper_router_init(&router, handler, NULL);
+    char serial[16];
+    good = true;
+    for (int i = 0; i < MDIF_WRAPPER_MAX_DEVICES; i++) {
+        snprintf(serial, sizeof(serial), "SN%d", i);
+        good &= mdif_wrapper_router_bind(&router, serial, handler, NULL) == 0;
+    }
+    CHECK("table filled", good && router.count == MDIF_WRAPPER_MAX_DEVICES);
+    errno = 0;
+    CHECK("bind to full table", mdif_wrapper_router_bind(&router, "SNX", handler, NULL) == -1 && errno == ENOSPC);
+    CHECK("announce to full table is ignored",
+          route(FIELD_DEVICE_ANNOUNCE_IND, "SNX") == MDIF_WRAPPER_NOT_WRAPPER &&
+              router.count == MDIF_WRAPPER_MAX_DEVICES && !reachable("SNX"));
+    CHECK("known device rebound in full table", mdif_wrapper_router_bind(&router, "SN0", handler, NULL) == 0);
+    good = true;
+    for (int i = 0; i < MDIF_WRAPPER_MAX_DEVICES; i++) {
+        snprintf(serial, sizeof(serial), "SN%d", i);
+        good &= reachable(serial);
+    }
+    CHECK("all devices of full table reachable", good);
+    CHECK("bind after remove from full table", mdif_wrapper_router_remove(&router, "SN5") == 0 &&
+                                                   mdif_wrapper_router_bind(&router, "SNX", handler, NULL) == 0 &&
+                                                   reachable("SNX") && !reachable("SN5"));
+
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,337 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : drone_cache.c                                                *
+ *                                                                             *
+ * Description  : Memory mapped cache of the drone library of a RF sensor.     *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "drone_cache.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Fibonacci hashing, the top bits of the product
+#define SLOT(type_id, bits) ((uint32_t)((type_id) * 2654435761u) >> (32 - (bits)))
+
+/*******************************************************************************
+ *                      Enumerations/Type definitions/Structs
+ *******************************************************************************/
+// String table being built. Names repeat, e.g. the vendor, so each string is
+// stored once.
+struct strtab {
+    char *buf;
+    uint32_t size;
+    uint32_t cap;
+};
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static uint32_t slot_bits(uint32_t count);
+static int64_t strtab_add(struct strtab *t, const char *s);
+static int write_all(int fd, const void *buf, size_t len);
+static bool valid_str(const struct drone_cache *c, uint32_t off);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+int drone_cache_write(const char *path, const char *sw_version, const struct drone_cache_info *infos,
+                      uint32_t count) {
+    if (count > DRONE_CACHE_MAX_ENTRIES || strlen(sw_version) >= DRONE_CACHE_MAX_SW_VERSION) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct drone_cache_header hdr = {
+        .magic = DRONE_CACHE_MAGIC,
+        .version = DRONE_CACHE_VERSION,
+        .count = count,
+        .slot_bits = slot_bits(count),
+    };
+    strcpy(hdr.sw_version, sw_version);
+    uint32_t slots = 1u << hdr.slot_bits;
+
+    struct drone_cache_entry *entries = calloc(count ? count : 1, sizeof(*entries));
+    uint16_t *index = calloc(slots, sizeof(*index));
+    struct strtab t = {0};
+    int ret = -1;
+    if (!entries || !index) {
+        goto out;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const struct drone_cache_info *in = &infos[i];
+        int64_t type_id_name = strtab_add(&t, in->type_id_name);
+        int64_t drone_name = strtab_add(&t, in->drone_name);
+        int64_t vendor_id_name = strtab_add(&t, in->vendor_id_name);
+        if (type_id_name < 0 || drone_name < 0 || vendor_id_name < 0) {
+            goto out;
+        }
+        entries[i] = (struct drone_cache_entry){
+            .type_id = in->type_id,
+            .vendor_id = in->vendor_id,
+            .type_id_name = type_id_name,
+            .drone_name = drone_name,
+            .vendor_id_name = vendor_id_name,
+            .category = in->category,
+            .bands = in->bands,
+        };
+        // Linear probing. The index is at most half full.
+        uint32_t s = SLOT(in->type_id, hdr.slot_bits);
+        while (index[s]) {
+            if (entries[index[s] - 1].type_id == in->type_id) {
+                // Duplicate, keep the first
+                break;
+            }
+            s = (s + 1) & (slots - 1);
+        }
+        if (!index[s]) {
+            index[s] = i + 1;
+        }
+    }
+    hdr.strings_size = t.size;
+
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, getpid()) >= (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        goto out;
+    }
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        goto out;
+    }
+    if (write_all(fd, &hdr, sizeof(hdr)) == -1 || write_all(fd, entries, count * sizeof(*entries)) == -1 ||
+        write_all(fd, index, slots * sizeof(*index)) == -1 || write_all(fd, t.buf, t.size) == -1 ||
+        fsync(fd) == -1) {
+        int err = errno;
+        close(fd);
+        unlink(tmp);
+        errno = err;
+        goto out;
+    }
+    close(fd);
+    if (rename(tmp, path) == -1) {
+        int err = errno;
+        unlink(tmp);
+        errno = err;
+        goto out;
+    }
+    ret = 0;
+
+out:
+    free(entries);
+    free(index);
+    free(t.buf);
+    return ret;
+}
+
+int drone_cache_open(struct drone_cache *c, const char *path, const char *sw_version) {
+    memset(c, 0, sizeof(*c));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(struct drone_cache_header)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    c->map = map;
+    c->size = st.st_size;
+    c->hdr = map;
+
+    // Check everything once, so lookups need not
+    const struct drone_cache_header *hdr = c->hdr;
+    if (hdr->magic != DRONE_CACHE_MAGIC || hdr->version != DRONE_CACHE_VERSION ||
+        strncmp(hdr->sw_version, sw_version, DRONE_CACHE_MAX_SW_VERSION) != 0 ||
+        hdr->count > DRONE_CACHE_MAX_ENTRIES || hdr->slot_bits != slot_bits(hdr->count)) {
+        goto invalid;
+    }
+    size_t slots = (size_t)1 << hdr->slot_bits;
+    size_t entries_off = sizeof(*hdr);
+    size_t index_off = entries_off + hdr->count * sizeof(struct drone_cache_entry);
+    size_t strings_off = index_off + slots * sizeof(uint16_t);
+    if (strings_off + hdr->strings_size != c->size) {
+        goto invalid;
+    }
+    c->entries = (const struct drone_cache_entry *)((const uint8_t *)map + entries_off);
+    c->index = (const uint16_t *)((const uint8_t *)map + index_off);
+    c->strings = (const char *)map + strings_off;
+    if (hdr->strings_size && c->strings[hdr->strings_size - 1] != '\0') {
+        goto invalid;
+    }
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        const struct drone_cache_entry *e = &c->entries[i];
+        if (!valid_str(c, e->type_id_name) || !valid_str(c, e->drone_name) || !valid_str(c, e->vendor_id_name)) {
+            goto invalid;
+        }
+    }
+    for (size_t s = 0; s < slots; s++) {
+        if (c->index[s] > hdr->count) {
+            goto invalid;
+        }
+    }
+    return 0;
+
+invalid:
+    drone_cache_close(c);
+    errno = EINVAL;
+    return -1;
+}
+
+void drone_cache_close(struct drone_cache *c) {
+    if (c->map) {
+        munmap(c->map, c->size);
+    }
+    memset(c, 0, sizeof(*c));
+}
+
+const struct drone_cache_entry *drone_cache_find(const struct drone_cache *c, uint32_t type_id) {
+    uint32_t mask = (1u << c->hdr->slot_bits) - 1;
+    // At most half the slots are used, so there is always a free one
+    for (uint32_t s = SLOT(type_id, c->hdr->slot_bits); c->index[s]; s = (s + 1) & mask) {
+        const struct drone_cache_entry *e = &c->entries[c->index[s] - 1];
+        if (e->type_id == type_id) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+void drone_cache_get(const struct drone_cache *c, const struct drone_cache_entry *e, struct drone_cache_info *info) {
+    *info = (struct drone_cache_info){
+        .type_id = e->type_id,
+        .vendor_id = e->vendor_id,
+        .type_id_name = c->strings + e->type_id_name,
+        .drone_name = c->strings + e->drone_name,
+        .vendor_id_name = c->strings + e->vendor_id_name,
+        .category = e->category,
+        .bands = e->bands,
+    };
+}
+
+// Index slots for `count` entries: a power of 2, at least twice the count
+static uint32_t slot_bits(uint32_t count) {
+    uint32_t bits = 1;
+    while ((1u << bits) < 2 * count) {
+        bits++;
+    }
+    return bits;
+}
+
+// Offset of `s` in the table, added if not there. Returns -1 if out of
+// memory.
+static int64_t strtab_add(struct strtab *t, const char *s) {
+    if (!s) {
+        s = "";
+    }
+    for (uint32_t off = 0; off < t->size; off += strlen(t->buf + off) + 1) {
+        if (strcmp(t->buf + off, s) == 0) {
+            return off;
+        }
+    }
+    uint32_t len = strlen(s) + 1;
+    if (t->size + len > t->cap) {
+        uint32_t cap = t->cap ? t->cap * 2 : 1024;
+        while (cap < t->size + len) {
+            cap *= 2;
+        }
+        char *buf = realloc(t->buf, cap);
+        if (!buf) {
+            return -1;
+        }
+        t->buf = buf;
+        t->cap = cap;
+    }
+    memcpy(t->buf + t->size, s, len);
+    t->size += len;
+    return t->size - len;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf = (const uint8_t *)buf + n;
+        len -= n;
+    }
+    return 0;
+}
+
+// String at `off` is within the strings, which end with a NUL
+static bool valid_str(const struct drone_cache *c, uint32_t off) {
+    return off < c->hdr->strings_size;
+}
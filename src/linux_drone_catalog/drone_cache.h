@@ -0,0 +1,140 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : drone_cache.h                                                *
+ *                                                                             *
+ * Description  : Memory mapped cache of the drone library of a RF sensor.     *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _DRONE_CACHE_H
+#define _DRONE_CACHE_H
+
+// The DroneInfo library of a RF sensor only changes with its firmware, so it
+// is stored in a file per sw_version and mapped read only. The file holds the
+// entries, a hash index of type_id for lookups in constant time, and the
+// strings:
+//
+//   struct drone_cache_header
+//   struct drone_cache_entry  entries[count]  In library order
+//   uint16_t                  index[slots]    Entry index + 1, 0 if free
+//   char                      strings[]       NUL terminated
+//
+// Integers are in host byte order, the cache is not meant to be copied between
+// machines.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DRONE_CACHE_MAGIC   0x4344444d // "MDDC"
+#define DRONE_CACHE_VERSION 1
+#define DRONE_CACHE_MAX_SW_VERSION 32
+// Entries are indexed by uint16_t
+#define DRONE_CACHE_MAX_ENTRIES 32767
+
+struct drone_cache_header {
+    uint32_t magic;
+    uint32_t version;
+    char sw_version[DRONE_CACHE_MAX_SW_VERSION];
+    uint32_t count;
+    uint32_t slot_bits; // log2 of index slots
+    uint32_t strings_size;
+};
+
+struct drone_cache_entry {
+    uint32_t type_id;
+    uint32_t vendor_id;
+    // Offsets into strings
+    uint32_t type_id_name;
+    uint32_t drone_name;
+    uint32_t vendor_id_name;
+    uint8_t category; // Mdif__Rfs__ThreatCategory
+    uint8_t bands;    // Bit (1 << Mdif__Rfs__ScanBand) for each band
+    uint16_t reserved;
+};
+
+// A DroneInfo, with strings
+struct drone_cache_info {
+    uint32_t type_id;
+    uint32_t vendor_id;
+    const char *type_id_name;
+    const char *drone_name;
+    const char *vendor_id_name;
+    uint8_t category;
+    uint8_t bands;
+};
+
+struct drone_cache {
+    void *map;
+    size_t size;
+    const struct drone_cache_header *hdr;
+    const struct drone_cache_entry *entries;
+    const uint16_t *index;
+    const char *strings;
+};
+
+// Write `count` entries for `sw_version` to `path`. The file is written under
+// a temporary name and renamed, so readers never see a partial cache. Returns
+// -1 with errno set on error.
+int drone_cache_write(const char *path, const char *sw_version, const struct drone_cache_info *infos,
+                      uint32_t count);
+
+// Map cache at `path` and check that it is for `sw_version`. Returns -1 with
+// errno set on error, ENOENT if there is no cache, or EINVAL if it is invalid
+// or for another version.
+int drone_cache_open(struct drone_cache *c, const char *path, const char *sw_version);
+void drone_cache_close(struct drone_cache *c);
+
+// Entry of `type_id`, or NULL if not in the library
+const struct drone_cache_entry *drone_cache_find(const struct drone_cache *c, uint32_t type_id);
+
+// Entry `e` with its strings
+void drone_cache_get(const struct drone_cache *c, const struct drone_cache_entry *e, struct drone_cache_info *info);
+
+#endif // _DRONE_CACHE_H
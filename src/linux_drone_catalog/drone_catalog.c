@@ -0,0 +1,403 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : drone_catalog.c                                              *
+ *                                                                             *
+ * Description  : Cached enumeration of the drone library of a RF sensor.      *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "_generated/mdif/rfs/rfs.pb-c.h"
+#include "linux_core_codec/mdif_buf.h"
+#include "drone_catalog.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Failed requests for entries in the chain before giving up
+#define MAX_FAILURES 8
+
+/*******************************************************************************
+ *                      Enumerations/Type definitions/Structs
+ *******************************************************************************/
+enum req_state {
+    REQ_IN_FLIGHT,
+    REQ_DONE,
+    REQ_FAILED,
+};
+
+struct drone_catalog_req {
+    uint32_t type_id;
+    enum req_state state;
+};
+
+// Context of a GetDroneInfoReq
+struct call {
+    struct drone_catalog *c;
+    uint32_t type_id;
+};
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static void request(struct drone_catalog *c, uint32_t type_id);
+static void drone_info_res(const uint8_t *res, uint32_t size, int err, void *ctx);
+static void add_info(struct drone_catalog *c, const Mdif__Rfs__DroneInfo *d, uint32_t next);
+static void advance(struct drone_catalog *c);
+static void finish(struct drone_catalog *c);
+static void stop(struct drone_catalog *c);
+static struct drone_catalog_req *find_req(struct drone_catalog *c, uint32_t type_id);
+static int find_info(const struct drone_catalog *c, uint32_t type_id);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+void drone_catalog_init(struct drone_catalog *c, struct mdif_rpc *rpc, const char *dir) {
+    memset(c, 0, sizeof(*c));
+    pthread_mutex_init(&c->lock, NULL);
+    c->rpc = rpc;
+    if (dir) {
+        snprintf(c->dir, sizeof(c->dir), "%s", dir);
+    } else {
+        const char *xdg = getenv("XDG_CACHE_HOME");
+        const char *home = getenv("HOME");
+        if (xdg && *xdg) {
+            snprintf(c->dir, sizeof(c->dir), "%s/mdif", xdg);
+        } else {
+            snprintf(c->dir, sizeof(c->dir), "%s/.cache/mdif", home ? home : ".");
+        }
+    }
+}
+
+void drone_catalog_start(struct drone_catalog *c, const char *sw_version) {
+    pthread_mutex_lock(&c->lock);
+    if (c->cache || c->running) {
+        pthread_mutex_unlock(&c->lock);
+        return;
+    }
+    // sw_version is part of the file name, so no '/' in it
+    snprintf(c->sw_version, sizeof(c->sw_version), "%s", sw_version);
+    int len = snprintf(c->path, sizeof(c->path), "%s/drones-", c->dir);
+    for (const char *s = c->sw_version; *s && len < (int)sizeof(c->path) - 5; s++) {
+        c->path[len++] = *s == '/' ? '_' : *s;
+    }
+    snprintf(c->path + len, sizeof(c->path) - len, ".bin");
+
+    if (drone_cache_open(&c->cache_storage, c->path, c->sw_version) == 0) {
+        printf("Drone catalog: %u entries from %s\n", c->cache_storage.hdr->count, c->path);
+        __atomic_store_n(&c->cache, &c->cache_storage, __ATOMIC_RELEASE);
+    } else {
+        if (errno != ENOENT) {
+            printf("Drone catalog: ignoring %s: %s\n", c->path, strerror(errno));
+        }
+        printf("Drone catalog: enumerating library of %s\n", c->sw_version);
+        c->running = true;
+        // 0 is the first entry
+        request(c, 0);
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+bool drone_catalog_find(const struct drone_catalog *c, uint32_t type_id, struct drone_cache_info *info) {
+    const struct drone_cache *cache = drone_catalog_cache(c);
+    if (!cache) {
+        return false;
+    }
+    const struct drone_cache_entry *e = drone_cache_find(cache, type_id);
+    if (!e) {
+        return false;
+    }
+    drone_cache_get(cache, e, info);
+    return true;
+}
+
+// Send GetDroneInfoReq. Must be called with the lock held.
+static void request(struct drone_catalog *c, uint32_t type_id) {
+    struct drone_catalog_req *r = find_req(c, type_id);
+    bool added = !r;
+    if (!r) {
+        if (c->n_reqs == c->cap_reqs) {
+            uint32_t cap = c->cap_reqs ? 2 * c->cap_reqs : 64;
+            struct drone_catalog_req *reqs = realloc(c->reqs, cap * sizeof(*reqs));
+            if (!reqs) {
+                return;
+            }
+            c->reqs = reqs;
+            c->cap_reqs = cap;
+        }
+        r = &c->reqs[c->n_reqs++];
+        r->type_id = type_id;
+    }
+    r->state = REQ_FAILED;
+
+    struct call *call = malloc(sizeof(*call));
+    if (!call) {
+        goto not_sent;
+    }
+    *call = (struct call){c, type_id};
+    Mdif__Rfs__GetDroneInfoReq req = MDIF__RFS__GET_DRONE_INFO_REQ__INIT;
+    req.type_id = type_id;
+    Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+    msg.msg_case = MDIF__RFS__RFS_MSG__MSG_GET_DRONE_INFO_REQ;
+    msg.get_drone_info_req = &req;
+    uint32_t size;
+    uint8_t *buf = mdif_buf_pack(&msg.base, &size);
+    if (!buf) {
+        free(call);
+        goto not_sent;
+    }
+    if (mdif_rpc_call(c->rpc, buf, size, DRONE_CATALOG_TIMEOUT_MS, drone_info_res, call) == -1) {
+        mdif_buf_free(buf);
+        free(call);
+        goto not_sent;
+    }
+    r->state = REQ_IN_FLIGHT;
+    return;
+
+not_sent:
+    // E.g. the pipeline is full. Not a failure of the device, so it is
+    // requested again from advance() on the next response.
+    if (added) {
+        c->n_reqs--;
+    }
+}
+
+static void drone_info_res(const uint8_t *res, uint32_t size, int err, void *ctx) {
+    struct call *call = ctx;
+    struct drone_catalog *c = call->c;
+    Mdif__Rfs__RfsMsg *msg = err ? NULL : mdif__rfs__rfs_msg__unpack(NULL, size, res);
+
+    pthread_mutex_lock(&c->lock);
+    struct drone_catalog_req *r = find_req(c, call->type_id);
+    if (r) {
+        r->state = REQ_FAILED;
+    }
+    if (msg && msg->msg_case == MDIF__RFS__RFS_MSG__MSG_GET_DRONE_INFO_RES) {
+        Mdif__Rfs__GetDroneInfoRes *info_res = msg->get_drone_info_res;
+        if (info_res->status == MDIF__COMMON__STATUS__SUCCESS && info_res->drone_info) {
+            if (r) {
+                r->state = REQ_DONE;
+            }
+            if (call->type_id == 0) {
+                c->first = info_res->drone_info->type_id;
+            }
+            if (c->running) {
+                add_info(c, info_res->drone_info, info_res->next_drone_type_id);
+            }
+        }
+    }
+    advance(c);
+    pthread_mutex_unlock(&c->lock);
+
+    if (msg) {
+        mdif__rfs__rfs_msg__free_unpacked(msg, NULL);
+    }
+    free(call);
+}
+
+// Keep a copy of DroneInfo `d`. Must be called with the lock held.
+static void add_info(struct drone_catalog *c, const Mdif__Rfs__DroneInfo *d, uint32_t next) {
+    if (find_info(c, d->type_id) >= 0 || c->n_infos == DRONE_CACHE_MAX_ENTRIES) {
+        return;
+    }
+    if (c->n_infos == c->cap_infos) {
+        uint32_t cap = c->cap_infos ? 2 * c->cap_infos : 64;
+        struct drone_cache_info *infos = realloc(c->infos, cap * sizeof(*infos));
+        if (!infos) {
+            return;
+        }
+        c->infos = infos;
+        uint32_t *n = realloc(c->next, cap * sizeof(*n));
+        if (!n) {
+            return;
+        }
+        c->next = n;
+        c->cap_infos = cap;
+    }
+    uint8_t bands = 0;
+    for (size_t i = 0; i < d->n_band; i++) {
+        if (d->band[i] < 8) {
+            bands |= 1 << d->band[i];
+        }
+    }
+    c->infos[c->n_infos] = (struct drone_cache_info){
+        .type_id = d->type_id,
+        .vendor_id = d->vendor_id,
+        .type_id_name = strdup(d->type_id_name ? d->type_id_name : ""),
+        .drone_name = strdup(d->drone_name ? d->drone_name : ""),
+        .vendor_id_name = strdup(d->vendor_id_name ? d->vendor_id_name : ""),
+        .category = d->category,
+        .bands = bands,
+    };
+    c->next[c->n_infos] = next;
+    c->n_infos++;
+}
+
+// Follow the chain as far as received, and request the missing entry and the
+// ones after it. Must be called with the lock held.
+static void advance(struct drone_catalog *c) {
+    if (!c->running) {
+        return;
+    }
+    uint32_t want = 0;
+    if (c->first) {
+        // A malformed chain could loop, so at most n_infos steps
+        uint32_t id = c->first;
+        for (uint32_t steps = 0; steps <= c->n_infos; steps++) {
+            int i = find_info(c, id);
+            if (i < 0) {
+                want = id;
+                break;
+            }
+            id = c->next[i];
+            if (id == 0) {
+                finish(c);
+                return;
+            }
+        }
+        if (!want) {
+            printf("Drone catalog: library of %s loops\n", c->sw_version);
+            stop(c);
+            return;
+        }
+    }
+
+    struct drone_catalog_req *r = find_req(c, want);
+    if (!r || r->state == REQ_FAILED) {
+        if (r && ++c->failures > MAX_FAILURES) {
+            printf("Drone catalog: failed to get type_id %u\n", want);
+            stop(c);
+            return;
+        }
+        request(c, want);
+    }
+    if (!c->first) {
+        // Nothing to guess from
+        return;
+    }
+    for (uint32_t k = 1; k <= DRONE_CATALOG_SPECULATE && want + k > want; k++) {
+        if (!find_req(c, want + k) && find_info(c, want + k) < 0) {
+            request(c, want + k);
+        }
+    }
+}
+
+// Store the entries in library order, and map the cache. Must be called with
+// the lock held.
+static void finish(struct drone_catalog *c) {
+    struct drone_cache_info *ordered = malloc((c->n_infos ? c->n_infos : 1) * sizeof(*ordered));
+    if (!ordered) {
+        stop(c);
+        return;
+    }
+    uint32_t n = 0;
+    for (uint32_t id = c->first; id && n < c->n_infos;) {
+        int i = find_info(c, id);
+        ordered[n++] = c->infos[i];
+        id = c->next[i];
+    }
+    mkdir(c->dir, 0755);
+    if (drone_cache_write(c->path, c->sw_version, ordered, n) == -1 ||
+        drone_cache_open(&c->cache_storage, c->path, c->sw_version) == -1) {
+        printf("Drone catalog: %s: %s\n", c->path, strerror(errno));
+    } else {
+        printf("Drone catalog: %u entries stored in %s\n", n, c->path);
+        __atomic_store_n(&c->cache, &c->cache_storage, __ATOMIC_RELEASE);
+    }
+    free(ordered);
+    stop(c);
+}
+
+// End the enumeration. Responses still in flight are ignored. Must be called
+// with the lock held.
+static void stop(struct drone_catalog *c) {
+    for (uint32_t i = 0; i < c->n_infos; i++) {
+        free((char *)c->infos[i].type_id_name);
+        free((char *)c->infos[i].drone_name);
+        free((char *)c->infos[i].vendor_id_name);
+    }
+    free(c->infos);
+    free(c->next);
+    free(c->reqs);
+    c->infos = NULL;
+    c->next = NULL;
+    c->reqs = NULL;
+    c->n_infos = c->cap_infos = 0;
+    c->n_reqs = c->cap_reqs = 0;
+    c->running = false;
+}
+
+// Linear searches. The library has some hundred entries, and each takes a
+// round trip to get.
+static struct drone_catalog_req *find_req(struct drone_catalog *c, uint32_t type_id) {
+    for (uint32_t i = 0; i < c->n_reqs; i++) {
+        if (c->reqs[i].type_id == type_id) {
+            return &c->reqs[i];
+        }
+    }
+    return NULL;
+}
+
+static int find_info(const struct drone_catalog *c, uint32_t type_id) {
+    for (uint32_t i = 0; i < c->n_infos; i++) {
+        if (c->infos[i].type_id == type_id) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,122 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : drone_catalog.h                                              *
+ *                                                                             *
+ * Description  : Cached enumeration of the drone library of a RF sensor.      *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _DRONE_CATALOG_H
+#define _DRONE_CATALOG_H
+
+// Enumerates the drone library of a RF sensor with GetDroneInfoReq, and keeps
+// it in a drone_cache per sw_version, so later starts on the same firmware
+// skip the enumeration.
+//
+// Each GetDroneInfoRes gives the type_id of the next entry, so following the
+// chain takes a round trip per entry. Type ids are mostly consecutive, so
+// while the next entry is requested, the ones after it are requested
+// speculatively in the same mdif_rpc pipeline. A guess that is not in the
+// library costs a failed request.
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "linux_core_codec/mdif_rpc.h"
+#include "drone_cache.h"
+
+// Ids requested after the next one in the chain
+#define DRONE_CATALOG_SPECULATE 3
+// Timeout of each GetDroneInfoReq
+#define DRONE_CATALOG_TIMEOUT_MS 2000
+
+struct drone_catalog_req;
+
+struct drone_catalog {
+    pthread_mutex_t lock;
+    struct mdif_rpc *rpc;
+    char dir[PATH_MAX];
+    char path[PATH_MAX];
+    // Enumeration in progress
+    bool running;
+    char sw_version[DRONE_CACHE_MAX_SW_VERSION];
+    uint32_t first; // type_id of the first entry, 0 until known
+    struct drone_cache_info *infos;
+    uint32_t *next; // next_drone_type_id of each of infos
+    uint32_t n_infos;
+    uint32_t cap_infos;
+    struct drone_catalog_req *reqs; // Requested type ids
+    uint32_t n_reqs;
+    uint32_t cap_reqs;
+    unsigned failures;
+    // Set once, when loaded or enumerated
+    struct drone_cache *cache;
+    struct drone_cache cache_storage;
+};
+
+// Catalog of the device served by `rpc`. Caches are kept in `dir`, or in
+// $XDG_CACHE_HOME/mdif or ~/.cache/mdif if NULL.
+void drone_catalog_init(struct drone_catalog *c, struct mdif_rpc *rpc, const char *dir);
+
+// Map the cache for `sw_version`, or start the enumeration if there is none.
+// Call on the DeviceInfo of the device. Returns at once.
+void drone_catalog_start(struct drone_catalog *c, const char *sw_version);
+
+// Mapped library, or NULL until loaded or enumerated
+static inline const struct drone_cache *drone_catalog_cache(const struct drone_catalog *c) {
+    return __atomic_load_n(&c->cache, __ATOMIC_ACQUIRE);
+}
+
+// Look up `type_id`, e.g. of a threat. Returns false if unknown, or the
+// library is not available yet. From any thread.
+bool drone_catalog_find(const struct drone_catalog *c, uint32_t type_id, struct drone_cache_info *info);
+
+#endif // _DRONE_CATALOG_H
@@ -0,0 +1,240 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : drone_catalog_test.c                                         *
+ *                                                                             *
+ * Description  : Test of the drone catalog against a simulated RF sensor.     *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "_generated/mdif/rfs/rfs.pb-c.h"
+#include "linux_core_codec/mdif_buf.h"
+#include "drone_catalog.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define N_DRONES 20
+// Round trips allowed for N_DRONES. One per entry without pipelining.
+#define MAX_ROUNDS 8
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Library of the simulated device, in library order
+static uint32_t library[N_DRONES];
+static char names[N_DRONES][16];
+
+// GetDroneInfoReq received and not answered yet
+static uint32_t requested[64];
+static unsigned n_requested;
+static unsigned n_requests;
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// The device receiving a request
+static void send(uint8_t *buf, uint32_t size, void *ctx) {
+    Mdif__Rfs__RfsMsg *msg = mdif__rfs__rfs_msg__unpack(NULL, size, buf);
+    if (msg && msg->msg_case == MDIF__RFS__RFS_MSG__MSG_GET_DRONE_INFO_REQ &&
+        n_requested < sizeof(requested) / sizeof(requested[0])) {
+        requested[n_requested++] = msg->get_drone_info_req->type_id;
+        n_requests++;
+    }
+    if (msg) {
+        mdif__rfs__rfs_msg__free_unpacked(msg, NULL);
+    }
+    mdif_buf_free(buf);
+}
+
+// The device answering GetDroneInfoReq for `type_id`, 0 being the first entry
+static uint8_t *respond(uint32_t type_id, uint32_t *size) {
+    int i = type_id == 0 ? 0 : -1;
+    for (int k = 0; k < N_DRONES && i < 0; k++) {
+        if (library[k] == type_id) {
+            i = k;
+        }
+    }
+    Mdif__Rfs__ScanBand bands[] = {MDIF__RFS__SCAN_BAND__MHz2400, MDIF__RFS__SCAN_BAND__MHz5800};
+    Mdif__Rfs__DroneInfo info = MDIF__RFS__DRONE_INFO__INIT;
+    Mdif__Rfs__GetDroneInfoRes res = MDIF__RFS__GET_DRONE_INFO_RES__INIT;
+    if (i < 0) {
+        res.status = MDIF__COMMON__STATUS__ERR_INVALID;
+    } else {
+        info.type_id = library[i];
+        info.type_id_name = "Proto";
+        info.drone_name = names[i];
+        info.vendor_id = i % 2;
+        info.vendor_id_name = i % 2 ? "DJI" : "Autel";
+        info.n_band = 2;
+        info.band = bands;
+        info.category = MDIF__RFS__THREAT_CATEGORY__CategoryDrone;
+        res.status = MDIF__COMMON__STATUS__SUCCESS;
+        res.drone_info = &info;
+        res.next_drone_type_id = i + 1 < N_DRONES ? library[i + 1] : 0;
+    }
+    Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+    msg.msg_case = MDIF__RFS__RFS_MSG__MSG_GET_DRONE_INFO_RES;
+    msg.get_drone_info_res = &res;
+    return mdif_buf_pack(&msg.base, size);
+}
+
+// Answer all requests in flight, as one round trip. Returns false if there
+// were none.
+static bool round_trip(struct mdif_rpc *rpc) {
+    uint32_t batch[64];
+    unsigned n = n_requested;
+    if (n == 0) {
+        return false;
+    }
+    memcpy(batch, requested, n * sizeof(batch[0]));
+    n_requested = 0;
+    for (unsigned i = 0; i < n; i++) {
+        uint32_t size;
+        uint8_t *buf = respond(batch[i], &size);
+        mdif_rpc_response(rpc, buf, size);
+        mdif_buf_free(buf);
+    }
+    return true;
+}
+
+int main(void) {
+    int fails = 0;
+
+    // Mostly consecutive type ids, with gaps the speculation misses
+    for (int i = 0; i < N_DRONES; i++) {
+        library[i] = 1000400 + i + (i >= 10) + (i >= 15 ? 999000 : 0);
+        snprintf(names[i], sizeof(names[i]), "Drone %d", i);
+    }
+    char dir[] = "/tmp/drone_catalog_test.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char path[PATH_MAX];
+    char path2[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/drones-4.3.1.bin", dir);
+    snprintf(path2, sizeof(path2), "%s/drones-4.3.2.bin", dir);
+
+    static struct mdif_rpc_wheel wheel;
+    static struct mdif_rpc rpc;
+    mdif_rpc_wheel_init(&wheel, 10);
+    mdif_rpc_init(&rpc, &wheel, 4, 16, send, NULL);
+
+    // Enumeration
+    static struct drone_catalog c;
+    drone_catalog_init(&c, &rpc, dir);
+    drone_catalog_start(&c, "4.3.1");
+    unsigned rounds = 0;
+    while (round_trip(&rpc)) {
+        rounds++;
+    }
+    printf("%u entries in %u round trips, %u requests\n", N_DRONES, rounds, n_requests);
+    CHECK("enumerate: cache mapped", drone_catalog_cache(&c) != NULL);
+    CHECK("enumerate: pipelined", rounds <= MAX_ROUNDS);
+
+    bool found = true;
+    struct drone_cache_info info;
+    for (int i = 0; i < N_DRONES; i++) {
+        found = found && drone_catalog_find(&c, library[i], &info) && strcmp(info.drone_name, names[i]) == 0 &&
+                info.bands == (1 << MDIF__RFS__SCAN_BAND__MHz2400 | 1 << MDIF__RFS__SCAN_BAND__MHz5800);
+    }
+    CHECK("enumerate: all entries found", found);
+    CHECK("enumerate: unknown type_id", !drone_catalog_find(&c, 1000410, &info));
+    const struct drone_cache *cache = drone_catalog_cache(&c);
+    bool ordered = cache && cache->hdr->count == N_DRONES;
+    for (uint32_t i = 0; ordered && i < cache->hdr->count; i++) {
+        ordered = cache->entries[i].type_id == library[i];
+    }
+    CHECK("enumerate: library order", ordered);
+
+    // A restart on the same firmware sends no requests
+    static struct drone_catalog c2;
+    drone_catalog_init(&c2, &rpc, dir);
+    n_requests = 0;
+    drone_catalog_start(&c2, "4.3.1");
+    CHECK("restart: no requests", n_requests == 0 && drone_catalog_cache(&c2) != NULL);
+    CHECK("restart: lookup",
+          drone_catalog_find(&c2, library[17], &info) && strcmp(info.vendor_id_name, "DJI") == 0);
+
+    // Other firmware is enumerated
+    static struct drone_catalog c3;
+    drone_catalog_init(&c3, &rpc, dir);
+    drone_catalog_start(&c3, "4.3.2");
+    CHECK("other version: enumerates", n_requests == 1 && drone_catalog_cache(&c3) == NULL);
+    while (round_trip(&rpc)) {
+    }
+    CHECK("other version: cache mapped", drone_catalog_cache(&c3) != NULL);
+
+    // A truncated cache is rejected
+    struct stat st;
+    struct drone_cache dc;
+    stat(path, &st);
+    if (truncate(path, st.st_size - 3) == -1) {
+        perror("truncate");
+    }
+    CHECK("truncated: rejected", drone_cache_open(&dc, path, "4.3.1") == -1 && errno == EINVAL);
+
+    mdif_rpc_free(&rpc);
+    unlink(path);
+    unlink(path2);
+    rmdir(dir);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,553 @@
+#!/usr/bin/env python3
+###############################################################################
+#                                                                             #
+#                                                 ,,                          #
+#                                                       ,,,,,                 #
+#                                                           ,,,,,             #
+#           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          #
+#          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        #
+#          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       #
+#          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     #
+#          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     #
+#          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    #
+#          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            #
+#          ,,,,,       ,,,,,      ,,,,,,                ,        ,            #
+#          ,,,,,       ,,,,,      ,,,,,,                 ,                    #
+#          ,,,,,       ,,,,,      ,,,,,,                                      #
+#          ,,,,,       ,,,,,      ,,,,,,                                      #
+#                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            #
+#                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          #
+#                                       ,,,,,                  ,,,,,,         #
+#                     ,                 ,,,,,                  ,,,,,,         #
+#             ,        ,,               ,,,,,                  ,,,,,,         #
+#    ,        ,,        ,,,             ,,,,,                  ,,,,,,         #
+#     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         #
+#     ,,,       ,,,                     ,,,,,                  ,,,,,,         #
+#      ,,,        ,,,,                  ,,,,,                  ,,,,,,         #
+#        ,,,         ,,,,               ,,,,,                  ,,,,,,         #
+#         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          #
+#            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            #
+#               ,,,,,                                                         #
+#                    ,,,,,                                                    #
+#                                                                             #
+# Program/file : gen_fast_decode.py                                           #
+#                                                                             #
+# Description  : Generate straight-line decoders for selected MDIF messages.  #
+#              :                                                              #
+#                                                                             #
+# Copyright 2026 MyDefence A/S.                                               #
+#                                                                             #
+# Licensed under the Apache License, Version 2.0 (the "License");             #
+# you may not use this file except in compliance with the License.            #
+# You may obtain a copy of the License at                                     #
+#                                                                             #
+# http://www.apache.org/licenses/LICENSE-2.0                                  #
+#                                                                             #
+# Unless required by applicable law or agreed to in writing, software         #
+# distributed under the License is distributed on an "AS IS" BASIS,           #
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    #
+# See the License for the specific language governing permissions and         #
+# limitations under the License.                                              #
+#                                                                             #
+#                                                                             #
+#                                                                             #
+###############################################################################
+"""Generate straight-line decoders for selected MDIF messages.
+
+protobuf-c unpacks every message by walking its descriptor. For the few
+indications that make up most of the traffic, this script instead generates a
+decoder with one switch case per field into a flat struct, with submessages
+embedded, repeated fields in fixed size arrays and strings/bytes pointing into
+the decoded buffer. Anything the decoder does not know, e.g. a field added in
+a newer firmware, makes it give up so the caller can fall back to protobuf-c.
+
+The input is a descriptor set made by protoc:
+
+    protoc --include_imports --descriptor_set_out=mdif.desc \\
+        -I../protobuf mdif/core/core.proto mdif/rfs/rfs.proto
+    gen_fast_decode.py -o _generated/mdif_fast --root mdif.rfs.RfsMsg \\
+        mdif.desc mdif.rfs.RfsThreatInd
+
+This writes mdif_fast.h and mdif_fast.c. See README.md for the generated API.
+"""
+
+import argparse
+import os
+import sys
+
+# FieldDescriptorProto.Type
+TYPE_DOUBLE, TYPE_FLOAT, TYPE_INT64, TYPE_UINT64, TYPE_INT32 = 1, 2, 3, 4, 5
+TYPE_FIXED64, TYPE_FIXED32, TYPE_BOOL, TYPE_STRING, TYPE_GROUP = 6, 7, 8, 9, 10
+TYPE_MESSAGE, TYPE_BYTES, TYPE_UINT32, TYPE_ENUM, TYPE_SFIXED32 = 11, 12, 13, 14, 15
+TYPE_SFIXED64, TYPE_SINT32, TYPE_SINT64 = 16, 17, 18
+
+LABEL_REPEATED = 3
+
+WIRE_VARINT, WIRE_FIXED64, WIRE_DELIM, WIRE_FIXED32 = 0, 1, 2, 5
+
+# type: (C type, wire type, read statement, assignment from v or None)
+VARINT = 'P = mdif_fast_varint(P, END, &v);'
+SCALARS = {
+    TYPE_DOUBLE: ('double', WIRE_FIXED64, 'P = mdif_fast_fixed64(P, END, &DST);', None),
+    TYPE_FLOAT: ('float', WIRE_FIXED32, 'P = mdif_fast_fixed32(P, END, &DST);', None),
+    TYPE_FIXED64: ('uint64_t', WIRE_FIXED64, 'P = mdif_fast_fixed64(P, END, &DST);', None),
+    TYPE_SFIXED64: ('int64_t', WIRE_FIXED64, 'P = mdif_fast_fixed64(P, END, &DST);', None),
+    TYPE_FIXED32: ('uint32_t', WIRE_FIXED32, 'P = mdif_fast_fixed32(P, END, &DST);', None),
+    TYPE_SFIXED32: ('int32_t', WIRE_FIXED32, 'P = mdif_fast_fixed32(P, END, &DST);', None),
+    TYPE_INT64: ('int64_t', WIRE_VARINT, VARINT, 'DST = (int64_t)v;'),
+    TYPE_UINT64: ('uint64_t', WIRE_VARINT, VARINT, 'DST = v;'),
+    TYPE_INT32: ('int32_t', WIRE_VARINT, VARINT, 'DST = (int32_t)v;'),
+    TYPE_UINT32: ('uint32_t', WIRE_VARINT, VARINT, 'DST = (uint32_t)v;'),
+    TYPE_BOOL: ('bool', WIRE_VARINT, VARINT, 'DST = v != 0;'),
+    TYPE_ENUM: ('int32_t', WIRE_VARINT, VARINT, 'DST = (int32_t)v;'),
+    TYPE_SINT32: ('int32_t', WIRE_VARINT, VARINT, 'DST = mdif_fast_zigzag32(v);'),
+    TYPE_SINT64: ('int64_t', WIRE_VARINT, VARINT, 'DST = mdif_fast_zigzag64(v);'),
+}
+
+
+def varint(buf, i):
+    x = shift = 0
+    while True:
+        b = buf[i]
+        i += 1
+        x |= (b & 0x7f) << shift
+        shift += 7
+        if b < 0x80:
+            return x, i
+
+
+def wire_fields(buf):
+    """Yield (number, value) for each field of an encoded message."""
+    i = 0
+    while i < len(buf):
+        key, i = varint(buf, i)
+        wt = key & 7
+        if wt == WIRE_VARINT:
+            v, i = varint(buf, i)
+        elif wt == WIRE_FIXED64:
+            v, i = buf[i:i + 8], i + 8
+        elif wt == WIRE_DELIM:
+            n, i = varint(buf, i)
+            v, i = buf[i:i + n], i + n
+        elif wt == WIRE_FIXED32:
+            v, i = buf[i:i + 4], i + 4
+        else:
+            raise ValueError('unsupported wire type %d' % wt)
+        yield key >> 3, v
+
+
+class Field:
+    def __init__(self, buf):
+        self.oneof_index = None
+        self.proto3_optional = False
+        self.label = 1
+        self.type_name = None
+        for num, v in wire_fields(buf):
+            if num == 1:
+                self.name = v.decode()
+            elif num == 3:
+                self.number = v
+            elif num == 4:
+                self.label = v
+            elif num == 5:
+                self.type = v
+            elif num == 6:
+                self.type_name = v.decode().lstrip('.')
+            elif num == 9:
+                self.oneof_index = v
+            elif num == 17:
+                self.proto3_optional = v != 0
+        self.repeated = self.label == LABEL_REPEATED
+
+
+class Message:
+    def __init__(self, buf, prefix, file, messages):
+        self.fields = []
+        self.oneofs = []
+        self.file = file
+        nested = []
+        for num, v in wire_fields(buf):
+            if num == 1:
+                self.name = v.decode()
+            elif num == 2:
+                self.fields.append(Field(v))
+            elif num == 3:
+                nested.append(v)
+            elif num == 8:
+                self.oneofs.append(dict(wire_fields(v))[1].decode())
+        self.full_name = prefix + self.name
+        # Name within the package, e.g. RfsThreatInd.RelativeBearing
+        self.path = self.full_name[len(file.package) + 1:] if file.package else self.full_name
+        messages[self.full_name] = self
+        for v in nested:
+            Message(v, self.full_name + '.', file, messages)
+
+
+class File:
+    def __init__(self, buf, messages):
+        self.package = ''
+        bodies = []
+        for num, v in wire_fields(buf):
+            if num == 1:
+                self.name = v.decode()
+            elif num == 2:
+                self.package = v.decode()
+            elif num == 4:
+                bodies.append(v)
+        for v in bodies:
+            Message(v, self.package + '.' if self.package else '', self, messages)
+
+
+def camel_to_lower(name):
+    out = ''
+    for i, c in enumerate(name):
+        if c.isupper() and i > 0 and not name[i - 1] == '_':
+            out += '_'
+        out += c.lower()
+    return out
+
+
+def to_camel(name):
+    return ''.join(p[:1].upper() + p[1:] for p in name.split('_'))
+
+
+class Generator:
+    def __init__(self, messages):
+        self.messages = messages
+        self.order = []  # Messages to generate, dependencies first
+        self.names = {}
+
+    def cname(self, msg):
+        """Name of the flat struct, e.g. rfs_threat_ind_relative_bearing."""
+        return '_'.join(camel_to_lower(p) for p in msg.path.split('.'))
+
+    def pbc_type(self, msg):
+        """protobuf-c struct, e.g. Mdif__Rfs__RfsThreatInd__RelativeBearing."""
+        return '__'.join(to_camel(p) for p in msg.full_name.split('.'))
+
+    def pbc_descriptor(self, msg):
+        """protobuf-c descriptor, e.g. mdif__rfs__rfs_msg__descriptor."""
+        return '__'.join(camel_to_lower(p) for p in msg.full_name.split('.')) + '__descriptor'
+
+    def add(self, full_name):
+        msg = self.messages.get(full_name)
+        if msg is None:
+            sys.exit('gen_fast_decode: unknown message %s' % full_name)
+        if msg in self.order:
+            return msg
+        for f in msg.fields:
+            if f.type == TYPE_GROUP:
+                sys.exit('gen_fast_decode: %s.%s: groups are not supported' % (full_name, f.name))
+            if f.type == TYPE_MESSAGE:
+                if f.type_name == full_name:
+                    sys.exit('gen_fast_decode: %s: recursive messages are not supported' % full_name)
+                self.add(f.type_name)
+        name = self.cname(msg)
+        if name in self.names:
+            sys.exit('gen_fast_decode: %s and %s both map to %s' % (full_name, self.names[name], name))
+        self.names[name] = full_name
+        self.order.append(msg)
+        return msg
+
+    def oneof_name(self, msg, f):
+        if f.oneof_index is None or f.proto3_optional:
+            return None
+        return msg.oneofs[f.oneof_index]
+
+    def c_member(self, f):
+        if f.type in SCALARS:
+            ctype = SCALARS[f.type][0]
+        elif f.type in (TYPE_STRING, TYPE_BYTES):
+            ctype = 'struct mdif_fast_bytes'
+        else:
+            ctype = 'struct mdif_fast_%s' % self.cname(self.messages[f.type_name])
+        if f.repeated:
+            return ['uint32_t n_%s;' % f.name, '%s %s[MDIF_FAST_MAX_REPEATED];' % (ctype, f.name)]
+        if f.type == TYPE_MESSAGE or f.proto3_optional:
+            return ['bool has_%s;' % f.name, '%s %s;' % (ctype, f.name)]
+        return ['%s %s;' % (ctype, f.name)]
+
+    def struct(self, msg):
+        out = ['// %s' % msg.full_name, 'struct mdif_fast_%s {' % self.cname(msg)]
+        for oneof in msg.oneofs:
+            if any(self.oneof_name(msg, f) == oneof for f in msg.fields):
+                out.append('    uint32_t %s_case; // Field number, 0 if none' % oneof)
+        for f in msg.fields:
+            out += ['    ' + m for m in self.c_member(f)]
+        out.append('};')
+        return out
+
+    def scalar(self, f, dst, p, end):
+        """Statements decoding one element of scalar field f into dst."""
+        ctype, wt, read, assign = SCALARS[f.type]
+        out = [read.replace('P', p).replace('END', end).replace('DST', dst)]
+        out += ['if (!%s) {' % p, '    return -1;', '}']
+        if assign:
+            out.append(assign.replace('DST', dst))
+        return out
+
+    def field_cases(self, msg, f):
+        """Switch cases decoding field f of msg."""
+        dst = 'msg->%s' % f.name
+        full = []
+        if f.repeated:
+            dst = 'msg->%s[msg->n_%s]' % (f.name, f.name)
+            full = ['if (msg->n_%s == MDIF_FAST_MAX_REPEATED) {' % f.name, '    return -1;', '}']
+        check = ['if (!p) {', '    return -1;', '}']
+
+        if f.type in SCALARS:
+            wt = SCALARS[f.type][1]
+            body = full + self.scalar(f, dst, 'p', 'end')
+        elif f.type == TYPE_MESSAGE:
+            wt = WIRE_DELIM
+            sub = self.cname(self.messages[f.type_name])
+            body = full + ['p = mdif_fast_delim(p, end, &b);'] + check
+            body += ['if (merge_%s(b.data, b.data + b.len, &%s) == -1) {' % (sub, dst), '    return -1;', '}']
+            if not f.repeated:
+                body.append('msg->has_%s = true;' % f.name)
+        else:
+            wt = WIRE_DELIM
+            body = full + ['p = mdif_fast_delim(p, end, &%s);' % dst] + check
+        if f.repeated:
+            body.append('msg->n_%s++;' % f.name)
+        elif f.proto3_optional:
+            body.append('msg->has_%s = true;' % f.name)
+        oneof = self.oneof_name(msg, f)
+        if oneof:
+            body.append('msg->%s_case = %d;' % (oneof, f.number))
+
+        cases = [(wt, '', body)]
+        if f.repeated and f.type in SCALARS:
+            # Packed encoding, the default for repeated scalars in proto3
+            loop = ['p = mdif_fast_delim(p, end, &b);'] + check
+            loop += ['for (const uint8_t *q = b.data; q < b.data + b.len;) {']
+            loop += ['    ' + l for l in full + self.scalar(f, dst, 'q', 'b.data + b.len')]
+            loop += ['    msg->n_%s++;' % f.name, '}']
+            cases.append((WIRE_DELIM, ', packed', loop))
+
+        out = []
+        for wt, note, body in cases:
+            out.append('case %d << 3 | %d: { // %s%s' % (f.number, wt, f.name, note))
+            out += ['    ' + l for l in body]
+            out.append('    break;')
+            out.append('}')
+        return out
+
+    def uses(self, msg):
+        """Whether the decoder of msg needs v and b."""
+        v = any(f.type in SCALARS and SCALARS[f.type][3] for f in msg.fields)
+        b = any(f.type == TYPE_MESSAGE or (f.repeated and f.type in SCALARS) for f in msg.fields)
+        return v, b
+
+    def merge(self, msg):
+        name = self.cname(msg)
+        out = ['static int merge_%s(const uint8_t *p, const uint8_t *end, struct mdif_fast_%s *msg)' % (name, name), '{']
+        v, b = self.uses(msg)
+        out += ['    uint64_t v;'] if v else []
+        out += ['    struct mdif_fast_bytes b;'] if b else []
+        out += [''] if v or b else []
+        out += ['    while (p < end) {', '        uint64_t tag;', '        p = mdif_fast_varint(p, end, &tag);',
+                '        if (!p || tag > UINT32_MAX) {', '            return -1;', '        }',
+                '        switch ((uint32_t)tag) {']
+        for f in msg.fields:
+            out += ['        ' + l for l in self.field_cases(msg, f)]
+        out += ['        default:', '            // Unknown field or wire type', '            return -1;', '        }',
+                '    }', '    return 0;', '}']
+        return out
+
+    def compare_field(self, msg, f):
+        """Statements returning -1 if field f of a and b differs."""
+        name = f.name
+        out = []
+
+        def element(a, b):
+            if f.type in (TYPE_FLOAT, TYPE_DOUBLE):
+                return 'memcmp(&%s, &%s, sizeof(%s)) != 0' % (a, b, a)
+            if f.type == TYPE_BOOL:
+                return '%s != (%s != 0)' % (a, b)
+            if f.type == TYPE_ENUM:
+                return '%s != (int32_t)%s' % (a, b)
+            if f.type in SCALARS:
+                return '%s != %s' % (a, b)
+            if f.type == TYPE_BYTES:
+                return '%s.len != %s.len || memcmp(%s.data, %s.data, %s.len) != 0' % (a, b, a, b, a)
+            if f.type == TYPE_STRING:
+                return '%s.len != strlen(%s) || memcmp(%s.data, %s, %s.len) != 0' % (a, b, a, b, a)
+            sub = self.cname(self.messages[f.type_name])
+            return 'mdif_fast_cmp_%s(&%s, %s) != 0' % (sub, a, b)
+
+        if f.repeated:
+            out.append('if (a->n_%s != b->n_%s) {' % (name, name))
+            out += ['    return -1;', '}']
+            out.append('for (uint32_t i = 0; i < a->n_%s; i++) {' % name)
+            out.append('    if (%s) {' % element('a->%s[i]' % name, 'b->%s[i]' % name))
+            out += ['        return -1;', '    }', '}']
+            return out
+
+        cond = element('a->%s' % name, 'b->%s' % name)
+        if f.type == TYPE_MESSAGE:
+            out.append('if (a->has_%s != (b->%s != NULL)) {' % (name, name))
+            out += ['    return -1;', '}']
+            cond = 'a->has_%s && %s' % (name, cond)
+        elif f.proto3_optional:
+            out.append('if (a->has_%s != b->has_%s) {' % (name, name))
+            out += ['    return -1;', '}']
+            cond = 'a->has_%s && (%s)' % (name, cond)
+        oneof = self.oneof_name(msg, f)
+        if oneof:
+            cond = 'a->%s_case == %d && (%s)' % (oneof, f.number, cond)
+        out.append('if (%s) {' % cond)
+        out += ['    return -1;', '}']
+        return out
+
+    def compare(self, msg):
+        name = self.cname(msg)
+        out = ['static int mdif_fast_cmp_%s(const struct mdif_fast_%s *a, const %s *b)' % (name, name, self.pbc_type(msg)),
+               '{']
+        for oneof in msg.oneofs:
+            if any(self.oneof_name(msg, f) == oneof for f in msg.fields):
+                out += ['    if (a->%s_case != b->%s_case) {' % (oneof, oneof), '        return -1;', '    }']
+        for f in msg.fields:
+            out += ['    ' + l for l in self.compare_field(msg, f)]
+        out += ['    return 0;', '}']
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate fast decoders for selected MDIF messages.')
+    parser.add_argument('-o', '--output', default='mdif_fast', help='output path without .c/.h (default mdif_fast)')
+    parser.add_argument('--root', action='append', default=[],
+                        help='component message, e.g. mdif.rfs.RfsMsg, whose fields select messages for mdif_fast_decode()')
+    parser.add_argument('--max-repeated', type=int, default=8,
+                        help='capacity of repeated fields. Longer ones fall back to protobuf-c (default 8)')
+    parser.add_argument('descriptor_set', help='made by protoc --include_imports --descriptor_set_out')
+    parser.add_argument('message', nargs='+', help='full name of message to generate a decoder for')
+    args = parser.parse_args()
+
+    messages = {}
+    with open(args.descriptor_set, 'rb') as f:
+        for num, v in wire_fields(f.read()):
+            if num == 1:
+                File(v, messages)
+
+    gen = Generator(messages)
+    hot = [gen.add(name) for name in args.message]
+
+    # Fields of the component messages that carry a selected message
+    dispatch = {}
+    roots = []
+    for root_name in args.root:
+        root = messages.get(root_name)
+        if root is None:
+            sys.exit('gen_fast_decode: unknown message %s' % root_name)
+        roots.append(root)
+        for f in root.fields:
+            if f.type == TYPE_MESSAGE and not f.repeated and messages[f.type_name] in hot:
+                if f.number in dispatch:
+                    sys.exit('gen_fast_decode: field %d is in both %s and %s' %
+                             (f.number, dispatch[f.number][0].full_name, root_name))
+                dispatch[f.number] = (root, f)
+    if not dispatch and roots:
+        sys.exit('gen_fast_decode: no selected message is a field of %s' % ', '.join(args.root))
+
+    base = os.path.basename(args.output)
+    guard = '_%s_H' % base.upper()
+    note = '/* Generated by gen_fast_decode.py from %s. DO NOT EDIT! */' % os.path.basename(args.descriptor_set)
+
+    h = [note, '', '#ifndef %s' % guard, '#define %s' % guard, '', '#include <stdbool.h>', '#include <stdint.h>', '',
+         '#include "linux_fast_decode/mdif_fast_wire.h"', '']
+    h.append('// Capacity of repeated fields')
+    h.append('#define MDIF_FAST_MAX_REPEATED %d' % args.max_repeated)
+    h.append('')
+    for msg in gen.order:
+        h += gen.struct(msg)
+        h.append('')
+    if dispatch:
+        h.append('// A message with one of the selected fields of %s' % ', '.join(args.root))
+        h.append('struct mdif_fast_msg {')
+        h.append('    uint32_t field;')
+        h.append('    union {')
+        for num, (root, f) in sorted(dispatch.items()):
+            h.append('        struct mdif_fast_%s %s;' % (gen.cname(messages[f.type_name]), f.name))
+        h += ['    };', '};', '']
+    h.append('// Decode buf into msg. Return 0, or -1 if the message is malformed or has')
+    h.append('// fields the decoder does not know, in which case protobuf-c must be used.')
+    for msg in hot:
+        name = gen.cname(msg)
+        h.append('int mdif_fast_decode_%s(const uint8_t *buf, uint32_t size, struct mdif_fast_%s *msg);' % (name, name))
+    h.append('')
+    if dispatch:
+        h.append('// Decode a component message holding one of the selected messages. Return')
+        h.append('// the field number stored in msg->field, or 0 if the message must be')
+        h.append('// decoded with protobuf-c.')
+        h.append('uint32_t mdif_fast_decode(const uint8_t *buf, uint32_t size, struct mdif_fast_msg *msg);')
+        h.append('')
+        h.append('#ifdef MDIF_FAST_PROTOBUF_C')
+        h.append('#include <protobuf-c/protobuf-c.h>')
+        h.append('')
+        h.append('// Compare msg with the same message unpacked by protobuf-c. Return 0 if')
+        h.append('// equal, -1 if not. For testing the generated decoders.')
+        h.append('int mdif_fast_cmp(const struct mdif_fast_msg *msg, const ProtobufCMessage *pbc);')
+        h.append('#endif')
+        h.append('')
+    h.append('#endif /* %s */' % guard)
+
+    c = [note, '', '#include <stdint.h>', '#include <string.h>', '', '#include "%s.h"' % base]
+    if dispatch:
+        pbc_files = sorted({m.file.name for m in gen.order + roots})
+        c += ['', '#ifdef MDIF_FAST_PROTOBUF_C']
+        c += ['#include "%s.pb-c.h"' % os.path.splitext(name)[0] for name in pbc_files]
+        c += ['#endif']
+    c.append('')
+    for msg in gen.order:
+        c += gen.merge(msg)
+        c.append('')
+    for msg in hot:
+        name = gen.cname(msg)
+        c.append('int mdif_fast_decode_%s(const uint8_t *buf, uint32_t size, struct mdif_fast_%s *msg)' % (name, name))
+        c += ['{', '    memset(msg, 0, sizeof(*msg));', '    return merge_%s(buf, buf + size, msg);' % name, '}', '']
+
+    if dispatch:
+        c += ['uint32_t mdif_fast_decode(const uint8_t *buf, uint32_t size, struct mdif_fast_msg *msg)', '{',
+              '    const uint8_t *end = buf + size;', '    struct mdif_fast_bytes b = {0};', '    uint64_t tag;', '',
+              '    // Exactly one length delimited field',
+              '    const uint8_t *p = mdif_fast_varint(buf, end, &tag);',
+              '    if (!p || (tag & 7) != 2 || mdif_fast_delim(p, end, &b) != end) {', '        return 0;', '    }',
+              '', '    int ret;', '    switch (tag >> 3) {']
+        for num, (root, f) in sorted(dispatch.items()):
+            name = gen.cname(messages[f.type_name])
+            c += ['    case %d: // %s.%s' % (num, root.full_name, f.name),
+                  '        memset(&msg->%s, 0, sizeof(msg->%s));' % (f.name, f.name),
+                  '        ret = merge_%s(b.data, b.data + b.len, &msg->%s);' % (name, f.name), '        break;']
+        c += ['    default:', '        return 0;', '    }', '    if (ret == -1) {', '        return 0;', '    }',
+              '    msg->field = tag >> 3;', '    return msg->field;', '}', '']
+
+        c += ['#ifdef MDIF_FAST_PROTOBUF_C', '']
+        for msg in gen.order:
+            c += gen.compare(msg)
+            c.append('')
+        c += ['int mdif_fast_cmp(const struct mdif_fast_msg *msg, const ProtobufCMessage *pbc)', '{']
+        for root in roots:
+            fields = [(n, f) for n, (r, f) in sorted(dispatch.items()) if r is root]
+            if not fields:
+                continue
+            c += ['    if (pbc->descriptor == &%s) {' % gen.pbc_descriptor(root),
+                  '        const %s *m = (const %s *)pbc;' % (gen.pbc_type(root), gen.pbc_type(root))]
+            oneof = gen.oneof_name(root, fields[0][1])
+            c += ['        if (m->%s_case != msg->field) {' % oneof, '            return -1;', '        }'] if oneof else []
+            c += ['        switch (msg->field) {']
+            for num, f in fields:
+                name = gen.cname(messages[f.type_name])
+                c += ['        case %d:' % num,
+                      '            return mdif_fast_cmp_%s(&msg->%s, m->%s);' % (name, f.name, f.name)]
+            c += ['        }', '    }']
+        c += ['    return -1;', '}', '', '#endif']
+
+    with open(args.output + '.h', 'w') as f:
+        f.write('\n'.join(h) + '\n')
+    with open(args.output + '.c', 'w') as f:
+        f.write('\n'.join(c) + '\n')
+
+
+if __name__ == '__main__':
+    main()
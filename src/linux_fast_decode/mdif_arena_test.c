@@ -0,0 +1,200 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_arena_test.c                                            *
+ *                                                                             *
+ * Description  : Counts the malloc() calls of decoding RfsThreatInd with the  *
+ *              : arena and with the fast decoder                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "linux_core_codec/mdif_arena.h"
+#include "mdif/rfs/rfs.pb-c.h"
+#include "mdif_fast.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define ITERATIONS 1000
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Calls of malloc(), calloc() and realloc() by the calling thread
+static __thread unsigned n_alloc;
+
+static uint8_t packed[256];
+static size_t packed_len;
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Linked with -Wl,--wrap for each, also wrapping the calls of protobuf-c
+void *__wrap_malloc(size_t size)
+{
+    n_alloc++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    n_alloc++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    n_alloc++;
+    return __real_realloc(ptr, size);
+}
+
+// A threat with all fields set, so every submessage and repeated field is
+// allocated by protobuf-c
+static void pack_threat(void)
+{
+    Google__Protobuf__Timestamp ts = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+    ts.seconds = 1700000000;
+    ts.nanos = 500000000;
+    Mdif__Rfs__RfsThreatInd__RelativeBearing bearing = MDIF__RFS__RFS_THREAT_IND__RELATIVE_BEARING__INIT;
+    bearing.valid = 1;
+    bearing.bearing = 42.5f;
+    bearing.var_bearing = 3.0f;
+    bearing.ts = &ts;
+    Mdif__Rfs__ScanBand bands[] = {MDIF__RFS__SCAN_BAND__MHz2400, MDIF__RFS__SCAN_BAND__MHz5800};
+    Mdif__Rfs__RfsThreatInd threat = MDIF__RFS__RFS_THREAT_IND__INIT;
+    threat.id = 17;
+    threat.type_id = 1234;
+    threat.power = -61.5f;
+    threat.n_current_band = 2;
+    threat.current_band = bands;
+    threat.relative_bearing = &bearing;
+    threat.start_ts = &ts;
+    threat.last_seen_ts = &ts;
+    threat.muted = 1;
+    packed_len = mdif__rfs__rfs_threat_ind__pack(&threat, packed);
+}
+
+static int unpack_arena(void)
+{
+    mdif_arena_mark_t mark = mdif_arena_mark();
+    Mdif__Rfs__RfsThreatInd *t = mdif__rfs__rfs_threat_ind__unpack(mdif_arena(), packed_len, packed);
+    int good = t && t->id == 17 && t->n_current_band == 2 && t->current_band[1] == MDIF__RFS__SCAN_BAND__MHz5800 &&
+               t->relative_bearing && t->relative_bearing->ts && t->last_seen_ts &&
+               t->last_seen_ts->seconds == 1700000000;
+    mdif_arena_release(mark);
+    return good;
+}
+
+static void *decode_thread(void *arg)
+{
+    int *failsp = arg;
+    int fails = 0;
+
+    n_alloc = 0;
+    mdif_arena_release(mdif_arena_mark());
+    CHECK("no buffer until the thread unpacks", n_alloc == 0);
+
+    CHECK("first unpack decodes", unpack_arena());
+    CHECK("first unpack allocates the buffer", n_alloc == 1);
+
+    n_alloc = 0;
+    int good = 1;
+    for (int i = 0; i < ITERATIONS; i++) {
+        good &= unpack_arena();
+    }
+    CHECK("unpacks with the arena decode", good);
+    CHECK("unpacks with the arena make no malloc()", n_alloc == 0);
+
+    n_alloc = 0;
+    good = 1;
+    for (int i = 0; i < ITERATIONS; i++) {
+        struct mdif_fast_rfs_threat_ind t;
+        good &= mdif_fast_decode_rfs_threat_ind(packed, packed_len, &t) == 0 && t.id == 17 &&
+                t.n_current_band == 2 && t.has_relative_bearing && t.relative_bearing.has_ts;
+    }
+    CHECK("fast decodes decode", good);
+    CHECK("fast decodes make no malloc()", n_alloc == 0);
+
+    // The count does see the allocations of protobuf-c
+    n_alloc = 0;
+    Mdif__Rfs__RfsThreatInd *t = mdif__rfs__rfs_threat_ind__unpack(NULL, packed_len, packed);
+    CHECK("unpack with default allocator counted", t && n_alloc > 0);
+    mdif__rfs__rfs_threat_ind__free_unpacked(t, NULL);
+
+    *failsp = fails;
+    return NULL;
+}
+
+int main(void)
+{
+    int fails = 0;
+    pack_threat();
+    CHECK("threat packed", packed_len > 0 && packed_len < sizeof(packed));
+
+    // In a new thread, to see its first unpack
+    int thread_fails = 0;
+    pthread_t thread;
+    pthread_create(&thread, NULL, decode_thread, &thread_fails);
+    pthread_join(thread, NULL);
+    fails += thread_fails;
+    return fails ? 1 : 0;
+}
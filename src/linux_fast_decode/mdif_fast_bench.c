@@ -0,0 +1,461 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_fast_bench.c                                            *
+ *                                                                             *
+ * Description  : Benchmark of generated fast decoders against protobuf-c.     *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#define _GNU_SOURCE
+#include <argp.h>
+#include <endian.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "linux_core_codec/mdif_arena.h"
+#include "linux_core_codec/mdif_router.h"
+#include "mdif/core/core.pb-c.h"
+#include "mdif/rfs/rfs.pb-c.h"
+#include "mdif_fast.h"
+
+// Decodes the same traffic with protobuf-c and with the decoders generated by
+// gen_fast_decode.py, and reports the time per message of each. Every message
+// handled by the fast decoders is first checked to decode to the same values
+// as with protobuf-c.
+//
+// The traffic is a recording in the TCP framing (32 bit little endian length
+// prefix before each message), e.g. captured from mdif_gatewayd with
+//
+//   nc localhost 21020 > traffic.bin
+//
+// Without a recording, a synthetic mix of indications is used.
+
+//////////////////////////////////////////////////////////////////////////////
+// Arguments
+
+static char doc[] = "\nBenchmark of fast MDIF decoders against protobuf-c.\n";
+static char args_doc[] = "[recording]";
+
+static struct argp_option options[] = {
+    {"iterations", 'n', "N", 0, "Passes over the traffic. Default 100."},
+    {"count", 'c', "N", 0, "Number of synthetic messages. Default 10000."},
+    {"write", 'w', "FILE", 0, "Write the synthetic traffic to FILE, to be used as recording."},
+    {0}};
+
+struct args {
+    const char *recording;
+    unsigned iterations;
+    unsigned count;
+    const char *write;
+} args = {
+    // Defaults
+    .iterations = 100,
+    .count = 10000,
+};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state)
+{
+    struct args *args = state->input;
+
+    switch (key) {
+    case ARGP_KEY_ARG:
+        if (state->arg_num >= 1) {
+            argp_usage(state);
+        }
+        args->recording = arg;
+        break;
+
+    case 'n':
+        args->iterations = strtoul(arg, NULL, 0);
+        break;
+
+    case 'c':
+        args->count = strtoul(arg, NULL, 0);
+        break;
+
+    case 'w':
+        args->write = arg;
+        break;
+
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+
+    return 0;
+}
+
+static struct argp argp = {options, parse_opt, args_doc, doc, 0, 0, 0};
+
+//////////////////////////////////////////////////////////////////////////////
+// Traffic
+
+struct msg {
+    const uint8_t *data;
+    uint32_t len;
+    const ProtobufCMessageDescriptor *descriptor;
+};
+
+static uint8_t *traffic;
+static size_t traffic_len;
+static struct msg *msgs;
+static size_t n_msgs;
+
+static void append(const void *data, size_t len)
+{
+    static size_t size;
+    if (traffic_len + len > size) {
+        size = size ? 2 * size : 1024 * 1024;
+        if (size < traffic_len + len) {
+            size = traffic_len + len;
+        }
+        traffic = realloc(traffic, size);
+        if (!traffic) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    memcpy(traffic + traffic_len, data, len);
+    traffic_len += len;
+}
+
+static void append_msg(const ProtobufCMessage *msg)
+{
+    uint8_t buf[1024];
+    uint32_t len = protobuf_c_message_get_packed_size(msg);
+    if (len > sizeof(buf)) {
+        fprintf(stderr, "Message too large\n");
+        exit(1);
+    }
+    protobuf_c_message_pack(msg, buf);
+    uint32_t prefix = htole32(len);
+    append(&prefix, sizeof(prefix));
+    append(buf, len);
+}
+
+static float frand(float min, float max)
+{
+    return min + (max - min) * (float)rand() / RAND_MAX;
+}
+
+// Mix of indications like an RF sensor seeing a handful of drones, with
+// remote ID and GNSS/compass streaming enabled.
+static void synthesize(unsigned count)
+{
+    srand(1);
+    for (unsigned i = 0; i < count; i++) {
+        Google__Protobuf__Timestamp ts1 = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+        Google__Protobuf__Timestamp ts2 = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+        Google__Protobuf__Timestamp ts3 = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+        ts1.seconds = ts2.seconds = ts3.seconds = 1760000000 + i / 10;
+        ts1.nanos = rand() % 1000000000;
+        ts2.nanos = rand() % 1000000000;
+        ts3.nanos = rand() % 1000000000;
+
+        int kind = rand() % 100;
+        if (kind < 55) {
+            Mdif__Rfs__RfsThreatInd__RelativeBearing rb = MDIF__RFS__RFS_THREAT_IND__RELATIVE_BEARING__INIT;
+            rb.valid = true;
+            rb.bearing = frand(-180, 180);
+            rb.var_bearing = frand(0, 20);
+            rb.ts = &ts1;
+            Mdif__Rfs__ScanBand bands[] = {MDIF__RFS__SCAN_BAND__MHz2400, MDIF__RFS__SCAN_BAND__MHz5800};
+            Mdif__Rfs__RfsThreatInd ind = MDIF__RFS__RFS_THREAT_IND__INIT;
+            ind.id = rand() % 8;
+            ind.type_id = 1 + rand() % 200;
+            ind.power = frand(-90, -30);
+            ind.n_current_band = 1 + rand() % 2;
+            ind.current_band = bands;
+            ind.relative_bearing = &rb;
+            ind.start_ts = &ts2;
+            ind.last_seen_ts = &ts3;
+            Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+            msg.msg_case = MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND;
+            msg.rfs_threat_ind = &ind;
+            append_msg(&msg.base);
+        } else if (kind < 70) {
+            uint8_t mac[6];
+            for (unsigned j = 0; j < sizeof(mac); j++) {
+                mac[j] = rand();
+            }
+            Mdif__Rfs__WifiThreatInd ind = MDIF__RFS__WIFI_THREAT_IND__INIT;
+            ind.id = 8 + rand() % 4;
+            ind.type_id = 1 + rand() % 200;
+            ind.power = frand(-90, -30);
+            ind.channel = 1 + rand() % 13;
+            ind.mac_adr.data = mac;
+            ind.mac_adr.len = sizeof(mac);
+            ind.start_ts = &ts1;
+            Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+            msg.msg_case = MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND;
+            msg.wifi_threat_ind = &ind;
+            append_msg(&msg.base);
+        } else if (kind < 80) {
+            Mdif__Rfs__ThreatStoppedInd ind = MDIF__RFS__THREAT_STOPPED_IND__INIT;
+            ind.id = rand() % 12;
+            Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+            msg.msg_case = MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND;
+            msg.threat_stopped_ind = &ind;
+            append_msg(&msg.base);
+        } else if (kind < 95) {
+            // ASTM F3411 message pack of a few 25 byte messages
+            uint8_t mac[6], payload[3 + 4 * 25];
+            for (unsigned j = 0; j < sizeof(mac); j++) {
+                mac[j] = rand();
+            }
+            for (unsigned j = 0; j < sizeof(payload); j++) {
+                payload[j] = rand();
+            }
+            Mdif__Rfs__RemoteIdInd ind = MDIF__RFS__REMOTE_ID_IND__INIT;
+            ind.mac_adr.data = mac;
+            ind.mac_adr.len = sizeof(mac);
+            ind.payload.data = payload;
+            ind.payload.len = sizeof(payload);
+            ind.id = rand() % 4;
+            ind.transport_type = MDIF__RFS__RID_TRANSPORT_TYPE__TRANSPORT_BEACON;
+            Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+            msg.msg_case = MDIF__RFS__RFS_MSG__MSG_REMOTE_ID_IND;
+            msg.remote_id_ind = &ind;
+            append_msg(&msg.base);
+        } else {
+            Mdif__Core__GnssStatus gnss = MDIF__CORE__GNSS_STATUS__INIT;
+            gnss.pos_valid = true;
+            gnss.pos_hacc = frand(0, 5);
+            gnss.pos_hmsl = frand(0, 100);
+            gnss.pos_vacc = frand(0, 5);
+            gnss.sol_time = 1760000000000000LL + i;
+            gnss.num_sv = 5 + rand() % 20;
+            gnss.fix_type = MDIF__CORE__GNSS_FIX_TYPE__GNSS_FIX_3D;
+            gnss.t_acc = rand() % 100;
+            gnss.pos_lat = frand(55, 56);
+            gnss.pos_lon = frand(12, 13);
+            gnss.ecef_x = frand(3500000, 3600000);
+            gnss.ecef_y = frand(700000, 800000);
+            gnss.ecef_z = frand(5200000, 5300000);
+            Mdif__Core__CompassHeading compass = MDIF__CORE__COMPASS_HEADING__INIT;
+            compass.calibrated = true;
+            compass.heading = frand(0, 360);
+            compass.x = rand() % 2000 - 1000;
+            compass.y = rand() % 2000 - 1000;
+            compass.z = rand() % 2000 - 1000;
+            Mdif__Core__GnssCompassStreamInd ind = MDIF__CORE__GNSS_COMPASS_STREAM_IND__INIT;
+            ind.gnss_status = &gnss;
+            ind.compass_heading = &compass;
+            Mdif__Core__CoreMsg msg = MDIF__CORE__CORE_MSG__INIT;
+            msg.msg_case = MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_IND;
+            msg.gnss_compass_stream_ind = &ind;
+            append_msg(&msg.base);
+        }
+    }
+}
+
+static void load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    uint8_t buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        append(buf, n);
+    }
+    fclose(f);
+}
+
+static void save(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(traffic, 1, traffic_len, f) != traffic_len || fclose(f) != 0) {
+        perror(path);
+        exit(1);
+    }
+}
+
+// Split traffic into messages. Only core and RFS messages are benchmarked.
+static void split(void)
+{
+    size_t n_other = 0;
+    for (size_t pos = 0; pos + 4 <= traffic_len;) {
+        uint32_t len;
+        memcpy(&len, traffic + pos, sizeof(len));
+        len = le32toh(len);
+        pos += 4;
+        if (len > traffic_len - pos) {
+            fprintf(stderr, "Recording truncated\n");
+            break;
+        }
+
+        const ProtobufCMessageDescriptor *descriptor = NULL;
+        switch (mdif_msg_component(traffic + pos, len)) {
+        case MDIF_COMPONENT_CORE:
+            descriptor = &mdif__core__core_msg__descriptor;
+            break;
+        case MDIF_COMPONENT_RFS:
+            descriptor = &mdif__rfs__rfs_msg__descriptor;
+            break;
+        default:
+            n_other++;
+            break;
+        }
+        if (descriptor) {
+            msgs = realloc(msgs, (n_msgs + 1) * sizeof(*msgs));
+            if (!msgs) {
+                perror("realloc");
+                exit(1);
+            }
+            msgs[n_msgs++] = (struct msg){traffic + pos, len, descriptor};
+        }
+        pos += len;
+    }
+    if (n_other) {
+        printf("Skipped %zu messages of other components\n", n_other);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+// Keeps the compiler from optimizing decoding away
+static volatile uint32_t sink;
+
+// Each fast decoded message must be equal to the protobuf-c result
+static void verify(void)
+{
+    size_t n_fast = 0, n_mismatch = 0, n_bytes = 0;
+    for (size_t i = 0; i < n_msgs; i++) {
+        struct mdif_fast_msg fast;
+        n_bytes += msgs[i].len;
+        if (!mdif_fast_decode(msgs[i].data, msgs[i].len, &fast)) {
+            continue;
+        }
+        n_fast++;
+        ProtobufCMessage *pbc = protobuf_c_message_unpack(msgs[i].descriptor, NULL, msgs[i].len, msgs[i].data);
+        if (!pbc || mdif_fast_cmp(&fast, pbc) != 0) {
+            fprintf(stderr, "Message %zu (field %u) decoded differently\n", i, fast.field);
+            n_mismatch++;
+        }
+        if (pbc) {
+            protobuf_c_message_free_unpacked(pbc, NULL);
+        }
+    }
+    printf("%zu messages, %zu bytes, %zu (%.1f%%) handled by fast decoders\n", n_msgs, n_bytes, n_fast,
+           n_msgs ? 100.0 * n_fast / n_msgs : 0.0);
+    if (n_mismatch) {
+        fprintf(stderr, "%zu mismatches\n", n_mismatch);
+        exit(1);
+    }
+}
+
+static void decode_pbc(const struct msg *m)
+{
+    ProtobufCMessage *pbc = protobuf_c_message_unpack(m->descriptor, NULL, m->len, m->data);
+    sink += pbc != NULL;
+    protobuf_c_message_free_unpacked(pbc, NULL);
+}
+
+// Like the demos, see linux_core_codec/mdif_arena.h
+static void decode_pbc_arena(const struct msg *m)
+{
+    mdif_arena_mark_t mark = mdif_arena_mark();
+    ProtobufCMessage *pbc = protobuf_c_message_unpack(m->descriptor, mdif_arena(), m->len, m->data);
+    sink += pbc != NULL;
+    mdif_arena_release(mark);
+}
+
+static void decode_fast(const struct msg *m)
+{
+    struct mdif_fast_msg fast;
+    uint32_t field = mdif_fast_decode(m->data, m->len, &fast);
+    if (field) {
+        sink += field;
+    } else {
+        decode_pbc_arena(m);
+    }
+}
+
+static void run(const char *name, void (*decode)(const struct msg *))
+{
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned it = 0; it < args.iterations; it++) {
+        for (size_t i = 0; i < n_msgs; i++) {
+            decode(&msgs[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    printf("%-20s %8.1f ns/msg\n", name, ns / ((double)args.iterations * n_msgs));
+}
+
+int main(int argc, char *argv[])
+{
+    argp_parse(&argp, argc, argv, 0, 0, &args);
+
+    if (args.recording) {
+        load(args.recording);
+    } else {
+        synthesize(args.count);
+        if (args.write) {
+            save(args.write);
+        }
+    }
+    split();
+    if (!n_msgs) {
+        fprintf(stderr, "No core or RFS messages\n");
+        return 1;
+    }
+    verify();
+
+    run("protobuf-c", decode_pbc);
+    run("protobuf-c arena", decode_pbc_arena);
+    run("fast", decode_fast);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_fast_wire.h                                             *
+ *                                                                             *
+ * Description  : Wire format primitives for the generated fast MDIF decoders. *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_FAST_WIRE_H
+#define _MDIF_FAST_WIRE_H
+
+// Helpers used by the decoders generated by gen_fast_decode.py. Each takes the
+// current position and the end of the buffer, stores the decoded value and
+// returns the position after it, or NULL if the buffer is truncated or the
+// value malformed.
+
+#include <endian.h>
+#include <stdint.h>
+#include <string.h>
+
+// A string or bytes field. Points into the decoded buffer, which must be kept
+// while the field is used. Strings are not NUL terminated.
+struct mdif_fast_bytes {
+    const uint8_t *data;
+    uint32_t len;
+};
+
+// Fixed 32/64 bit fields can be loaded directly on little endian hosts
+static inline const uint8_t *mdif_fast_fixed32(const uint8_t *p, const uint8_t *end, void *v) {
+    if (end - p < 4) {
+        return NULL;
+    }
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    x = le32toh(x);
+    memcpy(v, &x, sizeof(x));
+    return p + 4;
+}
+
+static inline const uint8_t *mdif_fast_fixed64(const uint8_t *p, const uint8_t *end, void *v) {
+    if (end - p < 8) {
+        return NULL;
+    }
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    x = le64toh(x);
+    memcpy(v, &x, sizeof(x));
+    return p + 8;
+}
+
+// Varint of any length, one byte at a time
+static inline const uint8_t *mdif_fast_varint_slow(const uint8_t *p, const uint8_t *end, uint64_t *v) {
+    uint64_t x = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        x |= (uint64_t)(b & 0x7f) << shift;
+        if (b < 0x80) {
+            *v = x;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Most varints are tags, lengths and small values of a single byte. Up to 8
+// bytes are decoded from one load: the first clear continuation bit gives the
+// length, and the 7 bit groups are then packed together without a loop.
+static inline const uint8_t *mdif_fast_varint(const uint8_t *p, const uint8_t *end, uint64_t *v) {
+    if (p < end && *p < 0x80) {
+        *v = *p;
+        return p + 1;
+    }
+    if (end - p < 8) {
+        return mdif_fast_varint_slow(p, end, v);
+    }
+
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    x = le64toh(x);
+    uint64_t stop = ~x & 0x8080808080808080ULL;
+    if (!stop) {
+        // 9 or 10 bytes, i.e. a negative int32/int64
+        return mdif_fast_varint_slow(p, end, v);
+    }
+    x &= stop ^ (stop - 1);
+    x = (x & 0x000000000000007fULL) | ((x & 0x0000000000007f00ULL) >> 1) | ((x & 0x00000000007f0000ULL) >> 2) |
+        ((x & 0x000000007f000000ULL) >> 3) | ((x & 0x0000007f00000000ULL) >> 4) | ((x & 0x00007f0000000000ULL) >> 5) |
+        ((x & 0x007f000000000000ULL) >> 6) | ((x & 0x7f00000000000000ULL) >> 7);
+    *v = x;
+    return p + (__builtin_ctzll(stop) + 1) / 8;
+}
+
+// Length delimited field. The contents are returned in b.
+static inline const uint8_t *mdif_fast_delim(const uint8_t *p, const uint8_t *end, struct mdif_fast_bytes *b) {
+    uint64_t len;
+    p = mdif_fast_varint(p, end, &len);
+    if (!p || len > (uint64_t)(end - p)) {
+        return NULL;
+    }
+    b->data = p;
+    b->len = len;
+    return p + len;
+}
+
+// Encode `v` as a varint at `p`, which has room for 5 bytes. Returns the
+// position after it. For the few messages encoded by hand.
+static inline uint8_t *mdif_fast_put_varint32(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = v | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static inline int32_t mdif_fast_zigzag32(uint64_t v) {
+    return (int32_t)((uint32_t)v >> 1 ^ -(uint32_t)(v & 1));
+}
+
+static inline int64_t mdif_fast_zigzag64(uint64_t v) {
+    return (int64_t)(v >> 1 ^ -(v & 1));
+}
+
+#endif /* _MDIF_FAST_WIRE_H */
@@ -0,0 +1,519 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : fwu_client.c                                                 *
+ *                                                                             *
+ * Description  : Pipelined firmware update of an MDIF device from a mapped    *
+ *              : image.                                                       *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fwu_client.h"
+#include "linux_core_codec/mdif_const_msg.h"
+#include "linux_core_codec/mdif_router.h"
+#include "linux_fast_decode/mdif_fast_wire.h"
+
+// Oneof fields of FwuMsg, see fwu.proto
+#define FWU_INIT_REQ 0x20
+#define FWU_INIT_RES 0x21
+#define FWU_CHUNK_REQ 0x22
+#define FWU_CHUNK_RES 0x23
+#define FWU_STATE_IND 0x24
+#define FWU_ABORT_REQ 0x25
+#define FWU_ABORT_RES 0x26
+
+#define FWU_DEFAULT_WINDOW 8
+#define FWU_DEFAULT_TIMEOUT_MS 5000
+
+// Status enum of common.proto
+#define STATUS_SUCCESS 0
+#define STATUS_ERR_NOT_READY 5
+#define STATUS_ERR_SIZE 6
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+}
+
+// Varint fields 1 to 3 of the FWU message in `buf`, which are all any of them
+// has. Fields not present are 0, as in proto3. Returns the oneof field number,
+// or 0 if the message is malformed.
+static uint32_t parse(const uint8_t *buf, uint32_t size, uint32_t vals[4])
+{
+    memset(vals, 0, 4 * sizeof(vals[0]));
+    uint64_t tag;
+    struct mdif_fast_bytes msg;
+    const uint8_t *p = mdif_fast_varint(buf, buf + size, &tag);
+    if (!p || (tag & 7) != 2 || !mdif_fast_delim(p, buf + size, &msg)) {
+        return 0;
+    }
+    const uint8_t *end = msg.data + msg.len;
+    for (p = msg.data; p && p < end;) {
+        uint64_t field, v;
+        struct mdif_fast_bytes b;
+        p = mdif_fast_varint(p, end, &field);
+        if (!p) {
+            return 0;
+        }
+        switch (field & 7) {
+        case 0:
+            p = mdif_fast_varint(p, end, &v);
+            if (p && (field >> 3) < 4) {
+                vals[field >> 3] = v;
+            }
+            break;
+        case 1:
+            p = mdif_fast_fixed64(p, end, &v);
+            break;
+        case 2:
+            p = mdif_fast_delim(p, end, &b);
+            break;
+        case 5:
+            p = mdif_fast_fixed32(p, end, &v);
+            break;
+        default:
+            return 0;
+        }
+    }
+    return p ? tag >> 3 : 0;
+}
+
+static int status_errno(uint32_t status)
+{
+    switch (status) {
+    case STATUS_ERR_NOT_READY:
+        return EBUSY;
+    case STATUS_ERR_SIZE:
+        return EFBIG;
+    default:
+        return EPROTO;
+    }
+}
+
+static void fail(struct fwu_client *c, int err)
+{
+    c->phase = FWU_PHASE_FAILED;
+    c->err = err;
+    c->deadline_ms = 0;
+}
+
+// Send the chunks not acknowledged again, from the oldest. Requests are sent
+// by kick().
+static void resume(struct fwu_client *c)
+{
+    if (c->in_flight) {
+        c->resumed = true;
+    }
+    c->sent = c->acked;
+    c->in_flight = 0;
+    c->deadline_ms = 0;
+}
+
+// The device has chunks out of order or twice, so start over. Requests are
+// sent by kick().
+static void restart(struct fwu_client *c)
+{
+    if (++c->restarts > FWU_CLIENT_MAX_RESTARTS) {
+        fail(c, ECONNRESET);
+        return;
+    }
+    c->phase = FWU_PHASE_ABORT;
+    c->req_sent = false;
+    c->acked = c->sent = 0;
+    c->in_flight = 0;
+    c->resumed = false;
+    c->deadline_ms = 0;
+}
+
+static void awaiting(struct fwu_client *c)
+{
+    if (!c->deadline_ms) {
+        c->deadline_ms = now_ms() + c->timeout_ms;
+    }
+}
+
+static void send_init(struct fwu_client *c)
+{
+    uint8_t req[16], body[8];
+    uint8_t *p = body;
+    *p++ = 0x08; // size = 1
+    p = mdif_fast_put_varint32(p, c->image->size);
+    if (c->force) {
+        *p++ = 0x10; // force = 2
+        *p++ = 1;
+    }
+    uint32_t n = p - body;
+    p = mdif_fast_put_varint32(req, MDIF_TAG_LEN_DELIM(FWU_INIT_REQ));
+    p = mdif_fast_put_varint32(p, n);
+    memcpy(p, body, n);
+    struct iovec part = {.iov_base = req, .iov_len = p + n - req};
+    if (c->send(&part, 1, c->send_ctx) == 0) {
+        c->req_sent = true;
+        awaiting(c);
+    }
+}
+
+static void send_abort(struct fwu_client *c)
+{
+    MDIF_EMPTY_MSG(req, FWU_ABORT_REQ);
+    struct iovec part = {.iov_base = (uint8_t *)req, .iov_len = req_len};
+    if (c->send(&part, 1, c->send_ctx) == 0) {
+        c->req_sent = true;
+        awaiting(c);
+    }
+}
+
+// Send chunks until `window` are in flight. The data is sent from the mapping.
+static void send_chunks(struct fwu_client *c)
+{
+    unsigned window = c->window ? c->window : 1;
+    while (c->in_flight < window && c->sent < c->image->size) {
+        uint32_t n = c->image->size - c->sent;
+        n = n < c->chunk_size ? n : c->chunk_size;
+        uint8_t data_hdr[6], hdr[FWU_CHUNK_HDR_MAX];
+        uint8_t *p = data_hdr;
+        *p++ = 0x0a; // data = 1
+        p = mdif_fast_put_varint32(p, n);
+        uint32_t data_hdr_len = p - data_hdr;
+        p = mdif_fast_put_varint32(hdr, MDIF_TAG_LEN_DELIM(FWU_CHUNK_REQ));
+        p = mdif_fast_put_varint32(p, data_hdr_len + n);
+        memcpy(p, data_hdr, data_hdr_len);
+        p += data_hdr_len;
+        struct iovec parts[] = {
+            {.iov_base = hdr, .iov_len = p - hdr},
+            {.iov_base = (uint8_t *)c->image->data + c->sent, .iov_len = n},
+        };
+        if (c->send(parts, 2, c->send_ctx) == -1) {
+            break;
+        }
+        c->sent += n;
+        c->in_flight++;
+        awaiting(c);
+    }
+}
+
+// Send what is due in the current phase
+static void kick(struct fwu_client *c)
+{
+    if (!c->link_up) {
+        return;
+    }
+    switch (c->phase) {
+    case FWU_PHASE_IDLE:
+        c->phase = FWU_PHASE_INIT;
+        c->req_sent = false;
+        // fall through
+    case FWU_PHASE_INIT:
+        if (!c->req_sent) {
+            send_init(c);
+        }
+        break;
+    case FWU_PHASE_ABORT:
+        if (!c->req_sent) {
+            send_abort(c);
+        }
+        break;
+    case FWU_PHASE_SENDING:
+        send_chunks(c);
+        break;
+    default:
+        break;
+    }
+}
+
+// Unlock and report progress if `changed`
+static void unlock(struct fwu_client *c, bool changed)
+{
+    struct fwu_progress p;
+    if (changed) {
+        p = (struct fwu_progress){
+            .phase = c->phase,
+            .state = c->state,
+            .acked = c->acked,
+            .size = c->image->size,
+            .restarts = c->restarts,
+            .err = c->err,
+        };
+    }
+    pthread_mutex_unlock(&c->lock);
+    if (changed && c->progress) {
+        c->progress(&p, c->progress_ctx);
+    }
+}
+
+int fwu_image_open(struct fwu_image *img, const char *path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0 || st.st_size > UINT32_MAX) {
+        close(fd);
+        errno = EFBIG;
+        return -1;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    // Read ahead, as the image is sent from start to end
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    madvise(data, st.st_size, MADV_WILLNEED);
+    img->data = data;
+    img->size = st.st_size;
+    return 0;
+}
+
+void fwu_image_close(struct fwu_image *img)
+{
+    munmap((void *)img->data, img->size);
+    img->data = NULL;
+    img->size = 0;
+}
+
+void fwu_client_init(struct fwu_client *c, const struct fwu_image *image, fwu_send_t send, void *send_ctx,
+                     fwu_progress_t progress, void *progress_ctx)
+{
+    memset(c, 0, sizeof(*c));
+    pthread_mutex_init(&c->lock, NULL);
+    c->image = image;
+    c->send = send;
+    c->send_ctx = send_ctx;
+    c->progress = progress;
+    c->progress_ctx = progress_ctx;
+    c->window = FWU_DEFAULT_WINDOW;
+    c->timeout_ms = FWU_DEFAULT_TIMEOUT_MS;
+}
+
+void fwu_client_free(struct fwu_client *c)
+{
+    pthread_mutex_destroy(&c->lock);
+}
+
+bool fwu_client_recv(struct fwu_client *c, const uint8_t *buf, uint32_t size)
+{
+    if (mdif_msg_component(buf, size) != MDIF_COMPONENT_FWU) {
+        return false;
+    }
+    uint32_t vals[4];
+    uint32_t field = parse(buf, size, vals);
+    uint32_t status = vals[1];
+
+    pthread_mutex_lock(&c->lock);
+    enum fwu_phase phase = c->phase;
+    enum fwu_state state = c->state;
+    uint32_t acked = c->acked;
+    switch (field) {
+    case FWU_INIT_RES:
+        if (c->phase != FWU_PHASE_INIT || !c->req_sent) {
+            break;
+        }
+        c->state = vals[2];
+        c->deadline_ms = 0;
+        if (status != STATUS_SUCCESS) {
+            fail(c, status_errno(status));
+        } else if (c->state != FWU_STATE_RECEIVING_DATA || !vals[3]) {
+            fail(c, EPROTO);
+        } else {
+            c->chunk_size = c->max_chunk && c->max_chunk < vals[3] ? c->max_chunk : vals[3];
+            c->phase = FWU_PHASE_SENDING;
+        }
+        break;
+
+    case FWU_CHUNK_RES:
+        if (c->phase != FWU_PHASE_SENDING || !c->in_flight) {
+            break;
+        }
+        if (status != STATUS_SUCCESS) {
+            // E.g. the device lost the update during a link reset
+            restart(c);
+            break;
+        }
+        c->in_flight--;
+        c->acked += c->image->size - c->acked < c->chunk_size ? c->image->size - c->acked : c->chunk_size;
+        c->deadline_ms = c->in_flight ? now_ms() + c->timeout_ms : 0;
+        if (c->acked == c->image->size) {
+            c->phase = FWU_PHASE_WAITING;
+            c->deadline_ms = now_ms() + FWU_CLIENT_DONE_TIMEOUT_MS;
+        }
+        break;
+
+    case FWU_STATE_IND:
+        // The state is field 1 of FwuStateInd
+        c->state = vals[1];
+        if (c->phase < FWU_PHASE_INIT || c->phase > FWU_PHASE_WAITING) {
+            break;
+        }
+        if (c->state == FWU_STATE_ERROR && c->resumed) {
+            // Probably a resent chunk that had arrived after all
+            restart(c);
+        } else if (c->state == FWU_STATE_ERROR) {
+            fail(c, EIO);
+        } else if (c->state == FWU_STATE_COMPLETE && c->phase == FWU_PHASE_WAITING) {
+            c->phase = FWU_PHASE_DONE;
+            c->deadline_ms = 0;
+        } else if (c->phase == FWU_PHASE_SENDING &&
+                   (c->state == FWU_STATE_IDLE || (c->state != FWU_STATE_RECEIVING_DATA && c->sent < c->image->size))) {
+            // Lost the update, or got the full size before the end of the
+            // image, i.e. resent chunks had arrived
+            restart(c);
+        } else if (c->phase == FWU_PHASE_WAITING) {
+            // Still working
+            c->deadline_ms = now_ms() + FWU_CLIENT_DONE_TIMEOUT_MS;
+        }
+        break;
+
+    case FWU_ABORT_RES:
+        if (c->phase != FWU_PHASE_ABORT || !c->req_sent) {
+            break;
+        }
+        // Whatever the status, the device is not receiving anymore
+        c->state = vals[2];
+        c->phase = FWU_PHASE_INIT;
+        c->req_sent = false;
+        c->deadline_ms = 0;
+        break;
+
+    default:
+        break;
+    }
+    kick(c);
+    unlock(c, c->phase != phase || c->state != state || c->acked != acked);
+    return true;
+}
+
+void fwu_client_link_up(struct fwu_client *c)
+{
+    pthread_mutex_lock(&c->lock);
+    enum fwu_phase phase = c->phase;
+    c->link_up = true;
+    kick(c);
+    unlock(c, c->phase != phase);
+}
+
+void fwu_client_link_down(struct fwu_client *c)
+{
+    pthread_mutex_lock(&c->lock);
+    enum fwu_phase phase = c->phase;
+    c->link_up = false;
+    switch (c->phase) {
+    case FWU_PHASE_ABORT:
+    case FWU_PHASE_INIT:
+        if (c->req_sent) {
+            // Not known if the request arrived
+            restart(c);
+        }
+        break;
+    case FWU_PHASE_SENDING:
+        resume(c);
+        break;
+    default:
+        // While waiting the device works on its own
+        break;
+    }
+    unlock(c, c->phase != phase);
+}
+
+void fwu_client_tick(struct fwu_client *c, uint64_t now_ms)
+{
+    pthread_mutex_lock(&c->lock);
+    enum fwu_phase phase = c->phase;
+    if (c->deadline_ms && now_ms >= c->deadline_ms) {
+        if (c->phase == FWU_PHASE_WAITING) {
+            fail(c, ETIMEDOUT);
+        } else if (c->phase == FWU_PHASE_SENDING) {
+            resume(c);
+        } else {
+            restart(c);
+        }
+    }
+    // Also retries sends that failed
+    kick(c);
+    unlock(c, c->phase != phase);
+}
+
+void fwu_client_abort(struct fwu_client *c)
+{
+    pthread_mutex_lock(&c->lock);
+    enum fwu_phase phase = c->phase;
+    if (c->phase != FWU_PHASE_DONE && c->phase != FWU_PHASE_FAILED) {
+        if (c->link_up && c->phase != FWU_PHASE_IDLE) {
+            send_abort(c);
+        }
+        fail(c, ECANCELED);
+    }
+    unlock(c, c->phase != phase);
+}
+
+void fwu_client_get_progress(struct fwu_client *c, struct fwu_progress *p)
+{
+    pthread_mutex_lock(&c->lock);
+    *p = (struct fwu_progress){
+        .phase = c->phase,
+        .state = c->state,
+        .acked = c->acked,
+        .size = c->image->size,
+        .restarts = c->restarts,
+        .err = c->err,
+    };
+    pthread_mutex_unlock(&c->lock);
+}
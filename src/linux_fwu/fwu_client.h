@@ -0,0 +1,195 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : fwu_client.h                                                 *
+ *                                                                             *
+ * Description  : Pipelined firmware update of an MDIF device from a mapped    *
+ *              : image.                                                       *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#ifndef _FWU_CLIENT_H
+#define _FWU_CLIENT_H
+
+// Firmware update with FwuInitReq, FwuChunkReq and FwuStateInd, see fwu.proto.
+//
+// The image is mapped read-only, and each FwuChunkReq is sent as a header of a
+// few bytes plus a slice of the mapping, so the transport can send it without
+// copying, e.g. with mdif_client_sendv(). Up to `window` chunks are sent
+// before their FwuChunkRes, instead of one per round trip. A device answers
+// chunks in order, so each response acknowledges the oldest chunk in flight.
+//
+// After a link reset, or a response timeout, the update resumes from the
+// oldest chunk not acknowledged. FwuChunkReq carries no offset and the device
+// appends every chunk it gets, so chunks in flight that had arrived are then
+// received twice. The device notices when it gets more than the image size:
+// it rejects the chunk, leaves RECEIVING_DATA before the last chunk is sent,
+// or fails to verify the image. The update is then restarted with FwuAbortReq
+// and FwuInitReq, at most FWU_CLIENT_MAX_RESTARTS times.
+//
+// The messages are encoded and decoded by hand, so there is no protobuf
+// dependency. All functions may be called from any thread.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#ifndef FWU_CLIENT_MAX_RESTARTS
+#define FWU_CLIENT_MAX_RESTARTS 3
+#endif
+#ifndef FWU_CLIENT_DONE_TIMEOUT_MS
+// Time allowed for processing, erasing, writing and verifying after the last
+// chunk
+#define FWU_CLIENT_DONE_TIMEOUT_MS 300000
+#endif
+// Bytes of a FwuChunkReq before its data
+#define FWU_CHUNK_HDR_MAX 13
+
+// State of the device, the State enum of fwu.proto
+enum fwu_state {
+    FWU_STATE_IDLE = 0,
+    FWU_STATE_RECEIVING_DATA = 1,
+    FWU_STATE_PROCESSING_IMAGE = 2,
+    FWU_STATE_ERASING_FLASH = 3,
+    FWU_STATE_WRITING_FLASH = 4,
+    FWU_STATE_VERIFYING_FLASH = 5,
+    FWU_STATE_COMPLETE = 6,
+    FWU_STATE_ERROR = 7,
+};
+
+// State of the client
+enum fwu_phase {
+    FWU_PHASE_IDLE,    // Waiting for the link
+    FWU_PHASE_ABORT,   // FwuAbortReq sent, to restart
+    FWU_PHASE_INIT,    // FwuInitReq sent
+    FWU_PHASE_SENDING, // Sending chunks
+    FWU_PHASE_WAITING, // All chunks acknowledged, waiting for FWU_STATE_COMPLETE
+    FWU_PHASE_DONE,
+    FWU_PHASE_FAILED,
+};
+
+struct fwu_image {
+    const uint8_t *data;
+    uint32_t size;
+};
+
+struct fwu_progress {
+    enum fwu_phase phase;
+    enum fwu_state state; // As last reported by the device
+    uint32_t acked;       // Bytes acknowledged
+    uint32_t size;
+    unsigned restarts;
+    int err; // errno value if FWU_PHASE_FAILED
+};
+
+// Send a message in `n_parts` parts, the last a slice of the image. Called
+// with the client locked, so it must not call fwu_client functions. Returns
+// -1 with errno set if the message was not sent; it is retried on the next
+// response, fwu_client_tick() or fwu_client_link_up().
+typedef int (*fwu_send_t)(const struct iovec *parts, int n_parts, void *ctx);
+
+// Called on changes of phase or device state, and on acknowledged chunks.
+// Called without the client locked.
+typedef void (*fwu_progress_t)(const struct fwu_progress *p, void *ctx);
+
+struct fwu_client {
+    pthread_mutex_t lock;
+    const struct fwu_image *image;
+    fwu_send_t send;
+    void *send_ctx;
+    fwu_progress_t progress;
+    void *progress_ctx;
+    // Settings, may be changed before the first fwu_client_link_up()
+    bool force;          // FwuInitReq.force, see fwu.proto
+    unsigned window;     // Chunks in flight
+    uint32_t max_chunk;  // Largest chunk the transport takes, 0 for no limit
+    uint32_t timeout_ms; // Time to wait for a response
+    // State
+    bool link_up;
+    enum fwu_phase phase;
+    bool req_sent; // FwuAbortReq or FwuInitReq of the phase sent
+    enum fwu_state state;
+    uint32_t chunk_size; // max_chunk_size of FwuInitRes, or less
+    uint32_t acked;      // Offset of the oldest chunk in flight
+    uint32_t sent;       // Offset of the next chunk to send
+    unsigned in_flight;
+    bool resumed; // Chunks resent since FwuInitReq
+    unsigned restarts;
+    int err;
+    uint64_t deadline_ms; // For the oldest response, 0 if none awaited
+};
+
+// Map `path` read-only. Returns -1 with errno set on error.
+int fwu_image_open(struct fwu_image *img, const char *path);
+void fwu_image_close(struct fwu_image *img);
+
+// Update with `image`, which must stay mapped until done. Messages are sent
+// with `send`. Starts on fwu_client_link_up().
+void fwu_client_init(struct fwu_client *c, const struct fwu_image *image, fwu_send_t send, void *send_ctx,
+                     fwu_progress_t progress, void *progress_ctx);
+void fwu_client_free(struct fwu_client *c);
+
+// Handle a message received from the device. Returns false if it is not a
+// FWU message.
+bool fwu_client_recv(struct fwu_client *c, const uint8_t *buf, uint32_t size);
+
+// Link to the device established, the first time or after a reset
+void fwu_client_link_up(struct fwu_client *c);
+
+// Link to the device reset or lost
+void fwu_client_link_down(struct fwu_client *c);
+
+// Check the timeout, at `now_ms` (CLOCK_MONOTONIC). A timeout is handled like
+// a link reset. Call regularly, e.g. every 100 ms.
+void fwu_client_tick(struct fwu_client *c, uint64_t now_ms);
+
+// Abort the update with FwuAbortReq
+void fwu_client_abort(struct fwu_client *c);
+
+void fwu_client_get_progress(struct fwu_client *c, struct fwu_progress *p);
+
+#endif // _FWU_CLIENT_H
@@ -0,0 +1,400 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : fwu_client_test.c                                            *
+ *                                                                             *
+ * Description  : Tests of fwu_client against a simulated device               *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fwu_client.h"
+#include "linux_core_codec/mdif_const_msg.h"
+#include "linux_fast_decode/mdif_fast_wire.h"
+#include "test/mdif_test.h"
+
+// A simulated device with a link of two queues. Each round trip, the device
+// handles the requests sent to it, and the client the responses.
+
+// Oneof fields of FwuMsg, see fwu.proto
+#define FWU_INIT_REQ 0x20
+#define FWU_INIT_RES 0x21
+#define FWU_CHUNK_REQ 0x22
+#define FWU_CHUNK_RES 0x23
+#define FWU_STATE_IND 0x24
+#define FWU_ABORT_REQ 0x25
+#define FWU_ABORT_RES 0x26
+
+// Status enum of common.proto
+#define STATUS_SUCCESS 0
+#define STATUS_ERR_SIZE 6
+
+#define IMAGE_SIZE 10000
+#define MAX_CHUNK 256
+#define CHUNKS ((IMAGE_SIZE + MAX_CHUNK - 1) / MAX_CHUNK)
+#define WINDOW 8
+#define MAX_ROUNDS 1000
+
+struct msg {
+    uint8_t data[MAX_CHUNK + FWU_CHUNK_HDR_MAX];
+    uint32_t size;
+};
+
+struct queue {
+    struct msg msgs[64];
+    unsigned n;
+};
+
+static uint8_t image_data[IMAGE_SIZE];
+static const struct fwu_image image = {image_data, IMAGE_SIZE};
+
+static struct queue to_device, to_client;
+static bool link_ok;
+
+// The device
+static enum fwu_state state;
+static uint8_t received[2 * IMAGE_SIZE];
+static uint32_t n_received;
+static uint32_t expected;
+static unsigned chunk_reqs;
+// Chunks received and not answered, largest number seen
+static unsigned outstanding, max_outstanding;
+// Chunks to lose on the link after `lose_after` more
+static unsigned lose, lose_after;
+
+static uint64_t mono_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+}
+
+// The transport of the client
+static int send_parts(const struct iovec *parts, int n_parts, void *ctx)
+{
+    if (!link_ok) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    struct msg *m = &to_device.msgs[to_device.n];
+    m->size = 0;
+    for (int i = 0; i < n_parts; i++) {
+        memcpy(m->data + m->size, parts[i].iov_base, parts[i].iov_len);
+        m->size += parts[i].iov_len;
+    }
+    to_device.n++;
+    return 0;
+}
+
+// Queue a response with varint fields 1 to 3, 0 if not present
+static void respond(uint32_t field, uint32_t v1, uint32_t v2, uint32_t v3)
+{
+    uint8_t body[16];
+    uint8_t *p = body;
+    uint32_t vals[] = {v1, v2, v3};
+    for (int i = 0; i < 3; i++) {
+        if (vals[i]) {
+            *p++ = (i + 1) << 3;
+            p = mdif_fast_put_varint32(p, vals[i]);
+        }
+    }
+    struct msg *m = &to_client.msgs[to_client.n++];
+    uint8_t *q = mdif_fast_put_varint32(m->data, MDIF_TAG_LEN_DELIM(field));
+    q = mdif_fast_put_varint32(q, p - body);
+    memcpy(q, body, p - body);
+    m->size = q + (p - body) - m->data;
+}
+
+static void set_state(enum fwu_state s)
+{
+    state = s;
+    respond(FWU_STATE_IND, s, 0, 0);
+}
+
+// The device handling a request
+static void handle(const uint8_t *buf, uint32_t size)
+{
+    uint64_t tag = 0, v = 0;
+    struct mdif_fast_bytes body, data = {0};
+    const uint8_t *p = mdif_fast_varint(buf, buf + size, &tag);
+    if (!p || !mdif_fast_delim(p, buf + size, &body)) {
+        return;
+    }
+    switch (tag >> 3) {
+    case FWU_INIT_REQ:
+        // Only field 1, the size, is sent without force
+        p = mdif_fast_varint(body.data + 1, body.data + body.len, &v);
+        if (state != FWU_STATE_IDLE) {
+            respond(FWU_INIT_RES, 5, state, 0);
+            break;
+        }
+        expected = v;
+        n_received = 0;
+        state = FWU_STATE_RECEIVING_DATA;
+        respond(FWU_INIT_RES, STATUS_SUCCESS, state, MAX_CHUNK);
+        break;
+    case FWU_CHUNK_REQ:
+        chunk_reqs++;
+        mdif_fast_delim(body.data + 1, body.data + body.len, &data);
+        if (state != FWU_STATE_RECEIVING_DATA || n_received + data.len > expected) {
+            respond(FWU_CHUNK_RES, STATUS_ERR_SIZE, 0, 0);
+            break;
+        }
+        memcpy(received + n_received, data.data, data.len);
+        n_received += data.len;
+        respond(FWU_CHUNK_RES, STATUS_SUCCESS, 0, 0);
+        if (n_received == expected) {
+            set_state(FWU_STATE_PROCESSING_IMAGE);
+            bool good = expected == IMAGE_SIZE && memcmp(received, image_data, IMAGE_SIZE) == 0;
+            set_state(good ? FWU_STATE_COMPLETE : FWU_STATE_ERROR);
+        }
+        break;
+    case FWU_ABORT_REQ:
+        state = FWU_STATE_IDLE;
+        respond(FWU_ABORT_RES, STATUS_SUCCESS, state, 0);
+        break;
+    }
+}
+
+// The device handles the requests sent to it
+static void deliver(void)
+{
+    for (unsigned i = 0; i < to_device.n; i++) {
+        const struct msg *m = &to_device.msgs[i];
+        uint64_t tag = 0;
+        mdif_fast_varint(m->data, m->data + m->size, &tag);
+        if (tag >> 3 == FWU_CHUNK_REQ && lose && !lose_after--) {
+            lose--;
+            lose_after = 0;
+            continue;
+        }
+        outstanding += tag >> 3 == FWU_CHUNK_REQ;
+        max_outstanding = outstanding > max_outstanding ? outstanding : max_outstanding;
+        handle(m->data, m->size);
+    }
+    to_device.n = 0;
+}
+
+// The device handles the requests, then the client the responses. Returns
+// false if nothing was sent either way.
+static bool round_trip(struct fwu_client *c)
+{
+    if (!to_device.n && !to_client.n) {
+        return false;
+    }
+    deliver();
+    struct queue q = to_client;
+    to_client.n = 0;
+    for (unsigned i = 0; i < q.n; i++) {
+        uint64_t tag = 0;
+        mdif_fast_varint(q.msgs[i].data, q.msgs[i].data + q.msgs[i].size, &tag);
+        outstanding -= tag >> 3 == FWU_CHUNK_RES;
+        fwu_client_recv(c, q.msgs[i].data, q.msgs[i].size);
+    }
+    return true;
+}
+
+// The link is reset, losing what is on it
+static void reset_link(struct fwu_client *c)
+{
+    link_ok = false;
+    to_device.n = to_client.n = 0;
+    outstanding = 0;
+    fwu_client_link_down(c);
+}
+
+// Round trips until the link is idle, timing out once if the update is not
+// done. Returns the number of round trips.
+static unsigned run(struct fwu_client *c)
+{
+    unsigned rounds = 0;
+    for (int timeouts = 0; rounds < MAX_ROUNDS; rounds++) {
+        if (!round_trip(c)) {
+            struct fwu_progress p;
+            fwu_client_get_progress(c, &p);
+            if (p.phase == FWU_PHASE_DONE || p.phase == FWU_PHASE_FAILED || timeouts++) {
+                break;
+            }
+            fwu_client_tick(c, mono_ms() + FWU_CLIENT_DONE_TIMEOUT_MS / 2);
+        }
+    }
+    return rounds;
+}
+
+static void start(struct fwu_client *c)
+{
+    to_device.n = to_client.n = 0;
+    state = FWU_STATE_IDLE;
+    chunk_reqs = outstanding = max_outstanding = 0;
+    lose = lose_after = 0;
+    fwu_client_init(c, &image, send_parts, NULL, NULL, NULL);
+    c->window = WINDOW;
+    link_ok = true;
+    fwu_client_link_up(c);
+}
+
+// Done, with the image on the device
+static bool done(struct fwu_client *c, unsigned restarts)
+{
+    struct fwu_progress p;
+    fwu_client_get_progress(c, &p);
+    if (p.phase != FWU_PHASE_DONE || p.restarts != restarts || p.acked != IMAGE_SIZE) {
+        printf("phase %d, state %d, restarts %u, acked %u, err %d\n", p.phase, p.state, p.restarts, p.acked,
+               p.err);
+        return false;
+    }
+    return state == FWU_STATE_COMPLETE && n_received == IMAGE_SIZE && memcmp(received, image_data, IMAGE_SIZE) == 0;
+}
+
+// Send chunks until `n` have been received by the device
+static void transfer(struct fwu_client *c, unsigned n)
+{
+    while (chunk_reqs < n && round_trip(c)) {
+    }
+}
+
+int main(void)
+{
+    int fails = 0;
+    static struct fwu_client c;
+
+    srand(1);
+    for (int i = 0; i < IMAGE_SIZE; i++) {
+        image_data[i] = rand();
+    }
+
+    // Image mapped from a file
+    char path[] = "/tmp/fwu_client_test.XXXXXX";
+    int fd = mkstemp(path);
+    struct fwu_image img;
+    bool good = fd != -1 && write(fd, image_data, IMAGE_SIZE) == IMAGE_SIZE && fwu_image_open(&img, path) == 0;
+    CHECK("image mapped", good && img.size == IMAGE_SIZE && memcmp(img.data, image_data, IMAGE_SIZE) == 0);
+    if (good) {
+        fwu_image_close(&img);
+    }
+    if (fd != -1) {
+        close(fd);
+        unlink(path);
+    }
+
+    // The window is refilled as chunks are acknowledged, so each round trip
+    // but the first sends a window of chunks
+    start(&c);
+    unsigned rounds = run(&c);
+    printf("%u chunks in %u round trips\n", CHUNKS, rounds);
+    CHECK("window: done", done(&c, 0));
+    CHECK("window: one round trip per window", rounds <= 1 + (CHUNKS + WINDOW - 1) / WINDOW + 1);
+    CHECK("window: full windows in flight", max_outstanding == WINDOW);
+    CHECK("window: each chunk sent once", chunk_reqs == CHUNKS);
+    fwu_client_free(&c);
+
+    // The last chunk is lost. It is sent again after the timeout.
+    start(&c);
+    lose = 1;
+    lose_after = CHUNKS - 1;
+    run(&c);
+    CHECK("lost chunk: resent and done", done(&c, 0));
+    CHECK("lost chunk: sent again", chunk_reqs == CHUNKS);
+    fwu_client_free(&c);
+
+    // The device lost the update, e.g. rebooted, and rejects chunks
+    start(&c);
+    transfer(&c, 12);
+    state = FWU_STATE_IDLE;
+    run(&c);
+    CHECK("restart: done", done(&c, 1));
+    fwu_client_free(&c);
+
+    // Link reset with chunks in flight that did not arrive. The update is
+    // resumed, not restarted.
+    start(&c);
+    transfer(&c, 12);
+    reset_link(&c);
+    fwu_client_tick(&c, mono_ms());
+    struct fwu_progress p;
+    fwu_client_get_progress(&c, &p);
+    CHECK("link down: waiting for the link", p.phase == FWU_PHASE_SENDING && p.acked == n_received);
+    link_ok = true;
+    fwu_client_link_up(&c);
+    run(&c);
+    CHECK("link down: resumed and done", done(&c, 0));
+    CHECK("link down: in flight chunks resent", chunk_reqs == CHUNKS);
+    fwu_client_free(&c);
+
+    // Link reset with chunks in flight that arrived, but not their responses.
+    // The device rejects the chunks past the image, and the update is
+    // restarted.
+    start(&c);
+    transfer(&c, 12);
+    deliver();
+    reset_link(&c);
+    link_ok = true;
+    fwu_client_link_up(&c);
+    run(&c);
+    CHECK("link down after chunks arrived: restarted and done", done(&c, 1));
+    fwu_client_free(&c);
+
+    // Link reset with no chunks in flight
+    start(&c);
+    transfer(&c, 12);
+    while (round_trip(&c)) {
+    }
+    reset_link(&c);
+    link_ok = true;
+    fwu_client_link_up(&c);
+    run(&c);
+    CHECK("link down when done: still done", done(&c, 0));
+    fwu_client_free(&c);
+
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,406 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : main.c                                                       *
+ *                                                                             *
+ * Description  : Firmware update of MDIF devices on serial or TCP links.      *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#define _GNU_SOURCE
+#include <argp.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hdlc/include/hdlc.h"
+#include "hdlc/include/hdlc_os.h"
+#include "hdlc/ports/linux/linux_port.h"
+
+#include "fwu_client.h"
+#include "linux_mdif_socket/mdif_client.h"
+
+// Updates any number of devices on TCP, e.g. networked devices or serial
+// devices behind mdif_gatewayd, and at most one device on a local serial port,
+// with the same image. The image is mapped once, and chunks are sent from the
+// mapping, see fwu_client.
+//
+// TCP devices are serviced by one mdif_client thread. A lost connection is
+// reconnected by mdif_client, and the update resumed or restarted by
+// fwu_client. On the serial port an HDLC reset is handled alike.
+
+#define TICK_MS 100
+// Frames queued in HDLC, beyond the chunk window
+#define HDLC_TXQ_MAX 32
+
+//////////////////////////////////////////////////////////////////////////////
+// Arguments
+
+static char doc[] = "\nMDIF firmware update. Updates the devices with IMAGE.\n"
+                    "\vA device is a serial device, e.g. /dev/ttyUSB0, or \"host[:port]\" of a networked device "
+                    "or mdif_gatewayd. At most one serial device may be given.\n";
+static char args_doc[] = "IMAGE DEVICE...";
+static struct argp_option options[] = {
+    {"verbose", 'v', 0, 0, "Verbose output. Repeat for increased verbosity."},
+    {"window", 'w', "CHUNKS", 0, "Chunks sent before their response. Default 8."},
+    {"timeout", 't', "MS", 0, "Time to wait for a response before restarting. Default 5000."},
+    {"force", 'F', 0, 0, "Skip the update guards of the device. Could brick the device."},
+    {"baud", 'b', "RATE", 0, "Serial baud rate. Default 460800."},
+    {"rtscts", 'f', 0, 0, "Enable RTS/CTS hardware flow control on serial device."},
+    {"low-latency", 'l', 0, 0, "Request low latency mode from serial driver."},
+    {0}};
+
+struct args {
+    const char *image;
+    const char **devices;
+    unsigned n_devices;
+    int verbose;
+    unsigned window;
+    uint32_t timeout_ms;
+    bool force;
+    struct serial_config serial;
+} args = {
+    // Defaults
+    .window = 8,
+    .timeout_ms = 5000,
+    .serial = SERIAL_CONFIG_DEFAULT,
+};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state)
+{
+    struct args *args = state->input;
+
+    switch (key) {
+    case ARGP_KEY_ARG:
+        if (state->arg_num == 0) {
+            args->image = arg;
+        } else {
+            args->devices = realloc(args->devices, state->arg_num * sizeof(args->devices[0]));
+            if (!args->devices) {
+                argp_failure(state, 1, errno, "realloc");
+            }
+            args->devices[args->n_devices++] = arg;
+        }
+        break;
+
+    case ARGP_KEY_END:
+        if (state->arg_num < 2) {
+            argp_usage(state);
+        }
+        break;
+
+    case 'v':
+        args->verbose++;
+        break;
+
+    case 'w':
+        args->window = strtoul(arg, NULL, 0);
+        if (args->window < 1) {
+            argp_error(state, "window must be at least 1");
+        }
+        break;
+
+    case 't':
+        args->timeout_ms = strtoul(arg, NULL, 0);
+        break;
+
+    case 'F':
+        args->force = true;
+        break;
+
+    case 'b': {
+        // 0 would hang up the line
+        char *end;
+        errno = 0;
+        unsigned long baud = strtoul(arg, &end, 0);
+        if (errno || end == arg || *end || baud == 0 || baud > UINT32_MAX) {
+            argp_error(state, "invalid baud rate %s", arg);
+        }
+        args->serial.baud = baud;
+        break;
+    }
+
+    case 'f':
+        args->serial.rtscts = true;
+        break;
+
+    case 'l':
+        args->serial.low_latency = true;
+        break;
+
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+
+    return 0;
+}
+
+static struct argp argp = {options, parse_opt, args_doc, doc, 0, 0, 0};
+
+//////////////////////////////////////////////////////////////////////////////
+// Devices
+
+struct target {
+    const char *name;
+    struct fwu_client fwu;
+    mdif_device_t *dev; // NULL for the serial device
+    unsigned percent;   // Last printed
+};
+
+static struct fwu_image image;
+static struct target *targets;
+static struct target *serial_target;
+
+static const char *const phases[] = {
+    [FWU_PHASE_IDLE] = "waiting for link",
+    [FWU_PHASE_ABORT] = "restarting",
+    [FWU_PHASE_INIT] = "initializing",
+    [FWU_PHASE_SENDING] = "sending",
+    [FWU_PHASE_WAITING] = "installing",
+    [FWU_PHASE_DONE] = "complete",
+    [FWU_PHASE_FAILED] = "failed",
+};
+
+// Print phase changes, and every 10% sent
+static void progress(const struct fwu_progress *p, void *ctx)
+{
+    struct target *t = ctx;
+    unsigned percent = (uint64_t)p->acked * 100 / p->size;
+    if (p->phase == FWU_PHASE_SENDING && percent / 10 == t->percent / 10 && args.verbose < 2) {
+        return;
+    }
+    t->percent = percent;
+    if (p->phase == FWU_PHASE_FAILED) {
+        printf("%s: %s: %s\n", t->name, phases[p->phase], strerror(p->err));
+    } else {
+        printf("%s: %s, %u%% sent, device state %d, %u restarts\n", t->name, phases[p->phase], percent, p->state,
+               p->restarts);
+    }
+}
+
+static int tcp_send(const struct iovec *parts, int n_parts, void *ctx)
+{
+    struct target *t = ctx;
+    return mdif_client_sendv(t->dev, parts, n_parts);
+}
+
+// HDLC keeps the frame until hdlc_frame_sent_cb(), and escapes it when
+// sending anyway, so the chunk is copied into one frame
+static int hdlc_send(const struct iovec *parts, int n_parts, void *ctx)
+{
+    if (hdlc->hdlc_tx_queue_size >= HDLC_TXQ_MAX) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    uint32_t len = 0;
+    for (int i = 0; i < n_parts; i++) {
+        len += parts[i].iov_len;
+    }
+    uint8_t *frame = malloc(len);
+    if (!frame) {
+        return -1;
+    }
+    len = 0;
+    for (int i = 0; i < n_parts; i++) {
+        memcpy(frame + len, parts[i].iov_base, parts[i].iov_len);
+        len += parts[i].iov_len;
+    }
+    if (hdlc_send_frame(hdlc, frame, len) != HDLC_SUCCESS) {
+        free(frame);
+        errno = ENOTCONN;
+        return -1;
+    }
+    return 0;
+}
+
+static void tcp_connected(mdif_device_t *dev)
+{
+    struct target *t = mdif_device_user_data(dev);
+    log_info("%s connected", t->name);
+    fwu_client_link_up(&t->fwu);
+}
+
+static void tcp_disconnected(mdif_device_t *dev, int err)
+{
+    struct target *t = mdif_device_user_data(dev);
+    log_warn("%s disconnected (%s)", t->name, err ? strerror(err) : "closed by device");
+    fwu_client_link_down(&t->fwu);
+}
+
+static void tcp_recv(mdif_device_t *dev, const uint8_t *msg, uint32_t len)
+{
+    struct target *t = mdif_device_user_data(dev);
+    fwu_client_recv(&t->fwu, msg, len);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Implementation of HDLC callbacks
+
+void hdlc_frame_sent_cb(hdlc_data_t *_hdlc, const uint8_t *frame, uint32_t len)
+{
+    free((uint8_t *)frame);
+}
+
+void hdlc_recv_frame_cb(hdlc_data_t *_hdlc, uint8_t *frame, uint32_t len)
+{
+    fwu_client_recv(&serial_target->fwu, frame, len);
+}
+
+void hdlc_reset_cb(hdlc_data_t *_hdlc, hdlc_reset_cause_t cause)
+{
+    log_warn("hdlc reset (%d)", cause);
+    fwu_client_link_down(&serial_target->fwu);
+}
+
+void hdlc_connected_cb(hdlc_data_t *_hdlc)
+{
+    log_info("hdlc connected");
+    fwu_client_link_up(&serial_target->fwu);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Main program logic
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+}
+
+int main(int argc, char **argv)
+{
+    argp_parse(&argp, argc, argv, 0, 0, &args);
+    if (args.verbose >= 2) {
+        log_set_level(LOG_DEBUG);
+    } else if (args.verbose) {
+        log_set_level(LOG_INFO);
+    } else {
+        log_set_level(LOG_WARN);
+    }
+
+    if (fwu_image_open(&image, args.image) == -1) {
+        perror(args.image);
+        exit(1);
+    }
+    printf("Updating %u devices with %s, %u bytes\n", args.n_devices, args.image, image.size);
+    targets = calloc(args.n_devices, sizeof(targets[0]));
+    if (!targets) {
+        perror("calloc");
+        exit(1);
+    }
+
+    static const struct mdif_client_callbacks callbacks = {
+        .connected = tcp_connected,
+        .disconnected = tcp_disconnected,
+        .recv = tcp_recv,
+    };
+    mdif_client_t *client = NULL;
+    for (unsigned i = 0; i < args.n_devices; i++) {
+        struct target *t = &targets[i];
+        t->name = args.devices[i];
+        bool serial = t->name[0] == '/';
+        if (serial && serial_target) {
+            fprintf(stderr, "Only one serial device is supported\n");
+            exit(1);
+        }
+        fwu_client_init(&t->fwu, &image, serial ? hdlc_send : tcp_send, t, progress, t);
+        t->fwu.window = args.window;
+        t->fwu.timeout_ms = args.timeout_ms;
+        t->fwu.force = args.force;
+        if (serial) {
+            t->fwu.max_chunk = HDLC_MAX_FRAME_LEN - FWU_CHUNK_HDR_MAX;
+            serial_target = t;
+            continue;
+        }
+        t->fwu.max_chunk = MDIF_CLIENT_TX_BUF_SIZE - sizeof(uint32_t) - FWU_CHUNK_HDR_MAX;
+        if (!client && !(client = mdif_client_create(&callbacks))) {
+            perror("mdif_client_create");
+            exit(1);
+        }
+        t->dev = mdif_client_add(client, t->name, t);
+        if (!t->dev) {
+            perror(t->name);
+            exit(1);
+        }
+    }
+    if (client && mdif_client_start(client) == -1) {
+        perror("mdif_client_start");
+        exit(1);
+    }
+    if (serial_target) {
+        int fd = serial_open_config(serial_target->name, &args.serial);
+        hdlc_linux_init(); // calls hdlc_init()
+        start_rx_thread(fd);
+    }
+    unsigned done, failed;
+    do {
+        usleep(TICK_MS * 1000);
+        if (serial_target && rx_thread_running == RX_THREAD_STOPPED) {
+            fwu_client_abort(&serial_target->fwu);
+        }
+        done = failed = 0;
+        for (unsigned i = 0; i < args.n_devices; i++) {
+            fwu_client_tick(&targets[i].fwu, now_ms());
+            struct fwu_progress p;
+            fwu_client_get_progress(&targets[i].fwu, &p);
+            done += p.phase == FWU_PHASE_DONE;
+            failed += p.phase == FWU_PHASE_FAILED;
+        }
+    } while (done + failed < args.n_devices);
+
+    printf("%u of %u devices updated\n", done, args.n_devices);
+    if (client) {
+        mdif_client_destroy(client);
+    }
+    fwu_image_close(&image);
+    return failed ? 1 : 0;
+}
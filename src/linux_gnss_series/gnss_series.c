@@ -0,0 +1,574 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : gnss_series.c                                                *
+ *                                                                             *
+ * Description  : Time series of the GNSS and compass stream of a device,      *
+ *              : stored by field.                                             *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gnss_series.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define NONE UINT32_MAX
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static bool key_value(const struct gnss_series *s, const struct gnss_sample *x, float *v);
+static void store(struct gnss_series *s, const struct gnss_sample *x);
+static void set_pending(struct gnss_series *s, const struct gnss_sample *x);
+static uint32_t read_pending(const struct gnss_series *s, uint64_t head, struct gnss_sample *p);
+static void write_begin(struct gnss_series *s);
+static void write_end(struct gnss_series *s);
+static uint64_t lower_bound(const struct gnss_series *s, uint64_t first, uint64_t head, int64_t t_us);
+static void copy_slot(const struct gnss_series *s, uint32_t i, struct gnss_sample *out);
+static void range_run(const struct gnss_series *s, uint32_t i, uint32_t n, struct gnss_range *r);
+static void range_sample(struct gnss_range *r, const struct gnss_sample *x);
+static float lerp_angle(float a, float b, double f);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+int gnss_series_init(struct gnss_series *s, uint32_t capacity, enum gnss_downsample downsample, uint32_t factor,
+                     enum gnss_key key) {
+    memset(s, 0, sizeof(*s));
+    if (capacity == 0 || capacity > (1u << 30) || (downsample != GNSS_DOWNSAMPLE_NONE && factor == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    uint32_t slots = 1;
+    while (slots < capacity) {
+        slots *= 2;
+    }
+    s->mask = slots - 1;
+    s->downsample = downsample;
+    s->factor = factor;
+    s->key = key;
+    s->min_i = NONE;
+    s->max_i = NONE;
+    s->last_t_us = INT64_MIN;
+    s->t_us = calloc(slots, sizeof(*s->t_us));
+    s->flags = calloc(slots, sizeof(*s->flags));
+    s->fix_type = calloc(slots, sizeof(*s->fix_type));
+    s->num_sv = calloc(slots, sizeof(*s->num_sv));
+    s->lat = calloc(slots, sizeof(*s->lat));
+    s->lon = calloc(slots, sizeof(*s->lon));
+    s->hmsl = calloc(slots, sizeof(*s->hmsl));
+    s->ecef_x = calloc(slots, sizeof(*s->ecef_x));
+    s->ecef_y = calloc(slots, sizeof(*s->ecef_y));
+    s->ecef_z = calloc(slots, sizeof(*s->ecef_z));
+    s->hacc = calloc(slots, sizeof(*s->hacc));
+    s->vacc = calloc(slots, sizeof(*s->vacc));
+    s->speed = calloc(slots, sizeof(*s->speed));
+    s->heading_2d = calloc(slots, sizeof(*s->heading_2d));
+    s->compass = calloc(slots, sizeof(*s->compass));
+    if (!s->t_us || !s->flags || !s->fix_type || !s->num_sv || !s->lat || !s->lon || !s->hmsl || !s->ecef_x ||
+        !s->ecef_y || !s->ecef_z || !s->hacc || !s->vacc || !s->speed || !s->heading_2d || !s->compass) {
+        gnss_series_free(s);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void gnss_series_free(struct gnss_series *s) {
+    free(s->t_us);
+    free(s->flags);
+    free(s->fix_type);
+    free(s->num_sv);
+    free(s->lat);
+    free(s->lon);
+    free(s->hmsl);
+    free(s->ecef_x);
+    free(s->ecef_y);
+    free(s->ecef_z);
+    free(s->hacc);
+    free(s->vacc);
+    free(s->speed);
+    free(s->heading_2d);
+    free(s->compass);
+    memset(s, 0, sizeof(*s));
+}
+
+void gnss_sample_from_ind(struct gnss_sample *x, const Mdif__Core__GnssCompassStreamInd *ind, int64_t t_us) {
+    memset(x, 0, sizeof(*x));
+    x->t_us = t_us;
+    const Mdif__Core__GnssStatus *g = ind->gnss_status;
+    if (g) {
+        x->flags |= GNSS_HAS_GNSS;
+        if (g->pos_valid) {
+            x->flags |= GNSS_POS_VALID;
+        }
+        if (g->time_valid != MDIF__CORE__SYS_TIME_STATUS__NOT_VALID) {
+            x->flags |= GNSS_TIME_VALID;
+        }
+        x->fix_type = g->fix_type;
+        x->num_sv = g->num_sv > UINT8_MAX ? UINT8_MAX : g->num_sv;
+        x->lat = g->pos_lat;
+        x->lon = g->pos_lon;
+        x->hmsl = g->pos_hmsl;
+        x->ecef_x = g->ecef_x;
+        x->ecef_y = g->ecef_y;
+        x->ecef_z = g->ecef_z;
+        x->hacc = g->pos_hacc;
+        x->vacc = g->pos_vacc;
+        x->speed = g->ground_speed;
+        x->heading_2d = g->heading_2d;
+    }
+    const Mdif__Core__CompassHeading *c = ind->compass_heading;
+    if (c) {
+        x->flags |= GNSS_HAS_COMPASS;
+        if (c->calibrated) {
+            x->flags |= GNSS_CALIBRATED;
+        }
+        x->compass = c->heading;
+    }
+}
+
+void gnss_series_add(struct gnss_series *s, const struct gnss_sample *x) {
+    s->received++;
+    if (x->t_us < s->last_t_us) {
+        s->out_of_order++;
+        return;
+    }
+    s->last_t_us = x->t_us;
+
+    switch (s->downsample) {
+    case GNSS_DOWNSAMPLE_NONE:
+        store(s, x);
+        return;
+    case GNSS_DOWNSAMPLE_DECIMATE:
+        if (s->in_bucket == 0) {
+            store(s, x);
+        }
+        if (++s->in_bucket == s->factor) {
+            s->in_bucket = 0;
+        }
+        set_pending(s, x);
+        return;
+    case GNSS_DOWNSAMPLE_MINMAX:
+        break;
+    }
+
+    // Keep the samples with the lowest and highest key of the bucket, and the
+    // last one in case no sample has the key field
+    float v;
+    if (key_value(s, x, &v)) {
+        if (s->min_i == NONE || v < s->min_v) {
+            s->min = *x;
+            s->min_v = v;
+            s->min_i = s->in_bucket;
+        }
+        if (s->max_i == NONE || v > s->max_v) {
+            s->max = *x;
+            s->max_v = v;
+            s->max_i = s->in_bucket;
+        }
+    }
+    s->last = *x;
+    if (++s->in_bucket < s->factor) {
+        set_pending(s, x);
+        return;
+    }
+    if (s->min_i == NONE) {
+        store(s, &s->last);
+    } else if (s->min_i == s->max_i) {
+        store(s, &s->min);
+    } else if (s->min_i < s->max_i) {
+        store(s, &s->min);
+        store(s, &s->max);
+    } else {
+        store(s, &s->max);
+        store(s, &s->min);
+    }
+    s->in_bucket = 0;
+    s->min_i = NONE;
+    s->max_i = NONE;
+    set_pending(s, x);
+}
+
+bool gnss_series_latest(const struct gnss_series *s, struct gnss_sample *out) {
+    uint32_t seq;
+    bool found;
+    do {
+        seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        uint64_t head = s->head;
+        struct gnss_sample pending[3];
+        uint32_t n_pending = read_pending(s, head, pending);
+        found = head > 0 || n_pending > 0;
+        if (n_pending > 0) {
+            *out = pending[n_pending - 1];
+        } else if (found) {
+            copy_slot(s, (uint32_t)(head - 1) & s->mask, out);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&s->seq, __ATOMIC_RELAXED) != seq);
+    return found;
+}
+
+int gnss_series_at(const struct gnss_series *s, int64_t t_us, int64_t max_gap_us, struct gnss_sample *out) {
+    struct gnss_sample a, b;
+    uint32_t seq;
+    int err;
+    do {
+        seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        uint64_t head = s->head;
+        uint64_t first = head > s->mask ? head - s->mask - 1 : 0;
+        uint64_t k = lower_bound(s, first, head, t_us);
+        err = 0;
+        if (k == head) {
+            // After the stored samples, maybe before a pending one
+            struct gnss_sample pending[3];
+            uint32_t n_pending = read_pending(s, head, pending);
+            uint32_t j = 0;
+            while (j < n_pending && pending[j].t_us < t_us) {
+                j++;
+            }
+            if (j == n_pending) {
+                err = ENOENT;
+            } else if (pending[j].t_us == t_us) {
+                a = b = pending[j];
+            } else if (j > 0) {
+                a = pending[j - 1];
+                b = pending[j];
+            } else if (head > first) {
+                copy_slot(s, (uint32_t)(head - 1) & s->mask, &a);
+                b = pending[j];
+            } else {
+                err = ENOENT;
+            }
+        } else if (k == first && s->t_us[k & s->mask] != t_us) {
+            err = ENOENT;
+        } else if (s->t_us[k & s->mask] == t_us) {
+            copy_slot(s, (uint32_t)k & s->mask, &a);
+            b = a;
+        } else {
+            copy_slot(s, (uint32_t)(k - 1) & s->mask, &a);
+            copy_slot(s, (uint32_t)k & s->mask, &b);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&s->seq, __ATOMIC_RELAXED) != seq);
+    if (!err && b.t_us - a.t_us > max_gap_us) {
+        err = ENODATA;
+    }
+    if (err) {
+        errno = err;
+        return -1;
+    }
+
+    double f = b.t_us > a.t_us ? (double)(t_us - a.t_us) / (double)(b.t_us - a.t_us) : 0;
+    out->t_us = t_us;
+    out->flags = a.flags & b.flags;
+    out->fix_type = a.fix_type < b.fix_type ? a.fix_type : b.fix_type;
+    out->num_sv = a.num_sv < b.num_sv ? a.num_sv : b.num_sv;
+    out->lat = a.lat + (b.lat - a.lat) * f;
+    // Across the antimeridian go the short way
+    double dlon = b.lon - a.lon;
+    if (dlon > 180) {
+        dlon -= 360;
+    } else if (dlon < -180) {
+        dlon += 360;
+    }
+    out->lon = a.lon + dlon * f;
+    if (out->lon > 180) {
+        out->lon -= 360;
+    } else if (out->lon < -180) {
+        out->lon += 360;
+    }
+    out->hmsl = a.hmsl + (b.hmsl - a.hmsl) * f;
+    out->ecef_x = a.ecef_x + (b.ecef_x - a.ecef_x) * f;
+    out->ecef_y = a.ecef_y + (b.ecef_y - a.ecef_y) * f;
+    out->ecef_z = a.ecef_z + (b.ecef_z - a.ecef_z) * f;
+    out->hacc = a.hacc > b.hacc ? a.hacc : b.hacc;
+    out->vacc = a.vacc > b.vacc ? a.vacc : b.vacc;
+    out->speed = a.speed + (b.speed - a.speed) * f;
+    out->heading_2d = lerp_angle(a.heading_2d, b.heading_2d, f);
+    out->compass = lerp_angle(a.compass, b.compass, f);
+    return 0;
+}
+
+void gnss_series_range(const struct gnss_series *s, int64_t t0_us, int64_t t1_us, struct gnss_range *out) {
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        memset(out, 0, sizeof(*out));
+        out->lat_min = out->lon_min = INFINITY;
+        out->lat_max = out->lon_max = -INFINITY;
+        out->hmsl_min = INFINITY;
+        out->hmsl_max = -INFINITY;
+        uint64_t head = s->head;
+        uint64_t first = head > s->mask ? head - s->mask - 1 : 0;
+        uint64_t k0 = lower_bound(s, first, head, t0_us);
+        uint64_t k1 = t1_us == INT64_MAX ? head : lower_bound(s, k0, head, t1_us + 1);
+        // The samples are in at most two runs, before and after the end of
+        // the arrays
+        uint32_t i = (uint32_t)k0 & s->mask;
+        uint32_t n = (uint32_t)(k1 - k0);
+        uint32_t n1 = n < s->mask + 1 - i ? n : s->mask + 1 - i;
+        range_run(s, i, n1, out);
+        range_run(s, 0, n - n1, out);
+        struct gnss_sample pending[3];
+        uint32_t n_pending = read_pending(s, head, pending);
+        for (uint32_t j = 0; j < n_pending; j++) {
+            if (pending[j].t_us >= t0_us && pending[j].t_us <= t1_us) {
+                range_sample(out, &pending[j]);
+            }
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&s->seq, __ATOMIC_RELAXED) != seq);
+    if (out->n_pos == 0) {
+        out->lat_min = out->lat_max = out->lon_min = out->lon_max = 0;
+        out->hmsl_min = out->hmsl_max = 0;
+    }
+}
+
+// Key field of x for GNSS_DOWNSAMPLE_MINMAX, if it has it
+static bool key_value(const struct gnss_series *s, const struct gnss_sample *x, float *v) {
+    switch (s->key) {
+    case GNSS_KEY_HMSL:
+        *v = x->hmsl;
+        return x->flags & GNSS_POS_VALID;
+    case GNSS_KEY_SPEED:
+        *v = x->speed;
+        return x->flags & GNSS_POS_VALID;
+    case GNSS_KEY_COMPASS:
+        *v = x->compass;
+        return x->flags & GNSS_HAS_COMPASS;
+    }
+    return false;
+}
+
+static void store(struct gnss_series *s, const struct gnss_sample *x) {
+    uint32_t i = (uint32_t)s->head & s->mask;
+    write_begin(s);
+    s->t_us[i] = x->t_us;
+    s->flags[i] = x->flags;
+    s->fix_type[i] = x->fix_type;
+    s->num_sv[i] = x->num_sv;
+    s->lat[i] = x->lat;
+    s->lon[i] = x->lon;
+    s->hmsl[i] = x->hmsl;
+    s->ecef_x[i] = x->ecef_x;
+    s->ecef_y[i] = x->ecef_y;
+    s->ecef_z[i] = x->ecef_z;
+    s->hacc[i] = x->hacc;
+    s->vacc[i] = x->vacc;
+    s->speed[i] = x->speed;
+    s->heading_2d[i] = x->heading_2d;
+    s->compass[i] = x->compass;
+    s->head++;
+    write_end(s);
+}
+
+// Let readers see the samples of the current bucket that will be stored, and
+// `x`, the newest received, unless it is stored. Those of a bucket just
+// stored are left out by read_pending().
+static void set_pending(struct gnss_series *s, const struct gnss_sample *x) {
+    struct gnss_sample p[3];
+    uint32_t n = 0;
+    if (s->in_bucket > 0 && s->min_i != NONE) {
+        p[n++] = s->min_i <= s->max_i ? s->min : s->max;
+        if (s->min_i != s->max_i) {
+            p[n++] = s->min_i < s->max_i ? s->max : s->min;
+        }
+    }
+    uint64_t head = s->head;
+    bool stored = head > 0 && s->t_us[(uint32_t)(head - 1) & s->mask] == x->t_us;
+    if (!stored && (n == 0 || p[n - 1].t_us != x->t_us)) {
+        p[n++] = *x;
+    }
+    write_begin(s);
+    memcpy(s->pending, p, n * sizeof(p[0]));
+    s->n_pending = n;
+    write_end(s);
+}
+
+// Copy the pending samples newer than the newest stored to p. Returns their
+// number. Checked by the caller's retry, like lower_bound().
+static uint32_t read_pending(const struct gnss_series *s, uint64_t head, struct gnss_sample *p) {
+    uint32_t n_pending = s->n_pending < 3 ? s->n_pending : 3;
+    int64_t newest = head > 0 ? s->t_us[(uint32_t)(head - 1) & s->mask] : INT64_MIN;
+    uint32_t n = 0;
+    for (uint32_t j = 0; j < n_pending; j++) {
+        if (s->pending[j].t_us > newest) {
+            p[n++] = s->pending[j];
+        }
+    }
+    return n;
+}
+
+// The sequence number is odd while the series is written. Readers that saw
+// it odd, or changed, retry.
+static void write_begin(struct gnss_series *s) {
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void write_end(struct gnss_series *s) {
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+// First sample from `first` to `head` at or after t_us, or head if none. As
+// the reader may see a series being written, the result is only bounded, and
+// checked by the caller's retry.
+static uint64_t lower_bound(const struct gnss_series *s, uint64_t first, uint64_t head, int64_t t_us) {
+    uint64_t lo = first, hi = head;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (s->t_us[(uint32_t)mid & s->mask] < t_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void copy_slot(const struct gnss_series *s, uint32_t i, struct gnss_sample *out) {
+    out->t_us = s->t_us[i];
+    out->flags = s->flags[i];
+    out->fix_type = s->fix_type[i];
+    out->num_sv = s->num_sv[i];
+    out->lat = s->lat[i];
+    out->lon = s->lon[i];
+    out->hmsl = s->hmsl[i];
+    out->ecef_x = s->ecef_x[i];
+    out->ecef_y = s->ecef_y[i];
+    out->ecef_z = s->ecef_z[i];
+    out->hacc = s->hacc[i];
+    out->vacc = s->vacc[i];
+    out->speed = s->speed[i];
+    out->heading_2d = s->heading_2d[i];
+    out->compass = s->compass[i];
+}
+
+// Add the n samples from slot i to r. The fields are loaded for all samples
+// and those without a position replaced by a neutral value, so the loop has
+// no branches. GCC vectorizes it when min/max may ignore NaN and signed zeros
+// and the target can select doubles by a mask, e.g. with -O3
+// -ffinite-math-only -fno-signed-zeros -march=x86-64-v3.
+static void range_run(const struct gnss_series *s, uint32_t i, uint32_t n, struct gnss_range *r) {
+    const uint8_t *flags = s->flags + i;
+    const double *lat = s->lat + i;
+    const double *lon = s->lon + i;
+    const float *hmsl = s->hmsl + i;
+    const float *hacc = s->hacc + i;
+    const float *speed = s->speed + i;
+    uint32_t n_pos = 0;
+    double lat_min = r->lat_min, lat_max = r->lat_max, lon_min = r->lon_min, lon_max = r->lon_max;
+    float hmsl_min = r->hmsl_min, hmsl_max = r->hmsl_max, hacc_max = r->hacc_max, speed_max = r->speed_max;
+    for (uint32_t j = 0; j < n; j++) {
+        bool pos = flags[j] & GNSS_POS_VALID;
+        double la = lat[j], lo = lon[j];
+        float h = hmsl[j], ha = hacc[j], sp = speed[j];
+        n_pos += pos;
+        double la_lo = pos ? la : INFINITY, la_hi = pos ? la : -INFINITY;
+        double lo_lo = pos ? lo : INFINITY, lo_hi = pos ? lo : -INFINITY;
+        float h_lo = pos ? h : INFINITY, h_hi = pos ? h : -INFINITY;
+        ha = pos ? ha : 0;
+        sp = pos ? sp : 0;
+        lat_min = la_lo < lat_min ? la_lo : lat_min;
+        lat_max = la_hi > lat_max ? la_hi : lat_max;
+        lon_min = lo_lo < lon_min ? lo_lo : lon_min;
+        lon_max = lo_hi > lon_max ? lo_hi : lon_max;
+        hmsl_min = h_lo < hmsl_min ? h_lo : hmsl_min;
+        hmsl_max = h_hi > hmsl_max ? h_hi : hmsl_max;
+        hacc_max = ha > hacc_max ? ha : hacc_max;
+        speed_max = sp > speed_max ? sp : speed_max;
+    }
+    r->n += n;
+    r->n_pos += n_pos;
+    r->lat_min = lat_min;
+    r->lat_max = lat_max;
+    r->lon_min = lon_min;
+    r->lon_max = lon_max;
+    r->hmsl_min = hmsl_min;
+    r->hmsl_max = hmsl_max;
+    r->hacc_max = hacc_max;
+    r->speed_max = speed_max;
+}
+
+// Add one sample to r, like range_run()
+static void range_sample(struct gnss_range *r, const struct gnss_sample *x) {
+    r->n++;
+    if (!(x->flags & GNSS_POS_VALID)) {
+        return;
+    }
+    r->n_pos++;
+    r->lat_min = x->lat < r->lat_min ? x->lat : r->lat_min;
+    r->lat_max = x->lat > r->lat_max ? x->lat : r->lat_max;
+    r->lon_min = x->lon < r->lon_min ? x->lon : r->lon_min;
+    r->lon_max = x->lon > r->lon_max ? x->lon : r->lon_max;
+    r->hmsl_min = x->hmsl < r->hmsl_min ? x->hmsl : r->hmsl_min;
+    r->hmsl_max = x->hmsl > r->hmsl_max ? x->hmsl : r->hmsl_max;
+    r->hacc_max = x->hacc > r->hacc_max ? x->hacc : r->hacc_max;
+    r->speed_max = x->speed > r->speed_max ? x->speed : r->speed_max;
+}
+
+// Interpolate between angles a and b in degrees, the short way round
+static float lerp_angle(float a, float b, double f) {
+    double d = fmod((double)b - a, 360);
+    if (d > 180) {
+        d -= 360;
+    } else if (d < -180) {
+        d += 360;
+    }
+    double v = fmod(a + d * f, 360);
+    return v < 0 ? v + 360 : v;
+}
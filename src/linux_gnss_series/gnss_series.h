@@ -0,0 +1,206 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : gnss_series.h                                                *
+ *                                                                             *
+ * Description  : Time series of the GNSS and compass stream of a device.      *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#ifndef _GNSS_SERIES_H
+#define _GNSS_SERIES_H
+
+// Stores the GnssCompassStreamInd of one device in a ring of fixed capacity,
+// oldest samples overwritten first. The fields are kept in separate arrays,
+// so a query over a time range reads only the columns it needs, in
+// contiguous runs the compiler can vectorize.
+//
+// Samples are keyed by a time in microseconds chosen by the caller, e.g. the
+// receive time, and must be added in time order. The position at any time is
+// interpolated between the samples around it, e.g. to place a threat bearing.
+//
+// Optionally the stream is downsampled before it is stored, keeping one
+// sample of every `factor` (decimation), or the samples with the lowest and
+// highest value of a key field of every `factor` (min/max), so extremes are
+// not lost. Until a bucket of `factor` samples is complete, readers see the
+// samples of it that will be stored, and the newest sample received, after
+// the stored ones.
+//
+// Like threat_table, the series is written by one thread and read by any
+// number of threads without locks (seqlock).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "_generated/mdif/core/core.pb-c.h"
+
+// Flags of a sample
+#define GNSS_HAS_GNSS 0x01    // From a GnssStatus
+#define GNSS_POS_VALID 0x02   // Position, altitude, speed and heading_2d valid
+#define GNSS_TIME_VALID 0x04  // time_valid was not NOT_VALID
+#define GNSS_HAS_COMPASS 0x08 // From a CompassHeading
+#define GNSS_CALIBRATED 0x10  // Compass calibrated
+
+struct gnss_sample {
+    int64_t t_us;
+    uint8_t flags;
+    uint8_t fix_type;
+    uint8_t num_sv;
+    double lat; // Degrees, WGS84
+    double lon;
+    float hmsl; // m above mean sea level
+    double ecef_x; // m
+    double ecef_y;
+    double ecef_z;
+    float hacc; // m
+    float vacc;
+    float speed;      // m/s over ground
+    float heading_2d; // Degrees, of movement
+    float compass;    // Degrees, magnetic
+};
+
+enum gnss_downsample {
+    GNSS_DOWNSAMPLE_NONE,
+    GNSS_DOWNSAMPLE_DECIMATE,
+    GNSS_DOWNSAMPLE_MINMAX,
+};
+
+// Key field of GNSS_DOWNSAMPLE_MINMAX
+enum gnss_key {
+    GNSS_KEY_HMSL,
+    GNSS_KEY_SPEED,
+    GNSS_KEY_COMPASS,
+};
+
+// Statistics of the samples in a time range, see gnss_series_range()
+struct gnss_range {
+    uint32_t n;
+    uint32_t n_pos; // With GNSS_POS_VALID. The rest is of these, 0 if none
+    double lat_min;
+    double lat_max;
+    double lon_min;
+    double lon_max;
+    float hmsl_min;
+    float hmsl_max;
+    float hacc_max;
+    float speed_max;
+};
+
+struct gnss_series {
+    uint32_t seq;  // Odd while written
+    uint32_t mask; // Capacity - 1
+    uint64_t head; // Samples stored, the newest at (head - 1) & mask
+    // Downsampling, writer only
+    enum gnss_downsample downsample;
+    enum gnss_key key;
+    uint32_t factor;
+    uint32_t in_bucket; // Samples received of the current bucket
+    uint32_t min_i;     // Of min in the bucket, UINT32_MAX if none
+    uint32_t max_i;
+    float min_v; // Key of min
+    float max_v;
+    struct gnss_sample min;
+    struct gnss_sample max;
+    struct gnss_sample last;
+    int64_t last_t_us;
+    // Samples received and not stored yet, in time order, see
+    // gnss_series_add(). Those not newer than the newest stored are stale.
+    struct gnss_sample pending[3];
+    uint32_t n_pending;
+    // Counters
+    uint64_t received;
+    uint64_t out_of_order; // Dropped, older than the newest
+    // Fields of the samples
+    int64_t *t_us;
+    uint8_t *flags;
+    uint8_t *fix_type;
+    uint8_t *num_sv;
+    double *lat;
+    double *lon;
+    float *hmsl;
+    double *ecef_x;
+    double *ecef_y;
+    double *ecef_z;
+    float *hacc;
+    float *vacc;
+    float *speed;
+    float *heading_2d;
+    float *compass;
+};
+
+// Allocate a series of `capacity` samples, rounded up to a power of 2. With
+// GNSS_DOWNSAMPLE_DECIMATE or GNSS_DOWNSAMPLE_MINMAX every `factor` received
+// samples are reduced to one or two, by `key` for min/max. Returns -1 with
+// errno set on failure.
+int gnss_series_init(struct gnss_series *s, uint32_t capacity, enum gnss_downsample downsample, uint32_t factor,
+                     enum gnss_key key);
+
+// Free the series. No readers may be using it.
+void gnss_series_free(struct gnss_series *s);
+
+// Sample of `ind` received at `t_us`
+void gnss_sample_from_ind(struct gnss_sample *x, const Mdif__Core__GnssCompassStreamInd *ind, int64_t t_us);
+
+// Add a sample, downsampled as configured. Until it is stored, or its bucket
+// is, it is pending. Samples older than the newest are dropped. Writer only.
+void gnss_series_add(struct gnss_series *s, const struct gnss_sample *x);
+
+// Copy the newest sample, stored or pending. Returns false if there is none.
+// From any thread.
+bool gnss_series_latest(const struct gnss_series *s, struct gnss_sample *out);
+
+// Interpolate the sample at `t_us` between the stored samples around it,
+// which must be at most `max_gap_us` apart. Flags are those both samples
+// have. Returns -1 with errno ENOENT if `t_us` is outside the series, or
+// ENODATA if the gap is longer. From any thread.
+int gnss_series_at(const struct gnss_series *s, int64_t t_us, int64_t max_gap_us, struct gnss_sample *out);
+
+// Statistics of the samples from `t0_us` to `t1_us`, inclusive. From any
+// thread.
+void gnss_series_range(const struct gnss_series *s, int64_t t0_us, int64_t t1_us, struct gnss_range *out);
+
+#endif // _GNSS_SERIES_H
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : gnss_series_test.c                                           *
+ *                                                                             *
+ * Description  : Test of the GNSS series: interpolation across the            *
+ *              : antimeridian and heading wraparound, and samples pending in  *
+ *              : a downsampling bucket.                                       *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "gnss_series.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define FLAGS (GNSS_HAS_GNSS | GNSS_POS_VALID | GNSS_HAS_COMPASS)
+#define NEAR(a, b) (fabs((double)(a) - (double)(b)) < 1e-4)
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static void add(struct gnss_series *s, int64_t t_us, double lon, float hmsl, float heading) {
+    struct gnss_sample x = {
+        .t_us = t_us,
+        .flags = FLAGS,
+        .lat = 55,
+        .lon = lon,
+        .hmsl = hmsl,
+        .heading_2d = heading,
+        .compass = heading,
+    };
+    gnss_series_add(s, &x);
+}
+
+int main(void) {
+    int fails = 0;
+    struct gnss_series s;
+    struct gnss_sample x;
+    struct gnss_range r;
+
+    // Across the antimeridian, eastwards then westwards
+    gnss_series_init(&s, 8, GNSS_DOWNSAMPLE_NONE, 0, 0);
+    add(&s, 0, 179.5, 0, 0);
+    add(&s, 1000, -179.5, 0, 0);
+    add(&s, 2000, 179.0, 0, 0);
+    CHECK("antimeridian: short way east", gnss_series_at(&s, 250, 1000, &x) == 0 && NEAR(x.lon, 179.75));
+    CHECK("antimeridian: at 180", gnss_series_at(&s, 500, 1000, &x) == 0 && NEAR(fabs(x.lon), 180));
+    CHECK("antimeridian: wrapped to -180..180", gnss_series_at(&s, 750, 1000, &x) == 0 && NEAR(x.lon, -179.75));
+    CHECK("antimeridian: short way west", gnss_series_at(&s, 1500, 1000, &x) == 0 && NEAR(x.lon, 179.75));
+    gnss_series_free(&s);
+
+    // Headings across north, both ways, and exactly opposite
+    gnss_series_init(&s, 8, GNSS_DOWNSAMPLE_NONE, 0, 0);
+    add(&s, 0, 0, 0, 350);
+    add(&s, 1000, 0, 0, 10);
+    add(&s, 2000, 0, 0, 340);
+    add(&s, 3000, 0, 0, 160);
+    CHECK("heading: clockwise across north", gnss_series_at(&s, 250, 1000, &x) == 0 && NEAR(x.heading_2d, 355) &&
+                                                 NEAR(x.compass, 355));
+    CHECK("heading: north is 0", gnss_series_at(&s, 500, 1000, &x) == 0 && NEAR(fmod(x.heading_2d, 360), 0));
+    CHECK("heading: past north", gnss_series_at(&s, 750, 1000, &x) == 0 && NEAR(x.heading_2d, 5));
+    CHECK("heading: counterclockwise across north",
+          gnss_series_at(&s, 1500, 1000, &x) == 0 && NEAR(x.heading_2d, 355) && NEAR(x.compass, 355));
+    CHECK("heading: in 0..360", gnss_series_at(&s, 2500, 1000, &x) == 0 && x.heading_2d >= 0 && x.heading_2d < 360);
+    gnss_series_free(&s);
+
+    // Min/max by height of every 4: the samples of a bucket not complete are
+    // seen by readers
+    gnss_series_init(&s, 8, GNSS_DOWNSAMPLE_MINMAX, 4, GNSS_KEY_HMSL);
+    add(&s, 0, 0, 10, 0);
+    CHECK("minmax: first sample pending", gnss_series_latest(&s, &x) && x.t_us == 0 && s.head == 0);
+    add(&s, 1000, 1, 30, 0);
+    add(&s, 2000, 2, 20, 0);
+    CHECK("minmax: newest pending", gnss_series_latest(&s, &x) && x.t_us == 2000 && s.head == 0);
+    CHECK("minmax: at between pending", gnss_series_at(&s, 1500, 1000, &x) == 0 && NEAR(x.lon, 1.5));
+    CHECK("minmax: pending in range", (gnss_series_range(&s, 0, INT64_MAX, &r), r.n == 3 && r.hmsl_max == 30));
+    add(&s, 3000, 3, 15, 0);
+    CHECK("minmax: bucket stored", s.head == 2 && s.t_us[0] == 0 && s.t_us[1] == 1000);
+    CHECK("minmax: newest still seen", gnss_series_latest(&s, &x) && x.t_us == 3000);
+    CHECK("minmax: at after stored", gnss_series_at(&s, 2000, 2000, &x) == 0 && NEAR(x.lon, 2));
+    add(&s, 4000, 4, 5, 0);
+    // 3000 is neither min nor max of its bucket, so it is gone
+    CHECK("minmax: next bucket pending", gnss_series_latest(&s, &x) && x.t_us == 4000 &&
+                                             gnss_series_at(&s, 3000, 1000, &x) == -1 && errno == ENODATA);
+    CHECK("minmax: stored and pending in range", (gnss_series_range(&s, 0, INT64_MAX, &r), r.n == 3 && r.hmsl_min == 5));
+    gnss_series_free(&s);
+
+    // Decimation by 3
+    gnss_series_init(&s, 8, GNSS_DOWNSAMPLE_DECIMATE, 3, 0);
+    add(&s, 0, 0, 0, 0);
+    add(&s, 1000, 1, 0, 0);
+    CHECK("decimate: newest pending", s.head == 1 && gnss_series_latest(&s, &x) && x.t_us == 1000);
+    CHECK("decimate: at pending", gnss_series_at(&s, 1000, 1000, &x) == 0 && NEAR(x.lon, 1));
+    add(&s, 2000, 2, 0, 0);
+    add(&s, 3000, 3, 0, 0);
+    CHECK("decimate: stored newest not pending", s.head == 2 && gnss_series_latest(&s, &x) && x.t_us == 3000 &&
+                                                     (gnss_series_range(&s, 0, INT64_MAX, &r), r.n == 2));
+    gnss_series_free(&s);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,324 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : gw_clients.c                                                 *
+ *                                                                             *
+ * Description  : TCP clients of the gateway daemon                            *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#include <endian.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "log/log.h"
+
+#include "gw_clients.h"
+
+#define PREFIX_LEN 4
+#define MAX_IOV 64
+// Messages from clients are small requests, so a small ring is enough
+#define CLIENT_RX_RING_SIZE (16 * 1024)
+
+struct gw_client {
+    int fd;
+    LIST_ENTRY(gw_client) entry;
+    // Bounded queue of messages to send. head is being sent, and head_off
+    // bytes of it are already sent.
+    struct gw_buf **queue;
+    unsigned head;
+    unsigned count;
+    uint32_t head_off;
+    unsigned long dropped;
+    struct mdif_rx_ring ring;
+};
+
+static LIST_HEAD(client_list, gw_client) clients = LIST_HEAD_INITIALIZER(clients);
+static unsigned num_clients;
+static struct gw_clients_config cfg;
+
+// Only written by the main thread, but read by the HDLC callbacks to decide
+// whether the main thread must be woken to resume.
+static volatile bool clients_paused;
+
+struct gw_buf *gw_buf_alloc(const uint8_t *msg, uint32_t len)
+{
+    struct gw_buf *b = malloc(sizeof(*b) + PREFIX_LEN + len);
+    if (!b) {
+        return NULL;
+    }
+    b->len = PREFIX_LEN + len;
+    uint32_t pblen = htole32(len);
+    memcpy(b->data, &pblen, PREFIX_LEN);
+    memcpy(b->data + PREFIX_LEN, msg, len);
+    return b;
+}
+
+void gw_buf_put(struct gw_buf *b)
+{
+    if (--b->refcnt == 0) {
+        free(b);
+    }
+}
+
+static void client_set_events(struct gw_client *c)
+{
+    struct epoll_event ev = {.data.ptr = c};
+    ev.events = (clients_paused ? 0 : EPOLLIN) | (c->count ? EPOLLOUT : 0);
+    if (epoll_ctl(cfg.epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1) {
+        perror("epoll_ctl");
+        exit(1);
+    }
+}
+
+static void client_free(struct gw_client *c)
+{
+    mdif_rx_ring_free(&c->ring);
+    free(c->queue);
+    free(c);
+}
+
+static void client_close(struct gw_client *c)
+{
+    log_info("client %d disconnected. %lu messages dropped", c->fd, c->dropped);
+    close(c->fd);
+    while (c->count) {
+        gw_buf_put(c->queue[c->head]);
+        c->head = (c->head + 1) % cfg.queue_len;
+        c->count--;
+    }
+    LIST_REMOVE(c, entry);
+    num_clients--;
+    client_free(c);
+}
+
+// Queue message to client. If the queue is full, the oldest message is
+// dropped, unless it is partially sent.
+static void client_queue(struct gw_client *c, struct gw_buf *b)
+{
+    if (c->count == cfg.queue_len) {
+        if (c->head_off) {
+            // Keep the partially sent head in place of the next oldest
+            unsigned next = (c->head + 1) % cfg.queue_len;
+            gw_buf_put(c->queue[next]);
+            c->queue[next] = c->queue[c->head];
+        } else {
+            gw_buf_put(c->queue[c->head]);
+        }
+        c->head = (c->head + 1) % cfg.queue_len;
+        c->count--;
+        if (c->dropped++ == 0) {
+            log_warn("client %d not keeping up. Dropping messages", c->fd);
+        }
+    }
+    c->queue[(c->head + c->count) % cfg.queue_len] = b;
+    c->count++;
+    b->refcnt++;
+}
+
+// Write as much of the queue as the socket accepts. Returns -1 if the client
+// was closed.
+static int client_write(struct gw_client *c)
+{
+    while (c->count) {
+        struct iovec iov[MAX_IOV];
+        int n = 0;
+        for (unsigned i = 0; i < c->count && n < MAX_IOV; i++) {
+            struct gw_buf *b = c->queue[(c->head + i) % cfg.queue_len];
+            uint32_t off = i == 0 ? c->head_off : 0;
+            iov[n].iov_base = b->data + off;
+            iov[n].iov_len = b->len - off;
+            n++;
+        }
+        // Not writev(), as a client gone away must not raise SIGPIPE
+        struct msghdr msg = {.msg_iov = iov, .msg_iovlen = n};
+        ssize_t sent = sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+        if (sent == -1) {
+            if (errno == EAGAIN || errno == EINTR) {
+                break;
+            }
+            log_warn("client %d: %s", c->fd, strerror(errno));
+            client_close(c);
+            return -1;
+        }
+        // Release fully sent messages
+        while (sent > 0) {
+            struct gw_buf *b = c->queue[c->head];
+            uint32_t left = b->len - c->head_off;
+            if ((size_t)sent < left) {
+                c->head_off += sent;
+                break;
+            }
+            sent -= left;
+            c->head_off = 0;
+            gw_buf_put(b);
+            c->head = (c->head + 1) % cfg.queue_len;
+            c->count--;
+        }
+    }
+    client_set_events(c);
+    return 0;
+}
+
+static void client_read(struct gw_client *c)
+{
+    ssize_t n = mdif_rx_ring_recv(&c->ring, c->fd, cfg.rx_msg, c);
+    if (n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR)) {
+        client_close(c);
+    }
+}
+
+void gw_clients_init(const struct gw_clients_config *config)
+{
+    cfg = *config;
+}
+
+struct gw_client *gw_client_add(int fd)
+{
+    if (num_clients >= cfg.max_clients) {
+        log_warn("max clients reached. Rejecting connection");
+        close(fd);
+        return NULL;
+    }
+    struct gw_client *c = calloc(1, sizeof(*c));
+    if (!c) {
+        log_warn("out of memory. Rejecting connection");
+        close(fd);
+        return NULL;
+    }
+    c->fd = fd;
+    c->queue = calloc(cfg.queue_len, sizeof(*c->queue));
+    if (!c->queue || mdif_rx_ring_init(&c->ring, CLIENT_RX_RING_SIZE) == -1) {
+        log_warn("out of memory. Rejecting connection");
+        client_free(c);
+        close(fd);
+        return NULL;
+    }
+    struct epoll_event ev = {.events = clients_paused ? 0 : EPOLLIN, .data.ptr = c};
+    if (epoll_ctl(cfg.epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        perror("epoll_ctl");
+        exit(1);
+    }
+    LIST_INSERT_HEAD(&clients, c, entry);
+    num_clients++;
+    log_info("client %d connected", fd);
+    return c;
+}
+
+void gw_client_event(void *ptr, uint32_t events)
+{
+    // A client closed earlier in this batch is not in the list
+    struct gw_client *c;
+    LIST_FOREACH(c, &clients, entry)
+    {
+        if (c == ptr) {
+            break;
+        }
+    }
+    if (!c) {
+        return;
+    }
+    if ((events & EPOLLOUT) && client_write(c) == -1) {
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        client_read(c);
+    }
+}
+
+void gw_clients_send(struct gw_buf_list *list)
+{
+    struct gw_buf *b = STAILQ_FIRST(list);
+    while (b) {
+        struct gw_buf *next = STAILQ_NEXT(b, entry);
+        struct gw_client *c;
+        // Hold a reference while queueing, so the buffer survives if a client
+        // drops it immediately.
+        b->refcnt = 1;
+        LIST_FOREACH(c, &clients, entry)
+        {
+            client_queue(c, b);
+        }
+        gw_buf_put(b);
+        b = next;
+    }
+    STAILQ_INIT(list);
+
+    struct gw_client *c, *tmp;
+    for (c = LIST_FIRST(&clients); c; c = tmp) {
+        tmp = LIST_NEXT(c, entry);
+        client_write(c);
+    }
+}
+
+void gw_clients_pause(bool paused)
+{
+    if (paused == clients_paused) {
+        return;
+    }
+    clients_paused = paused;
+    struct gw_client *c;
+    LIST_FOREACH(c, &clients, entry)
+    {
+        client_set_events(c);
+    }
+}
+
+bool gw_clients_paused(void)
+{
+    return clients_paused;
+}
+
+unsigned gw_clients_count(void)
+{
+    return num_clients;
+}
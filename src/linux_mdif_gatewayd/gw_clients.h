@@ -0,0 +1,121 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : gw_clients.h                                                 *
+ *                                                                             *
+ * Description  : TCP clients of the gateway daemon                            *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _GW_CLIENTS_H
+#define _GW_CLIENTS_H
+
+// A message from the device is stored once, with length prefix, in a
+// reference counted buffer that is queued to all clients and written with
+// sendmsg(). Client queues are bounded. When a client does not keep up, its
+// oldest messages are dropped, so a slow client never stalls the serial link
+// or the other clients.
+//
+// All functions are called by the main thread, which runs the epoll loop.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+#include "linux_mdif_socket/mdif_rx_ring.h"
+
+// A message from the device, with length prefix, shared by all client queues.
+// Only the main thread touches refcnt, so it needs no atomics.
+struct gw_buf {
+    STAILQ_ENTRY(gw_buf) entry;
+    unsigned refcnt;
+    uint32_t len; // Including prefix
+    uint8_t data[];
+};
+
+STAILQ_HEAD(gw_buf_list, gw_buf);
+
+struct gw_clients_config {
+    int epfd;
+    // Max messages queued per client before dropping the oldest
+    unsigned queue_len;
+    unsigned max_clients;
+    // Called with each message received from a client
+    mdif_rx_ring_cb_t rx_msg;
+};
+
+// Copy `msg` to a new buffer with length prefix. Returns NULL if out of memory.
+// May be called from any thread.
+struct gw_buf *gw_buf_alloc(const uint8_t *msg, uint32_t len);
+
+void gw_buf_put(struct gw_buf *b);
+
+void gw_clients_init(const struct gw_clients_config *cfg);
+
+// Add client connected on non-blocking socket `fd`. The client is registered
+// in epoll with itself as data.ptr. Returns NULL, with `fd` closed, if max
+// clients is reached or out of memory.
+struct gw_client *gw_client_add(int fd);
+
+// Handle `events` from epoll for the client `ptr`. Ignored if the client was
+// closed earlier in the same batch of events.
+void gw_client_event(void *ptr, uint32_t events);
+
+// Queue all messages of `list` to all clients, and write as much as the
+// sockets accept. The list is emptied.
+void gw_clients_send(struct gw_buf_list *list);
+
+// Stop or resume reading from all clients
+void gw_clients_pause(bool paused);
+
+// May be called from any thread
+bool gw_clients_paused(void);
+
+unsigned gw_clients_count(void);
+
+#endif // _GW_CLIENTS_H
@@ -0,0 +1,272 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : gw_clients_test.c                                            *
+ *                                                                             *
+ * Description  : Tests of the gateway clients: fan-out, slow clients and      *
+ *              : requests                                                     *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <endian.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log/log.h"
+
+#include "gw_clients.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define QUEUE_LEN 8
+#define MAX_CLIENTS 3
+#define MESSAGES 2000
+#define SNDBUF 4096
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Test side of a client connection, checking the messages as they arrive
+struct reader {
+    int fd;
+    uint8_t buf[16 * 1024];
+    size_t have;
+    uint32_t n;    // Messages received
+    int64_t last;  // Index of last message received
+    uint32_t gaps; // Places where messages were dropped
+    uint32_t bad;
+};
+
+static int epfd;
+
+// Requests received from clients
+static uint32_t n_req;
+static char last_req[32];
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static void rx_msg(const uint8_t *msg, uint32_t len, void *ctx)
+{
+    len = len < sizeof(last_req) - 1 ? len : sizeof(last_req) - 1;
+    memcpy(last_req, msg, len);
+    last_req[len] = '\0';
+    n_req++;
+}
+
+// Message `i` from the device: its index and a pattern
+static void send_msg(uint32_t i)
+{
+    uint8_t msg[4 + 200];
+    uint32_t len = 4 + i % 200;
+    uint32_t idx = htole32(i);
+    memcpy(msg, &idx, 4);
+    for (uint32_t j = 4; j < len; j++) {
+        msg[j] = i + j;
+    }
+    struct gw_buf_list list = STAILQ_HEAD_INITIALIZER(list);
+    struct gw_buf *b = gw_buf_alloc(msg, len);
+    STAILQ_INSERT_TAIL(&list, b, entry);
+    gw_clients_send(&list);
+}
+
+static void check_msg(struct reader *r, const uint8_t *msg, uint32_t len)
+{
+    uint32_t i = 0;
+    if (len >= 4) {
+        memcpy(&i, msg, 4);
+        i = le32toh(i);
+    }
+    int good = len == 4 + i % 200 && (int64_t)i > r->last;
+    for (uint32_t j = 4; good && j < len; j++) {
+        good = msg[j] == (uint8_t)(i + j);
+    }
+    if (!good) {
+        r->bad++;
+        return;
+    }
+    r->gaps += (int64_t)i != r->last + 1;
+    r->last = i;
+    r->n++;
+}
+
+// Read and check what is available
+static void reader_poll(struct reader *r)
+{
+    ssize_t n;
+    while ((n = read(r->fd, r->buf + r->have, sizeof(r->buf) - r->have)) > 0) {
+        r->have += n;
+        size_t off = 0;
+        while (r->have - off >= 4) {
+            uint32_t len;
+            memcpy(&len, r->buf + off, 4);
+            len = le32toh(len);
+            if (r->have - off < 4 + len) {
+                break;
+            }
+            check_msg(r, r->buf + off + 4, len);
+            off += 4 + len;
+        }
+        memmove(r->buf, r->buf + off, r->have - off);
+        r->have -= off;
+    }
+}
+
+// Handle epoll events as the gateway main loop does
+static void pump(int timeout_ms)
+{
+    struct epoll_event events[16];
+    int n = epoll_wait(epfd, events, 16, timeout_ms);
+    for (int i = 0; i < n; i++) {
+        gw_client_event(events[i].data.ptr, events[i].events);
+    }
+}
+
+// Connect a client. Returns the gateway side, and the test side in `peer`.
+static struct gw_client *connect_client(int *peer, int sndbuf)
+{
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv);
+    if (sndbuf) {
+        setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    }
+    *peer = sv[1];
+    return gw_client_add(sv[0]);
+}
+
+static void send_req(int fd, const char *req)
+{
+    uint8_t buf[36];
+    uint32_t len = htole32(strlen(req));
+    memcpy(buf, &len, 4);
+    memcpy(buf + 4, req, strlen(req));
+    if (write(fd, buf, 4 + strlen(req)) == -1) {
+        perror("write");
+    }
+}
+
+int main(void)
+{
+    int fails = 0;
+    log_set_level(LOG_ERROR);
+    epfd = epoll_create1(0);
+    struct gw_clients_config cfg = {
+        .epfd = epfd,
+        .queue_len = QUEUE_LEN,
+        .max_clients = MAX_CLIENTS,
+        .rx_msg = rx_msg,
+    };
+    gw_clients_init(&cfg);
+
+    static struct reader fast = {.last = -1}, slow = {.last = -1};
+    int gone;
+    struct gw_client *fast_c = connect_client(&fast.fd, 0);
+    struct gw_client *slow_c = connect_client(&slow.fd, SNDBUF);
+    struct gw_client *gone_c = connect_client(&gone, 0);
+    CHECK("clients added", fast_c && slow_c && gone_c && gw_clients_count() == 3);
+    int extra;
+    CHECK("client beyond max rejected", connect_client(&extra, 0) == NULL && gw_clients_count() == 3);
+    close(extra);
+
+    // Gone before the first message. Sending to it must close it, not raise
+    // SIGPIPE.
+    close(gone);
+
+    // The fast client reads all the time, the slow one only at the end
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        send_msg(i);
+        pump(0);
+        reader_poll(&fast);
+    }
+    CHECK("client gone away closed", gw_clients_count() == 2);
+    for (int i = 0; i < 1000 && (fast.last != MESSAGES - 1 || slow.last != MESSAGES - 1); i++) {
+        pump(1);
+        reader_poll(&fast);
+        reader_poll(&slow);
+    }
+    CHECK("fast client got all messages in order", fast.n == MESSAGES && fast.gaps == 0 && fast.bad == 0);
+    CHECK("slow client got intact messages in order", slow.bad == 0 && slow.last == MESSAGES - 1);
+    CHECK("slow client had oldest messages dropped", slow.n < MESSAGES && slow.gaps > 0);
+    printf("slow client got %u of %u messages\n", slow.n, MESSAGES);
+
+    send_req(fast.fd, "req1");
+    pump(10);
+    CHECK("request from client received", n_req == 1 && strcmp(last_req, "req1") == 0);
+
+    gw_clients_pause(true);
+    send_req(fast.fd, "req2");
+    pump(10);
+    CHECK("no requests read while paused", n_req == 1 && gw_clients_paused());
+    gw_clients_pause(false);
+    pump(10);
+    CHECK("requests read when resumed", n_req == 2 && strcmp(last_req, "req2") == 0);
+
+    // Readable and writable in one event: both must be handled
+    for (uint32_t i = 0; i < 100; i++) {
+        send_msg(i);
+        reader_poll(&fast);
+    }
+    send_req(slow.fd, "req3");
+    gw_client_event(slow_c, EPOLLIN | EPOLLOUT);
+    CHECK("request read along with write", n_req == 3 && strcmp(last_req, "req3") == 0);
+
+    close(fast.fd);
+    pump(10);
+    CHECK("client closed on EOF", gw_clients_count() == 1);
+
+    close(slow.fd);
+    close(epfd);
+    return fails ? 1 : 0;
+}
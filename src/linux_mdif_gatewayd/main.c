@@ -0,0 +1,476 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : main.c                                                       *
+ *                                                                             *
+ * Description  : Gateway daemon serving a serial MDIF device to TCP clients.  *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#define _GNU_SOURCE
+#include <argp.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "hdlc/include/hdlc.h"
+#include "hdlc/include/hdlc_os.h"
+#include "hdlc/ports/linux/linux_port.h"
+
+#include "linux_mdif_shm/mdif_shm.h"
+
+#include "gw_clients.h"
+
+// The gateway terminates HDLC on the serial device and exposes the MDIF
+// messages with the TCP framing (32 bit little endian length prefix), like a
+// networked device. Every message from the device is sent to all clients, and
+// messages from any client are sent to the device.
+//
+// The rx thread of the HDLC port hands received frames to the main thread,
+// which runs an epoll loop for all clients, see gw_clients.h.
+//
+// Optionally, messages are also published in a shared memory region for local
+// consumers, see linux_mdif_shm.
+
+#define MAX_EVENTS 64
+
+//////////////////////////////////////////////////////////////////////////////
+// Arguments
+
+static char doc[] = "\nMDIF gateway. Exposes an MDIF device on a serial port to TCP clients.\n";
+static char args_doc[] = "device";
+static struct argp_option options[] = {
+    {"verbose", 'v', 0, 0, "Verbose output. Repeat for increased verbosity."},
+    {"port", 'P', "PORT", 0, "TCP port to listen on. Default 21020."},
+    {"queue", 'q', "MSGS", 0, "Max messages queued per client before dropping the oldest. Default 256."},
+    {"max-clients", 'n', "N", 0, "Max number of clients. Default 64."},
+    {"shm", 's', "NAME", 0, "Also serve local clients through shared memory NAME."},
+    {"baud", 'b', "RATE", 0, "Serial baud rate. Default 460800."},
+    {"rtscts", 'f', 0, 0, "Enable RTS/CTS hardware flow control on serial device."},
+    {"low-latency", 'l', 0, 0, "Request low latency mode from serial driver."},
+    {"rt-priority", 'p', "PRIO", 0, "Run HDLC rx and timer threads with SCHED_FIFO priority PRIO (1-99)."},
+    {"rt-cpu", 'c', "CPU", 0, "Pin HDLC rx and timer threads to CPU."},
+    {"mlock", 'm', 0, 0, "Lock all memory to avoid page faults."},
+    {0}};
+
+struct args {
+    const char *serial_device;
+    int verbose;
+    uint16_t port;
+    unsigned queue_len;
+    unsigned max_clients;
+    const char *shm_name;
+    struct serial_config serial;
+    struct hdlc_linux_rt_config rt;
+} args = {
+    // Defaults
+    .port = 21020,
+    .queue_len = 256,
+    .max_clients = 64,
+    .serial = SERIAL_CONFIG_DEFAULT,
+    .rt = HDLC_LINUX_RT_CONFIG_DEFAULT,
+};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state)
+{
+    struct args *args = state->input;
+
+    switch (key) {
+    case ARGP_KEY_ARG:
+        if (state->arg_num >= 1) {
+            argp_usage(state);
+        }
+        args->serial_device = arg;
+        break;
+
+    case ARGP_KEY_END:
+        if (state->arg_num < 1) {
+            argp_usage(state);
+        }
+        break;
+
+    case 'v':
+        args->verbose++;
+        break;
+
+    case 'P':
+        args->port = strtoul(arg, NULL, 0);
+        break;
+
+    case 'q':
+        args->queue_len = strtoul(arg, NULL, 0);
+        if (args->queue_len < 2) {
+            argp_error(state, "queue must be at least 2");
+        }
+        break;
+
+    case 'n':
+        args->max_clients = strtoul(arg, NULL, 0);
+        break;
+
+    case 's':
+        args->shm_name = arg;
+        break;
+
+    case 'b': {
+        // 0 would hang up the line
+        char *end;
+        errno = 0;
+        unsigned long baud = strtoul(arg, &end, 0);
+        if (errno || end == arg || *end || baud == 0 || baud > UINT32_MAX) {
+            argp_error(state, "invalid baud rate %s", arg);
+        }
+        args->serial.baud = baud;
+        break;
+    }
+
+    case 'f':
+        args->serial.rtscts = true;
+        break;
+
+    case 'l':
+        args->serial.low_latency = true;
+        break;
+
+    case 'p':
+        args->rt.rx_priority = args->rt.timer_priority = strtol(arg, NULL, 0);
+        break;
+
+    case 'c':
+        args->rt.rx_cpu = args->rt.timer_cpu = strtol(arg, NULL, 0);
+        break;
+
+    case 'm':
+        args->rt.mlock = true;
+        break;
+
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+
+    return 0;
+}
+
+static struct argp argp = {options, parse_opt, args_doc, doc, 0, 0, 0};
+
+//////////////////////////////////////////////////////////////////////////////
+// Clients
+
+static int epfd;
+static int listen_fd;
+
+// Frames received by the HDLC rx thread, waiting for the main thread. wake_fd
+// is signalled when the list becomes non-empty or when the HDLC tx queue has
+// room again.
+static struct gw_buf_list rx_list = STAILQ_HEAD_INITIALIZER(rx_list);
+static pthread_mutex_t rx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int wake_fd;
+
+// Reading from clients is paused while the HDLC tx queue is full
+#define HDLC_TXQ_MAX 16
+
+static void wake_main(void)
+{
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) == -1) {
+        perror("write eventfd");
+    }
+}
+
+// Client to device
+static void client_rx_msg(const uint8_t *msg, uint32_t len, void *ctx)
+{
+    if (len > HDLC_MAX_FRAME_LEN) {
+        log_warn("client message of %u bytes too long for HDLC. Dropped", len);
+        return;
+    }
+    // Freed in hdlc_frame_sent_cb()
+    uint8_t *frame = malloc(len);
+    if (!frame) {
+        log_warn("out of memory. Message dropped");
+        return;
+    }
+    memcpy(frame, msg, len);
+    if (hdlc_send_frame(hdlc, frame, len) != HDLC_SUCCESS) {
+        log_warn("device not connected. Message dropped");
+        free(frame);
+    }
+}
+
+static void client_accept(void)
+{
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) {
+        log_warn("accept: %s", strerror(errno));
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    gw_client_add(fd);
+}
+
+// Fan out all frames received from the device to all clients
+static void fan_out(void)
+{
+    struct gw_buf_list list = STAILQ_HEAD_INITIALIZER(list);
+    pthread_mutex_lock(&rx_mutex);
+    STAILQ_CONCAT(&list, &rx_list);
+    pthread_mutex_unlock(&rx_mutex);
+    gw_clients_send(&list);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Shared memory clients
+
+static mdif_shm_t *shm;
+
+// Pass requests from shared memory clients to the device
+static void *shm_request_thread(void *ptr)
+{
+    static uint8_t buf[HDLC_MAX_FRAME_LEN];
+    while (1) {
+        int n = mdif_shm_recv_request(shm, buf, sizeof(buf), -1);
+        if (n == -1) {
+            log_warn("shm request: %s", strerror(errno));
+            continue;
+        }
+        // Requests are rare, so just wait for the HDLC tx queue to drain
+        while (hdlc->hdlc_tx_queue_size >= HDLC_TXQ_MAX) {
+            usleep(1000);
+        }
+        client_rx_msg(buf, n, NULL);
+    }
+    return NULL;
+}
+
+static void shm_init(void)
+{
+    shm = mdif_shm_create(args.shm_name, 0);
+    if (!shm) {
+        perror("mdif_shm_create");
+        exit(1);
+    }
+}
+
+static void shm_start(void)
+{
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, shm_request_thread, NULL) != 0) {
+        perror("pthread_create");
+        exit(1);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Implementation of HDLC callbacks
+
+void hdlc_frame_sent_cb(hdlc_data_t *_hdlc, const uint8_t *frame, uint32_t len)
+{
+    free((uint8_t *)frame);
+    if (gw_clients_paused() && _hdlc->hdlc_tx_queue_size < HDLC_TXQ_MAX / 2) {
+        wake_main();
+    }
+}
+
+// Called by HDLC rx thread. Store frame with prefix and hand it to the main
+// thread.
+void hdlc_recv_frame_cb(hdlc_data_t *_hdlc, uint8_t *frame, uint32_t len)
+{
+    // This thread is the only publisher, as the ring requires
+    if (shm) {
+        mdif_shm_publish(shm, frame, len);
+    }
+
+    struct gw_buf *b = gw_buf_alloc(frame, len);
+    if (!b) {
+        log_error("out of memory. Frame dropped");
+        return;
+    }
+
+    pthread_mutex_lock(&rx_mutex);
+    bool was_empty = STAILQ_EMPTY(&rx_list);
+    STAILQ_INSERT_TAIL(&rx_list, b, entry);
+    pthread_mutex_unlock(&rx_mutex);
+    if (was_empty) {
+        wake_main();
+    }
+}
+
+void hdlc_reset_cb(hdlc_data_t *_hdlc, hdlc_reset_cause_t cause)
+{
+    log_warn("hdlc reset (%d)", cause);
+}
+
+void hdlc_connected_cb(hdlc_data_t *_hdlc)
+{
+    log_info("hdlc connected");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Main program logic
+
+static void listen_init(void)
+{
+    listen_fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd == -1) {
+        perror("socket");
+        exit(1);
+    }
+    int one = 1, zero = 0;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(listen_fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero)); // Also accept IPv4
+    struct sockaddr_in6 addr = {
+        .sin6_family = AF_INET6,
+        .sin6_port = htons(args.port),
+        .sin6_addr = IN6ADDR_ANY_INIT,
+    };
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("bind");
+        exit(1);
+    }
+    if (listen(listen_fd, 16) == -1) {
+        perror("listen");
+        exit(1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    argp_parse(&argp, argc, argv, 0, 0, &args);
+    if (args.verbose >= 2) {
+        log_set_level(LOG_DEBUG);
+    } else if (args.verbose) {
+        log_set_level(LOG_INFO);
+    } else {
+        log_set_level(LOG_WARN);
+    }
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epfd == -1 || wake_fd == -1) {
+        perror("epoll/eventfd");
+        exit(1);
+    }
+    listen_init();
+    struct gw_clients_config cfg = {
+        .epfd = epfd,
+        .queue_len = args.queue_len,
+        .max_clients = args.max_clients,
+        .rx_msg = client_rx_msg,
+    };
+    gw_clients_init(&cfg);
+    // data.ptr identifies the fd: NULL is wake_fd, &listen_fd is listen_fd,
+    // anything else a client.
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, wake_fd, &ev);
+    ev.data.ptr = &listen_fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+
+    // The region is created before the rx thread publishes to it
+    if (args.shm_name) {
+        shm_init();
+    }
+
+    int fd = serial_open_config(args.serial_device, &args.serial);
+    hdlc_linux_set_rt_config(&args.rt);
+    hdlc_linux_init(); // calls hdlc_init()
+    start_rx_thread(fd);
+
+    // The request thread sends to the device, so hdlc must be initialized
+    if (args.shm_name) {
+        shm_start();
+    }
+    printf("Serving %s on port %u\n", args.serial_device, args.port);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (rx_thread_running != RX_THREAD_STOPPED) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, 1000);
+        if (n == -1 && errno != EINTR) {
+            perror("epoll_wait");
+            exit(1);
+        }
+        bool wake = false;
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == NULL) {
+                uint64_t cnt;
+                if (read(wake_fd, &cnt, sizeof(cnt)) == -1 && errno != EAGAIN) {
+                    perror("read eventfd");
+                    exit(1);
+                }
+                wake = true;
+            } else if (ptr == &listen_fd) {
+                client_accept();
+            } else {
+                gw_client_event(ptr, events[i].events);
+                if (hdlc->hdlc_tx_queue_size >= HDLC_TXQ_MAX) {
+                    gw_clients_pause(true);
+                }
+            }
+        }
+        if (wake) {
+            fan_out();
+            if (gw_clients_paused() && hdlc->hdlc_tx_queue_size < HDLC_TXQ_MAX / 2) {
+                gw_clients_pause(false);
+            }
+        }
+    }
+    log_error("serial link lost");
+    if (shm) {
+        mdif_shm_close(shm);
+    }
+    return 1;
+}
@@ -0,0 +1,545 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_shm.c                                                   *
+ *                                                                             *
+ * Description  : Shared memory transport for MDIF messages between local      *
+ *              : processes.                                                   *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#define _GNU_SOURCE
+#include "mdif_shm.h"
+
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_MAGIC 0x4d444946 // "MDIF"
+#define SHM_VERSION 1
+#define PREFIX_LEN 4
+// Length prefix of a record telling that the rest of the ring is unused and
+// the next record is at the start.
+#define WRAP_MARK UINT32_MAX
+#define CACHE_LINE 64
+
+// Positions are free running byte counters. Offset in ring is pos & (size-1).
+struct shm_ring {
+    // Position after the last published record. Written by producer.
+    _Alignas(CACHE_LINE) _Atomic uint64_t head;
+    // Indication ring: position up to which the producer may be writing.
+    // Readers check it after copying a record to detect that it was
+    // overwritten meanwhile.
+    _Atomic uint64_t reserve;
+    // Indication ring: number of messages published
+    _Atomic uint64_t count;
+    // Request ring: read position of the producer
+    _Alignas(CACHE_LINE) _Atomic uint64_t tail;
+    // Incremented on every publish. Readers sleep on it.
+    _Alignas(CACHE_LINE) _Atomic uint32_t futex;
+    _Atomic uint32_t waiters;
+    uint32_t size;
+    uint32_t offset; // Of ring data from start of region
+    // Request ring: serializes senders
+    pthread_mutex_t mutex;
+};
+
+struct shm_hdr {
+    _Atomic uint32_t magic;
+    uint32_t version;
+    _Atomic uint32_t closed;
+    uint32_t region_size;
+    struct shm_ring ind;
+    struct shm_ring req;
+};
+
+struct mdif_shm {
+    struct shm_hdr *hdr;
+    size_t map_size;
+    bool producer;
+    // Polls before sleeping. Spinning only helps with another CPU to run the
+    // peer.
+    int spin;
+    char name[NAME_MAX];
+    // Consumer state
+    uint64_t ind_pos;
+    uint64_t ind_count;
+    unsigned long dropped;
+};
+
+static inline uint32_t record_len(uint32_t len)
+{
+    return PREFIX_LEN + ((len + 3) & ~3u);
+}
+
+static inline uint8_t *ring_data(struct mdif_shm *s, struct shm_ring *r)
+{
+    return (uint8_t *)s->hdr + r->offset;
+}
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+static int futex_wait(_Atomic uint32_t *addr, uint32_t val, int timeout_ms)
+{
+    struct timespec ts, *tsp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    // Not FUTEX_PRIVATE_FLAG, as waiters are in other processes
+    return syscall(SYS_futex, addr, FUTEX_WAIT, val, tsp, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// Called after publishing head. The seq_cst ordering pairs with ring_wait(),
+// so either the waiter sees the new head, or we see the waiter.
+static void ring_notify(struct shm_ring *r)
+{
+    atomic_fetch_add(&r->futex, 1);
+    if (atomic_load(&r->waiters)) {
+        futex_wake(&r->futex);
+    }
+}
+
+// Wait until head differs from `pos`. Returns head, or 0 with errno ETIMEDOUT
+// or EPIPE.
+static uint64_t ring_wait(struct mdif_shm *s, struct shm_ring *r, uint64_t pos, int timeout_ms)
+{
+    uint64_t head;
+    for (int i = 0; i < s->spin; i++) {
+        head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (head != pos) {
+            return head;
+        }
+        cpu_relax();
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+
+    for (;;) {
+        atomic_fetch_add(&r->waiters, 1);
+        uint32_t seq = atomic_load(&r->futex);
+        head = atomic_load(&r->head);
+        if (head != pos) {
+            atomic_fetch_sub(&r->waiters, 1);
+            return head;
+        }
+        if (atomic_load(&s->hdr->closed)) {
+            atomic_fetch_sub(&r->waiters, 1);
+            errno = EPIPE;
+            return 0;
+        }
+        int left = -1;
+        if (timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long ms = (deadline.tv_sec - now.tv_sec) * 1000 + (deadline.tv_nsec - now.tv_nsec) / 1000000;
+            left = ms > 0 ? ms : 0;
+        }
+        if (left != 0) {
+            futex_wait(&r->futex, seq, left);
+        }
+        atomic_fetch_sub(&r->waiters, 1);
+        if (left == 0) {
+            errno = ETIMEDOUT;
+            return 0;
+        }
+    }
+}
+
+// Write record at head of ring, returning the new head. Caller has checked
+// there is room for `need` bytes plus wrap.
+static uint64_t ring_write(struct mdif_shm *s, struct shm_ring *r, uint64_t pos, const uint8_t *msg, uint32_t len)
+{
+    uint8_t *data = ring_data(s, r);
+    uint32_t off = pos & (r->size - 1);
+    if (r->size - off < record_len(len)) {
+        uint32_t mark = WRAP_MARK;
+        memcpy(data + off, &mark, PREFIX_LEN);
+        pos += r->size - off;
+        off = 0;
+    }
+    uint32_t le = htole32(len);
+    memcpy(data + off, &le, PREFIX_LEN);
+    memcpy(data + off + PREFIX_LEN, msg, len);
+    return pos + record_len(len);
+}
+
+// End position of a record written at `pos`, including any wrap
+static inline uint64_t record_end(const struct shm_ring *r, uint64_t pos, uint32_t len)
+{
+    uint32_t off = pos & (r->size - 1);
+    if (r->size - off < record_len(len)) {
+        pos += r->size - off;
+    }
+    return pos + record_len(len);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Region setup
+
+static void ring_init(struct shm_ring *r, uint32_t offset, uint32_t size)
+{
+    r->offset = offset;
+    r->size = size;
+}
+
+static bool is_pow2(uint32_t x)
+{
+    return x && !(x & (x - 1));
+}
+
+static int spin_count(void)
+{
+    return sysconf(_SC_NPROCESSORS_ONLN) > 1 ? MDIF_SHM_SPIN : 0;
+}
+
+static void shm_path(char *path, const char *name)
+{
+    snprintf(path, NAME_MAX, "/%s", name);
+}
+
+mdif_shm_t *mdif_shm_create(const char *name, uint32_t ind_size)
+{
+    if (ind_size == 0) {
+        ind_size = MDIF_SHM_IND_SIZE;
+    }
+    if (!is_pow2(ind_size) || ind_size < 4096 || strlen(name) >= NAME_MAX - 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    struct mdif_shm *s = calloc(1, sizeof(*s));
+    if (!s) {
+        return NULL;
+    }
+    s->producer = true;
+    s->spin = spin_count();
+    shm_path(s->name, name);
+    // A stale region from a previous producer is replaced. Consumers still
+    // mapping it keep the old, now closed, region.
+    shm_unlink(s->name);
+    int fd = shm_open(s->name, O_RDWR | O_CREAT | O_EXCL, 0660);
+    if (fd == -1) {
+        free(s);
+        return NULL;
+    }
+    uint32_t hdr_size = (sizeof(struct shm_hdr) + 4095) & ~4095u;
+    s->map_size = hdr_size + ind_size + MDIF_SHM_REQ_SIZE;
+    if (ftruncate(fd, s->map_size) == -1) {
+        goto err;
+    }
+    s->hdr = mmap(NULL, s->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (s->hdr == MAP_FAILED) {
+        goto err;
+    }
+    close(fd);
+
+    struct shm_hdr *h = s->hdr;
+    h->version = SHM_VERSION;
+    h->region_size = s->map_size;
+    ring_init(&h->ind, hdr_size, ind_size);
+    ring_init(&h->req, hdr_size + ind_size, MDIF_SHM_REQ_SIZE);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&h->req.mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    // Consumers check magic last
+    atomic_store_explicit(&h->magic, SHM_MAGIC, memory_order_release);
+    return s;
+
+err: {
+    int e = errno;
+    close(fd);
+    shm_unlink(s->name);
+    free(s);
+    errno = e;
+    return NULL;
+}
+}
+
+mdif_shm_t *mdif_shm_open(const char *name)
+{
+    struct mdif_shm *s = calloc(1, sizeof(*s));
+    if (!s) {
+        return NULL;
+    }
+    s->spin = spin_count();
+    shm_path(s->name, name);
+    int fd = shm_open(s->name, O_RDWR, 0);
+    if (fd == -1) {
+        free(s);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(struct shm_hdr)) {
+        // Producer has not sized the region yet
+        close(fd);
+        free(s);
+        errno = EAGAIN;
+        return NULL;
+    }
+    s->map_size = st.st_size;
+    s->hdr = mmap(NULL, s->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (s->hdr == MAP_FAILED) {
+        free(s);
+        return NULL;
+    }
+    struct shm_hdr *h = s->hdr;
+    if (atomic_load_explicit(&h->magic, memory_order_acquire) != SHM_MAGIC || h->version != SHM_VERSION ||
+        h->region_size != s->map_size) {
+        munmap(s->hdr, s->map_size);
+        free(s);
+        errno = EAGAIN;
+        return NULL;
+    }
+    s->ind_pos = atomic_load_explicit(&h->ind.head, memory_order_acquire);
+    s->ind_count = atomic_load_explicit(&h->ind.count, memory_order_relaxed);
+    return s;
+}
+
+void mdif_shm_close(mdif_shm_t *s)
+{
+    if (s->producer) {
+        atomic_store(&s->hdr->closed, 1);
+        ring_notify(&s->hdr->ind);
+        shm_unlink(s->name);
+    }
+    munmap(s->hdr, s->map_size);
+    free(s);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Indication ring
+
+int mdif_shm_publish(mdif_shm_t *s, const uint8_t *msg, uint32_t len)
+{
+    struct shm_ring *r = &s->hdr->ind;
+    if (record_len(len) > r->size / 4) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    uint64_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint64_t end = record_end(r, pos, len);
+    // Claim the area before overwriting it, seqlock style
+    atomic_store_explicit(&r->reserve, end, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    ring_write(s, r, pos, msg, len);
+    atomic_store_explicit(&r->count, atomic_load_explicit(&r->count, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&r->head, end, memory_order_release);
+    ring_notify(r);
+    return 0;
+}
+
+// Skip to head after falling behind
+static void resync(struct mdif_shm *s, struct shm_ring *r)
+{
+    s->ind_pos = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint64_t count = atomic_load_explicit(&r->count, memory_order_relaxed);
+    s->dropped += count - s->ind_count;
+    s->ind_count = count;
+}
+
+int mdif_shm_recv(mdif_shm_t *s, uint8_t *buf, uint32_t size, int timeout_ms)
+{
+    struct shm_ring *r = &s->hdr->ind;
+    uint8_t *data = ring_data(s, r);
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (head == s->ind_pos) {
+            head = ring_wait(s, r, s->ind_pos, timeout_ms);
+            if (head == 0) {
+                return errno == ETIMEDOUT ? 0 : -1;
+            }
+        }
+        if (head - s->ind_pos > r->size) {
+            resync(s, r);
+            continue;
+        }
+
+        uint32_t off = s->ind_pos & (r->size - 1);
+        uint32_t len;
+        memcpy(&len, data + off, PREFIX_LEN);
+        len = le32toh(len);
+        uint64_t next;
+        if (len == WRAP_MARK) {
+            next = s->ind_pos + r->size - off;
+        } else if (len <= size && record_len(len) <= r->size - off) {
+            memcpy(buf, data + off + PREFIX_LEN, len);
+            next = s->ind_pos + record_len(len);
+        } else {
+            // Too large for `buf`, or garbage from an overwritten record
+            next = s->ind_pos + record_len(len);
+        }
+
+        // If the producer has claimed our record meanwhile, what we copied may
+        // be garbage.
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t reserve = atomic_load_explicit(&r->reserve, memory_order_relaxed);
+        if (reserve - s->ind_pos > r->size) {
+            resync(s, r);
+            continue;
+        }
+
+        s->ind_pos = next;
+        if (len == WRAP_MARK) {
+            continue;
+        }
+        s->ind_count++;
+        if (len > size) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        return len;
+    }
+}
+
+unsigned long mdif_shm_dropped(const mdif_shm_t *s)
+{
+    return s->dropped;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Request ring
+
+int mdif_shm_request(mdif_shm_t *s, const uint8_t *msg, uint32_t len)
+{
+    struct shm_ring *r = &s->hdr->req;
+    if (record_len(len) > r->size / 4) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    if (atomic_load(&s->hdr->closed)) {
+        errno = EPIPE;
+        return -1;
+    }
+    int ret = pthread_mutex_lock(&r->mutex);
+    if (ret == EOWNERDEAD) {
+        // A sender died holding the lock. Head is only published after the
+        // record is complete, so the ring is consistent.
+        pthread_mutex_consistent(&r->mutex);
+    } else if (ret) {
+        errno = ret;
+        return -1;
+    }
+    uint64_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint64_t end = record_end(r, pos, len);
+    if (end - atomic_load_explicit(&r->tail, memory_order_acquire) > r->size) {
+        pthread_mutex_unlock(&r->mutex);
+        errno = EAGAIN;
+        return -1;
+    }
+    ring_write(s, r, pos, msg, len);
+    atomic_store_explicit(&r->head, end, memory_order_release);
+    pthread_mutex_unlock(&r->mutex);
+    ring_notify(r);
+    return 0;
+}
+
+int mdif_shm_recv_request(mdif_shm_t *s, uint8_t *buf, uint32_t size, int timeout_ms)
+{
+    struct shm_ring *r = &s->hdr->req;
+    uint8_t *data = ring_data(s, r);
+    for (;;) {
+        uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (head == tail) {
+            head = ring_wait(s, r, tail, timeout_ms);
+            if (head == 0) {
+                return errno == ETIMEDOUT ? 0 : -1;
+            }
+        }
+        uint32_t off = tail & (r->size - 1);
+        uint32_t len;
+        memcpy(&len, data + off, PREFIX_LEN);
+        len = le32toh(len);
+        if (len == WRAP_MARK) {
+            atomic_store_explicit(&r->tail, tail + r->size - off, memory_order_release);
+            continue;
+        }
+        if (len <= size) {
+            memcpy(buf, data + off + PREFIX_LEN, len);
+        }
+        atomic_store_explicit(&r->tail, tail + record_len(len), memory_order_release);
+        if (len > size) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        return len;
+    }
+}
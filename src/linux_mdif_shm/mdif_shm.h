@@ -0,0 +1,138 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_shm.h                                                   *
+ *                                                                             *
+ * Description  : Shared memory transport for MDIF messages between local      *
+ *              : processes.                                                   *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_SHM_H
+#define _MDIF_SHM_H
+
+// Shared memory transport for local MDIF consumers, e.g. analytics processes
+// running on the same host as mdif_gatewayd. It avoids the copies and syscalls
+// of TCP loopback.
+//
+// The region is created by one producer (the gateway) with shm_open(), and
+// holds two rings of length prefixed messages, using the same framing as TCP:
+//
+// - Indication ring. Single producer, any number of consumers. Each consumer
+//   has its own read position. The producer never waits for consumers; a
+//   consumer that falls a full ring behind loses messages, which is detected
+//   and counted.
+// - Request ring. Any number of consumers send requests to the producer. The
+//   ring is guarded by a process shared mutex, and a full ring is reported to
+//   the sender.
+//
+// Readers spin for MDIF_SHM_SPIN iterations before sleeping on a futex, so a
+// busy consumer picks up a message without a syscall on either side.
+//
+// Usage, producer:
+//   mdif_shm_t *s = mdif_shm_create("mdif", 0);
+//   mdif_shm_publish(s, msg, len);
+//   n = mdif_shm_recv_request(s, buf, sizeof(buf), -1);
+//
+// Usage, consumer:
+//   mdif_shm_t *s = mdif_shm_open("mdif");
+//   n = mdif_shm_recv(s, buf, sizeof(buf), -1);
+//   mdif_shm_request(s, req, len);
+//
+// Functions return -1 (or NULL) with errno set on error.
+
+#include <stdint.h>
+
+typedef struct mdif_shm mdif_shm_t;
+
+#ifndef MDIF_SHM_IND_SIZE
+// Default size of indication ring. Must be a power of 2.
+#define MDIF_SHM_IND_SIZE (1024 * 1024)
+#endif
+#ifndef MDIF_SHM_REQ_SIZE
+// Size of request ring. Must be a power of 2.
+#define MDIF_SHM_REQ_SIZE (64 * 1024)
+#endif
+#ifndef MDIF_SHM_SPIN
+// Number of polls of an empty ring before sleeping, on multi-CPU hosts
+#define MDIF_SHM_SPIN 4000
+#endif
+
+// Create region `name` (without leading '/'), replacing any stale region of
+// the same name. `ind_size` is the indication ring size, 0 for default.
+mdif_shm_t *mdif_shm_create(const char *name, uint32_t ind_size);
+
+// Open region created by mdif_shm_create(). Fails with ENOENT if there is no
+// producer. Receiving starts with the next published message.
+mdif_shm_t *mdif_shm_open(const char *name);
+
+// Unmap region. For the producer, the region is also removed, and consumers
+// waiting in mdif_shm_recv() get EPIPE.
+void mdif_shm_close(mdif_shm_t *s);
+
+// Producer: publish message to all consumers. Must only be called from one
+// thread. Fails with EMSGSIZE if larger than a quarter of the ring.
+int mdif_shm_publish(mdif_shm_t *s, const uint8_t *msg, uint32_t len);
+
+// Consumer: copy next message to `buf` and return its length. Returns 0 if no
+// message within `timeout_ms` (-1 waits forever). Returns -1 with errno
+// EMSGSIZE if the message is larger than `size` (the message is skipped), or
+// EPIPE if the producer has closed the region.
+int mdif_shm_recv(mdif_shm_t *s, uint8_t *buf, uint32_t size, int timeout_ms);
+
+// Consumer: number of messages lost because this consumer fell behind. The
+// count is an estimate when whole laps of the ring are lost.
+unsigned long mdif_shm_dropped(const mdif_shm_t *s);
+
+// Consumer: send request to producer. May be called from any thread. Fails
+// with EAGAIN if the request ring is full.
+int mdif_shm_request(mdif_shm_t *s, const uint8_t *msg, uint32_t len);
+
+// Producer: like mdif_shm_recv(), for the request ring.
+int mdif_shm_recv_request(mdif_shm_t *s, uint8_t *buf, uint32_t size, int timeout_ms);
+
+#endif // _MDIF_SHM_H
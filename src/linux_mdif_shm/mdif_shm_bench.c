@@ -0,0 +1,310 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_shm_bench.c                                             *
+ *                                                                             *
+ * Description  : Measures message handoff latency of the shared memory        *
+ *              : transport.                                                   *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#define _GNU_SOURCE
+#include <argp.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mdif_shm.h"
+
+// Measures the time from mdif_shm_publish() in one process until
+// mdif_shm_recv() returns the message in another, and reports percentiles.
+//
+// Two phases are run. In "busy" messages are published back to back with a
+// short gap, so a consumer on its own CPU picks them up while spinning. In
+// "idle" the gap is longer than the spin, so the consumer sleeps on the futex
+// and is woken by the producer. On a single CPU host readers do not spin, and
+// both phases measure the futex path.
+//
+// For stable numbers, run on an otherwise idle host, e.g. with
+//
+//   taskset -c 2,3 ./mdif_shm_bench
+
+// Start of every message
+struct stamp {
+    uint32_t phase;
+    uint32_t seq;
+    uint64_t ns; // CLOCK_MONOTONIC at publish
+};
+
+enum { PHASE_BUSY, PHASE_IDLE, PHASE_END };
+
+static const char *phase_names[] = {"busy", "idle"};
+
+//////////////////////////////////////////////////////////////////////////////
+// Arguments
+
+static char doc[] = "\nBenchmark of MDIF shared memory handoff latency.\n";
+
+static struct argp_option options[] = {
+    {"count", 'n', "N", 0, "Messages per phase. Default 10000."},
+    {"size", 's', "BYTES", 0, "Message size. Default 64."},
+    {"busy-gap", 'b', "US", 0, "Gap between messages in busy phase. Default 2 us."},
+    {"idle-gap", 'i', "US", 0, "Gap between messages in idle phase. Default 1000 us."},
+    {0}};
+
+struct args {
+    unsigned count;
+    unsigned size;
+    unsigned busy_gap_us;
+    unsigned idle_gap_us;
+} args = {
+    // Defaults
+    .count = 10000,
+    .size = 64,
+    .busy_gap_us = 2,
+    .idle_gap_us = 1000,
+};
+
+static error_t parse_opt(int key, char *arg, struct argp_state *state)
+{
+    struct args *args = state->input;
+
+    switch (key) {
+    case 'n':
+        args->count = strtoul(arg, NULL, 0);
+        break;
+
+    case 's':
+        args->size = strtoul(arg, NULL, 0);
+        break;
+
+    case 'b':
+        args->busy_gap_us = strtoul(arg, NULL, 0);
+        break;
+
+    case 'i':
+        args->idle_gap_us = strtoul(arg, NULL, 0);
+        break;
+
+    case ARGP_KEY_END:
+        if (args->count == 0) {
+            argp_error(state, "count must be at least 1");
+        }
+        if (args->size < sizeof(struct stamp)) {
+            argp_error(state, "size must be at least %zu", sizeof(struct stamp));
+        }
+        break;
+
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+
+    return 0;
+}
+
+static struct argp argp = {options, parse_opt, 0, doc, 0, 0, 0};
+
+//////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void report(const char *name, uint64_t *lat, unsigned n)
+{
+    if (!n) {
+        printf("%-6s no messages received\n", name);
+        return;
+    }
+    qsort(lat, n, sizeof(*lat), cmp_u64);
+    printf("%-6s %6u msgs  min %7lu  p50 %7lu  p99 %7lu  p99.9 %7lu  max %8lu ns\n", name, n,
+           (unsigned long)lat[0], (unsigned long)lat[n / 2], (unsigned long)lat[(uint64_t)n * 99 / 100],
+           (unsigned long)lat[(uint64_t)n * 999 / 1000], (unsigned long)lat[n - 1]);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Consumer
+
+static int consumer(const char *name)
+{
+    mdif_shm_t *s = mdif_shm_open(name);
+    if (!s) {
+        perror("mdif_shm_open");
+        return 1;
+    }
+    uint64_t *lat[2];
+    unsigned n[2] = {0, 0};
+    uint8_t *buf = malloc(args.size);
+    lat[PHASE_BUSY] = malloc(args.count * sizeof(uint64_t));
+    lat[PHASE_IDLE] = malloc(args.count * sizeof(uint64_t));
+    if (!buf || !lat[PHASE_BUSY] || !lat[PHASE_IDLE]) {
+        perror("malloc");
+        return 1;
+    }
+
+    // Tell the producer that we receive from now on
+    uint8_t ready = 1;
+    if (mdif_shm_request(s, &ready, sizeof(ready)) == -1) {
+        perror("mdif_shm_request");
+        return 1;
+    }
+
+    for (;;) {
+        int len = mdif_shm_recv(s, buf, args.size, -1);
+        uint64_t t = now_ns();
+        if (len == -1) {
+            perror("mdif_shm_recv");
+            return 1;
+        }
+        struct stamp st;
+        memcpy(&st, buf, sizeof(st));
+        if (st.phase == PHASE_END) {
+            break;
+        }
+        if (st.phase < PHASE_END && n[st.phase] < args.count) {
+            lat[st.phase][n[st.phase]++] = t - st.ns;
+        }
+    }
+
+    report(phase_names[PHASE_BUSY], lat[PHASE_BUSY], n[PHASE_BUSY]);
+    report(phase_names[PHASE_IDLE], lat[PHASE_IDLE], n[PHASE_IDLE]);
+    printf("dropped %lu\n", mdif_shm_dropped(s));
+    mdif_shm_close(s);
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Producer
+
+static void publish(mdif_shm_t *s, uint8_t *msg, uint32_t phase, uint32_t seq)
+{
+    struct stamp st = {.phase = phase, .seq = seq, .ns = now_ns()};
+    memcpy(msg, &st, sizeof(st));
+    if (mdif_shm_publish(s, msg, args.size) == -1) {
+        perror("mdif_shm_publish");
+        exit(1);
+    }
+}
+
+static void run_phase(mdif_shm_t *s, uint8_t *msg, uint32_t phase, unsigned gap_us)
+{
+    for (unsigned i = 0; i < args.count; i++) {
+        publish(s, msg, phase, i);
+        // Busy wait short gaps, so the producer stays on its CPU
+        if (gap_us < 100) {
+            uint64_t until = now_ns() + gap_us * 1000ULL;
+            while (now_ns() < until) {
+            }
+        } else {
+            usleep(gap_us);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    argp_parse(&argp, argc, argv, 0, 0, &args);
+
+    char name[64];
+    snprintf(name, sizeof(name), "mdif_shm_bench.%d", (int)getpid());
+    mdif_shm_t *s = mdif_shm_create(name, 0);
+    if (!s) {
+        perror("mdif_shm_create");
+        return 1;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        exit(consumer(name));
+    }
+
+    uint8_t ready;
+    if (mdif_shm_recv_request(s, &ready, sizeof(ready), 5000) <= 0) {
+        fprintf(stderr, "Consumer did not start\n");
+        mdif_shm_close(s);
+        return 1;
+    }
+
+    printf("%ld CPUs, readers %s, %u byte messages\n", sysconf(_SC_NPROCESSORS_ONLN),
+           sysconf(_SC_NPROCESSORS_ONLN) > 1 ? "spin" : "do not spin", args.size);
+    fflush(stdout);
+    uint8_t *msg = calloc(1, args.size);
+    if (!msg) {
+        perror("calloc");
+        return 1;
+    }
+    run_phase(s, msg, PHASE_BUSY, args.busy_gap_us);
+    usleep(10000);
+    run_phase(s, msg, PHASE_IDLE, args.idle_gap_us);
+    publish(s, msg, PHASE_END, 0);
+
+    int status;
+    waitpid(pid, &status, 0);
+    mdif_shm_close(s);
+    free(msg);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_shm_link.c                                              *
+ *                                                                             *
+ * Description  : MDIF connection to mdif_gatewayd over shared memory.         *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "codec.h"
+#include "mdif_shm_link.h"
+
+mdif_shm_t *mdif_shm_link;
+
+static pthread_t rx_thread;
+
+// Largest message the default ring carries
+static uint8_t rx_buf[MDIF_SHM_IND_SIZE / 4];
+
+static void *rx_thread_func(void *ptr)
+{
+    while (1) {
+        int n = mdif_shm_recv(mdif_shm_link, rx_buf, sizeof(rx_buf), -1);
+        if (n == -1) {
+            if (errno == EMSGSIZE) {
+                fprintf(stderr, "Message too large. Skipped\n");
+                continue;
+            }
+            perror("mdif_shm_recv");
+            exit(1);
+        }
+        printf("Received %d bytes\n", n);
+        recv_mdif_msg(rx_buf, n);
+    }
+    return NULL;
+}
+
+void mdif_shm_link_init(const char *name)
+{
+    printf("Opening shared memory %s\n", name);
+    mdif_shm_t *s;
+    while ((s = mdif_shm_open(name)) == NULL) {
+        if (errno != ENOENT && errno != EAGAIN) {
+            perror("mdif_shm_open");
+            exit(1);
+        }
+        sleep(1);
+    }
+    printf("Connected\n");
+    mdif_shm_link = s;
+
+    if (pthread_create(&rx_thread, NULL, rx_thread_func, NULL) != 0) {
+        perror("pthread_create");
+        exit(1);
+    }
+}
+
+void mdif_shm_link_send(const uint8_t *buf, uint32_t size)
+{
+    // The gateway drains requests as fast as HDLC accepts them, so a full
+    // ring only lasts a moment.
+    while (mdif_shm_request(mdif_shm_link, buf, size) == -1) {
+        if (errno != EAGAIN) {
+            perror("mdif_shm_request");
+            exit(1);
+        }
+        usleep(1000);
+    }
+}
@@ -0,0 +1,696 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_client.c                                                *
+ *                                                                             *
+ * Description  : Multi-device MDIF TCP client. All connections are serviced by*
+ *              : a single epoll thread.                                       *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#define _GNU_SOURCE
+#include <endian.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/queue.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mdif_client.h"
+#include "mdif_rx_ring.h"
+
+#define PREFIX_LEN 4
+#define MAX_EVENTS 64
+
+enum dev_state {
+    DEV_WAITING,    // Waiting for (re)connect time
+    DEV_CONNECTING, // Non-blocking connect in progress
+    DEV_CONNECTED,
+};
+
+struct mdif_device {
+    mdif_client_t *client;
+    char *host;
+    void *user_data;
+    struct addrinfo *addrs;
+    struct addrinfo *next_addr; // Addresses are tried in turn
+
+    // State and fd are changed by client thread with tx_mutex held, so
+    // mdif_client_send() can be called from any thread.
+    pthread_mutex_t tx_mutex;
+    enum dev_state state;
+    int fd;
+    uint8_t *tx_buf;
+    size_t tx_len;
+
+    struct mdif_rx_ring ring;
+
+    // Timer for reconnect or connect timeout
+    uint64_t deadline_ms;
+    int heap_idx; // -1 if no timer
+    unsigned backoff_ms;
+    unsigned seed;
+
+    bool removed;
+    LIST_ENTRY(mdif_device) entry;
+};
+
+LIST_HEAD(dev_list, mdif_device);
+
+struct mdif_client {
+    struct mdif_client_callbacks cb;
+    int epfd;
+    int evfd; // Wakes client thread when timers change
+    // Held by client thread while handling events. Recursive, so callbacks may
+    // call mdif_client_remove().
+    pthread_mutex_t mutex;
+    pthread_t thread;
+    bool started;
+    volatile bool stop;
+
+    struct dev_list devices;
+    // Removed devices. Freed by client thread when no events can refer to them.
+    struct dev_list zombies;
+
+    // Min-heap of device timers
+    mdif_device_t **heap;
+    size_t heap_len;
+    size_t heap_cap;
+};
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Timer heap
+
+static void heap_swap(mdif_client_t *c, size_t a, size_t b)
+{
+    mdif_device_t *t = c->heap[a];
+    c->heap[a] = c->heap[b];
+    c->heap[b] = t;
+    c->heap[a]->heap_idx = a;
+    c->heap[b]->heap_idx = b;
+}
+
+static void heap_up(mdif_client_t *c, size_t i)
+{
+    while (i > 0 && c->heap[(i - 1) / 2]->deadline_ms > c->heap[i]->deadline_ms) {
+        heap_swap(c, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void heap_down(mdif_client_t *c, size_t i)
+{
+    while (1) {
+        size_t min = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < c->heap_len && c->heap[l]->deadline_ms < c->heap[min]->deadline_ms) {
+            min = l;
+        }
+        if (r < c->heap_len && c->heap[r]->deadline_ms < c->heap[min]->deadline_ms) {
+            min = r;
+        }
+        if (min == i) {
+            return;
+        }
+        heap_swap(c, i, min);
+        i = min;
+    }
+}
+
+static void timer_cancel(mdif_client_t *c, mdif_device_t *dev)
+{
+    if (dev->heap_idx < 0) {
+        return;
+    }
+    size_t i = dev->heap_idx;
+    c->heap_len--;
+    if (i != c->heap_len) {
+        heap_swap(c, i, c->heap_len);
+        heap_up(c, i);
+        heap_down(c, i);
+    }
+    dev->heap_idx = -1;
+}
+
+static int timer_set(mdif_client_t *c, mdif_device_t *dev, uint64_t deadline_ms)
+{
+    timer_cancel(c, dev);
+    if (c->heap_len == c->heap_cap) {
+        size_t cap = c->heap_cap ? 2 * c->heap_cap : 16;
+        mdif_device_t **heap = realloc(c->heap, cap * sizeof(*heap));
+        if (!heap) {
+            return -1;
+        }
+        c->heap = heap;
+        c->heap_cap = cap;
+    }
+    dev->deadline_ms = deadline_ms;
+    dev->heap_idx = c->heap_len;
+    c->heap[c->heap_len++] = dev;
+    heap_up(c, dev->heap_idx);
+    return 0;
+}
+
+static void wake(mdif_client_t *c)
+{
+    uint64_t one = 1;
+    if (write(c->evfd, &one, sizeof(one)) == -1) {
+        // Only fails if counter overflows, in which case thread is awake anyway
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Connection handling. Called by client thread with c->mutex held.
+
+static void close_fd(mdif_device_t *dev, enum dev_state state)
+{
+    pthread_mutex_lock(&dev->tx_mutex);
+    if (dev->fd != -1) {
+        close(dev->fd); // Also removes it from epoll
+        dev->fd = -1;
+    }
+    dev->state = state;
+    dev->tx_len = 0;
+    pthread_mutex_unlock(&dev->tx_mutex);
+}
+
+static void schedule_reconnect(mdif_client_t *c, mdif_device_t *dev)
+{
+    unsigned delay = dev->backoff_ms - dev->backoff_ms / 4 + rand_r(&dev->seed) % (dev->backoff_ms / 2 + 1);
+    dev->backoff_ms = dev->backoff_ms * 2 > MDIF_CLIENT_BACKOFF_MAX_MS ? MDIF_CLIENT_BACKOFF_MAX_MS : dev->backoff_ms * 2;
+    close_fd(dev, DEV_WAITING);
+    timer_set(c, dev, now_ms() + delay);
+}
+
+static void set_connected(mdif_client_t *c, mdif_device_t *dev)
+{
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = dev};
+    if (epoll_ctl(c->epfd, EPOLL_CTL_MOD, dev->fd, &ev) == -1) {
+        schedule_reconnect(c, dev);
+        return;
+    }
+    timer_cancel(c, dev);
+    dev->backoff_ms = MDIF_CLIENT_BACKOFF_MIN_MS;
+    free(dev->ring.big);
+    dev->ring.big = NULL;
+    dev->ring.head = dev->ring.tail = 0;
+
+    pthread_mutex_lock(&dev->tx_mutex);
+    dev->state = DEV_CONNECTED;
+    pthread_mutex_unlock(&dev->tx_mutex);
+
+    if (c->cb.connected) {
+        c->cb.connected(dev);
+    }
+}
+
+static void start_connect(mdif_client_t *c, mdif_device_t *dev)
+{
+    struct addrinfo *ai = dev->next_addr;
+    dev->next_addr = ai->ai_next ? ai->ai_next : dev->addrs;
+
+    int fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        schedule_reconnect(c, dev);
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    pthread_mutex_lock(&dev->tx_mutex);
+    dev->fd = fd;
+    dev->state = DEV_CONNECTING;
+    pthread_mutex_unlock(&dev->tx_mutex);
+
+    // Writable when connect completes or fails
+    struct epoll_event ev = {.events = EPOLLOUT, .data.ptr = dev};
+    if (epoll_ctl(c->epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        schedule_reconnect(c, dev);
+        return;
+    }
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+        set_connected(c, dev);
+    } else if (errno == EINPROGRESS) {
+        timer_set(c, dev, now_ms() + MDIF_CLIENT_CONNECT_TIMEOUT_MS);
+    } else {
+        schedule_reconnect(c, dev);
+    }
+}
+
+static void connection_lost(mdif_client_t *c, mdif_device_t *dev, int err)
+{
+    schedule_reconnect(c, dev);
+    if (c->cb.disconnected) {
+        c->cb.disconnected(dev, err);
+    }
+}
+
+static void rx_msg(const uint8_t *msg, uint32_t len, void *ctx)
+{
+    mdif_device_t *dev = ctx;
+    // Callback may have removed device, or the connection may have been lost
+    if (!dev->removed && dev->state == DEV_CONNECTED && dev->client->cb.recv) {
+        dev->client->cb.recv(dev, msg, len);
+    }
+}
+
+static void handle_rx(mdif_client_t *c, mdif_device_t *dev)
+{
+    ssize_t n = mdif_rx_ring_recv(&dev->ring, dev->fd, rx_msg, dev);
+    if (dev->removed) {
+        return;
+    }
+    if (n == 0) {
+        connection_lost(c, dev, 0);
+    } else if (n == -1 && errno != EAGAIN && errno != EINTR) {
+        connection_lost(c, dev, errno);
+    }
+}
+
+static void handle_tx(mdif_client_t *c, mdif_device_t *dev)
+{
+    pthread_mutex_lock(&dev->tx_mutex);
+    ssize_t n = send(dev->fd, dev->tx_buf, dev->tx_len, MSG_NOSIGNAL);
+    if (n == -1 && errno != EAGAIN && errno != EINTR) {
+        int err = errno;
+        pthread_mutex_unlock(&dev->tx_mutex);
+        connection_lost(c, dev, err);
+        return;
+    }
+    if (n > 0) {
+        memmove(dev->tx_buf, dev->tx_buf + n, dev->tx_len - n);
+        dev->tx_len -= n;
+    }
+    if (!dev->tx_len) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = dev};
+        epoll_ctl(c->epfd, EPOLL_CTL_MOD, dev->fd, &ev);
+    }
+    pthread_mutex_unlock(&dev->tx_mutex);
+}
+
+static void handle_event(mdif_client_t *c, mdif_device_t *dev, uint32_t events)
+{
+    if (dev->removed) {
+        return;
+    }
+    if (dev->state == DEV_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(dev->fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1 || err) {
+            schedule_reconnect(c, dev);
+        } else {
+            set_connected(c, dev);
+        }
+        return;
+    }
+    if (dev->state != DEV_CONNECTED) {
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        handle_rx(c, dev);
+    }
+    if (!dev->removed && dev->state == DEV_CONNECTED && (events & EPOLLOUT)) {
+        handle_tx(c, dev);
+    }
+}
+
+static void handle_timers(mdif_client_t *c)
+{
+    uint64_t now = now_ms();
+    while (c->heap_len && c->heap[0]->deadline_ms <= now) {
+        mdif_device_t *dev = c->heap[0];
+        timer_cancel(c, dev);
+        if (dev->state == DEV_CONNECTING) {
+            schedule_reconnect(c, dev); // Connect timeout
+        } else if (dev->state == DEV_WAITING) {
+            start_connect(c, dev);
+        }
+    }
+}
+
+static void free_device(mdif_device_t *dev)
+{
+    if (dev->fd != -1) {
+        close(dev->fd);
+    }
+    mdif_rx_ring_free(&dev->ring);
+    freeaddrinfo(dev->addrs);
+    pthread_mutex_destroy(&dev->tx_mutex);
+    free(dev->tx_buf);
+    free(dev->host);
+    free(dev);
+}
+
+static void free_zombies(mdif_client_t *c)
+{
+    while (!LIST_EMPTY(&c->zombies)) {
+        mdif_device_t *dev = LIST_FIRST(&c->zombies);
+        LIST_REMOVE(dev, entry);
+        free_device(dev);
+    }
+}
+
+static void *client_thread_func(void *ptr)
+{
+    mdif_client_t *c = ptr;
+    struct epoll_event events[MAX_EVENTS];
+
+    pthread_mutex_lock(&c->mutex);
+    while (!c->stop) {
+        int timeout = -1;
+        if (c->heap_len) {
+            uint64_t now = now_ms();
+            timeout = c->heap[0]->deadline_ms > now ? c->heap[0]->deadline_ms - now : 0;
+        }
+        pthread_mutex_unlock(&c->mutex);
+        int n = epoll_wait(c->epfd, events, MAX_EVENTS, timeout);
+        pthread_mutex_lock(&c->mutex);
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) {
+                uint64_t cnt;
+                if (read(c->evfd, &cnt, sizeof(cnt)) == -1) {
+                    // Not possible, evfd is readable
+                }
+                continue;
+            }
+            handle_event(c, events[i].data.ptr, events[i].events);
+        }
+        handle_timers(c);
+        free_zombies(c);
+    }
+    pthread_mutex_unlock(&c->mutex);
+    return NULL;
+}
+
+// Split `name`, "addr[:port]" or "[addr][:port]", in place. An IPv6 address
+// with a port must be in brackets, one without may also be bare.
+static int split_host(char *name, const char **addr, const char **port)
+{
+    char *colon;
+    *addr = name;
+    *port = "21020";
+    if (name[0] == '[') {
+        char *end = strchr(name, ']');
+        if (!end || (end[1] && end[1] != ':')) {
+            return -1;
+        }
+        *end = '\0';
+        *addr = name + 1;
+        colon = end[1] ? end + 1 : NULL;
+    } else {
+        colon = strchr(name, ':');
+        if (colon && strchr(colon + 1, ':')) {
+            colon = NULL; // Bare IPv6 address
+        }
+    }
+    if (colon) {
+        *colon = '\0';
+        *port = colon + 1;
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// API
+
+mdif_client_t *mdif_client_create(const struct mdif_client_callbacks *cb)
+{
+    mdif_client_t *c = calloc(1, sizeof(*c));
+    if (!c) {
+        return NULL;
+    }
+    c->cb = *cb;
+    LIST_INIT(&c->devices);
+    LIST_INIT(&c->zombies);
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&c->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    c->epfd = epoll_create1(EPOLL_CLOEXEC);
+    c->evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    if (c->epfd == -1 || c->evfd == -1 || epoll_ctl(c->epfd, EPOLL_CTL_ADD, c->evfd, &ev) == -1) {
+        int err = errno;
+        mdif_client_destroy(c);
+        errno = err;
+        return NULL;
+    }
+    return c;
+}
+
+int mdif_client_start(mdif_client_t *c)
+{
+    int ret = pthread_create(&c->thread, NULL, client_thread_func, c);
+    if (ret != 0) {
+        errno = ret;
+        return -1;
+    }
+    c->started = true;
+    return 0;
+}
+
+void mdif_client_destroy(mdif_client_t *c)
+{
+    if (c->started) {
+        c->stop = true;
+        wake(c);
+        pthread_join(c->thread, NULL);
+    }
+    while (!LIST_EMPTY(&c->devices)) {
+        mdif_device_t *dev = LIST_FIRST(&c->devices);
+        LIST_REMOVE(dev, entry);
+        free_device(dev);
+    }
+    free_zombies(c);
+    if (c->epfd != -1) {
+        close(c->epfd);
+    }
+    if (c->evfd != -1) {
+        close(c->evfd);
+    }
+    pthread_mutex_destroy(&c->mutex);
+    free(c->heap);
+    free(c);
+}
+
+mdif_device_t *mdif_client_add(mdif_client_t *c, const char *host, void *user_data)
+{
+    mdif_device_t *dev = calloc(1, sizeof(*dev));
+    if (!dev) {
+        return NULL;
+    }
+    dev->client = c;
+    dev->user_data = user_data;
+    dev->fd = -1;
+    dev->heap_idx = -1;
+    dev->backoff_ms = MDIF_CLIENT_BACKOFF_MIN_MS;
+    dev->seed = (uintptr_t)dev ^ now_ms();
+    dev->state = DEV_WAITING;
+    pthread_mutex_init(&dev->tx_mutex, NULL);
+    dev->host = strdup(host);
+    dev->tx_buf = malloc(MDIF_CLIENT_TX_BUF_SIZE);
+    if (!dev->host || !dev->tx_buf || mdif_rx_ring_init(&dev->ring, MDIF_CLIENT_RX_RING_SIZE) == -1) {
+        free_device(dev);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    char *name = strdup(host);
+    if (!name) {
+        free_device(dev);
+        errno = ENOMEM;
+        return NULL;
+    }
+    const char *addr, *port;
+    if (split_host(name, &addr, &port) == -1) {
+        free(name);
+        free_device(dev);
+        errno = EINVAL;
+        return NULL;
+    }
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    int ret = getaddrinfo(addr, port, &hints, &dev->addrs);
+    free(name);
+    if (ret != 0) {
+        dev->addrs = NULL;
+        free_device(dev);
+        errno = ret == EAI_SYSTEM ? errno : EHOSTUNREACH;
+        return NULL;
+    }
+    dev->next_addr = dev->addrs;
+
+    pthread_mutex_lock(&c->mutex);
+    LIST_INSERT_HEAD(&c->devices, dev, entry);
+    timer_set(c, dev, now_ms());
+    pthread_mutex_unlock(&c->mutex);
+    wake(c);
+    return dev;
+}
+
+void mdif_client_remove(mdif_client_t *c, mdif_device_t *dev)
+{
+    pthread_mutex_lock(&c->mutex);
+    dev->removed = true;
+    timer_cancel(c, dev);
+    close_fd(dev, DEV_WAITING);
+    LIST_REMOVE(dev, entry);
+    LIST_INSERT_HEAD(&c->zombies, dev, entry);
+    if (!c->started) {
+        free_zombies(c);
+    }
+    pthread_mutex_unlock(&c->mutex);
+    // Let the client thread free it and recompute its timeout
+    if (c->started) {
+        wake(c);
+    }
+}
+
+int mdif_client_send(mdif_device_t *dev, const uint8_t *buf, uint32_t size)
+{
+    struct iovec iov = {.iov_base = (uint8_t *)buf, .iov_len = size};
+    return mdif_client_sendv(dev, &iov, 1);
+}
+
+int mdif_client_sendv(mdif_device_t *dev, const struct iovec *parts, int n_parts)
+{
+    if (n_parts < 1 || n_parts > MDIF_CLIENT_MAX_PARTS) {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t size = 0;
+    for (int i = 0; i < n_parts; i++) {
+        size += parts[i].iov_len;
+    }
+    if (size + PREFIX_LEN > MDIF_CLIENT_TX_BUF_SIZE) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    uint32_t pblen = htole32(size);
+    struct iovec iov[1 + MDIF_CLIENT_MAX_PARTS] = {{.iov_base = &pblen, .iov_len = PREFIX_LEN}};
+    memcpy(iov + 1, parts, n_parts * sizeof(*parts));
+
+    pthread_mutex_lock(&dev->tx_mutex);
+    if (dev->state != DEV_CONNECTED) {
+        pthread_mutex_unlock(&dev->tx_mutex);
+        errno = ENOTCONN;
+        return -1;
+    }
+
+    // Data already waiting for the socket goes first
+    size_t sent = 0;
+    if (!dev->tx_len) {
+        struct msghdr msg = {.msg_iov = iov, .msg_iovlen = 1 + n_parts};
+        ssize_t n = sendmsg(dev->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n == -1 && errno != EAGAIN && errno != EINTR) {
+            // Client thread detects the lost connection
+            pthread_mutex_unlock(&dev->tx_mutex);
+            return -1;
+        }
+        sent = n > 0 ? n : 0;
+        if (sent == PREFIX_LEN + size) {
+            pthread_mutex_unlock(&dev->tx_mutex);
+            return 0;
+        }
+    } else if (dev->tx_len + PREFIX_LEN + size > MDIF_CLIENT_TX_BUF_SIZE) {
+        pthread_mutex_unlock(&dev->tx_mutex);
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    // Buffer the rest and let client thread send it when socket is writable
+    bool was_empty = !dev->tx_len;
+    uint8_t *p = dev->tx_buf + dev->tx_len;
+    for (int i = 0; i < 1 + n_parts; i++) {
+        if (sent >= iov[i].iov_len) {
+            sent -= iov[i].iov_len;
+            continue;
+        }
+        memcpy(p, (uint8_t *)iov[i].iov_base + sent, iov[i].iov_len - sent);
+        p += iov[i].iov_len - sent;
+        sent = 0;
+    }
+    dev->tx_len = p - dev->tx_buf;
+    if (was_empty) {
+        struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.ptr = dev};
+        epoll_ctl(dev->client->epfd, EPOLL_CTL_MOD, dev->fd, &ev);
+    }
+    pthread_mutex_unlock(&dev->tx_mutex);
+    return 0;
+}
+
+void *mdif_device_user_data(const mdif_device_t *dev)
+{
+    return dev->user_data;
+}
+
+const char *mdif_device_host(const mdif_device_t *dev)
+{
+    return dev->host;
+}
+
+bool mdif_device_connected(const mdif_device_t *dev)
+{
+    return dev->state == DEV_CONNECTED;
+}
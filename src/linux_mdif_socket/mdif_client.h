@@ -0,0 +1,144 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_client.h                                                *
+ *                                                                             *
+ * Description  : Multi-device MDIF TCP client. All connections are serviced by*
+ *              : a single epoll thread.                                       *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_CLIENT_H
+#define _MDIF_CLIENT_H
+
+// Unlike mdif_socket, which handles a single device, the client handles any
+// number of devices with a single thread. Connections are made non-blocking,
+// and a lost or failed connection is retried with exponential backoff.
+//
+// Usage:
+//   mdif_client_t *c = mdif_client_create(&callbacks);
+//   mdif_client_add(c, "192.168.1.10", my_device_data);
+//   mdif_client_add(c, "192.168.1.11:21020", other_device_data);
+//   mdif_client_start(c);
+//
+// Functions return -1 (or NULL) with errno set on error. No function exits the
+// process.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+typedef struct mdif_client mdif_client_t;
+typedef struct mdif_device mdif_device_t;
+
+// Callbacks are called from the client thread. They may call
+// mdif_client_send() and mdif_client_remove(). They should not block, as that
+// blocks all devices.
+struct mdif_client_callbacks {
+    // Connection to device established
+    void (*connected)(mdif_device_t *dev);
+    // Established connection lost. `err` is an errno value, or 0 if closed by
+    // device. A reconnect is scheduled.
+    void (*disconnected)(mdif_device_t *dev, int err);
+    // Message received. `msg` is only valid during the call.
+    void (*recv)(mdif_device_t *dev, const uint8_t *msg, uint32_t len);
+};
+
+#ifndef MDIF_CLIENT_RX_RING_SIZE
+// Receive ring per device. Must be a power of 2.
+#define MDIF_CLIENT_RX_RING_SIZE (64 * 1024)
+#endif
+#ifndef MDIF_CLIENT_TX_BUF_SIZE
+// Buffer per device for data not accepted by the socket. Also the maximum
+// message size for mdif_client_send().
+#define MDIF_CLIENT_TX_BUF_SIZE (64 * 1024)
+#endif
+// Max parts of a message given to mdif_client_sendv()
+#define MDIF_CLIENT_MAX_PARTS 4
+#ifndef MDIF_CLIENT_CONNECT_TIMEOUT_MS
+#define MDIF_CLIENT_CONNECT_TIMEOUT_MS 5000
+#endif
+#ifndef MDIF_CLIENT_BACKOFF_MIN_MS
+// Reconnect backoff. Doubled on every failed attempt up to the max, with +-25%
+// jitter.
+#define MDIF_CLIENT_BACKOFF_MIN_MS 500
+#define MDIF_CLIENT_BACKOFF_MAX_MS 30000
+#endif
+
+mdif_client_t *mdif_client_create(const struct mdif_client_callbacks *cb);
+
+// Start the client thread. Devices may be added before or after.
+int mdif_client_start(mdif_client_t *c);
+
+// Stop client thread, close all connections and free all devices.
+void mdif_client_destroy(mdif_client_t *c);
+
+// Add device at `host`, "name[:port]" with default port 21020. An IPv6 address
+// with a port is given as "[addr]:port". The name is resolved before
+// returning, so it may block on DNS. Connection is made in the background.
+// Returns NULL with errno EINVAL if `host` is malformed.
+mdif_device_t *mdif_client_add(mdif_client_t *c, const char *host, void *user_data);
+
+// Close connection and free device. `dev` must not be used afterwards.
+void mdif_client_remove(mdif_client_t *c, mdif_device_t *dev);
+
+// Send message to device. May be called from any thread. Returns -1 with errno
+// ENOTCONN if not connected, ENOBUFS if the device is not keeping up, or
+// EMSGSIZE if larger than MDIF_CLIENT_TX_BUF_SIZE.
+int mdif_client_send(mdif_device_t *dev, const uint8_t *buf, uint32_t size);
+
+// Like mdif_client_send(), for a message in up to MDIF_CLIENT_MAX_PARTS
+// parts, e.g. a header and data that are not contiguous. The parts are sent
+// with the length prefix by one sendmsg(), and only copied if the socket does
+// not take them all.
+int mdif_client_sendv(mdif_device_t *dev, const struct iovec *parts, int n_parts);
+
+void *mdif_device_user_data(const mdif_device_t *dev);
+const char *mdif_device_host(const mdif_device_t *dev);
+bool mdif_device_connected(const mdif_device_t *dev);
+
+#endif // _MDIF_CLIENT_H
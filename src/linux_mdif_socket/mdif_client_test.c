@@ -0,0 +1,364 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_client_test.c                                           *
+ *                                                                             *
+ * Description  : Tests of mdif_client: connect, reconnect backoff, host       *
+ *              : parsing and sendv                                            *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <endian.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mdif_client.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Connect attempts timed while the device refuses connections
+#define ATTEMPTS 6
+// Allowed lateness of a reconnect, for a loaded machine
+#define SLACK_MS 30
+// Size of messages sent until the client buffer is full
+#define FILL_LEN 8000
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Times of the calls of connect()
+static uint64_t attempt_ms[64];
+static atomic_int n_attempts;
+
+static atomic_int n_connected;
+static atomic_int n_disconnected;
+static atomic_int disconnect_err;
+static uint64_t disconnect_ms;
+static atomic_int n_recv;
+static uint8_t recv_msg[64];
+static uint32_t recv_len;
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+int __real_connect(int fd, const struct sockaddr *addr, socklen_t len);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Linked with -Wl,--wrap=connect, to time the connect attempts
+int __wrap_connect(int fd, const struct sockaddr *addr, socklen_t len)
+{
+    int n = atomic_load(&n_attempts);
+    if (n < 64) {
+        attempt_ms[n] = now_ms();
+    }
+    atomic_store(&n_attempts, n + 1);
+    return __real_connect(fd, addr, len);
+}
+
+static void on_connected(mdif_device_t *dev)
+{
+    atomic_fetch_add(&n_connected, 1);
+}
+
+static void on_disconnected(mdif_device_t *dev, int err)
+{
+    disconnect_ms = now_ms();
+    atomic_store(&disconnect_err, err);
+    atomic_fetch_add(&n_disconnected, 1);
+}
+
+static void on_recv(mdif_device_t *dev, const uint8_t *msg, uint32_t len)
+{
+    recv_len = len < sizeof(recv_msg) ? len : sizeof(recv_msg);
+    memcpy(recv_msg, msg, recv_len);
+    atomic_fetch_add(&n_recv, 1);
+}
+
+// Wait until `*v` reaches `want`. Returns false on timeout.
+static bool wait_for(atomic_int *v, int want, int timeout_ms)
+{
+    uint64_t end = now_ms() + timeout_ms;
+    while (atomic_load(v) < want) {
+        if (now_ms() > end) {
+            return false;
+        }
+        usleep(1000);
+    }
+    return true;
+}
+
+// Listen on 127.0.0.1:`port`, or any free port if 0
+static int listen_on(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // Small, so the client buffer fills quickly when not read
+    int rcvbuf = 4096;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) == -1 || listen(fd, 1) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int port_of(int fd)
+{
+    struct sockaddr_in sa;
+    socklen_t len = sizeof(sa);
+    getsockname(fd, (struct sockaddr *)&sa, &len);
+    return ntohs(sa.sin_port);
+}
+
+static bool read_all(int fd, void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    while (len) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Read a length prefixed message. Returns its length, or -1.
+static int read_msg(int fd, uint8_t *buf, size_t size)
+{
+    uint32_t len;
+    if (!read_all(fd, &len, sizeof(len)) || le32toh(len) > size || !read_all(fd, buf, le32toh(len))) {
+        return -1;
+    }
+    return le32toh(len);
+}
+
+static int test_host_parsing(mdif_client_t *c)
+{
+    int fails = 0;
+    mdif_device_t *dev = mdif_client_add(c, "[::1]:21020", NULL);
+    CHECK("IPv6 address with port in brackets", dev != NULL);
+    if (dev) {
+        CHECK("host kept as given", strcmp(mdif_device_host(dev), "[::1]:21020") == 0);
+        mdif_client_remove(c, dev);
+    }
+    dev = mdif_client_add(c, "[::1]", NULL);
+    CHECK("IPv6 address in brackets without port", dev != NULL);
+    if (dev) {
+        mdif_client_remove(c, dev);
+    }
+    dev = mdif_client_add(c, "::1", NULL);
+    CHECK("bare IPv6 address", dev != NULL);
+    if (dev) {
+        mdif_client_remove(c, dev);
+    }
+    errno = 0;
+    CHECK("unterminated bracket rejected", mdif_client_add(c, "[::1:21020", NULL) == NULL && errno == EINVAL);
+    errno = 0;
+    CHECK("junk after bracket rejected", mdif_client_add(c, "[::1]21020", NULL) == NULL && errno == EINVAL);
+    return fails;
+}
+
+// Connect attempts to a closed port must back off, doubling up to the max
+static int test_backoff(mdif_device_t *dev)
+{
+    int fails = 0;
+    CHECK("connect retried", wait_for(&n_attempts, ATTEMPTS, 4 * ATTEMPTS * MDIF_CLIENT_BACKOFF_MAX_MS));
+    int good = atomic_load(&n_attempts) >= ATTEMPTS;
+    unsigned backoff = MDIF_CLIENT_BACKOFF_MIN_MS;
+    for (int i = 1; good && i < ATTEMPTS; i++) {
+        uint64_t delay = attempt_ms[i] - attempt_ms[i - 1];
+        good = delay >= backoff - backoff / 4 && delay <= backoff + backoff / 4 + SLACK_MS;
+        if (!good) {
+            printf("attempt %d after %llu ms, backoff %u ms\n", i, (unsigned long long)delay, backoff);
+        }
+        backoff = backoff * 2 > MDIF_CLIENT_BACKOFF_MAX_MS ? MDIF_CLIENT_BACKOFF_MAX_MS : backoff * 2;
+    }
+    CHECK("backoff doubled up to max, with jitter", good);
+    CHECK("not connected", atomic_load(&n_connected) == 0 && !mdif_device_connected(dev));
+    errno = 0;
+    CHECK("send while not connected fails", mdif_client_send(dev, (const uint8_t *)"x", 1) == -1 && errno == ENOTCONN);
+    return fails;
+}
+
+static int test_sendv(mdif_device_t *dev, int s)
+{
+    int fails = 0;
+    static uint8_t data[1000];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = i * 7;
+    }
+    struct iovec parts[3] = {
+        {.iov_base = "head", .iov_len = 4},
+        {.iov_base = data, .iov_len = sizeof(data)},
+        {.iov_base = "tail", .iov_len = 4},
+    };
+    CHECK("sendv of three parts", mdif_client_sendv(dev, parts, 3) == 0);
+    static uint8_t msg[FILL_LEN];
+    int len = read_msg(s, msg, sizeof(msg));
+    CHECK("parts sent as one message",
+          len == 4 + sizeof(data) + 4 && memcmp(msg, "head", 4) == 0 && memcmp(msg + 4, data, sizeof(data)) == 0 &&
+              memcmp(msg + 4 + sizeof(data), "tail", 4) == 0);
+
+    errno = 0;
+    CHECK("sendv of no parts fails", mdif_client_sendv(dev, parts, 0) == -1 && errno == EINVAL);
+    struct iovec many[MDIF_CLIENT_MAX_PARTS + 1];
+    for (int i = 0; i <= MDIF_CLIENT_MAX_PARTS; i++) {
+        many[i] = parts[0];
+    }
+    errno = 0;
+    CHECK("sendv of too many parts fails",
+          mdif_client_sendv(dev, many, MDIF_CLIENT_MAX_PARTS + 1) == -1 && errno == EINVAL);
+    struct iovec huge = {.iov_base = data, .iov_len = MDIF_CLIENT_TX_BUF_SIZE};
+    errno = 0;
+    CHECK("too large message fails", mdif_client_sendv(dev, &huge, 1) == -1 && errno == EMSGSIZE);
+
+    // Device not reading: messages are buffered until the buffer is full, and
+    // sent in order by the client thread once the device reads again
+    int sent = 0;
+    int ret = 0;
+    while (sent < 100000) {
+        for (int j = 0; j < FILL_LEN; j++) {
+            msg[j] = sent + j * 7;
+        }
+        parts[1] = (struct iovec){.iov_base = msg, .iov_len = FILL_LEN};
+        ret = mdif_client_sendv(dev, &parts[1], 1);
+        if (ret == -1) {
+            break;
+        }
+        sent++;
+    }
+    CHECK("full buffer fails with ENOBUFS", ret == -1 && errno == ENOBUFS);
+    int good = 1;
+    for (int i = 0; good && i < sent; i++) {
+        good = read_msg(s, msg, sizeof(msg)) == FILL_LEN;
+        for (int j = 0; good && j < FILL_LEN; j++) {
+            good = msg[j] == (uint8_t)(i + j * 7);
+        }
+    }
+    CHECK("buffered messages sent intact and in order", good);
+
+    uint8_t in[4 + 5] = {5, 0, 0, 0, 'h', 'e', 'l', 'l', 'o'};
+    CHECK("device message written", write(s, in, sizeof(in)) == sizeof(in));
+    CHECK("device message received", wait_for(&n_recv, 1, 1000) && recv_len == 5 && memcmp(recv_msg, "hello", 5) == 0);
+    return fails;
+}
+
+int main(void)
+{
+    int fails = 0;
+    struct mdif_client_callbacks cb = {
+        .connected = on_connected,
+        .disconnected = on_disconnected,
+        .recv = on_recv,
+    };
+    mdif_client_t *c = mdif_client_create(&cb);
+    fails += test_host_parsing(c);
+
+    // Find a free port, and refuse connections on it
+    int l = listen_on(0);
+    int port = port_of(l);
+    close(l);
+    char host[32];
+    snprintf(host, sizeof(host), "127.0.0.1:%d", port);
+    mdif_device_t *dev = mdif_client_add(c, host, NULL);
+    CHECK("device added", dev != NULL);
+    mdif_client_start(c);
+    fails += test_backoff(dev);
+
+    l = listen_on(port);
+    CHECK("connected when device listens", wait_for(&n_connected, 1, 2 * MDIF_CLIENT_BACKOFF_MAX_MS + SLACK_MS));
+    int s = accept(l, NULL, NULL);
+    struct timeval tv = {.tv_sec = 2};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    CHECK("device connected", mdif_device_connected(dev));
+    fails += test_sendv(dev, s);
+
+    // A lost connection is reported, and retried with the backoff reset
+    int attempts = atomic_load(&n_attempts);
+    close(s);
+    CHECK("disconnect reported", wait_for(&n_disconnected, 1, 1000) && atomic_load(&disconnect_err) == 0);
+    CHECK("reconnected", wait_for(&n_connected, 2, 1000));
+    CHECK("backoff reset by connection",
+          atomic_load(&n_attempts) == attempts + 1 &&
+              attempt_ms[attempts] - disconnect_ms <= MDIF_CLIENT_BACKOFF_MIN_MS * 5 / 4 + SLACK_MS);
+    s = accept(l, NULL, NULL);
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    uint8_t byte;
+    mdif_client_remove(c, dev);
+    CHECK("remove closes connection", read(s, &byte, 1) == 0);
+
+    mdif_client_destroy(c);
+    close(s);
+    close(l);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_rx_ring.c                                               *
+ *                                                                             *
+ * Description  : Receive ring for length-prefixed MDIF messages on a TCP      *
+ *              : stream.                                                      *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+#define _GNU_SOURCE
+#include <endian.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "mdif_rx_ring.h"
+
+// Each message is preceded by its length, 32 bit little endian
+#define PREFIX_LEN 4
+
+int mdif_rx_ring_init(struct mdif_rx_ring *r, size_t size)
+{
+    if (size < PREFIX_LEN || (size & (size - 1))) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->buf = malloc(size);
+    r->spill = malloc(size);
+    r->big = NULL;
+    if (!r->buf || !r->spill) {
+        mdif_rx_ring_free(r);
+        errno = ENOMEM;
+        return -1;
+    }
+    r->size = size;
+    r->head = r->tail = 0;
+    return 0;
+}
+
+void mdif_rx_ring_free(struct mdif_rx_ring *r)
+{
+    free(r->buf);
+    free(r->spill);
+    free(r->big);
+    r->buf = r->spill = r->big = NULL;
+}
+
+// Copy `len` bytes from ring position `pos` to `dst`, handling wrap
+static void ring_copy(const struct mdif_rx_ring *r, uint64_t pos, uint8_t *dst, size_t len)
+{
+    size_t off = pos & (r->size - 1);
+    size_t first = r->size - off < len ? r->size - off : len;
+    memcpy(dst, r->buf + off, first);
+    memcpy(dst + first, r->buf, len - first);
+}
+
+// Message too large for the ring. The part already received is copied to a
+// temporary buffer, and the remainder is received directly into it by
+// recv_big().
+static int start_big(struct mdif_rx_ring *r, uint32_t len)
+{
+    r->big = malloc(len);
+    if (!r->big) {
+        errno = ENOMEM;
+        return -1;
+    }
+    r->big_len = len;
+    r->big_have = r->head - r->tail - PREFIX_LEN;
+    ring_copy(r, r->tail + PREFIX_LEN, r->big, r->big_have);
+    r->head = r->tail = 0;
+    return 0;
+}
+
+static ssize_t recv_big(struct mdif_rx_ring *r, int sock, mdif_rx_ring_cb_t cb, void *ctx)
+{
+    ssize_t n = recv(sock, r->big + r->big_have, r->big_len - r->big_have, 0);
+    if (n <= 0) {
+        return n;
+    }
+    r->big_have += n;
+    if (r->big_have == r->big_len) {
+        cb(r->big, r->big_len, ctx);
+        free(r->big);
+        r->big = NULL;
+    }
+    return n;
+}
+
+ssize_t mdif_rx_ring_recv(struct mdif_rx_ring *r, int sock, mdif_rx_ring_cb_t cb, void *ctx)
+{
+    if (r->big) {
+        return recv_big(r, sock, cb, ctx);
+    }
+
+    // Receive into the contiguous free space after head. It is never empty,
+    // because a message larger than the ring is moved out as soon as its
+    // length is known.
+    size_t used = r->head - r->tail;
+    size_t off = r->head & (r->size - 1);
+    size_t space = r->size - used < r->size - off ? r->size - used : r->size - off;
+    ssize_t n = recv(sock, r->buf + off, space, 0);
+    if (n <= 0) {
+        return n;
+    }
+    r->head += n;
+
+    while (r->head - r->tail >= PREFIX_LEN) {
+        uint32_t len;
+        ring_copy(r, r->tail, (uint8_t *)&len, PREFIX_LEN);
+        len = le32toh(len);
+
+        if (len > r->size - PREFIX_LEN) {
+            if (start_big(r, len) == -1) {
+                return -1;
+            }
+            break;
+        }
+        if (r->head - r->tail < PREFIX_LEN + (uint64_t)len) {
+            break; // Incomplete
+        }
+
+        uint64_t start = r->tail + PREFIX_LEN;
+        size_t start_off = start & (r->size - 1);
+        if (start_off + len <= r->size) {
+            cb(r->buf + start_off, len, ctx);
+        } else {
+            ring_copy(r, start, r->spill, len);
+            cb(r->spill, len, ctx);
+        }
+        r->tail = start + len;
+    }
+
+    // Restart at the beginning when empty, so next recv() gets the whole ring
+    if (r->head == r->tail) {
+        r->head = r->tail = 0;
+    }
+    return n;
+}
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_rx_ring.h                                               *
+ *                                                                             *
+ * Description  : Receive ring for length-prefixed MDIF messages on a TCP      *
+ *              : stream.                                                      *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _MDIF_RX_RING_H
+#define _MDIF_RX_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Called for each complete message. `msg` is only valid during the call. It
+// points into the ring, or into the spill buffer if the message wraps around
+// the end of the ring.
+typedef void (*mdif_rx_ring_cb_t)(const uint8_t *msg, uint32_t len, void *ctx);
+
+// Receive ring. Each recv() reads as much as fits, and all complete messages
+// are delivered from the ring without copying.
+struct mdif_rx_ring {
+    uint8_t *buf;
+    size_t size;    // Power of 2
+    uint64_t head;  // Total bytes received
+    uint64_t tail;  // Total bytes consumed
+    uint8_t *spill; // Messages wrapping around end of buf are copied here
+    // Message larger than the ring, being received
+    uint8_t *big;
+    uint32_t big_len;
+    uint32_t big_have;
+};
+
+#ifndef MDIF_RX_RING_SIZE
+// Default ring size. Messages larger than this are received into a temporary
+// buffer.
+#define MDIF_RX_RING_SIZE (256 * 1024)
+#endif
+
+// Allocate ring of `size` bytes (power of 2). Returns -1 if out of memory.
+int mdif_rx_ring_init(struct mdif_rx_ring *r, size_t size);
+void mdif_rx_ring_free(struct mdif_rx_ring *r);
+
+// Do a single recv() on `sock` and call `cb` for every complete message
+// received. Returns the number of bytes received, 0 if peer closed the
+// connection, or -1 on error with errno set. `sock` may be non-blocking, in
+// which case -1 with errno EAGAIN is returned if there is no data.
+ssize_t mdif_rx_ring_recv(struct mdif_rx_ring *r, int sock, mdif_rx_ring_cb_t cb, void *ctx);
+
+#endif // _MDIF_RX_RING_H
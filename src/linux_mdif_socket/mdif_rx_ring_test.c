@@ -0,0 +1,186 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_rx_ring_test.c                                          *
+ *                                                                             *
+ * Description  : Test of the receive ring: messages straddling the end of the *
+ *              : ring, and messages larger than the ring, received in chunks  *
+ *              : of any size.                                                 *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "mdif_rx_ring.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define RING_SIZE 64
+#define MESSAGES 5000
+// Longest message, several times the ring
+#define MAX_LEN (4 * RING_SIZE)
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+static struct mdif_rx_ring ring;
+
+// Messages delivered, and how
+static uint32_t n_got;
+static uint32_t n_bad;
+static uint32_t n_spilled;
+static uint32_t n_big;
+static uint32_t n_in_ring;
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Length and content of message `i`. Short ones are the most common.
+static uint32_t msg_len(uint32_t i)
+{
+    uint32_t r = (i * 2654435761u) >> 16;
+    return r % 8 == 0 ? r % MAX_LEN : r % (RING_SIZE / 2);
+}
+
+static uint8_t msg_byte(uint32_t i, uint32_t j)
+{
+    return (uint8_t)(i * 31 + j * 7);
+}
+
+static void on_msg(const uint8_t *msg, uint32_t len, void *ctx)
+{
+    uint32_t i = n_got++;
+    int ok = len == msg_len(i);
+    for (uint32_t j = 0; ok && j < len; j++) {
+        ok = msg[j] == msg_byte(i, j);
+    }
+    n_bad += !ok;
+    if (msg == ring.spill) {
+        n_spilled++;
+    } else if (msg >= ring.buf && msg < ring.buf + ring.size) {
+        n_in_ring++;
+    } else {
+        n_big++;
+    }
+}
+
+// Receive until the socket is empty
+static void drain(int sock)
+{
+    while (mdif_rx_ring_recv(&ring, sock, on_msg, NULL) > 0) {
+    }
+}
+
+int main(void)
+{
+    int fails = 0;
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    fcntl(sv[1], F_SETFL, O_NONBLOCK);
+    CHECK("init: size not a power of 2 rejected", mdif_rx_ring_init(&ring, 100) == -1 && errno == EINVAL);
+    CHECK("init", mdif_rx_ring_init(&ring, RING_SIZE) == 0);
+
+    // All messages back to back, written in chunks of random size
+    uint8_t *stream = malloc(MESSAGES * (4 + MAX_LEN));
+    size_t size = 0;
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        uint32_t len = msg_len(i);
+        uint32_t prefix = htole32(len);
+        memcpy(stream + size, &prefix, 4);
+        size += 4;
+        for (uint32_t j = 0; j < len; j++) {
+            stream[size++] = msg_byte(i, j);
+        }
+    }
+    srand(1);
+    for (size_t sent = 0; sent < size;) {
+        size_t chunk = 1 + rand() % (2 * RING_SIZE);
+        chunk = chunk < size - sent ? chunk : size - sent;
+        sent += write(sv[0], stream + sent, chunk);
+        drain(sv[1]);
+    }
+
+    CHECK("all messages delivered", n_got == MESSAGES);
+    CHECK("messages intact and in order", n_bad == 0);
+    CHECK("messages straddling the end spilled", n_spilled > 0);
+    CHECK("messages larger than the ring received", n_big > 0);
+    CHECK("other messages read in place", n_in_ring > 0);
+    CHECK("ring empty", ring.head == ring.tail && !ring.big);
+
+    // A message of exactly the ring size less the prefix stays in the ring,
+    // one byte more does not
+    uint32_t in_ring = n_in_ring, big = n_big;
+    uint8_t one[4 + RING_SIZE] = {0};
+    for (uint32_t extra = 0; extra <= 1; extra++) {
+        uint32_t len = RING_SIZE - 4 + extra;
+        uint32_t prefix = htole32(len);
+        memcpy(one, &prefix, 4);
+        write(sv[0], one, 4 + len);
+        drain(sv[1]);
+    }
+    CHECK("largest message in the ring", n_in_ring == in_ring + 1 && n_big == big + 1);
+
+    // Peer closed
+    close(sv[0]);
+    CHECK("closed", mdif_rx_ring_recv(&ring, sv[1], on_msg, NULL) == 0);
+    close(sv[1]);
+    mdif_rx_ring_free(&ring);
+    free(stream);
+    return fails ? 1 : 0;
+}
@@ -61,14 +61,25 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <pthread.h>
-#include "codec.h"
+#include "linux_core_codec/mdif_buf.h"
+#include "mdif_rx_ring.h"
+#include "mdif_socket.h"
 
 static pthread_t rx_thread;
 
 int mdif_socket = -1;
 
+// Messages queued by mdif_socket_queue(), with length prefix, waiting to be
+// sent in one segment.
+static uint8_t tx_queue[MDIF_SOCKET_TX_QUEUE_SIZE];
+static size_t tx_queue_len;
+static pthread_mutex_t tx_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static int mdif_socket_connect(const char *host) {
     const char *port = "21020";
     char *colon = strchr(host, ':');
@@ -108,47 +119,49 @@ static int mdif_socket_connect(const char *host) {
     }
 }
 
-// Receive exactly n bytes from sock. Returns -1 if that fails, otherwise 0
-static int recvn(int sock, void *buf, size_t n)
+static void rx_msg(const uint8_t *pb, uint32_t pblen, void *ctx)
 {
-    int len = recv(sock, buf, n, MSG_WAITALL);
-    if (len == -1) {
-        perror("recv");
-        return -1;
-    }
-    if (len == 0) {
-        return -1;
-    }
-    if (len != n) {
-        printf("incomplete length (%d vs %ld)\n", len, n);
-        return -1;
-    }
-    return 0;
+    printf("Received %d bytes\n", pblen);
+    recv_mdif_msg(pb, pblen);
 }
 
+// Each recv() returns as much as is available, which may be many messages.
+// They are all decoded directly from the receive ring.
 static void *rx_thread_func(void *ptr)
 {
+    struct mdif_rx_ring ring;
+    if (mdif_rx_ring_init(&ring, MDIF_RX_RING_SIZE) == -1) {
+        perror("mdif_rx_ring_init");
+        exit(1);
+    }
+
     while (1) {
-        uint32_t pblen;
-        if (recvn(mdif_socket, &pblen, sizeof(pblen)) == -1) {
+        ssize_t n = mdif_rx_ring_recv(&ring, mdif_socket, rx_msg, NULL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("recv");
             exit(1);
         }
-        pblen = le32toh(pblen);
-
-        uint8_t *pb = malloc(pblen);
-        if (recvn(mdif_socket, pb, pblen) == -1) {
+        if (n == 0) {
+            printf("Connection closed\n");
             exit(1);
         }
-        printf("Received %d bytes\n", pblen);
-        decode_mdif_msg(pb, pblen);
-
-        free(pb);
     }
 }
 
 void mdif_socket_init(const char *host)
 {
     mdif_socket = mdif_socket_connect(host);
+
+    // Each message is sent with a single syscall and batching is done by
+    // mdif_socket_queue(), so Nagle would only add latency.
+    int one = 1;
+    if (setsockopt(mdif_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == -1) {
+        perror("setsockopt TCP_NODELAY");
+    }
+
     if (pthread_create(&rx_thread, NULL, rx_thread_func, NULL) != 0) {
         perror("pthread_create");
         exit(1);
@@ -156,6 +169,33 @@ void mdif_socket_init(const char *host)
 }
 
 
+// Send all of iov with as few syscalls as possible. Must be called with
+// tx_mutex held.
+static void sendv(struct iovec *iov, int iovcnt)
+{
+    struct msghdr msg = {.msg_iov = iov, .msg_iovlen = iovcnt};
+    while (msg.msg_iovlen) {
+        ssize_t n = sendmsg(mdif_socket, &msg, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("sendmsg");
+            exit(1);
+        }
+        // Partial send. Skip what was sent.
+        while (msg.msg_iovlen && (size_t)n >= msg.msg_iov->iov_len) {
+            n -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen) {
+            msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + n;
+            msg.msg_iov->iov_len -= n;
+        }
+    }
+}
+
 void mdif_socket_send(const uint8_t *buf, uint32_t size)
 {
     if (mdif_socket == -1) {
@@ -163,12 +203,69 @@ void mdif_socket_send(const uint8_t *buf, uint32_t size)
         return;
     }
     uint32_t pblen = htole32(size);
-    if (send(mdif_socket, &pblen, sizeof(pblen), 0) == -1) {
-        perror("send");
-        exit(1);
+    pthread_mutex_lock(&tx_mutex);
+    // Queued messages go first, in the same segment
+    struct iovec iov[] = {
+        {.iov_base = tx_queue, .iov_len = tx_queue_len},
+        {.iov_base = &pblen, .iov_len = sizeof(pblen)},
+        {.iov_base = (uint8_t *)buf, .iov_len = size},
+    };
+    sendv(iov, 3);
+    tx_queue_len = 0;
+    pthread_mutex_unlock(&tx_mutex);
+}
+
+void mdif_socket_send_buf(uint8_t *buf, uint32_t size)
+{
+    if (mdif_socket == -1) {
+        printf("Not connected\n");
+        return;
     }
-    if (send(mdif_socket, buf, size, 0) == -1) {
-        perror("send");
-        exit(1);
+    pthread_mutex_lock(&tx_mutex);
+    struct iovec iov[2];
+    int n = 0;
+    if (tx_queue_len) {
+        iov[n++] = (struct iovec){.iov_base = tx_queue, .iov_len = tx_queue_len};
+    }
+    iov[n++] = (struct iovec){.iov_base = mdif_buf_prefix(buf, size), .iov_len = MDIF_BUF_HEADROOM + size};
+    sendv(iov, n);
+    tx_queue_len = 0;
+    pthread_mutex_unlock(&tx_mutex);
+}
+
+void mdif_socket_queue(const uint8_t *buf, uint32_t size)
+{
+    if (mdif_socket == -1) {
+        printf("Not connected\n");
+        return;
+    }
+    if (sizeof(uint32_t) + size > sizeof(tx_queue)) {
+        mdif_socket_send(buf, size);
+        return;
+    }
+    uint32_t pblen = htole32(size);
+    pthread_mutex_lock(&tx_mutex);
+    if (tx_queue_len + sizeof(pblen) + size > sizeof(tx_queue)) {
+        struct iovec iov = {.iov_base = tx_queue, .iov_len = tx_queue_len};
+        sendv(&iov, 1);
+        tx_queue_len = 0;
+    }
+    memcpy(tx_queue + tx_queue_len, &pblen, sizeof(pblen));
+    memcpy(tx_queue + tx_queue_len + sizeof(pblen), buf, size);
+    tx_queue_len += sizeof(pblen) + size;
+    pthread_mutex_unlock(&tx_mutex);
+}
+
+void mdif_socket_flush(void)
+{
+    if (mdif_socket == -1) {
+        return;
+    }
+    pthread_mutex_lock(&tx_mutex);
+    if (tx_queue_len) {
+        struct iovec iov = {.iov_base = tx_queue, .iov_len = tx_queue_len};
+        sendv(&iov, 1);
+        tx_queue_len = 0;
     }
+    pthread_mutex_unlock(&tx_mutex);
 }
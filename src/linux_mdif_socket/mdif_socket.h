@@ -55,9 +55,39 @@
 #ifndef _MDIF_SOCKET_H
 #define _MDIF_SOCKET_H
 
+#include <stdint.h>
+
+#ifndef MDIF_SOCKET_TX_QUEUE_SIZE
+// Size of buffer for messages queued by mdif_socket_queue()
+#define MDIF_SOCKET_TX_QUEUE_SIZE (16 * 1024)
+#endif
+
 extern int mdif_socket;
 
-int mdif_socket_init(const char *host);
+// Connect to `host`, "addr[:port]", and start a thread passing each message
+// received to recv_mdif_msg()
+void mdif_socket_init(const char *host);
+
+// Called from the receive thread with each message. Provided by the
+// application, e.g. by codec.c of the demos.
+void recv_mdif_msg(const uint8_t *buf, uint32_t size);
+
+// Send message immediately, together with any messages queued by
+// mdif_socket_queue(). Use this for urgent commands. Length prefix and message
+// are sent with a single syscall.
 void mdif_socket_send(const uint8_t *buf, uint32_t size);
 
+// Like mdif_socket_send(), for a buffer from mdif_buf_pack(). The length prefix
+// is written into the headroom of `buf`, so prefix and message are one
+// contiguous buffer.
+void mdif_socket_send_buf(uint8_t *buf, uint32_t size);
+
+// Queue message to be sent in one segment with other queued messages, on the
+// next mdif_socket_flush() or mdif_socket_send(). The queue is also sent when
+// it is full. `buf` may be freed when the function returns.
+void mdif_socket_queue(const uint8_t *buf, uint32_t size);
+
+// Send all queued messages
+void mdif_socket_flush(void);
+
 #endif // _MDIF_SOCKET_H
\ No newline at end of file
@@ -0,0 +1,246 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : mdif_socket_test.c                                           *
+ *                                                                             *
+ * Description  : Test of the send path of mdif_socket: short writes,          *
+ *              : interrupted sends and overflow of the send queue, on a       *
+ *              : socketpair with a small send buffer.                         *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <endian.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "linux_core_codec/mdif_buf.h"
+#include "mdif_socket.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define MESSAGES 3000
+// Longest message, larger than the send queue so it is sent directly
+#define MAX_LEN (MDIF_SOCKET_TX_QUEUE_SIZE + 1000)
+#define SNDBUF 4096
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Messages checked by the reader
+static uint32_t n_read;
+static uint32_t n_bad;
+
+// Calls of sendmsg() that sent less than asked, or were interrupted
+static uint32_t n_calls;
+static uint32_t n_short;
+static uint32_t n_eintr;
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+ssize_t __real_sendmsg(int sock, const struct msghdr *msg, int flags);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Linked with -Wl,--wrap=sendmsg, to count short and interrupted sends
+ssize_t __wrap_sendmsg(int sock, const struct msghdr *msg, int flags)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < msg->msg_iovlen; i++) {
+        len += msg->msg_iov[i].iov_len;
+    }
+    ssize_t n = __real_sendmsg(sock, msg, flags);
+    n_calls++;
+    if (n == -1 && errno == EINTR) {
+        n_eintr++;
+    } else if (n >= 0 && (size_t)n < len) {
+        n_short++;
+    }
+    return n;
+}
+
+void recv_mdif_msg(const uint8_t *buf, uint32_t size)
+{
+}
+
+// Length and content of message `i`. Mostly short, some larger than the
+// send queue.
+static uint32_t msg_len(uint32_t i)
+{
+    uint32_t r = (i * 2654435761u) >> 16;
+    return r % 50 == 0 ? MDIF_SOCKET_TX_QUEUE_SIZE + r % 1000 : r % 300;
+}
+
+static uint8_t msg_byte(uint32_t i, uint32_t j)
+{
+    return (uint8_t)(i * 31 + j * 7);
+}
+
+static void read_all(int sock, uint8_t *buf, size_t len)
+{
+    while (len) {
+        // Slowly, so the sender fills its buffer
+        size_t chunk = len < 512 ? len : 512;
+        ssize_t n = read(sock, buf, chunk);
+        if (n <= 0) {
+            return;
+        }
+        buf += n;
+        len -= n;
+        usleep(20);
+    }
+}
+
+// Check the messages as they arrive
+static void *reader(void *arg)
+{
+    int sock = *(int *)arg;
+    static uint8_t msg[MAX_LEN];
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        uint32_t len;
+        read_all(sock, (uint8_t *)&len, sizeof(len));
+        len = le32toh(len);
+        int ok = len == msg_len(i) && len <= MAX_LEN;
+        if (ok) {
+            read_all(sock, msg, len);
+            for (uint32_t j = 0; ok && j < len; j++) {
+                ok = msg[j] == msg_byte(i, j);
+            }
+        }
+        n_bad += !ok;
+        n_read++;
+        if (!ok) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void on_alarm(int sig)
+{
+}
+
+int main(void)
+{
+    int fails = 0;
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    int sndbuf = SNDBUF;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    mdif_socket = sv[0];
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, reader, &sv[1]);
+
+    // Interrupt the sender while it waits for room, without SA_RESTART
+    struct sigaction sa = {.sa_handler = on_alarm};
+    sigaction(SIGALRM, &sa, NULL);
+    struct itimerval tv = {.it_interval = {.tv_usec = 500}, .it_value = {.tv_usec = 500}};
+    setitimer(ITIMER_REAL, &tv, NULL);
+
+    static uint8_t msg[MAX_LEN];
+    uint32_t queue_calls = 0;
+    for (uint32_t i = 0; i < MESSAGES; i++) {
+        uint32_t len = msg_len(i);
+        for (uint32_t j = 0; j < len; j++) {
+            msg[j] = msg_byte(i, j);
+        }
+        // Runs of queued messages, longer than the queue, then queued, sent
+        // directly and from a pool buffer in turn
+        int how = i % 200 < 150 ? 0 : i % 4;
+        if (how == 0) {
+            uint32_t calls = n_calls;
+            mdif_socket_queue(msg, len);
+            if (len < MDIF_SOCKET_TX_QUEUE_SIZE) {
+                queue_calls += n_calls - calls;
+            }
+        } else if (how == 1) {
+            mdif_socket_send(msg, len);
+        } else if (how == 2) {
+            uint8_t *buf = mdif_buf_copy(msg, len);
+            mdif_socket_send_buf(buf, len);
+            mdif_buf_free(buf);
+        } else {
+            mdif_socket_queue(msg, len);
+            mdif_socket_flush();
+        }
+    }
+    mdif_socket_flush();
+    pthread_join(thread, NULL);
+    struct itimerval off = {0};
+    setitimer(ITIMER_REAL, &off, NULL);
+
+    printf("%u sendmsg, %u short, %u interrupted\n", n_calls, n_short, n_eintr);
+    CHECK("all messages received", n_read == MESSAGES);
+    CHECK("messages intact and in order", n_bad == 0);
+    CHECK("short writes completed", n_short > 0);
+    CHECK("interrupted sends retried", n_eintr > 0);
+    CHECK("full queue sent by mdif_socket_queue()", queue_calls > 0);
+    uint32_t calls = n_calls;
+    mdif_socket_flush();
+    CHECK("nothing left to flush", n_calls == calls);
+
+    close(sv[0]);
+    close(sv[1]);
+    return fails ? 1 : 0;
+}
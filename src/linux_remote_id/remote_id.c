@@ -0,0 +1,210 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : remote_id.c                                                  *
+ *                                                                             *
+ * Description  : Decoder of ASTM F3411 Remote ID messages and message packs.  *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <string.h>
+
+#include "remote_id.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Message pack: header, message size, number of messages, messages
+#define PACK_HDR_SIZE 3
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static void decode_location(const uint8_t *m, struct rid_location *l);
+static void decode_system(const uint8_t *m, struct rid_system *s);
+static void copy_text(char *dst, const uint8_t *src, uint32_t max);
+static inline uint16_t le16(const uint8_t *p);
+static inline uint32_t le32(const uint8_t *p);
+static inline float altitude(const uint8_t *p);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+int rid_split(const uint8_t *payload, uint32_t size, const uint8_t **msgs, uint32_t max) {
+    if (size < RID_MSG_SIZE) {
+        errno = EBADMSG;
+        return -1;
+    }
+    if (payload[0] >> 4 != RID_PACK) {
+        if (max > 0) {
+            msgs[0] = payload;
+        }
+        return 1;
+    }
+    uint32_t n = payload[2];
+    if (payload[1] != RID_MSG_SIZE || n > RID_MAX_PACK || size < PACK_HDR_SIZE + n * RID_MSG_SIZE) {
+        errno = EBADMSG;
+        return -1;
+    }
+    for (uint32_t i = 0; i < n && i < max; i++) {
+        msgs[i] = payload + PACK_HDR_SIZE + i * RID_MSG_SIZE;
+    }
+    return n;
+}
+
+int rid_decode_msg(const uint8_t *m, struct rid_msg *out) {
+    out->type = m[0] >> 4;
+    out->version = m[0] & 0xf;
+    switch (out->type) {
+    case RID_BASIC_ID:
+        out->basic_id.id_type = m[1] >> 4;
+        out->basic_id.ua_type = m[1] & 0xf;
+        copy_text(out->basic_id.uas_id, m + 2, RID_ID_SIZE);
+        return 0;
+    case RID_LOCATION:
+        decode_location(m, &out->location);
+        return 0;
+    case RID_AUTH:
+        out->auth.auth_type = m[1] >> 4;
+        out->auth.page = m[1] & 0xf;
+        memcpy(out->auth.data, m + 2, sizeof(out->auth.data));
+        return 0;
+    case RID_SELF_ID:
+        out->self_id.desc_type = m[1];
+        copy_text(out->self_id.desc, m + 2, RID_TEXT_SIZE);
+        return 0;
+    case RID_SYSTEM:
+        decode_system(m, &out->system);
+        return 0;
+    case RID_OPERATOR_ID:
+        out->operator_id.id_type = m[1];
+        copy_text(out->operator_id.operator_id, m + 2, RID_ID_SIZE);
+        return 0;
+    default:
+        errno = ENOMSG;
+        return -1;
+    }
+}
+
+int rid_decode(const uint8_t *payload, uint32_t size, struct rid_msg *msgs, uint32_t max) {
+    const uint8_t *raw[RID_MAX_PACK];
+    int n = rid_split(payload, size, raw, RID_MAX_PACK);
+    if (n < 0) {
+        return -1;
+    }
+    uint32_t decoded = 0;
+    for (int i = 0; i < n && decoded < max; i++) {
+        if (rid_decode_msg(raw[i], &msgs[decoded]) == 0) {
+            decoded++;
+        }
+    }
+    return decoded;
+}
+
+static void decode_location(const uint8_t *m, struct rid_location *l) {
+    l->status = m[1] >> 4;
+    l->height_agl = m[1] & 0x04;
+    // Direction is sent as 0-179, with a flag for the eastern or western half
+    l->direction = m[2] + (m[1] & 0x02 ? 180 : 0);
+    // Speeds above 63.75 m/s are sent with a coarser resolution
+    l->speed_h = m[1] & 0x01 ? m[3] * 0.75f + 255 * 0.25f : m[3] * 0.25f;
+    l->speed_v = (int8_t)m[4] * 0.5f;
+    l->lat = (int32_t)le32(m + 5) * 1e-7;
+    l->lon = (int32_t)le32(m + 9) * 1e-7;
+    l->alt_baro = altitude(m + 13);
+    l->alt_geo = altitude(m + 15);
+    l->height = altitude(m + 17);
+    l->v_accuracy = m[19] >> 4;
+    l->h_accuracy = m[19] & 0xf;
+    l->baro_accuracy = m[20] >> 4;
+    l->speed_accuracy = m[20] & 0xf;
+    l->timestamp = le16(m + 21) * 0.1f;
+    l->ts_accuracy = m[23] & 0xf;
+}
+
+static void decode_system(const uint8_t *m, struct rid_system *s) {
+    s->classification_type = (m[1] >> 2) & 0x7;
+    s->operator_location_type = m[1] & 0x3;
+    s->operator_lat = (int32_t)le32(m + 2) * 1e-7;
+    s->operator_lon = (int32_t)le32(m + 6) * 1e-7;
+    s->area_count = le16(m + 10);
+    s->area_radius = m[12] * 10.0f;
+    s->area_ceiling = altitude(m + 13);
+    s->area_floor = altitude(m + 15);
+    s->ua_category = m[17] >> 4;
+    s->ua_class = m[17] & 0xf;
+    s->operator_alt_geo = altitude(m + 18);
+    s->timestamp = le32(m + 20);
+}
+
+// Copy text field of up to `max` characters, padded with NUL
+static void copy_text(char *dst, const uint8_t *src, uint32_t max) {
+    uint32_t i;
+    for (i = 0; i < max && src[i]; i++) {
+        dst[i] = src[i];
+    }
+    dst[i] = 0;
+}
+
+static inline uint16_t le16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+static inline uint32_t le32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Altitudes are sent in 0.5 m steps from -1000 m
+static inline float altitude(const uint8_t *p) {
+    return le16(p) * 0.5f - 1000;
+}
@@ -0,0 +1,172 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : remote_id.h                                                  *
+ *                                                                             *
+ * Description  : Decoder of ASTM F3411 Remote ID messages and message packs.  *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _REMOTE_ID_H
+#define _REMOTE_ID_H
+
+// Decodes the ASTM F3411 messages in the payload of RemoteIdInd into fixed
+// structs, without allocation. Each message is 25 bytes, with its type in the
+// upper nibble of the first byte and the protocol version in the lower. A
+// message pack (type 0xF) holds up to RID_MAX_PACK of them.
+//
+// Values are converted to SI units and degrees, but not checked: the
+// encodings of unknown values (e.g. direction 361, altitude -1000) are
+// returned as is, see F3411.
+//
+// No protobuf dependency.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RID_MSG_SIZE 25
+#define RID_MAX_PACK 9
+// Longest UAS ID, operator ID and self ID text, without terminator
+#define RID_ID_SIZE 20
+#define RID_TEXT_SIZE 23
+
+enum rid_msg_type {
+    RID_BASIC_ID = 0x0,
+    RID_LOCATION = 0x1,
+    RID_AUTH = 0x2,
+    RID_SELF_ID = 0x3,
+    RID_SYSTEM = 0x4,
+    RID_OPERATOR_ID = 0x5,
+    RID_MSG_TYPES,
+    RID_PACK = 0xF,
+};
+
+struct rid_basic_id {
+    uint8_t id_type; // 1 serial number, 2 CAA registration, 3 UTM UUID, 4 session ID
+    uint8_t ua_type;
+    char uas_id[RID_ID_SIZE + 1];
+};
+
+struct rid_location {
+    uint8_t status; // 0 undeclared, 1 ground, 2 airborne, 3 emergency
+    bool height_agl; // height above ground, else above takeoff
+    float direction; // Degrees clockwise from true north
+    float speed_h;   // m/s
+    float speed_v;   // m/s, positive up
+    double lat;      // Degrees
+    double lon;
+    float alt_baro; // m
+    float alt_geo;  // m, WGS84
+    float height;   // m
+    uint8_t h_accuracy;
+    uint8_t v_accuracy;
+    uint8_t baro_accuracy;
+    uint8_t speed_accuracy;
+    float timestamp;     // s since the full hour
+    uint8_t ts_accuracy; // 0.1 s
+};
+
+struct rid_auth {
+    uint8_t auth_type;
+    uint8_t page;
+    uint8_t data[RID_MSG_SIZE - 2]; // Page as sent
+};
+
+struct rid_self_id {
+    uint8_t desc_type;
+    char desc[RID_TEXT_SIZE + 1];
+};
+
+struct rid_system {
+    uint8_t operator_location_type; // 0 takeoff, 1 live GNSS, 2 fixed
+    uint8_t classification_type;    // 0 undeclared, 1 EU
+    double operator_lat;
+    double operator_lon;
+    uint16_t area_count;
+    float area_radius; // m
+    float area_ceiling;
+    float area_floor;
+    uint8_t ua_category;
+    uint8_t ua_class;
+    float operator_alt_geo;
+    uint32_t timestamp; // s since 2019-01-01 00:00 UTC
+};
+
+struct rid_operator_id {
+    uint8_t id_type;
+    char operator_id[RID_ID_SIZE + 1];
+};
+
+struct rid_msg {
+    enum rid_msg_type type;
+    uint8_t version;
+    union {
+        struct rid_basic_id basic_id;
+        struct rid_location location;
+        struct rid_auth auth;
+        struct rid_self_id self_id;
+        struct rid_system system;
+        struct rid_operator_id operator_id;
+    };
+};
+
+// Find the messages in `payload`, a message pack or a single message, without
+// decoding them. Sets `msgs` to up to `max` of them. Returns the number of
+// messages, or -1 with errno EBADMSG if `payload` is malformed.
+int rid_split(const uint8_t *payload, uint32_t size, const uint8_t **msgs, uint32_t max);
+
+// Decode one message of RID_MSG_SIZE bytes. Returns -1 with errno ENOMSG if
+// the type is unknown, or a message pack.
+int rid_decode_msg(const uint8_t *msg, struct rid_msg *out);
+
+// Decode all messages in `payload`, into up to `max` of `msgs`. Unknown
+// messages are skipped. Returns the number decoded, or -1 with errno EBADMSG
+// if `payload` is malformed.
+int rid_decode(const uint8_t *payload, uint32_t size, struct rid_msg *msgs, uint32_t max);
+
+#endif // _REMOTE_ID_H
@@ -0,0 +1,204 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : remote_id_test.c                                             *
+ *                                                                             *
+ * Description  : Tests of remote_id: ASTM F3411 message packs and messages    *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "remote_id.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define NEAR(a, b) (fabs((double)(a) - (double)(b)) < 1e-6)
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+// Messages as a drone sends them, version 2 (F3411-22a)
+
+// Basic ID: serial number, helicopter or multirotor, "1581F5FKD229R00B1234"
+static const uint8_t basic_id[RID_MSG_SIZE] = {
+    0x02, 0x12, 0x31, 0x35, 0x38, 0x31, 0x46, 0x35, 0x46, 0x4B, 0x44, 0x32, 0x32,
+    0x39, 0x52, 0x30, 0x30, 0x42, 0x31, 0x32, 0x33, 0x34, 0x00, 0x00, 0x00,
+};
+
+// Location: airborne, height above ground, direction 215 (35 + 180), 5.25 m/s
+// horizontally, 1.5 m/s up, at 55.6761234,12.5683371, pressure altitude
+// 100.5 m, geodetic altitude 110 m, height 50 m, accuracies 4/10/3/2, at
+// 360.5 s past the hour with accuracy 0.2 s
+static const uint8_t location[RID_MSG_SIZE] = {
+    0x12, 0x26, 0x23, 0x15, 0x03, 0x92, 0x80, 0x2F, 0x21, 0xAB, 0xC6, 0x7D, 0x07,
+    0x99, 0x08, 0xAC, 0x08, 0x34, 0x08, 0x4A, 0x32, 0x15, 0x0E, 0x02, 0x00,
+};
+
+// Location: airborne, direction 10, 66 m/s (speed multiplier), 2 m/s down, at
+// -33.8688,-58.9, altitudes and timestamp unknown
+static const uint8_t location_fast[RID_MSG_SIZE] = {
+    0x12, 0x21, 0x0A, 0x03, 0xFC, 0x00, 0x08, 0xD0, 0xEB, 0xC0, 0x92, 0xE4, 0xDC,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00,
+};
+
+// System: EU classification, live GNSS operator location at 55.675,12.565,
+// one area with unknown radius and altitudes, category open, class C2,
+// operator 15 m above WGS84, 2024-01-01 00:00 UTC
+static const uint8_t system_msg[RID_MSG_SIZE] = {
+    0x42, 0x05, 0xB0, 0x54, 0x2F, 0x21, 0x50, 0x44, 0x7D, 0x07, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x12, 0xEE, 0x07, 0x00, 0x53, 0x67, 0x09, 0x00,
+};
+
+// Operator ID "FIN87astrdge12k8"
+static const uint8_t operator_id[RID_MSG_SIZE] = {
+    0x52, 0x00, 0x46, 0x49, 0x4E, 0x38, 0x37, 0x61, 0x73, 0x74, 0x72, 0x64, 0x67,
+    0x65, 0x31, 0x32, 0x6B, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Message pack of `n` messages
+static uint32_t pack(uint8_t *buf, const uint8_t *const *msgs, uint32_t n) {
+    buf[0] = RID_PACK << 4 | 2;
+    buf[1] = RID_MSG_SIZE;
+    buf[2] = n;
+    for (uint32_t i = 0; i < n; i++) {
+        memcpy(buf + 3 + i * RID_MSG_SIZE, msgs[i], RID_MSG_SIZE);
+    }
+    return 3 + n * RID_MSG_SIZE;
+}
+
+int main(void) {
+    int fails = 0;
+    uint8_t buf[3 + (RID_MAX_PACK + 1) * RID_MSG_SIZE];
+    const uint8_t *raw[RID_MAX_PACK];
+    struct rid_msg msg;
+
+    // Message pack split
+    const uint8_t *const four[] = {basic_id, location, system_msg, operator_id};
+    uint32_t size = pack(buf, four, 4);
+    int good = rid_split(buf, size, raw, RID_MAX_PACK) == 4;
+    for (int i = 0; i < 4; i++) {
+        good &= raw[i] == buf + 3 + i * RID_MSG_SIZE && memcmp(raw[i], four[i], RID_MSG_SIZE) == 0;
+    }
+    CHECK("pack split into its messages", good);
+    CHECK("pack split into fewer than it holds", rid_split(buf, size, raw, 2) == 4 && raw[1] == buf + 3 + RID_MSG_SIZE);
+    CHECK("single message is not split", rid_split(location, sizeof(location), raw, RID_MAX_PACK) == 1 &&
+                                             raw[0] == location);
+    errno = 0;
+    CHECK("truncated pack", rid_split(buf, size - 1, raw, RID_MAX_PACK) == -1 && errno == EBADMSG);
+    errno = 0;
+    CHECK("short message", rid_split(location, RID_MSG_SIZE - 1, raw, RID_MAX_PACK) == -1 && errno == EBADMSG);
+    buf[1] = RID_MSG_SIZE + 1;
+    errno = 0;
+    CHECK("pack of other message size", rid_split(buf, size, raw, RID_MAX_PACK) == -1 && errno == EBADMSG);
+    const uint8_t *const ten[] = {location, location, location, location, location,
+                                  location, location, location, location, location};
+    size = pack(buf, ten, 10);
+    errno = 0;
+    CHECK("pack of more than 9", rid_split(buf, size, raw, RID_MAX_PACK) == -1 && errno == EBADMSG);
+
+    // Location
+    good = rid_decode_msg(location, &msg) == 0 && msg.type == RID_LOCATION && msg.version == 2;
+    const struct rid_location *l = &msg.location;
+    good &= l->status == 2 && l->height_agl && NEAR(l->direction, 215) && NEAR(l->speed_h, 5.25) &&
+            NEAR(l->speed_v, 1.5);
+    good &= NEAR(l->lat, 55.6761234) && NEAR(l->lon, 12.5683371);
+    good &= NEAR(l->alt_baro, 100.5) && NEAR(l->alt_geo, 110) && NEAR(l->height, 50);
+    good &= l->v_accuracy == 4 && l->h_accuracy == 10 && l->baro_accuracy == 3 && l->speed_accuracy == 2;
+    good &= NEAR(l->timestamp, 360.5) && l->ts_accuracy == 2;
+    CHECK("location", good);
+    good = rid_decode_msg(location_fast, &msg) == 0 && l->status == 2 && !l->height_agl &&
+           NEAR(l->direction, 10) && NEAR(l->speed_h, 66) && NEAR(l->speed_v, -2);
+    good &= NEAR(l->lat, -33.8688) && NEAR(l->lon, -58.9);
+    good &= NEAR(l->alt_baro, -1000) && NEAR(l->alt_geo, -1000) && NEAR(l->height, -1000);
+    CHECK("location: speed multiplier, south-west, unknown altitudes", good);
+
+    // System
+    good = rid_decode_msg(system_msg, &msg) == 0 && msg.type == RID_SYSTEM;
+    const struct rid_system *s = &msg.system;
+    good &= s->classification_type == 1 && s->operator_location_type == 1;
+    good &= NEAR(s->operator_lat, 55.675) && NEAR(s->operator_lon, 12.565);
+    good &= s->area_count == 1 && NEAR(s->area_radius, 0) && NEAR(s->area_ceiling, -1000) &&
+            NEAR(s->area_floor, -1000);
+    good &= s->ua_category == 1 && s->ua_class == 2 && NEAR(s->operator_alt_geo, 15);
+    good &= s->timestamp == 157766400;
+    CHECK("system", good);
+
+    // Basic ID, 20 characters without terminator
+    good = rid_decode_msg(basic_id, &msg) == 0 && msg.type == RID_BASIC_ID;
+    good &= msg.basic_id.id_type == 1 && msg.basic_id.ua_type == 2;
+    good &= strcmp(msg.basic_id.uas_id, "1581F5FKD229R00B1234") == 0;
+    CHECK("basic ID", good);
+    good = rid_decode_msg(operator_id, &msg) == 0 && msg.type == RID_OPERATOR_ID && msg.operator_id.id_type == 0 &&
+           strcmp(msg.operator_id.operator_id, "FIN87astrdge12k8") == 0;
+    CHECK("operator ID", good);
+
+    // Unknown types are skipped
+    uint8_t unknown[RID_MSG_SIZE] = {0x62};
+    errno = 0;
+    CHECK("unknown type", rid_decode_msg(unknown, &msg) == -1 && errno == ENOMSG);
+    const uint8_t *const mixed[] = {basic_id, unknown, location};
+    size = pack(buf, mixed, 3);
+    struct rid_msg msgs[RID_MAX_PACK];
+    CHECK("pack decoded, unknown skipped", rid_decode(buf, size, msgs, RID_MAX_PACK) == 2 &&
+                                               msgs[0].type == RID_BASIC_ID && msgs[1].type == RID_LOCATION);
+    CHECK("pack decoded into fewer", rid_decode(buf, size, msgs, 1) == 1 && msgs[0].type == RID_BASIC_ID);
+
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,312 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : rid_tracker.c                                                *
+ *                                                                             *
+ * Description  : Deduplication and per drone state of Remote ID messages.     *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <string.h>
+
+#include "rid_tracker.h"
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static bool is_repeat(struct rid_tracker *t, uint64_t mac, const uint8_t *msg, uint64_t now_ms);
+static struct rid_drone *find_mac(struct rid_tracker *t, uint64_t mac);
+static struct rid_drone *find_uas_id(const struct rid_tracker *t, const char *uas_id);
+static struct rid_drone *add_drone(struct rid_tracker *t, uint64_t now_ms);
+static struct rid_drone *merge(struct rid_tracker *t, struct rid_drone *dst, struct rid_drone *src);
+static void add_mac(struct rid_drone *d, uint64_t mac);
+static void apply(struct rid_drone *d, const struct rid_msg *msg, uint64_t now_ms);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+void rid_tracker_init(struct rid_tracker *t, uint32_t window_ms, uint32_t timeout_ms) {
+    memset(t, 0, sizeof(*t));
+    t->window_ms = window_ms;
+    t->timeout_ms = timeout_ms;
+}
+
+const struct rid_drone *rid_tracker_update(struct rid_tracker *t, const uint8_t *mac, uint32_t transport,
+                                           const uint8_t *payload, uint32_t size, uint64_t now_ms) {
+    t->payloads++;
+    const uint8_t *raw[RID_MAX_PACK];
+    int n = rid_split(payload, size, raw, RID_MAX_PACK);
+    if (n < 0) {
+        t->malformed++;
+        return NULL;
+    }
+    t->messages += n;
+
+    // Repeats are dropped before decoding
+    uint64_t m = rid_mac(mac);
+    struct rid_msg msgs[RID_MAX_PACK];
+    uint32_t n_msgs = 0;
+    for (int i = 0; i < n; i++) {
+        if (is_repeat(t, m, raw[i], now_ms)) {
+            t->repeats++;
+        } else if (rid_decode_msg(raw[i], &msgs[n_msgs]) == 0) {
+            n_msgs++;
+        }
+    }
+    if (!n_msgs) {
+        return NULL;
+    }
+
+    struct rid_drone *d = find_mac(t, m);
+    for (uint32_t i = 0; i < n_msgs; i++) {
+        if (msgs[i].type == RID_BASIC_ID && msgs[i].basic_id.uas_id[0]) {
+            // Known from another MAC address, e.g. another transport
+            struct rid_drone *other = find_uas_id(t, msgs[i].basic_id.uas_id);
+            if (other && d && other != d) {
+                d = merge(t, other, d);
+            } else if (other) {
+                d = other;
+            }
+            break;
+        }
+    }
+    if (!d) {
+        d = add_drone(t, now_ms);
+    }
+    add_mac(d, m);
+    if (transport < 32) {
+        d->transports |= 1u << transport;
+    }
+    for (uint32_t i = 0; i < n_msgs; i++) {
+        apply(d, &msgs[i], now_ms);
+    }
+    d->last_ms = now_ms;
+    return d;
+}
+
+const struct rid_drone *rid_tracker_find(const struct rid_tracker *t, const char *uas_id) {
+    // Drones without a Basic ID have an empty UAS ID
+    if (!uas_id[0]) {
+        return NULL;
+    }
+    return find_uas_id(t, uas_id);
+}
+
+void rid_tracker_expire(struct rid_tracker *t, uint64_t now_ms) {
+    for (uint32_t i = 0; i < t->n_drones;) {
+        if (now_ms - t->drones[i].last_ms > t->timeout_ms) {
+            t->drones[i] = t->drones[--t->n_drones];
+        } else {
+            i++;
+        }
+    }
+}
+
+// Check fingerprint of (mac, msg) against the dedup set, and add it. Each
+// fingerprint has RID_DEDUP_PROBE candidate slots; a new one replaces the
+// oldest of them, so the set never needs cleaning.
+static bool is_repeat(struct rid_tracker *t, uint64_t mac, const uint8_t *msg, uint64_t now_ms) {
+    // FNV-1a of MAC address and message, which starts with its type
+    uint64_t fp = 0xcbf29ce484222325ull;
+    for (int i = 0; i < 6; i++) {
+        fp = (fp ^ (uint8_t)(mac >> (8 * i))) * 0x100000001b3ull;
+    }
+    for (int i = 0; i < RID_MSG_SIZE; i++) {
+        fp = (fp ^ msg[i]) * 0x100000001b3ull;
+    }
+    fp = fp ? fp : 1; // 0 is a free slot
+
+    uint32_t oldest = fp & (RID_DEDUP_SLOTS - 1);
+    for (uint32_t p = 0; p < RID_DEDUP_PROBE; p++) {
+        uint32_t i = (fp + p) & (RID_DEDUP_SLOTS - 1);
+        if (t->dedup_fp[i] == fp) {
+            if (now_ms - t->dedup_ms[i] <= t->window_ms) {
+                return true;
+            }
+            // Seen before the window, so let it through once more
+            t->dedup_ms[i] = now_ms;
+            return false;
+        }
+        if (t->dedup_ms[i] < t->dedup_ms[oldest]) {
+            oldest = i;
+        }
+    }
+    t->dedup_fp[oldest] = fp;
+    t->dedup_ms[oldest] = now_ms;
+    return false;
+}
+
+static struct rid_drone *find_mac(struct rid_tracker *t, uint64_t mac) {
+    for (uint32_t i = 0; i < t->n_drones; i++) {
+        for (uint32_t j = 0; j < t->drones[i].n_macs; j++) {
+            if (t->drones[i].macs[j] == mac) {
+                return &t->drones[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static struct rid_drone *find_uas_id(const struct rid_tracker *t, const char *uas_id) {
+    for (uint32_t i = 0; i < t->n_drones; i++) {
+        if (strcmp(t->drones[i].basic_id.uas_id, uas_id) == 0) {
+            return (struct rid_drone *)&t->drones[i];
+        }
+    }
+    return NULL;
+}
+
+// New drone, replacing the one heard least recently if there is no room
+static struct rid_drone *add_drone(struct rid_tracker *t, uint64_t now_ms) {
+    if (t->n_drones == RID_MAX_DRONES) {
+        rid_tracker_expire(t, now_ms);
+    }
+    struct rid_drone *d;
+    if (t->n_drones < RID_MAX_DRONES) {
+        d = &t->drones[t->n_drones++];
+    } else {
+        d = &t->drones[0];
+        for (uint32_t i = 1; i < t->n_drones; i++) {
+            if (t->drones[i].last_ms < d->last_ms) {
+                d = &t->drones[i];
+            }
+        }
+    }
+    memset(d, 0, sizeof(*d));
+    d->first_ms = now_ms;
+    return d;
+}
+
+// Merge `src` into `dst`, keeping the latest message of each type, and remove
+// `src`. Returns `dst`, which may have moved.
+static struct rid_drone *merge(struct rid_tracker *t, struct rid_drone *dst, struct rid_drone *src) {
+    for (int type = 0; type < RID_MSG_TYPES; type++) {
+        if (!(src->have & (1u << type)) || ((dst->have & (1u << type)) && dst->msg_ms[type] >= src->msg_ms[type])) {
+            continue;
+        }
+        switch (type) {
+        case RID_BASIC_ID:
+            dst->basic_id = src->basic_id;
+            break;
+        case RID_LOCATION:
+            dst->location = src->location;
+            break;
+        case RID_SELF_ID:
+            dst->self_id = src->self_id;
+            break;
+        case RID_SYSTEM:
+            dst->system = src->system;
+            break;
+        case RID_OPERATOR_ID:
+            dst->operator_id = src->operator_id;
+            break;
+        }
+        dst->msg_ms[type] = src->msg_ms[type];
+    }
+    for (uint32_t i = 0; i < src->n_macs; i++) {
+        add_mac(dst, src->macs[i]);
+    }
+    dst->have |= src->have;
+    dst->transports |= src->transports;
+    dst->msgs += src->msgs;
+    dst->first_ms = src->first_ms < dst->first_ms ? src->first_ms : dst->first_ms;
+    dst->last_ms = src->last_ms > dst->last_ms ? src->last_ms : dst->last_ms;
+
+    struct rid_drone *last = &t->drones[--t->n_drones];
+    if (src != last) {
+        *src = *last;
+        if (dst == last) {
+            dst = src;
+        }
+    }
+    return dst;
+}
+
+// Keep the RID_MAX_MACS latest MAC addresses
+static void add_mac(struct rid_drone *d, uint64_t mac) {
+    for (uint32_t i = 0; i < d->n_macs; i++) {
+        if (d->macs[i] == mac) {
+            return;
+        }
+    }
+    if (d->n_macs == RID_MAX_MACS) {
+        memmove(d->macs, d->macs + 1, (RID_MAX_MACS - 1) * sizeof(d->macs[0]));
+        d->n_macs--;
+    }
+    d->macs[d->n_macs++] = mac;
+}
+
+static void apply(struct rid_drone *d, const struct rid_msg *msg, uint64_t now_ms) {
+    switch (msg->type) {
+    case RID_BASIC_ID:
+        d->basic_id = msg->basic_id;
+        break;
+    case RID_LOCATION:
+        d->location = msg->location;
+        break;
+    case RID_SELF_ID:
+        d->self_id = msg->self_id;
+        break;
+    case RID_SYSTEM:
+        d->system = msg->system;
+        break;
+    case RID_OPERATOR_ID:
+        d->operator_id = msg->operator_id;
+        break;
+    default:
+        // Authentication pages are only counted
+        break;
+    }
+    d->have |= 1u << msg->type;
+    d->msg_ms[msg->type] = now_ms;
+    d->msgs++;
+}
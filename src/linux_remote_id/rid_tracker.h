@@ -0,0 +1,144 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : rid_tracker.h                                                *
+ *                                                                             *
+ * Description  : Deduplication and per drone state of Remote ID messages.     *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _RID_TRACKER_H
+#define _RID_TRACKER_H
+
+// Drones broadcast the same Remote ID messages on several transports (Wi-Fi
+// beacon and NAN, Bluetooth legacy and extended advertising), often from
+// different MAC addresses, and repeat unchanged messages. The tracker drops
+// repeated messages before decoding them, and keeps one state per drone,
+// merged across its transports.
+//
+// A message is a repeat if the same MAC address sent a message of the same
+// type and content within the dedup window. RemoteIdInd carries the message
+// pack without the message counter of the transport, so content is used
+// instead. Fingerprints are kept in a small hash set that needs no cleanup:
+// old entries are just overwritten.
+//
+// A drone is found by MAC address, or by UAS ID from its Basic ID message.
+// When a Basic ID shows that two MAC addresses belong to the same drone,
+// their states are merged.
+//
+// No allocation and no protobuf dependency. Not thread safe.
+
+#include <stdint.h>
+
+#include "remote_id.h"
+
+// Size of the dedup set, power of 2
+#define RID_DEDUP_SLOTS 1024
+// Slots probed for a fingerprint
+#define RID_DEDUP_PROBE 8
+#define RID_MAX_DRONES 64
+// MAC addresses kept per drone
+#define RID_MAX_MACS 4
+
+struct rid_drone {
+    // Bit (1 << rid_msg_type) for each message type received
+    uint32_t have;
+    // Bit (1 << RidTransportType) for each transport it was received on
+    uint32_t transports;
+    uint64_t macs[RID_MAX_MACS]; // As 48 bit numbers, see rid_mac()
+    uint32_t n_macs;
+    uint64_t first_ms;
+    uint64_t last_ms;
+    uint64_t msg_ms[RID_MSG_TYPES]; // Time of latest message of each type
+    uint64_t msgs;                  // Messages applied, not counting repeats
+    struct rid_basic_id basic_id;   // uas_id is empty until received
+    struct rid_location location;
+    struct rid_self_id self_id;
+    struct rid_system system;
+    struct rid_operator_id operator_id;
+};
+
+struct rid_tracker {
+    uint32_t window_ms;
+    uint32_t timeout_ms;
+    uint64_t dedup_fp[RID_DEDUP_SLOTS];
+    uint64_t dedup_ms[RID_DEDUP_SLOTS];
+    struct rid_drone drones[RID_MAX_DRONES];
+    uint32_t n_drones;
+    // Counters
+    uint64_t payloads;
+    uint64_t messages;
+    uint64_t repeats;
+    uint64_t malformed;
+};
+
+// Messages repeated within `window_ms` are dropped. Drones not heard for
+// `timeout_ms` are forgotten.
+void rid_tracker_init(struct rid_tracker *t, uint32_t window_ms, uint32_t timeout_ms);
+
+// Apply the payload of a RemoteIdInd from `mac` (6 bytes), received on
+// `transport` at `now_ms`. Returns the drone updated, or NULL if all messages
+// were repeats, or the payload malformed. The drone is valid until the next
+// call.
+const struct rid_drone *rid_tracker_update(struct rid_tracker *t, const uint8_t *mac, uint32_t transport,
+                                           const uint8_t *payload, uint32_t size, uint64_t now_ms);
+
+// Drone with UAS ID `uas_id`, or NULL. The empty ID is never found.
+const struct rid_drone *rid_tracker_find(const struct rid_tracker *t, const char *uas_id);
+
+// Forget drones not heard for the timeout. rid_tracker_update() does it when
+// it needs room for a new drone.
+void rid_tracker_expire(struct rid_tracker *t, uint64_t now_ms);
+
+// MAC address as a 48 bit number
+static inline uint64_t rid_mac(const uint8_t *mac) {
+    return (uint64_t)mac[0] << 40 | (uint64_t)mac[1] << 32 | (uint64_t)mac[2] << 24 | (uint64_t)mac[3] << 16 |
+           (uint64_t)mac[4] << 8 | mac[5];
+}
+
+#endif // _RID_TRACKER_H
@@ -0,0 +1,163 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : rid_tracker_test.c                                           *
+ *                                                                             *
+ * Description  : Tests of rid_tracker: repeats, drones merged across MAC      *
+ *              : addresses and lookup by UAS ID                               *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <string.h>
+
+#include "rid_tracker.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define WINDOW_MS 1000
+#define TIMEOUT_MS 30000
+// RidTransportType, see rfs.proto
+#define TRANSPORT_BEACON 1
+#define TRANSPORT_BT_EXT 4
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+static const uint8_t mac_wifi[6] = {0x60, 0x60, 0x1f, 0x01, 0x02, 0x03};
+static const uint8_t mac_bt[6] = {0xc4, 0x2f, 0x90, 0x0a, 0x0b, 0x0c};
+
+// Basic ID: serial number, helicopter or multirotor, "1581F5FKD229R00B1234"
+static const uint8_t basic_id[RID_MSG_SIZE] = {
+    0x02, 0x12, 0x31, 0x35, 0x38, 0x31, 0x46, 0x35, 0x46, 0x4B, 0x44, 0x32, 0x32,
+    0x39, 0x52, 0x30, 0x30, 0x42, 0x31, 0x32, 0x33, 0x34, 0x00, 0x00, 0x00,
+};
+
+// Location: airborne at 55.6761234,12.5683371, see remote_id_test.c
+static const uint8_t location[RID_MSG_SIZE] = {
+    0x12, 0x26, 0x23, 0x15, 0x03, 0x92, 0x80, 0x2F, 0x21, 0xAB, 0xC6, 0x7D, 0x07,
+    0x99, 0x08, 0xAC, 0x08, 0x34, 0x08, 0x4A, 0x32, 0x15, 0x0E, 0x02, 0x00,
+};
+
+// Operator ID "FIN87astrdge12k8"
+static const uint8_t operator_id[RID_MSG_SIZE] = {
+    0x52, 0x00, 0x46, 0x49, 0x4E, 0x38, 0x37, 0x61, 0x73, 0x74, 0x72, 0x64, 0x67,
+    0x65, 0x31, 0x32, 0x6B, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+// Message pack of two messages
+static uint32_t pack2(uint8_t *buf, const uint8_t *a, const uint8_t *b) {
+    buf[0] = RID_PACK << 4 | 2;
+    buf[1] = RID_MSG_SIZE;
+    buf[2] = 2;
+    memcpy(buf + 3, a, RID_MSG_SIZE);
+    memcpy(buf + 3 + RID_MSG_SIZE, b, RID_MSG_SIZE);
+    return 3 + 2 * RID_MSG_SIZE;
+}
+
+int main(void) {
+    int fails = 0;
+    static struct rid_tracker t;
+    uint8_t buf[3 + 2 * RID_MSG_SIZE];
+    const struct rid_drone *d;
+
+    // Repeats within the window are dropped before decoding
+    rid_tracker_init(&t, WINDOW_MS, TIMEOUT_MS);
+    uint32_t size = pack2(buf, basic_id, location);
+    d = rid_tracker_update(&t, mac_wifi, TRANSPORT_BEACON, buf, size, 1000);
+    CHECK("new drone", d && t.n_drones == 1 && d->msgs == 2 &&
+                           d->have == (1u << RID_BASIC_ID | 1u << RID_LOCATION) &&
+                           strcmp(d->basic_id.uas_id, "1581F5FKD229R00B1234") == 0);
+    CHECK("repeat dropped", !rid_tracker_update(&t, mac_wifi, TRANSPORT_BEACON, buf, size, 1500) &&
+                                t.repeats == 2 && t.drones[0].msgs == 2);
+    CHECK("repeat from other MAC applied", rid_tracker_update(&t, mac_bt, TRANSPORT_BT_EXT, buf, size, 1500) &&
+                                               t.n_drones == 1 && t.drones[0].msgs == 4);
+    CHECK("repeat after window applied", rid_tracker_update(&t, mac_wifi, TRANSPORT_BEACON, buf, size, 2001) &&
+                                             t.drones[0].msgs == 6);
+    // Only the changed message of a pack
+    uint8_t moved[RID_MSG_SIZE];
+    memcpy(moved, location, sizeof(moved));
+    moved[5]++;
+    size = pack2(buf, basic_id, moved);
+    d = rid_tracker_update(&t, mac_wifi, TRANSPORT_BEACON, buf, size, 2100);
+    CHECK("changed message of pack applied", d && d->msgs == 7 && t.repeats == 3);
+    CHECK("malformed counted", !rid_tracker_update(&t, mac_wifi, TRANSPORT_BEACON, buf, size - 1, 2200) &&
+                                   t.malformed == 1);
+
+    // A drone first heard without Basic ID on Wi-Fi, and with it on
+    // Bluetooth, is merged when the Basic ID is also seen on Wi-Fi
+    rid_tracker_init(&t, WINDOW_MS, TIMEOUT_MS);
+    d = rid_tracker_update(&t, mac_wifi, TRANSPORT_BEACON, location, sizeof(location), 1000);
+    CHECK("drone without basic ID", d && t.n_drones == 1 && !d->basic_id.uas_id[0]);
+    CHECK("empty UAS ID not found", !rid_tracker_find(&t, ""));
+    size = pack2(buf, basic_id, operator_id);
+    d = rid_tracker_update(&t, mac_bt, TRANSPORT_BT_EXT, buf, size, 1100);
+    CHECK("other MAC is another drone", d && t.n_drones == 2 && rid_tracker_find(&t, "1581F5FKD229R00B1234") == d);
+    d = rid_tracker_update(&t, mac_wifi, TRANSPORT_BEACON, basic_id, sizeof(basic_id), 1200);
+    int good = d && t.n_drones == 1 && rid_tracker_find(&t, "1581F5FKD229R00B1234") == d;
+    good &= d && d->n_macs == 2 && d->transports == (1u << TRANSPORT_BEACON | 1u << TRANSPORT_BT_EXT);
+    good &= d && d->have == (1u << RID_BASIC_ID | 1u << RID_LOCATION | 1u << RID_OPERATOR_ID);
+    good &= d && d->msgs == 4 && d->first_ms == 1000 && d->last_ms == 1200;
+    good &= d && strcmp(d->operator_id.operator_id, "FIN87astrdge12k8") == 0;
+    CHECK("drones merged across MAC addresses and transports", good);
+    d = rid_tracker_update(&t, mac_bt, TRANSPORT_BT_EXT, location, sizeof(location), 1300);
+    CHECK("merged drone found by either MAC", d && t.n_drones == 1 && d->msgs == 5);
+    CHECK("unknown UAS ID not found", !rid_tracker_find(&t, "1581F5FKD229R00B9999"));
+
+    rid_tracker_expire(&t, 1300 + TIMEOUT_MS + 1);
+    CHECK("drone expired", t.n_drones == 0 && !rid_tracker_find(&t, "1581F5FKD229R00B1234"));
+
+    return fails ? 1 : 0;
+}
@@ -55,16 +55,27 @@
 /*******************************************************************************
  *                                Include files
  *******************************************************************************/
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 
 #include "codec.h"
+#include "_generated/mdif_fast.h"
+#include "linux_core_codec/mdif_arena.h"
+#include "linux_core_codec/mdif_buf.h"
+#include "linux_core_codec/mdif_const_msg.h"
+#include "linux_core_codec/mdif_router.h"
+#include "linux_core_codec/mdif_wrapper_router.h"
 
 
 /*******************************************************************************
  *                               Macro definitions
  *******************************************************************************/
+// Messages and bytes of received messages not yet decoded
+#define BUS_SLOTS 1024
+#define BUS_DATA_SIZE (1024 * 1024)
 // See the output *.pb-c.h from input *.proto file.
 
 /*******************************************************************************
@@ -75,10 +86,17 @@
 /*******************************************************************************
  *                             Global variables/const
  *******************************************************************************/
+struct mdif_rpc device_rpc;
+struct mdif_bcast mdif_bus;
 
 /*******************************************************************************
  *                             Local variables/const
  *******************************************************************************/
+// Oneofs of the components, to find messages by name and field number
+static const ProtobufCMessageDescriptor *const msg_descriptors[] = {
+    &mdif__core__core_msg__descriptor,
+    &mdif__rfe__rfe_msg__descriptor,
+};
 
 /*******************************************************************************
  *                           Local Function prototypes
@@ -86,6 +104,8 @@
 static void print_rfe_state(Mdif__Rfe__RfeState *rfe_state);
 static void print_state_info(Mdif__Rfe__StateInfo *state_info);
 static decode_rtn_t decode_rfe(const uint8_t *buf, uint32_t size);
+static void decode_wrapped(const char *receiver, const uint8_t *payload, uint32_t size, void *ctx);
+static void decode_subscriber(const uint8_t *buf, uint32_t size, void *ctx);
 
 /*******************************************************************************
  *                                 Implementation
@@ -106,8 +126,8 @@ static decode_rtn_t decode_rfe(const uint8_t *buf, uint32_t size);
  * @param clear_list Boolean to clear the current frequency band list.
  * @param n_freq_band_list Number of frequency bands in the list.
  * @param freq_band_list List of frequency bands to start.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_pack().
+ *         The caller is responsible for freeing it with mdif_buf_free().
 */
 uint8_t *encode_rfe_start_req(uint32_t *size, bool clear_list, size_t n_freq_band_list, Mdif__Rfe__FreqBand *freq_band_list) {
     // Construct the payload
@@ -121,97 +141,215 @@ uint8_t *encode_rfe_start_req(uint32_t *size, bool clear_list, size_t n_freq_ban
     rfe_msg.msg_case           = MDIF__RFE__RFE_MSG__MSG_START_REQ;
     rfe_msg.start_req = &start_req;
 
-    // Memory allocation sizing
-    *size        = mdif__rfe__rfe_msg__get_packed_size(&rfe_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__rfe__rfe_msg__pack(&rfe_msg, msg);
-    return msg;
+    // Packed into a pool buffer, with headroom for the TCP length prefix
+    return mdif_buf_pack(&rfe_msg.base, size);
 }
 
 /**
  * Encodes a RFE Stop request message.
  *
- * This function constructs a RFE Stop request message and returns the encoded
- * message along with its size.
+ * This function copies the constant encoding of a RFE Stop request message and
+ * returns the encoded message along with its size.
  *
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
 */
 uint8_t *encode_rfe_stop_req(uint32_t *size) {
-    // Construct the payload
-    Mdif__Rfe__StopReq stop_req = MDIF__RFE__STOP_REQ__INIT;
-
-    // Construct the message
-    Mdif__Rfe__RfeMsg rfe_msg  = MDIF__RFE__RFE_MSG__INIT;
-    rfe_msg.msg_case           = MDIF__RFE__RFE_MSG__MSG_STOP_REQ;
-    rfe_msg.stop_req = &stop_req;
-
-    // Memory allocation sizing
-    *size        = mdif__rfe__rfe_msg__get_packed_size(&rfe_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__rfe__rfe_msg__pack(&rfe_msg, msg);
-    return msg;
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__RFE__RFE_MSG__MSG_STOP_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
 }
 
 /**
  * Encodes a RFE Get State Info request message.
  *
- * This function constructs a RFE Get State Info request message and returns the
- * encoded message along with its size.
+ * This function copies the constant encoding of a RFE Get State Info request
+ * message and returns the encoded message along with its size.
  *
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
 */
 uint8_t *encode_rfe_get_state_info_req(uint32_t *size) {
-    // Construct the payload
-    Mdif__Rfe__GetStateInfoReq get_state_info_req = MDIF__RFE__GET_STATE_INFO_REQ__INIT;
-
-    // Construct the message
-    Mdif__Rfe__RfeMsg rfe_msg  = MDIF__RFE__RFE_MSG__INIT;
-    rfe_msg.msg_case           = MDIF__RFE__RFE_MSG__MSG_GET_STATE_INFO_REQ;
-    rfe_msg.get_state_info_req = &get_state_info_req;
-
-    // Memory allocation sizing
-    *size        = mdif__rfe__rfe_msg__get_packed_size(&rfe_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__rfe__rfe_msg__pack(&rfe_msg, msg);
-    return msg;
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__RFE__RFE_MSG__MSG_GET_STATE_INFO_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
 }
 
 /****************************************************
  * Client receives and decodes messages from device *
  ****************************************************/
 
+// Decoder of each component. Messages of other components are not decoded.
+static decode_rtn_t (*const decoders[MDIF_COMPONENT_COUNT])(const uint8_t *, uint32_t) = {
+    [MDIF_COMPONENT_CORE] = decode_core,
+    [MDIF_COMPONENT_RFE]  = decode_rfe,
+};
+
+// Devices on the daisy chain, learned from DeviceAnnounceInd. Only used from
+// the decoding thread, see codec_init().
+static struct mdif_wrapper_router wrapper_router = {.handler = decode_wrapped};
+
+/**
+ * Start decoding the messages published to mdif_bus.
+ *
+ * Messages are decoded by decode_mdif_msg() in a subscriber thread, so the
+ * receiving thread only copies them into the ring. Messages not in `only` are
+ * skipped by the receiving thread, without being copied or unpacked.
+ * Responses are always decoded, as requests wait for them, also when the
+ * subscriber lags and skips other messages. Call before starting a transport.
+ *
+ * @param only Messages to decode, or NULL for all.
+ */
+void codec_init(const struct mdif_field_set *only) {
+    struct mdif_field_set responses = {0};
+    for (size_t i = 0; i < sizeof(msg_descriptors) / sizeof(msg_descriptors[0]); i++) {
+        for (unsigned f = 0; f < msg_descriptors[i]->n_fields; f++) {
+            const char *name = msg_descriptors[i]->fields[f].name;
+            size_t len = strlen(name);
+            if (len > 4 && strcmp(name + len - 4, "_res") == 0) {
+                mdif_field_set_add(&responses, msg_descriptors[i]->fields[f].id);
+            }
+        }
+    }
+    struct mdif_field_set fields;
+    if (only) {
+        fields = *only;
+        for (int i = 0; i < (int)(sizeof(fields.bits) / sizeof(fields.bits[0])); i++) {
+            fields.bits[i] |= responses.bits[i];
+        }
+    }
+    if (mdif_bcast_init(&mdif_bus, BUS_SLOTS, BUS_DATA_SIZE) == -1 ||
+        mdif_bcast_subscribe(&mdif_bus, only ? &fields : NULL, &responses, decode_subscriber, NULL) == -1) {
+        perror("mdif_bcast");
+        exit(1);
+    }
+}
+
+/**
+ * Publish a received message to the subscribers of mdif_bus.
+ *
+ * @param buf Pointer to the binary buffer containing the MDIF Message. Only
+ *            used during the call.
+ * @param size Size of the binary buffer.
+ */
+void recv_mdif_msg(const uint8_t *buf, uint32_t size) {
+    if (mdif_bcast_publish(&mdif_bus, buf, size) == -1) {
+        printf("Message dropped: %s\n", strerror(errno));
+    }
+}
+
+/**
+ * Add messages to a set, by name.
+ *
+ * @param set The set to add to.
+ * @param names Comma separated names of the oneof members of the messages,
+ *              e.g. "remote_id_ind,get_battery_status_res".
+ * @return 0, or -1 with errno EINVAL if a name is unknown, or E2BIG if names
+ *         is too long.
+ */
+int codec_parse_fields(struct mdif_field_set *set, const char *names) {
+    char buf[1024];
+    if (snprintf(buf, sizeof(buf), "%s", names) >= (int)sizeof(buf)) {
+        errno = E2BIG;
+        return -1;
+    }
+    char *save;
+    for (char *name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        const ProtobufCFieldDescriptor *field = NULL;
+        for (size_t i = 0; i < sizeof(msg_descriptors) / sizeof(msg_descriptors[0]) && !field; i++) {
+            field = protobuf_c_message_descriptor_get_field_by_name(msg_descriptors[i], name);
+        }
+        if (!field) {
+            errno = EINVAL;
+            return -1;
+        }
+        mdif_field_set_add(set, field->id);
+    }
+    return 0;
+}
+
+/**
+ * Print the number of messages of each type received and skipped, see
+ * codec_init().
+ */
+void print_msg_counters(void) {
+    for (uint32_t field = 0; field <= MDIF_MAX_FIELD; field++) {
+        uint64_t received, skipped;
+        mdif_bcast_counters(&mdif_bus, field, &received, &skipped);
+        if (!received) {
+            continue;
+        }
+        const ProtobufCFieldDescriptor *desc = NULL;
+        for (size_t i = 0; i < sizeof(msg_descriptors) / sizeof(msg_descriptors[0]) && !desc; i++) {
+            desc = protobuf_c_message_descriptor_get_field(msg_descriptors[i], field);
+        }
+        printf("%-36s %10lu received %10lu skipped\n", desc ? desc->name : "unknown", (unsigned long)received,
+               (unsigned long)skipped);
+    }
+    for (int sub = 0; sub < MDIF_BCAST_MAX_SUBSCRIBERS; sub++) {
+        uint64_t lag, skipped;
+        if (mdif_bcast_sub_counters(&mdif_bus, sub, &lag, &skipped) == 0) {
+            printf("subscriber %d: %lu behind, %lu skipped while lagging\n", sub, (unsigned long)lag,
+                   (unsigned long)skipped);
+        }
+    }
+    printf("%lu dropped\n\n", (unsigned long)mdif_bus.dropped);
+}
+
 /**
+ * Decode a MDIF message of any component.
  *
- * This function tries all decode methods. A fallthrough will results
- * in a decode error.
+ * The component is found from the first field tag by mdif_msg_component(), and
+ * the message is unpacked once, by the decoder of that component.
  *
- * @param buf Pointer to the binary buffer containing the xxxx Message.
+ * Bytes fields of the messages decoded in place, and thus a Wrapper
+ * indication's payload passed back to this function, point into buf and are
+ * valid during the call only.
+ *
+ * @param buf Pointer to the binary buffer containing the MDIF Message.
  * @param size Size of the binary buffer.
  * @return A decode result code indicating the outcome of the decoding process.
  *         Possible return values are DECODE_SUCCESS for successful decoding,
- *         DECODE_ERR_NO_DECODER if the message type is not set, and DECODE_ERR_OTHER
- *         for other decoding errors.
+ *         DECODE_ERR_NO_DECODER if the message type is not set or belongs to
+ *         a component without decoder, and DECODE_ERR_OTHER for other
+ *         decoding errors.
  */
 decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size) {
     if (!buf) {
         return DECODE_ERR_OTHER;
     }
 
-    decode_rtn_t rtn;
-    if ((rtn = decode_rfe(buf, size)) != DECODE_ERR_NO_DECODER) {
-        return rtn;
+    // Responses to requests of the attached device are also passed to their
+    // callbacks. Wrapped messages are from other devices.
+    if (!decode_core_wrapped()) {
+        mdif_rpc_response(&device_rpc, buf, size);
+    }
+
+    // Wrapped messages for devices on the daisy chain are forwarded by
+    // receiver, without unpacking the wrapper.
+    if (mdif_wrapper_route(&wrapper_router, buf, size) == MDIF_WRAPPER_ROUTED) {
+        return DECODE_SUCCESS;
     }
-    if ((rtn = decode_core(buf, size)) != DECODE_ERR_NO_DECODER) {
-        return rtn;
+
+    // Messages with large bytes fields are decoded in place, with the fields
+    // pointing into buf instead of copied. See linux_fast_decode.
+    struct mdif_fast_msg msg;
+    switch (mdif_fast_decode(buf, size, &msg)) {
+    case MDIF__CORE__CORE_MSG__MSG_WRAPPER_MSG_IND:
+        return decode_core_wrapper_msg_ind(&msg.wrapper_msg_ind);
     }
 
-    return DECODE_ERR_NO_DECODER;
+    decode_rtn_t (*decoder)(const uint8_t *, uint32_t) = decoders[mdif_msg_component(buf, size)];
+    if (!decoder) {
+        return DECODE_ERR_NO_DECODER;
+    }
+    return decoder(buf, size);
 }
 
 /**
@@ -229,10 +367,13 @@ decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size) {
  *         for other decoding errors.
  */
 static decode_rtn_t decode_rfe(const uint8_t *buf, uint32_t size) {
-    Mdif__Rfe__RfeMsg *rfe_msg = mdif__rfe__rfe_msg__unpack(NULL, size, buf);
+    // Unpacked into the arena, released below instead of free_unpacked()
+    mdif_arena_mark_t mark = mdif_arena_mark();
+    Mdif__Rfe__RfeMsg *rfe_msg = mdif__rfe__rfe_msg__unpack(mdif_arena(), size, buf);
 
     // Was unpack successful?
     if (rfe_msg == NULL) {
+        mdif_arena_release(mark);
         return DECODE_ERR_NO_DECODER;
     }
 
@@ -280,7 +421,7 @@ static decode_rtn_t decode_rfe(const uint8_t *buf, uint32_t size) {
         rtn = DECODE_ERR_OTHER;
     }
 
-    mdif__rfe__rfe_msg__free_unpacked(rfe_msg, NULL);
+    mdif_arena_release(mark);
 
     printf("\n");
 
@@ -315,4 +456,18 @@ static void print_state_info(Mdif__Rfe__StateInfo *state_info) {
     } else {
         printf("    remote=NULL\n");
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Decode a message forwarded by mdif_wrapper_route() to a device on the daisy
+ * chain. The demo handles all devices alike; a client could instead bind a
+ * handler or socket to each with mdif_wrapper_router_bind().
+ */
+static void decode_wrapped(const char *receiver, const uint8_t *payload, uint32_t size, void *ctx) {
+    printf("Wrapped message for %s, %u bytes\n", receiver, size);
+    decode_core_wrapper_payload(payload, size);
+}
+
+static void decode_subscriber(const uint8_t *buf, uint32_t size, void *ctx) {
+    decode_mdif_msg(buf, size);
+}
@@ -55,6 +55,8 @@
 #include <stdbool.h>
 
 #include "linux_core_codec/core_codec.h"
+#include "linux_core_codec/mdif_bcast.h"
+#include "linux_core_codec/mdif_rpc.h"
 #include "_generated/mdif/rfe/rfe.pb-c.h"
 
 uint8_t *encode_rfe_start_req(uint32_t *size, bool clear_list, size_t n_freq_band_list, Mdif__Rfe__FreqBand *freq_band_list);
@@ -62,3 +64,15 @@ uint8_t *encode_rfe_stop_req(uint32_t *size);
 uint8_t *encode_rfe_get_state_info_req(uint32_t *size);
 
 decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size);
+
+// Received messages are published to mdif_bus by recv_mdif_msg(), called by
+// the transports, and decoded by its subscribers, started by codec_init().
+extern struct mdif_bcast mdif_bus;
+void codec_init(const struct mdif_field_set *only);
+void recv_mdif_msg(const uint8_t *buf, uint32_t size);
+int codec_parse_fields(struct mdif_field_set *set, const char *names);
+void print_msg_counters(void);
+
+// Requests sent with mdif_rpc_call(). Responses are matched by
+// decode_mdif_msg(). Initialized by main().
+extern struct mdif_rpc device_rpc;
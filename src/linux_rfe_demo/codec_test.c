@@ -0,0 +1,103 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : codec_test.c                                                 *
+ *                                                                             *
+ * Description  : Test of constant request encodings against protobuf-c.       *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "codec.h"
+#include "linux_core_codec/mdif_buf.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Compare encoder with protobuf-c packing of an RfeMsg holding an
+// empty Req in oneof member `member`. The Req initializer is given last, as
+// the protobuf-c INIT macros contain commas.
+#define CHECK_RFE(encoder, Req, member, msg_case_val, ...)          \
+    do {                                                            \
+        Req req                  = __VA_ARGS__;                     \
+        Mdif__Rfe__RfeMsg msg    = MDIF__RFE__RFE_MSG__INIT;        \
+        msg.msg_case             = msg_case_val;                    \
+        msg.member               = &req;                            \
+        fails += check(#encoder, encoder, &msg.base);               \
+    } while (0)
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static int check(const char *name, uint8_t *(*encode)(uint32_t *), const ProtobufCMessage *msg) {
+    uint8_t ref[16];
+    size_t ref_len = protobuf_c_message_pack(msg, ref);
+    uint32_t size;
+    uint8_t *buf = encode(&size);
+    int ok = size == ref_len && memcmp(buf, ref, size) == 0;
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    mdif_buf_free(buf);
+    return !ok;
+}
+
+int main(void) {
+    int fails = 0;
+
+    CHECK_RFE(encode_rfe_stop_req, Mdif__Rfe__StopReq, stop_req,
+               MDIF__RFE__RFE_MSG__MSG_STOP_REQ, MDIF__RFE__STOP_REQ__INIT);
+    CHECK_RFE(encode_rfe_get_state_info_req, Mdif__Rfe__GetStateInfoReq, get_state_info_req,
+               MDIF__RFE__RFE_MSG__MSG_GET_STATE_INFO_REQ, MDIF__RFE__GET_STATE_INFO_REQ__INIT);
+
+    return fails ? 1 : 0;
+}
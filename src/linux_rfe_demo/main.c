@@ -52,16 +52,26 @@
  *                                                                             *
  *******************************************************************************/
 #include <argp.h>
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "hdlc/include/hdlc.h"
 #include "hdlc/include/hdlc_os.h"
 #include "hdlc/ports/linux/linux_port.h"
 #include "linux_mdif_socket/mdif_socket.h"
+#include "linux_mdif_shm/mdif_shm_link.h"
 
 #include "codec.h"
+#include "linux_core_codec/mdif_buf.h"
 
 void send_frame(const uint8_t *frame, uint32_t len);
+void queue_frame(const uint8_t *frame, uint32_t len);
+void flush_frames(void);
+
+// Timeouts of the requests sent by call()
+static struct mdif_rpc_wheel rpc_wheel;
+#define RPC_TIMEOUT_MS 2000
 void print_help(void);
 
 //////////////////////////////////////////////////////////////////////////////
@@ -69,17 +79,31 @@ void print_help(void);
 
 static char doc[]                   = "\nDemo of communication with MyDefence device over MDIF TCP or HDLC/serial connection.\n\n"
                                       "  [device]            Address of MDIF device, e.g. \"/dev/ttyUSB0\"\n"
-                                      "                      or \"192.168.1.42\"\n";
+                                      "                      or \"192.168.1.42\", or \"shm:NAME\" for\n"
+                                      "                      mdif_gatewayd shared memory NAME\n";
 static char args_doc[]              = "[device]";
 static struct argp_option options[] = {
     {"verbose", 'v', 0, 0, "Verbose output, e.g. decoding of messages. Repeat for increased verbosity."},
+    {"baud", 'b', "RATE", 0, "Serial baud rate, e.g. 921600 or 3000000. Default 460800."},
+    {"rtscts", 'f', 0, 0, "Enable RTS/CTS hardware flow control on serial device."},
+    {"low-latency", 'l', 0, 0, "Request low latency mode from serial driver."},
+    {"batch", 'B', "BYTES", 0, "Batch serial reads of up to BYTES (max 255) bytes. Partial batches are read when the line is idle for 0.1 s."},
+    {"rt-priority", 'p', "PRIO", 0, "Run HDLC rx and timer threads with SCHED_FIFO priority PRIO (1-99)."},
+    {"rt-cpu", 'c', "CPU", 0, "Pin HDLC rx and timer threads to CPU."},
+    {"mlock", 'm', 0, 0, "Lock all memory to avoid page faults."},
+    {"only", 'o', "MSGS", 0, "Decode only messages MSGS, comma separated oneof member names, e.g. remote_id_ind. Responses are always decoded."},
     {0}};
 
 struct args {
     const char *serial_device; // first positional argument
     int verbose;
+    struct serial_config serial;
+    struct hdlc_linux_rt_config rt;
+    const char *only;
 } args = {
     // Defaults
+    .serial = SERIAL_CONFIG_DEFAULT,
+    .rt = HDLC_LINUX_RT_CONFIG_DEFAULT,
 };
 
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
@@ -103,6 +127,49 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
         args->verbose++;
         break;
 
+    case 'b': {
+        // 0 would hang up the line
+        char *end;
+        errno = 0;
+        unsigned long baud = strtoul(arg, &end, 0);
+        if (errno || end == arg || *end || baud == 0 || baud > UINT32_MAX) {
+            argp_error(state, "invalid baud rate %s", arg);
+        }
+        args->serial.baud = baud;
+        break;
+    }
+
+    case 'f':
+        args->serial.rtscts = true;
+        break;
+
+    case 'l':
+        args->serial.low_latency = true;
+        break;
+
+    case 'B': {
+        unsigned long vmin = strtoul(arg, NULL, 0);
+        args->serial.vmin = vmin > 255 ? 255 : vmin < 1 ? 1 : vmin;
+        args->serial.vtime = 1;
+        break;
+    }
+
+    case 'p':
+        args->rt.rx_priority = args->rt.timer_priority = strtol(arg, NULL, 0);
+        break;
+
+    case 'c':
+        args->rt.rx_cpu = args->rt.timer_cpu = strtol(arg, NULL, 0);
+        break;
+
+    case 'm':
+        args->rt.mlock = true;
+        break;
+
+    case 'o':
+        args->only = arg;
+        break;
+
     default:
         return ARGP_ERR_UNKNOWN;
     }
@@ -119,12 +186,12 @@ void hdlc_frame_sent_cb(hdlc_data_t *_hdlc, const uint8_t *frame, uint32_t len)
     if (args.verbose) {
         printf("hdlc transferred frame %d bytes\n", len);
     }
-    free((uint8_t *)frame);
+    mdif_buf_free(frame);
 }
 
 void hdlc_recv_frame_cb(hdlc_data_t *_hdlc, uint8_t *frame, uint32_t len) {
     if (args.verbose) printf("hdlc recv frame %d bytes\n", len);
-    decode_mdif_msg(frame, len);
+    recv_mdif_msg(frame, len);
 }
 
 void hdlc_reset_cb(hdlc_data_t *_hdlc, hdlc_reset_cause_t cause) {
@@ -147,16 +214,61 @@ void hdlc_connected_cb(hdlc_data_t *hdlc) {
 //////////////////////////////////////////////////////////////////////////////
 // Main program logic
 
+// Sends the requests of device_rpc
+static void rpc_send(uint8_t *buf, uint32_t size, void *ctx) {
+    send_frame(buf, size);
+}
+
+// Called with the response to the request named by ctx, after it is decoded
+static void rpc_done(const uint8_t *res, uint32_t size, int err, void *ctx) {
+    if (err) {
+        printf("%s failed: %s\n\n", (const char *)ctx, strerror(err));
+    } else {
+        printf("%s answered, %u bytes\n\n", (const char *)ctx, size);
+    }
+}
+
+// Send request with device_rpc, so its response is matched to it. Requests of
+// different types are all sent at once, instead of one per round trip.
+static void call(uint8_t *req, uint32_t size, const char *name) {
+    if (mdif_rpc_call(&device_rpc, req, size, RPC_TIMEOUT_MS, rpc_done, (void *)name) == -1) {
+        perror(name);
+        mdif_buf_free(req);
+    }
+}
+
 void send_frame(const uint8_t *frame, uint32_t len) {
     if (mdif_socket != -1) {
-        mdif_socket_send(frame, len);
-        free((uint8_t*)frame);
+        mdif_socket_send_buf((uint8_t *)frame, len);
+        mdif_buf_free(frame);
+    } else if (mdif_shm_link) {
+        mdif_shm_link_send(frame, len);
+        mdif_buf_free(frame);
     } else {
         int ret = hdlc_send_frame(hdlc, frame, len);
         if (ret != 0) {
             printf("ERROR sending frame: %d\n\n", ret);
+            // Not queued, so hdlc_frame_sent_cb() will not return it to the pool
+            mdif_buf_free(frame);
         }
-        // free'd in hdlc_frame_sent_cb()
+        // Otherwise free'd in hdlc_frame_sent_cb()
+    }
+}
+
+// Like send_frame(), but on TCP the frame is not sent until flush_frames() or
+// send_frame(), so several requests go in one segment. HDLC has its own queue.
+void queue_frame(const uint8_t *frame, uint32_t len) {
+    if (mdif_socket != -1) {
+        mdif_socket_queue(frame, len);
+        mdif_buf_free(frame);
+    } else {
+        send_frame(frame, len);
+    }
+}
+
+void flush_frames(void) {
+    if (mdif_socket != -1) {
+        mdif_socket_flush();
     }
 }
 
@@ -172,7 +284,10 @@ void print_help(void) {
     printf(" i - get device info\n");
     printf(" I - get state info\n");
     printf(" b - get battery status\n");
+    printf(" a - get device info and battery status (batched)\n");
+    printf(" A - get device info, battery status and ping (pipelined)\n");
     printf(" r - reset\n");
+    printf(" n - print message counters\n");
     printf("\n");
 }
 
@@ -189,10 +304,26 @@ int main(int argc, char **argv) {
     };
     log_set_level(hdlc_log_level);
 
+    // Before the transport, which may decode responses right away
+    mdif_rpc_wheel_init(&rpc_wheel, 10);
+    if (mdif_rpc_wheel_start(&rpc_wheel) == -1 || mdif_rpc_init(&device_rpc, &rpc_wheel, 4, 16, rpc_send, NULL) == -1) {
+        perror("mdif_rpc");
+        exit(1);
+    }
+    struct mdif_field_set only = {0};
+    if (args.only && codec_parse_fields(&only, args.only) == -1) {
+        fprintf(stderr, errno == E2BIG ? "Too many messages in %s\n" : "Unknown message in %s\n", args.only);
+        exit(1);
+    }
+    codec_init(args.only ? &only : NULL);
+
     if (args.serial_device[0] == '/') {
-        int fd = serial_open(args.serial_device);
+        int fd = serial_open_config(args.serial_device, &args.serial);
+        hdlc_linux_set_rt_config(&args.rt);
         hdlc_linux_init(); // calls hdlc_init()
         start_rx_thread(fd);
+    } else if (strncmp(args.serial_device, "shm:", 4) == 0) {
+        mdif_shm_link_init(args.serial_device + 4);
     } else {
         mdif_socket_init(args.serial_device);
     }
@@ -248,10 +379,29 @@ int main(int argc, char **argv) {
             req = encode_core_get_battery_status_req(&size);
             send_frame(req, size);
             break;
+        case 'a':
+            req = encode_core_get_device_info_req(&size);
+            queue_frame(req, size);
+            req = encode_core_get_battery_status_req(&size);
+            queue_frame(req, size);
+            flush_frames();
+            break;
+        case 'A':
+            req = encode_core_get_device_info_req(&size);
+            call(req, size, "GetDeviceInfo");
+            req = encode_core_get_battery_status_req(&size);
+            call(req, size, "GetBatteryStatus");
+            req = encode_core_ping_req(&size);
+            call(req, size, "Ping");
+            break;
         case 'r':
             req = encode_core_reset_req(&size);
             send_frame(req, size);
             break;
+
+        case 'n':
+            print_msg_counters();
+            break;
         }
     }
 }
@@ -55,14 +55,31 @@
 /*******************************************************************************
  *                                Include files
  *******************************************************************************/
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "codec.h"
+#include "_generated/mdif_fast.h"
+#include "linux_core_codec/mdif_arena.h"
+#include "linux_core_codec/mdif_buf.h"
+#include "linux_core_codec/mdif_const_msg.h"
+#include "linux_core_codec/mdif_router.h"
+#include "linux_core_codec/mdif_wrapper_router.h"
+#include "linux_remote_id/rid_tracker.h"
 
 /*******************************************************************************
  *                               Macro definitions
  *******************************************************************************/
+// Messages and bytes of received messages not yet decoded
+#define BUS_SLOTS 1024
+#define BUS_DATA_SIZE (1024 * 1024)
+// Remote ID messages repeated within the window are not printed
+#define RID_WINDOW_MS 1000
+#define RID_TIMEOUT_MS 30000
 // See the output *.pb-c.h from input *.proto file.
 
 /*******************************************************************************
@@ -73,15 +90,40 @@
 /*******************************************************************************
  *                             Global variables/const
  *******************************************************************************/
+struct mdif_rpc device_rpc;
+struct mdif_bcast mdif_bus;
+struct drone_catalog drone_catalog;
+struct threat_table threats;
+struct threat_queue *threat_subscriber;
+struct gnss_series gnss;
 
 /*******************************************************************************
  *                             Local variables/const
  *******************************************************************************/
+// Remote ID drones, only used by the decoding thread
+static struct rid_tracker rid_tracker;
+
+// Oneofs of the components, to find messages by name and field number
+static const ProtobufCMessageDescriptor *const msg_descriptors[] = {
+    &mdif__core__core_msg__descriptor,
+    &mdif__rfs__rfs_msg__descriptor,
+};
 
 /*******************************************************************************
  *                           Local Function prototypes
  *******************************************************************************/
 static decode_rtn_t decode_rfs(const uint8_t *buf, uint32_t size);
+static void decode_wrapped(const char *receiver, const uint8_t *payload, uint32_t size, void *ctx);
+static void decode_subscriber(const uint8_t *buf, uint32_t size, void *ctx);
+static void apply_threats(const uint8_t *buf, uint32_t size, void *ctx);
+static void apply_gnss(const uint8_t *buf, uint32_t size, void *ctx);
+static decode_rtn_t decode_rfs_remote_id_ind(const struct mdif_fast_remote_id_ind *ind);
+static decode_rtn_t decode_rfs_threat_ind(const struct mdif_fast_rfs_threat_ind *ind);
+static decode_rtn_t decode_rfs_wifi_threat_ind(const struct mdif_fast_wifi_threat_ind *ind);
+static decode_rtn_t decode_rfs_threat_stopped_ind(const struct mdif_fast_threat_stopped_ind *ind);
+static decode_rtn_t decode_core_gnss_compass_stream_ind(const struct mdif_fast_gnss_compass_stream_ind *ind);
+static void print_drone_name(uint32_t type_id);
+static void print_rid_drone(const struct rid_drone *d);
 
 /*******************************************************************************
  *                                 Implementation
@@ -100,8 +142,8 @@ static decode_rtn_t decode_rfs(const uint8_t *buf, uint32_t size);
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
  * @param type_id The type_id of the drone to get information about.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_pack().
+ *         The caller is responsible for freeing it with mdif_buf_free().
 */
 uint8_t *encode_rfs_get_drone_info_req(uint32_t *size, uint32_t type_id) {
     // Construct the payload
@@ -113,97 +155,286 @@ uint8_t *encode_rfs_get_drone_info_req(uint32_t *size, uint32_t type_id) {
     get_drone_info_req.type_id = type_id;
     rfs_msg.get_drone_info_req = &get_drone_info_req;
 
-    // Memory allocation sizing
-    *size        = mdif__rfs__rfs_msg__get_packed_size(&rfs_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__rfs__rfs_msg__pack(&rfs_msg, msg);
-    return msg;
+    // Packed into a pool buffer, with headroom for the TCP length prefix
+    return mdif_buf_pack(&rfs_msg.base, size);
 }
 
 /**
  * Encodes a RFS Start request message.
  *
- * This function constructs a RFS Start request message and returns the encoded
- * message along with its size.
+ * This function copies the constant encoding of a RFS Start request message and
+ * returns the encoded message along with its size.
  *
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
  */
 uint8_t *encode_rfs_start_req(uint32_t *size) {
-    // Construct the payload
-    Mdif__Rfs__StartReq start_req = MDIF__RFS__START_REQ__INIT;
-
-    // Construct the message
-    Mdif__Rfs__RfsMsg rfs_msg = MDIF__RFS__RFS_MSG__INIT;
-    rfs_msg.msg_case          = MDIF__RFS__RFS_MSG__MSG_START_REQ;
-    rfs_msg.start_req         = &start_req;
-
-    // Memory allocation sizing
-    *size        = mdif__rfs__rfs_msg__get_packed_size(&rfs_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__rfs__rfs_msg__pack(&rfs_msg, msg);
-    return msg;
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__RFS__RFS_MSG__MSG_START_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
 }
 
 /**
  * Encodes a RFS Stop request message.
  *
- * This function constructs a RFS Stop request message and returns the encoded
- * message along with its size.
+ * This function copies the constant encoding of a RFS Stop request message and
+ * returns the encoded message along with its size.
  *
  * @param size Pointer to a variable where the size of the encoded message will
  *             be stored.
- * @return A dynamically allocated uint8_t pointer containing the encoded
- *         message. The caller is responsible for freeing the memory when done.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
  */
 uint8_t *encode_rfs_stop_req(uint32_t *size) {
-    // Construct the payload
-    Mdif__Rfs__StopReq stop_req = MDIF__RFS__STOP_REQ__INIT;
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__RFS__RFS_MSG__MSG_STOP_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
 
-    // Construct the message
-    Mdif__Rfs__RfsMsg rfs_msg = MDIF__RFS__RFS_MSG__INIT;
-    rfs_msg.msg_case          = MDIF__RFS__RFS_MSG__MSG_STOP_REQ;
-    rfs_msg.stop_req          = &stop_req;
-
-    // Memory allocation sizing
-    *size        = mdif__rfs__rfs_msg__get_packed_size(&rfs_msg);
-    uint8_t *msg = malloc(*size);
-    mdif__rfs__rfs_msg__pack(&rfs_msg, msg);
-    return msg;
+/**
+ * Encodes a RFS State request message.
+ *
+ * This function copies the constant encoding of a RFS State request message and
+ * returns the encoded message along with its size.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_rfs_state_req(uint32_t *size) {
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__RFS__RFS_MSG__MSG_STATE_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
+}
+
+/**
+ * Encodes a RFS Get Signal Interference request message.
+ *
+ * This function copies the constant encoding of a RFS Get Signal Interference
+ * request message and returns the encoded message along with its size.
+ *
+ * @param size Pointer to a variable where the size of the encoded message will
+ *             be stored.
+ * @return A pointer to the encoded message in a buffer from mdif_buf_copy().
+ *         The caller is responsible for freeing it with mdif_buf_free().
+ */
+uint8_t *encode_rfs_get_signal_interference_req(uint32_t *size) {
+    // Constant encoding, no protobuf-c packing needed
+    MDIF_EMPTY_MSG(msg, MDIF__RFS__RFS_MSG__MSG_SIGNAL_INTERFERENCE_REQ);
+    *size = msg_len;
+    return mdif_buf_copy(msg, msg_len);
 }
 
 /****************************************************
  * Client receives and decodes messages from device *
  ****************************************************/
 
+// Decoder of each component. Messages of other components are not decoded.
+static decode_rtn_t (*const decoders[MDIF_COMPONENT_COUNT])(const uint8_t *, uint32_t) = {
+    [MDIF_COMPONENT_CORE] = decode_core,
+    [MDIF_COMPONENT_RFS]  = decode_rfs,
+};
+
+// Devices on the daisy chain, learned from DeviceAnnounceInd. Only used from
+// the decoding thread, see codec_init().
+static struct mdif_wrapper_router wrapper_router = {.handler = decode_wrapped};
+
+/**
+ * Start decoding the messages published to mdif_bus.
+ *
+ * Messages are decoded by decode_mdif_msg() in a subscriber thread, so the
+ * receiving thread only copies them into the ring. Messages not in `only` are
+ * skipped by the receiving thread, without being copied or unpacked.
+ * Responses are always decoded, as requests wait for them, also when the
+ * subscriber lags and skips other messages. Call before starting a transport.
+ *
+ * @param only Messages to decode, or NULL for all.
+ */
+void codec_init(const struct mdif_field_set *only) {
+    rid_tracker_init(&rid_tracker, RID_WINDOW_MS, RID_TIMEOUT_MS);
+    struct mdif_field_set responses = {0};
+    for (size_t i = 0; i < sizeof(msg_descriptors) / sizeof(msg_descriptors[0]); i++) {
+        for (unsigned f = 0; f < msg_descriptors[i]->n_fields; f++) {
+            const char *name = msg_descriptors[i]->fields[f].name;
+            size_t len = strlen(name);
+            if (len > 4 && strcmp(name + len - 4, "_res") == 0) {
+                mdif_field_set_add(&responses, msg_descriptors[i]->fields[f].id);
+            }
+        }
+    }
+    struct mdif_field_set fields;
+    if (only) {
+        fields = *only;
+        for (int i = 0; i < (int)(sizeof(fields.bits) / sizeof(fields.bits[0])); i++) {
+            fields.bits[i] |= responses.bits[i];
+        }
+    }
+    if (mdif_bcast_init(&mdif_bus, BUS_SLOTS, BUS_DATA_SIZE) == -1 ||
+        mdif_bcast_subscribe(&mdif_bus, only ? &fields : NULL, &responses, decode_subscriber, NULL) == -1) {
+        perror("mdif_bcast");
+        exit(1);
+    }
+    // Threat indications are also applied to the threat table by a subscriber
+    // of their own, in parallel with the decoding
+    struct mdif_field_set threat_fields = {0};
+    mdif_field_set_add(&threat_fields, MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND);
+    mdif_field_set_add(&threat_fields, MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND);
+    mdif_field_set_add(&threat_fields, MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND);
+    mdif_field_set_add(&threat_fields, MDIF__RFS__RFS_MSG__MSG_MUTE_IND);
+    // Threat indications are repeated while a threat is active, stops and
+    // muting are not
+    struct mdif_field_set threat_keep = {0};
+    mdif_field_set_add(&threat_keep, MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND);
+    mdif_field_set_add(&threat_keep, MDIF__RFS__RFS_MSG__MSG_MUTE_IND);
+    if (mdif_bcast_subscribe(&mdif_bus, &threat_fields, &threat_keep, apply_threats, NULL) == -1) {
+        perror("mdif_bcast_subscribe");
+        exit(1);
+    }
+    // And the GNSS and compass stream to its time series
+    struct mdif_field_set gnss_fields = {0};
+    mdif_field_set_add(&gnss_fields, MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_IND);
+    if (mdif_bcast_subscribe(&mdif_bus, &gnss_fields, NULL, apply_gnss, NULL) == -1) {
+        perror("mdif_bcast_subscribe");
+        exit(1);
+    }
+}
+
+/**
+ * Publish a received message to the subscribers of mdif_bus.
+ *
+ * @param buf Pointer to the binary buffer containing the MDIF Message. Only
+ *            used during the call.
+ * @param size Size of the binary buffer.
+ */
+void recv_mdif_msg(const uint8_t *buf, uint32_t size) {
+    if (mdif_bcast_publish(&mdif_bus, buf, size) == -1) {
+        printf("Message dropped: %s\n", strerror(errno));
+    }
+}
+
 /**
+ * Add messages to a set, by name.
  *
- * This function tries all decode methods. A fallthrough will results
- * in a decode error.
+ * @param set The set to add to.
+ * @param names Comma separated names of the oneof members of the messages,
+ *              e.g. "remote_id_ind,get_battery_status_res".
+ * @return 0, or -1 with errno EINVAL if a name is unknown, or E2BIG if names
+ *         is too long.
+ */
+int codec_parse_fields(struct mdif_field_set *set, const char *names) {
+    char buf[1024];
+    if (snprintf(buf, sizeof(buf), "%s", names) >= (int)sizeof(buf)) {
+        errno = E2BIG;
+        return -1;
+    }
+    char *save;
+    for (char *name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        const ProtobufCFieldDescriptor *field = NULL;
+        for (size_t i = 0; i < sizeof(msg_descriptors) / sizeof(msg_descriptors[0]) && !field; i++) {
+            field = protobuf_c_message_descriptor_get_field_by_name(msg_descriptors[i], name);
+        }
+        if (!field) {
+            errno = EINVAL;
+            return -1;
+        }
+        mdif_field_set_add(set, field->id);
+    }
+    return 0;
+}
+
+/**
+ * Print the number of messages of each type received and skipped, see
+ * codec_init().
+ */
+void print_msg_counters(void) {
+    for (uint32_t field = 0; field <= MDIF_MAX_FIELD; field++) {
+        uint64_t received, skipped;
+        mdif_bcast_counters(&mdif_bus, field, &received, &skipped);
+        if (!received) {
+            continue;
+        }
+        const ProtobufCFieldDescriptor *desc = NULL;
+        for (size_t i = 0; i < sizeof(msg_descriptors) / sizeof(msg_descriptors[0]) && !desc; i++) {
+            desc = protobuf_c_message_descriptor_get_field(msg_descriptors[i], field);
+        }
+        printf("%-36s %10lu received %10lu skipped\n", desc ? desc->name : "unknown", (unsigned long)received,
+               (unsigned long)skipped);
+    }
+    for (int sub = 0; sub < MDIF_BCAST_MAX_SUBSCRIBERS; sub++) {
+        uint64_t lag, skipped;
+        if (mdif_bcast_sub_counters(&mdif_bus, sub, &lag, &skipped) == 0) {
+            printf("subscriber %d: %lu behind, %lu skipped while lagging\n", sub, (unsigned long)lag,
+                   (unsigned long)skipped);
+        }
+    }
+    printf("%lu dropped\n\n", (unsigned long)mdif_bus.dropped);
+}
+
+/**
+ * Decode a MDIF message of any component.
  *
- * @param buf Pointer to the binary buffer containing the xxxx Message.
+ * The component is found from the first field tag by mdif_msg_component(), and
+ * the message is unpacked once, by the decoder of that component.
+ *
+ * Bytes fields of the messages decoded in place, and thus a Wrapper
+ * indication's payload passed back to this function, point into buf and are
+ * valid during the call only.
+ *
+ * @param buf Pointer to the binary buffer containing the MDIF Message.
  * @param size Size of the binary buffer.
  * @return A decode result code indicating the outcome of the decoding process.
  *         Possible return values are DECODE_SUCCESS for successful decoding,
- *         DECODE_ERR_NO_DECODER if the message type is not set, and DECODE_ERR_OTHER
- *         for other decoding errors.
+ *         DECODE_ERR_NO_DECODER if the message type is not set or belongs to
+ *         a component without decoder, and DECODE_ERR_OTHER for other
+ *         decoding errors.
  */
 decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size) {
     if (!buf) {
         return DECODE_ERR_OTHER;
     }
 
-    decode_rtn_t rtn;
-    if ((rtn = decode_rfs(buf, size)) != DECODE_ERR_NO_DECODER) {
-        return rtn;
+    // Responses to requests of the attached device are also passed to their
+    // callbacks. Wrapped messages are from other devices.
+    if (!decode_core_wrapped()) {
+        mdif_rpc_response(&device_rpc, buf, size);
     }
-    if ((rtn = decode_core(buf, size)) != DECODE_ERR_NO_DECODER) {
-        return rtn;
+
+    // Wrapped messages for devices on the daisy chain are forwarded by
+    // receiver, without unpacking the wrapper.
+    if (mdif_wrapper_route(&wrapper_router, buf, size) == MDIF_WRAPPER_ROUTED) {
+        return DECODE_SUCCESS;
     }
 
-    return DECODE_ERR_NO_DECODER;
+    // Messages with large bytes fields, and the frequent indications, are
+    // decoded in place, with the fields pointing into buf instead of copied.
+    // See linux_fast_decode.
+    struct mdif_fast_msg msg;
+    switch (mdif_fast_decode(buf, size, &msg)) {
+    case MDIF__CORE__CORE_MSG__MSG_WRAPPER_MSG_IND:
+        return decode_core_wrapper_msg_ind(&msg.wrapper_msg_ind);
+    case MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_IND:
+        return decode_core_gnss_compass_stream_ind(&msg.gnss_compass_stream_ind);
+    case MDIF__RFS__RFS_MSG__MSG_REMOTE_ID_IND:
+        return decode_rfs_remote_id_ind(&msg.remote_id_ind);
+    case MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND:
+        return decode_rfs_threat_ind(&msg.rfs_threat_ind);
+    case MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND:
+        return decode_rfs_wifi_threat_ind(&msg.wifi_threat_ind);
+    case MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND:
+        return decode_rfs_threat_stopped_ind(&msg.threat_stopped_ind);
+    }
+
+    decode_rtn_t (*decoder)(const uint8_t *, uint32_t) = decoders[mdif_msg_component(buf, size)];
+    if (!decoder) {
+        return DECODE_ERR_NO_DECODER;
+    }
+    return decoder(buf, size);
 }
 
 /**
@@ -221,10 +452,13 @@ decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size) {
  *         for other decoding errors.
  */
 static decode_rtn_t decode_rfs(const uint8_t *buf, uint32_t size) {
-    Mdif__Rfs__RfsMsg *rfs_msg = mdif__rfs__rfs_msg__unpack(NULL, size, buf);
+    // Unpacked into the arena, released below instead of free_unpacked()
+    mdif_arena_mark_t mark = mdif_arena_mark();
+    Mdif__Rfs__RfsMsg *rfs_msg = mdif__rfs__rfs_msg__unpack(mdif_arena(), size, buf);
 
     // Was unpack successful?
     if (rfs_msg == NULL) {
+        mdif_arena_release(mark);
         return DECODE_ERR_NO_DECODER;
     }
 
@@ -273,46 +507,60 @@ static decode_rtn_t decode_rfs(const uint8_t *buf, uint32_t size) {
         break;
     }
 
+    // Only when mdif_fast_decode() gave up, e.g. on fields added in newer
+    // firmware
     case MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND: {
-        printf("Decode RFS_THREAT_IND\n");
-
-        // Various scalars and strings picked at random
-        printf("    id=%u\n", rfs_msg->rfs_threat_ind->id);
-        printf("    type_id=%d\n", rfs_msg->rfs_threat_ind->type_id);
-        printf("    power=%f\n", rfs_msg->rfs_threat_ind->power);
-        if (rfs_msg->rfs_threat_ind->relative_bearing->valid) {
-            printf("    relative_bearing:\n");
-            printf("        bearing=%f\n", rfs_msg->rfs_threat_ind->relative_bearing->bearing);
-            printf("        var_bearing=%f\n", rfs_msg->rfs_threat_ind->relative_bearing->var_bearing);
+        const Mdif__Rfs__RfsThreatInd *threat = rfs_msg->rfs_threat_ind;
+        struct mdif_fast_rfs_threat_ind ind = {
+            .id = threat->id,
+            .type_id = threat->type_id,
+            .power = threat->power,
+            .has_relative_bearing = threat->relative_bearing != NULL,
+            .has_last_seen_ts = threat->last_seen_ts != NULL,
+            .muted = threat->muted,
+        };
+        if (threat->relative_bearing) {
+            ind.relative_bearing.valid = threat->relative_bearing->valid;
+            ind.relative_bearing.bearing = threat->relative_bearing->bearing;
+            ind.relative_bearing.var_bearing = threat->relative_bearing->var_bearing;
+        }
+        if (threat->last_seen_ts) {
+            ind.last_seen_ts.seconds = threat->last_seen_ts->seconds;
+            ind.last_seen_ts.nanos = threat->last_seen_ts->nanos;
         }
-        printf("    last_seen=%lu.%u\n", rfs_msg->rfs_threat_ind->last_seen_ts->seconds, rfs_msg->rfs_threat_ind->last_seen_ts->nanos);
-        // Todo: Add repeated current band to response and display
-        // Todo: Keep paired with .proto message response.
+        rtn = decode_rfs_threat_ind(&ind);
         break;
     }
     case MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND: {
-        printf("Decode WIFI_THREAT_IND\n");
-
-        // Various scalars and strings picked at random
-        printf("    id=%u\n", rfs_msg->wifi_threat_ind->id);
-        printf("    type_id=%d\n", rfs_msg->wifi_threat_ind->type_id);
-        printf("    power=%f\n", rfs_msg->wifi_threat_ind->power);
-        printf("    channel=%d\n", rfs_msg->wifi_threat_ind->channel);
-        printf("    max_addr=");
-        for (int i = 0; i < 6; i++) {
-            printf("%02X", rfs_msg->wifi_threat_ind->mac_adr.data[i]);
-            if (i < 5) {
-                printf(":");
-            }
-        }
-        printf("\n");
-        // Todo: Add repeated current band to response and display
-        // Todo: Keep paired with .proto message response.
+        const Mdif__Rfs__WifiThreatInd *wifi = rfs_msg->wifi_threat_ind;
+        struct mdif_fast_wifi_threat_ind ind = {
+            .id = wifi->id,
+            .type_id = wifi->type_id,
+            .power = wifi->power,
+            .channel = wifi->channel,
+            .mac_adr = {wifi->mac_adr.data, wifi->mac_adr.len},
+            .muted = wifi->muted,
+        };
+        rtn = decode_rfs_wifi_threat_ind(&ind);
         break;
     }
     case MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND: {
-        printf("Decode THREAT_STOPPED_IND\n");
-        printf("    id=%u\n", rfs_msg->threat_stopped_ind->id);
+        struct mdif_fast_threat_stopped_ind ind = {.id = rfs_msg->threat_stopped_ind->id};
+        rtn = decode_rfs_threat_stopped_ind(&ind);
+        break;
+    }
+    case MDIF__RFS__RFS_MSG__MSG_REMOTE_ID_IND: {
+        // Only when mdif_fast_decode() gave up, e.g. on fields added in newer
+        // firmware. The bytes fields are then copies in the arena.
+        Mdif__Rfs__RemoteIdInd *remote_id = rfs_msg->remote_id_ind;
+        struct mdif_fast_remote_id_ind ind = {
+            .mac_adr = {remote_id->mac_adr.data, remote_id->mac_adr.len},
+            .payload = {remote_id->payload.data, remote_id->payload.len},
+            .id = remote_id->id,
+            .transport_type = remote_id->transport_type,
+            .muted = remote_id->muted,
+        };
+        rtn = decode_rfs_remote_id_ind(&ind);
         break;
     }
 
@@ -320,9 +568,377 @@ static decode_rtn_t decode_rfs(const uint8_t *buf, uint32_t size) {
         rtn = DECODE_ERR_OTHER;
     }
 
-    mdif__rfs__rfs_msg__free_unpacked(rfs_msg, NULL);
+    mdif_arena_release(mark);
 
     printf("\n");
 
     return rtn;
 }
+
+/**
+ * Decode a RFS Remote ID indication.
+ *
+ * @param ind The indication, decoded in place by mdif_fast_decode(). The MAC
+ *            address and payload point into the receive buffer.
+ * @return DECODE_SUCCESS
+ */
+static decode_rtn_t decode_rfs_remote_id_ind(const struct mdif_fast_remote_id_ind *ind) {
+    printf("Decode REMOTE_ID_IND\n");
+    printf("    id=%u\n", ind->id);
+    printf("    transport_type=%d\n", ind->transport_type);
+    printf("    mac_adr=");
+    for (uint32_t i = 0; i < ind->mac_adr.len; i++) {
+        printf("%02X", ind->mac_adr.data[i]);
+        if (i + 1 < ind->mac_adr.len) {
+            printf(":");
+        }
+    }
+    printf("\n");
+    printf("    muted=%s\n", ind->muted ? "true" : "false");
+
+    uint8_t mac[6] = {0};
+    if (ind->mac_adr.len) {
+        memcpy(mac, ind->mac_adr.data, ind->mac_adr.len < sizeof(mac) ? ind->mac_adr.len : sizeof(mac));
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t malformed = rid_tracker.malformed;
+    const struct rid_drone *d = rid_tracker_update(&rid_tracker, mac, ind->transport_type, ind->payload.data,
+                                                   ind->payload.len, now.tv_sec * 1000ull + now.tv_nsec / 1000000);
+    if (d) {
+        print_rid_drone(d);
+    } else {
+        printf("    payload=%u bytes, %s\n\n", ind->payload.len,
+               rid_tracker.malformed != malformed ? "malformed" : "repeated");
+    }
+    return DECODE_SUCCESS;
+}
+
+/**
+ * Decode a RFS threat indication.
+ *
+ * @param ind The indication, decoded in place by mdif_fast_decode().
+ * @return DECODE_SUCCESS
+ */
+static decode_rtn_t decode_rfs_threat_ind(const struct mdif_fast_rfs_threat_ind *ind) {
+    printf("Decode RFS_THREAT_IND\n");
+
+    // Various scalars and strings picked at random
+    printf("    id=%u\n", ind->id);
+    printf("    type_id=%u\n", ind->type_id);
+    print_drone_name(ind->type_id);
+    printf("    power=%f\n", ind->power);
+    if (ind->has_relative_bearing && ind->relative_bearing.valid) {
+        printf("    relative_bearing:\n");
+        printf("        bearing=%f\n", ind->relative_bearing.bearing);
+        printf("        var_bearing=%f\n", ind->relative_bearing.var_bearing);
+    }
+    if (ind->has_last_seen_ts) {
+        printf("    last_seen=%lld.%09d\n", (long long)ind->last_seen_ts.seconds, ind->last_seen_ts.nanos);
+    }
+    // Todo: Add repeated current band to response and display
+    // Todo: Keep paired with .proto message response.
+    printf("\n");
+    return DECODE_SUCCESS;
+}
+
+/**
+ * Decode a RFS WiFi threat indication.
+ *
+ * @param ind The indication, decoded in place by mdif_fast_decode(). The MAC
+ *            address points into the receive buffer.
+ * @return DECODE_SUCCESS
+ */
+static decode_rtn_t decode_rfs_wifi_threat_ind(const struct mdif_fast_wifi_threat_ind *ind) {
+    printf("Decode WIFI_THREAT_IND\n");
+
+    // Various scalars and strings picked at random
+    printf("    id=%u\n", ind->id);
+    printf("    type_id=%u\n", ind->type_id);
+    print_drone_name(ind->type_id);
+    printf("    power=%f\n", ind->power);
+    printf("    channel=%u\n", ind->channel);
+    printf("    mac_adr=");
+    for (uint32_t i = 0; i < ind->mac_adr.len; i++) {
+        printf("%02X", ind->mac_adr.data[i]);
+        if (i + 1 < ind->mac_adr.len) {
+            printf(":");
+        }
+    }
+    printf("\n");
+    // Todo: Keep paired with .proto message response.
+    printf("\n");
+    return DECODE_SUCCESS;
+}
+
+/**
+ * Decode a RFS threat stopped indication.
+ *
+ * @param ind The indication, decoded in place by mdif_fast_decode().
+ * @return DECODE_SUCCESS
+ */
+static decode_rtn_t decode_rfs_threat_stopped_ind(const struct mdif_fast_threat_stopped_ind *ind) {
+    printf("Decode THREAT_STOPPED_IND\n");
+    printf("    id=%u\n", ind->id);
+    printf("\n");
+    return DECODE_SUCCESS;
+}
+
+/**
+ * Decode a Core GNSS and compass stream indication. decode_core() prints the
+ * few that mdif_fast_decode() gives up on.
+ *
+ * @param ind The indication, decoded in place by mdif_fast_decode().
+ * @return DECODE_SUCCESS
+ */
+static decode_rtn_t decode_core_gnss_compass_stream_ind(const struct mdif_fast_gnss_compass_stream_ind *ind) {
+    const struct mdif_fast_gnss_status *gnss = &ind->gnss_status;
+    const struct mdif_fast_compass_heading *compass = &ind->compass_heading;
+    printf("Decode GNSS_COMPASS_STREAM_IND\n");
+    if (ind->has_gnss_status) {
+        printf("    pos_valid=%d lat=%.7f lon=%.7f hmsl=%.1f hacc=%.1f num_sv=%u\n", gnss->pos_valid, gnss->pos_lat,
+               gnss->pos_lon, gnss->pos_hmsl, gnss->pos_hacc, gnss->num_sv);
+    }
+    if (ind->has_compass_heading) {
+        printf("    compass=%.1f calibrated=%d\n", compass->heading, compass->calibrated);
+    }
+    printf("\n");
+    return DECODE_SUCCESS;
+}
+
+/**
+ * Decode a message forwarded by mdif_wrapper_route() to a device on the daisy
+ * chain. The demo handles all devices alike; a client could instead bind a
+ * handler or socket to each with mdif_wrapper_router_bind().
+ */
+static void decode_wrapped(const char *receiver, const uint8_t *payload, uint32_t size, void *ctx) {
+    printf("Wrapped message for %s, %u bytes\n", receiver, size);
+    decode_core_wrapper_payload(payload, size);
+}
+
+/**
+ * Print the name of a threat type from the drone catalog, if it is known.
+ *
+ * @param type_id The type_id of the threat.
+ */
+static void print_drone_name(uint32_t type_id) {
+    struct drone_cache_info info;
+    if (drone_catalog_find(&drone_catalog, type_id, &info)) {
+        printf("    drone=%s %s (%s)\n", info.vendor_id_name, info.drone_name, info.type_id_name);
+    }
+}
+
+/**
+ * Print the state of a Remote ID drone, merged from all its transports.
+ *
+ * @param d The drone updated by rid_tracker_update().
+ */
+static void print_rid_drone(const struct rid_drone *d) {
+    printf("    uas_id=%s\n", d->basic_id.uas_id[0] ? d->basic_id.uas_id : "(unknown)");
+    printf("    macs=%u transports=0x%x msgs=%llu\n", d->n_macs, d->transports, (unsigned long long)d->msgs);
+    if (d->have & (1u << RID_LOCATION)) {
+        const struct rid_location *l = &d->location;
+        printf("    location=%.7f,%.7f alt_geo=%.1f height=%.1f\n", l->lat, l->lon, l->alt_geo, l->height);
+        printf("    direction=%.0f speed_h=%.2f speed_v=%.1f status=%u\n", l->direction, l->speed_h, l->speed_v,
+               l->status);
+    }
+    if (d->have & (1u << RID_SYSTEM)) {
+        printf("    operator=%.7f,%.7f\n", d->system.operator_lat, d->system.operator_lon);
+    }
+    if (d->have & (1u << RID_OPERATOR_ID)) {
+        printf("    operator_id=%s\n", d->operator_id.operator_id);
+    }
+    if (d->have & (1u << RID_SELF_ID)) {
+        printf("    self_id=%s\n", d->self_id.desc);
+    }
+    printf("\n");
+}
+
+static void decode_subscriber(const uint8_t *buf, uint32_t size, void *ctx) {
+    decode_mdif_msg(buf, size);
+}
+
+// Serializes the writers of the threat table, apply_threats() and
+// expire_threats()
+static pthread_mutex_t threats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000ull + now.tv_nsec / 1000000;
+}
+
+static void apply_threat_msg(const Mdif__Rfs__RfsMsg *rfs_msg) {
+    pthread_mutex_lock(&threats_lock);
+    uint64_t now = now_ms();
+    if (!threat_table_apply(&threats, 0, rfs_msg, now)) {
+        printf("Threat table full\n");
+    }
+    if (threat_subscriber && threat_queue_apply(threat_subscriber, &threats, 0, rfs_msg, now) == -1) {
+        printf("Threat subscriber queue full\n");
+    }
+    pthread_mutex_unlock(&threats_lock);
+}
+
+static void apply_threats(const uint8_t *buf, uint32_t size, void *ctx) {
+    struct mdif_fast_msg fast;
+    uint32_t field = mdif_fast_decode(buf, size, &fast);
+    if (field == 0) {
+        // Only when mdif_fast_decode() gave up, e.g. on fields added in newer
+        // firmware
+        mdif_arena_mark_t mark = mdif_arena_mark();
+        Mdif__Rfs__RfsMsg *rfs_msg = mdif__rfs__rfs_msg__unpack(mdif_arena(), size, buf);
+        if (rfs_msg) {
+            apply_threat_msg(rfs_msg);
+        }
+        mdif_arena_release(mark);
+        return;
+    }
+
+    // The threat table takes protobuf-c messages, so the decoded indication
+    // is passed in one on the stack. Nothing is allocated.
+    Mdif__Rfs__RfsMsg rfs_msg = MDIF__RFS__RFS_MSG__INIT;
+    Mdif__Rfs__RfsThreatInd rfs = MDIF__RFS__RFS_THREAT_IND__INIT;
+    Mdif__Rfs__RfsThreatInd__RelativeBearing bearing = MDIF__RFS__RFS_THREAT_IND__RELATIVE_BEARING__INIT;
+    Mdif__Rfs__ScanBand bands[MDIF_FAST_MAX_REPEATED];
+    Mdif__Rfs__WifiThreatInd wifi = MDIF__RFS__WIFI_THREAT_IND__INIT;
+    Mdif__Rfs__ThreatStoppedInd stopped = MDIF__RFS__THREAT_STOPPED_IND__INIT;
+    Mdif__Rfs__MuteInd mute = MDIF__RFS__MUTE_IND__INIT;
+    Google__Protobuf__Timestamp start_ts = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+    Google__Protobuf__Timestamp last_seen_ts = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+    rfs_msg.msg_case = field;
+    switch (field) {
+    case MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND: {
+        const struct mdif_fast_rfs_threat_ind *ind = &fast.rfs_threat_ind;
+        rfs.id = ind->id;
+        rfs.type_id = ind->type_id;
+        rfs.power = ind->power;
+        for (uint32_t i = 0; i < ind->n_current_band; i++) {
+            bands[i] = ind->current_band[i];
+        }
+        rfs.n_current_band = ind->n_current_band;
+        rfs.current_band = bands;
+        if (ind->has_relative_bearing) {
+            bearing.valid = ind->relative_bearing.valid;
+            bearing.bearing = ind->relative_bearing.bearing;
+            bearing.var_bearing = ind->relative_bearing.var_bearing;
+            rfs.relative_bearing = &bearing;
+        }
+        if (ind->has_start_ts) {
+            start_ts.seconds = ind->start_ts.seconds;
+            start_ts.nanos = ind->start_ts.nanos;
+            rfs.start_ts = &start_ts;
+        }
+        if (ind->has_last_seen_ts) {
+            last_seen_ts.seconds = ind->last_seen_ts.seconds;
+            last_seen_ts.nanos = ind->last_seen_ts.nanos;
+            rfs.last_seen_ts = &last_seen_ts;
+        }
+        rfs.muted = ind->muted;
+        rfs_msg.rfs_threat_ind = &rfs;
+        break;
+    }
+    case MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND: {
+        const struct mdif_fast_wifi_threat_ind *ind = &fast.wifi_threat_ind;
+        wifi.id = ind->id;
+        wifi.type_id = ind->type_id;
+        wifi.power = ind->power;
+        wifi.channel = ind->channel;
+        wifi.mac_adr.data = (uint8_t *)ind->mac_adr.data;
+        wifi.mac_adr.len = ind->mac_adr.len;
+        if (ind->has_start_ts) {
+            start_ts.seconds = ind->start_ts.seconds;
+            start_ts.nanos = ind->start_ts.nanos;
+            wifi.start_ts = &start_ts;
+        }
+        wifi.muted = ind->muted;
+        rfs_msg.wifi_threat_ind = &wifi;
+        break;
+    }
+    case MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND:
+        stopped.id = fast.threat_stopped_ind.id;
+        rfs_msg.threat_stopped_ind = &stopped;
+        break;
+    case MDIF__RFS__RFS_MSG__MSG_MUTE_IND:
+        mute.muted = fast.mute_ind.muted;
+        mute.id = fast.mute_ind.id;
+        mute.type_id = fast.mute_ind.type_id;
+        rfs_msg.mute_ind = &mute;
+        break;
+    default:
+        return;
+    }
+    apply_threat_msg(&rfs_msg);
+}
+
+void expire_threats(void) {
+    pthread_mutex_lock(&threats_lock);
+    threat_table_expire(&threats, now_ms());
+    pthread_mutex_unlock(&threats_lock);
+}
+
+// The only writer of the GNSS series
+static void apply_gnss(const uint8_t *buf, uint32_t size, void *ctx) {
+    struct timespec now;
+    struct gnss_sample x;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t t_us = now.tv_sec * 1000000ll + now.tv_nsec / 1000;
+
+    struct mdif_fast_msg fast;
+    if (mdif_fast_decode(buf, size, &fast) == 0) {
+        // Only when mdif_fast_decode() gave up, e.g. on fields added in newer
+        // firmware
+        mdif_arena_mark_t mark = mdif_arena_mark();
+        Mdif__Core__CoreMsg *core_msg = mdif__core__core_msg__unpack(mdif_arena(), size, buf);
+        if (core_msg && core_msg->msg_case == MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_IND) {
+            gnss_sample_from_ind(&x, core_msg->gnss_compass_stream_ind, t_us);
+            gnss_series_add(&gnss, &x);
+        }
+        mdif_arena_release(mark);
+        return;
+    }
+    if (fast.field != MDIF__CORE__CORE_MSG__MSG_GNSS_COMPASS_STREAM_IND) {
+        return;
+    }
+
+    // As in apply_threats(), passed to the series in protobuf-c structs on
+    // the stack
+    const struct mdif_fast_gnss_compass_stream_ind *ind = &fast.gnss_compass_stream_ind;
+    Mdif__Core__GnssCompassStreamInd stream = MDIF__CORE__GNSS_COMPASS_STREAM_IND__INIT;
+    Mdif__Core__GnssStatus status = MDIF__CORE__GNSS_STATUS__INIT;
+    Mdif__Core__CompassHeading compass = MDIF__CORE__COMPASS_HEADING__INIT;
+    if (ind->has_gnss_status) {
+        const struct mdif_fast_gnss_status *g = &ind->gnss_status;
+        status.pos_valid = g->pos_valid;
+        status.time_valid = g->time_valid;
+        status.pos_hacc = g->pos_hacc;
+        status.pos_hmsl = g->pos_hmsl;
+        status.pos_vacc = g->pos_vacc;
+        status.sol_time = g->sol_time;
+        status.p_acc = g->p_acc;
+        status.ground_speed = g->ground_speed;
+        status.heading_2d = g->heading_2d;
+        status.sacc = g->sacc;
+        status.heading_acc = g->heading_acc;
+        status.num_sv = g->num_sv;
+        status.fix_type = g->fix_type;
+        status.t_acc = g->t_acc;
+        status.systime_drift = g->systime_drift;
+        status.pos_lat = g->pos_lat;
+        status.pos_lon = g->pos_lon;
+        status.ecef_x = g->ecef_x;
+        status.ecef_y = g->ecef_y;
+        status.ecef_z = g->ecef_z;
+        stream.gnss_status = &status;
+    }
+    if (ind->has_compass_heading) {
+        compass.calibrated = ind->compass_heading.calibrated;
+        compass.heading = ind->compass_heading.heading;
+        compass.x = ind->compass_heading.x;
+        compass.y = ind->compass_heading.y;
+        compass.z = ind->compass_heading.z;
+        stream.compass_heading = &compass;
+    }
+    gnss_sample_from_ind(&x, &stream, t_us);
+    gnss_series_add(&gnss, &x);
+}
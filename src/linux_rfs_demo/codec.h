@@ -54,10 +54,49 @@
 #include <stdint.h>
 
 #include "linux_core_codec/core_codec.h"
+#include "linux_core_codec/mdif_bcast.h"
+#include "linux_core_codec/mdif_rpc.h"
+#include "linux_drone_catalog/drone_catalog.h"
+#include "linux_gnss_series/gnss_series.h"
+#include "linux_rfs_threats/threat_queue.h"
+#include "linux_rfs_threats/threat_table.h"
 #include "_generated/mdif/rfs/rfs.pb-c.h"
 
 uint8_t *encode_rfs_get_drone_info_req(uint32_t *size, uint32_t type_id);
 uint8_t *encode_rfs_start_req(uint32_t *size);
 uint8_t *encode_rfs_stop_req(uint32_t *size);
+uint8_t *encode_rfs_state_req(uint32_t *size);
+uint8_t *encode_rfs_get_signal_interference_req(uint32_t *size);
 
 decode_rtn_t decode_mdif_msg(const uint8_t *buf, uint32_t size);
+
+// Received messages are published to mdif_bus by recv_mdif_msg(), called by
+// the transports, and decoded by its subscribers, started by codec_init().
+extern struct mdif_bcast mdif_bus;
+void codec_init(const struct mdif_field_set *only);
+void recv_mdif_msg(const uint8_t *buf, uint32_t size);
+int codec_parse_fields(struct mdif_field_set *set, const char *names);
+void print_msg_counters(void);
+
+// Requests sent with mdif_rpc_call(). Responses are matched by
+// decode_mdif_msg(). Initialized by main().
+extern struct mdif_rpc device_rpc;
+
+// Drone library of the device, used to name threats. Initialized by main().
+extern struct drone_catalog drone_catalog;
+
+// Active threats of the device, updated by a subscriber of mdif_bus.
+// Initialized by main().
+extern struct threat_table threats;
+
+// If set, the threats changed in the threat table are queued to it.
+extern struct threat_queue *threat_subscriber;
+
+// Remove the threats not updated for the timeout of the threat table, e.g.
+// from a timer when no indications arrive.
+void expire_threats(void);
+
+// Position and compass heading of the device from GnssCompassStreamInd, at the
+// receive time in µs on CLOCK_MONOTONIC, as threat updated_ms. Updated by a
+// subscriber of mdif_bus. Initialized by main().
+extern struct gnss_series gnss;
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : codec_test.c                                                 *
+ *                                                                             *
+ * Description  : Test of constant request encodings against protobuf-c.       *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "codec.h"
+#include "linux_core_codec/mdif_buf.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+// Compare encoder with protobuf-c packing of an RfsMsg holding an
+// empty Req in oneof member `member`. The Req initializer is given last, as
+// the protobuf-c INIT macros contain commas.
+#define CHECK_RFS(encoder, Req, member, msg_case_val, ...)          \
+    do {                                                            \
+        Req req                  = __VA_ARGS__;                     \
+        Mdif__Rfs__RfsMsg msg    = MDIF__RFS__RFS_MSG__INIT;        \
+        msg.msg_case             = msg_case_val;                    \
+        msg.member               = &req;                            \
+        fails += check(#encoder, encoder, &msg.base);               \
+    } while (0)
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static int check(const char *name, uint8_t *(*encode)(uint32_t *), const ProtobufCMessage *msg) {
+    uint8_t ref[16];
+    size_t ref_len = protobuf_c_message_pack(msg, ref);
+    uint32_t size;
+    uint8_t *buf = encode(&size);
+    int ok = size == ref_len && memcmp(buf, ref, size) == 0;
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    mdif_buf_free(buf);
+    return !ok;
+}
+
+int main(void) {
+    int fails = 0;
+
+    CHECK_RFS(encode_rfs_start_req, Mdif__Rfs__StartReq, start_req,
+               MDIF__RFS__RFS_MSG__MSG_START_REQ, MDIF__RFS__START_REQ__INIT);
+    CHECK_RFS(encode_rfs_stop_req, Mdif__Rfs__StopReq, stop_req,
+               MDIF__RFS__RFS_MSG__MSG_STOP_REQ, MDIF__RFS__STOP_REQ__INIT);
+    CHECK_RFS(encode_rfs_state_req, Mdif__Rfs__StateReq, state_req,
+               MDIF__RFS__RFS_MSG__MSG_STATE_REQ, MDIF__RFS__STATE_REQ__INIT);
+    CHECK_RFS(encode_rfs_get_signal_interference_req, Mdif__Rfs__GetSignalInterferenceReq, signal_interference_req,
+               MDIF__RFS__RFS_MSG__MSG_SIGNAL_INTERFERENCE_REQ, MDIF__RFS__GET_SIGNAL_INTERFERENCE_REQ__INIT);
+
+    // Names of --only
+    struct mdif_field_set set = {0};
+    CHECK("parse fields", codec_parse_fields(&set, "remote_id_ind,get_battery_status_res") == 0 &&
+                              mdif_field_set_has(&set, MDIF__RFS__RFS_MSG__MSG_REMOTE_ID_IND) &&
+                              mdif_field_set_has(&set, MDIF__CORE__CORE_MSG__MSG_GET_BATTERY_STATUS_RES));
+    errno = 0;
+    CHECK("parse unknown field", codec_parse_fields(&set, "remote_id_ind,no_such_ind") == -1 && errno == EINVAL);
+    char names[2048] = "";
+    while (strlen(names) + sizeof("remote_id_ind,") < sizeof(names)) {
+        strcat(names, "remote_id_ind,");
+    }
+    errno = 0;
+    CHECK("parse too long fields", codec_parse_fields(&set, names) == -1 && errno == E2BIG);
+
+    return fails ? 1 : 0;
+}
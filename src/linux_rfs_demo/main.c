@@ -52,33 +52,78 @@
  *                                                                             *
  *******************************************************************************/
 #include <argp.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "hdlc/include/hdlc.h"
 #include "hdlc/include/hdlc_os.h"
 #include "hdlc/ports/linux/linux_port.h"
 
 #include "codec.h"
+#include "linux_core_codec/mdif_buf.h"
 #include "linux_mdif_socket/mdif_socket.h"
+#include "linux_mdif_shm/mdif_shm_link.h"
 
 void send_frame(const uint8_t *frame, uint32_t len);
+void queue_frame(const uint8_t *frame, uint32_t len);
+void flush_frames(void);
+static void get_device_info(void);
+
+// Timeouts of the requests sent by call()
+static struct mdif_rpc_wheel rpc_wheel;
+#define RPC_TIMEOUT_MS 2000
+
+// Size of the threat table, and time without indications after which a threat
+// is considered stopped
+#define MAX_THREATS 256
+#define THREAT_TIMEOUT_MS 10000
+
+// GNSS and compass stream period, samples kept (an hour at 1 s), and the
+// longest gap between samples a threat position is interpolated over
+#define GNSS_PERIOD_MS 1000
+#define GNSS_SAMPLES 4096
+#define GNSS_MAX_GAP_US (3 * GNSS_PERIOD_MS * 1000ll)
 
 //////////////////////////////////////////////////////////////////////////////
 // Command line parsing (using argp)
 
 static char doc[]                   = "\nDemo of communication with MyDefence device over MDIF TCP or HDLC/serial connection.\n\n"
                                       "  [device]            Address of MDIF device, e.g. \"/dev/ttyUSB0\"\n"
-                                      "                      or \"192.168.1.42\"\n";
+                                      "                      or \"192.168.1.42\", or \"shm:NAME\" for\n"
+                                      "                      mdif_gatewayd shared memory NAME\n";
 static char args_doc[]              = "[device]";
 static struct argp_option options[] = {
     {"verbose", 'v', 0, 0, "Verbose output, e.g. decoding of messages. Repeat for increased verbosity."},
+    {"baud", 'b', "RATE", 0, "Serial baud rate, e.g. 921600 or 3000000. Default 460800."},
+    {"rtscts", 'f', 0, 0, "Enable RTS/CTS hardware flow control on serial device."},
+    {"low-latency", 'l', 0, 0, "Request low latency mode from serial driver."},
+    {"batch", 'B', "BYTES", 0, "Batch serial reads of up to BYTES (max 255) bytes. Partial batches are read when the line is idle for 0.1 s."},
+    {"rt-priority", 'p', "PRIO", 0, "Run HDLC rx and timer threads with SCHED_FIFO priority PRIO (1-99)."},
+    {"rt-cpu", 'c', "CPU", 0, "Pin HDLC rx and timer threads to CPU."},
+    {"mlock", 'm', 0, 0, "Lock all memory to avoid page faults."},
+    {"only", 'o', "MSGS", 0, "Decode only messages MSGS, comma separated oneof member names, e.g. remote_id_ind. Responses are always decoded."},
+    {"cache-dir", 'C', "DIR", 0, "Directory of drone library caches. Default $XDG_CACHE_HOME/mdif or ~/.cache/mdif."},
+    {"subscriber", 'S', "MS", 0, "Print threat updates from a subscriber thread taking MS per update. Updates of a threat waiting for it are replaced by newer ones."},
     {0}};
 
 struct args {
     const char *serial_device; // first positional argument
     int verbose;
+    struct serial_config serial;
+    struct hdlc_linux_rt_config rt;
+    const char *only;
+    const char *cache_dir;
+    int subscriber_ms; // -1 if no subscriber
 } args = {
     // Defaults
+    .serial = SERIAL_CONFIG_DEFAULT,
+    .rt = HDLC_LINUX_RT_CONFIG_DEFAULT,
+    .subscriber_ms = -1,
 };
 
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
@@ -102,6 +147,57 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
         args->verbose++;
         break;
 
+    case 'b': {
+        // 0 would hang up the line
+        char *end;
+        errno = 0;
+        unsigned long baud = strtoul(arg, &end, 0);
+        if (errno || end == arg || *end || baud == 0 || baud > UINT32_MAX) {
+            argp_error(state, "invalid baud rate %s", arg);
+        }
+        args->serial.baud = baud;
+        break;
+    }
+
+    case 'f':
+        args->serial.rtscts = true;
+        break;
+
+    case 'l':
+        args->serial.low_latency = true;
+        break;
+
+    case 'B': {
+        unsigned long vmin = strtoul(arg, NULL, 0);
+        args->serial.vmin = vmin > 255 ? 255 : vmin < 1 ? 1 : vmin;
+        args->serial.vtime = 1;
+        break;
+    }
+
+    case 'p':
+        args->rt.rx_priority = args->rt.timer_priority = strtol(arg, NULL, 0);
+        break;
+
+    case 'c':
+        args->rt.rx_cpu = args->rt.timer_cpu = strtol(arg, NULL, 0);
+        break;
+
+    case 'm':
+        args->rt.mlock = true;
+        break;
+
+    case 'o':
+        args->only = arg;
+        break;
+
+    case 'C':
+        args->cache_dir = arg;
+        break;
+
+    case 'S':
+        args->subscriber_ms = strtol(arg, NULL, 0);
+        break;
+
     default:
         return ARGP_ERR_UNKNOWN;
     }
@@ -118,12 +214,12 @@ void hdlc_frame_sent_cb(hdlc_data_t *_hdlc, const uint8_t *frame, uint32_t len)
     if (args.verbose) {
         printf("hdlc transferred frame %d bytes\n", len);
     }
-    free((uint8_t *)frame);
+    mdif_buf_free(frame);
 }
 
 void hdlc_recv_frame_cb(hdlc_data_t *_hdlc, uint8_t *frame, uint32_t len) {
     if (args.verbose) printf("hdlc recv frame %d bytes\n", len);
-    decode_mdif_msg(frame, len);
+    recv_mdif_msg(frame, len);
 }
 
 void hdlc_reset_cb(hdlc_data_t *_hdlc, hdlc_reset_cause_t cause) {
@@ -133,27 +229,194 @@ void hdlc_reset_cb(hdlc_data_t *_hdlc, hdlc_reset_cause_t cause) {
 void hdlc_connected_cb(hdlc_data_t *hdlc) {
     printf("hdlc connected\n");
 
-    uint32_t size;
-    uint8_t *req = encode_core_get_device_info_req(&size);
-    send_frame(req, size);
+    get_device_info();
 
-    req = encode_rfs_start_req(&size);
+    uint32_t size;
+    uint8_t *req = encode_rfs_start_req(&size);
     send_frame(req, size);
 }
 
 //////////////////////////////////////////////////////////////////////////////
 // Main program logic
 
+// Sends the requests of device_rpc
+static void rpc_send(uint8_t *buf, uint32_t size, void *ctx) {
+    send_frame(buf, size);
+}
+
+// Called with the response to the request named by ctx, after it is decoded
+static void rpc_done(const uint8_t *res, uint32_t size, int err, void *ctx) {
+    if (err) {
+        printf("%s failed: %s\n\n", (const char *)ctx, strerror(err));
+    } else {
+        printf("%s answered, %u bytes\n\n", (const char *)ctx, size);
+    }
+}
+
+// The drone library is cached per firmware version, so it is loaded, or
+// enumerated, once the DeviceInfo is known
+static void device_info_res(const uint8_t *res, uint32_t size, int err, void *ctx) {
+    if (err) {
+        printf("GetDeviceInfo failed: %s\n\n", strerror(err));
+        return;
+    }
+    Mdif__Core__CoreMsg *msg = mdif__core__core_msg__unpack(NULL, size, res);
+    if (msg && msg->msg_case == MDIF__CORE__CORE_MSG__MSG_GET_DEVICE_INFO_RES && msg->get_device_info_res->sw_version) {
+        drone_catalog_start(&drone_catalog, msg->get_device_info_res->sw_version);
+    }
+    mdif__core__core_msg__free_unpacked(msg, NULL);
+}
+
+static void get_device_info(void) {
+    uint32_t size;
+    uint8_t *req = encode_core_get_device_info_req(&size);
+    if (mdif_rpc_call(&device_rpc, req, size, RPC_TIMEOUT_MS, device_info_res, NULL) == -1) {
+        perror("GetDeviceInfo");
+        mdif_buf_free(req);
+    }
+}
+
+// Print the active threats. The table is read while the receiving thread
+// updates it.
+static void print_threats(void) {
+    static struct threat list[MAX_THREATS];
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint32_t n = threat_table_snapshot(&threats, now.tv_sec * 1000ull + now.tv_nsec / 1000000, list, MAX_THREATS);
+    for (uint32_t i = 0; i < n; i++) {
+        struct threat *t = &list[i];
+        struct drone_cache_info info;
+        printf("%6u  %-4s type_id=%-6u power=%6.1f", t->id, t->flags & THREAT_WIFI ? "wifi" : "rf", t->type_id, t->power);
+        if (t->flags & THREAT_BEARING_VALID) {
+            printf(" bearing=%6.1f", t->bearing);
+            // The bearing is relative to the device and counter-clockwise,
+            // the compass heading clockwise from magnetic north
+            struct gnss_sample pos;
+            if (gnss_series_at(&gnss, t->updated_ms * 1000, GNSS_MAX_GAP_US, &pos) == 0 &&
+                (pos.flags & GNSS_HAS_COMPASS)) {
+                printf(" magnetic=%5.1f", fmodf(pos.compass - t->bearing + 720, 360));
+            }
+        }
+        if (t->flags & THREAT_MUTED) {
+            printf(" muted");
+        }
+        if (drone_catalog_find(&drone_catalog, t->type_id, &info)) {
+            printf(" %s %s", info.vendor_id_name, info.drone_name);
+        }
+        printf("\n");
+    }
+    printf("%u active threats\n\n", n);
+}
+
+// Print the latest GNSS sample, and the range of positions of the last minute
+static void print_gnss(void) {
+    struct gnss_sample x;
+    struct gnss_range r;
+    if (!gnss_series_latest(&gnss, &x)) {
+        printf("No GNSS samples, start the stream with g\n\n");
+        return;
+    }
+    printf("pos_valid=%d lat=%.7f lon=%.7f hmsl=%.1f hacc=%.1f num_sv=%u", !!(x.flags & GNSS_POS_VALID), x.lat,
+           x.lon, x.hmsl, x.hacc, x.num_sv);
+    if (x.flags & GNSS_HAS_COMPASS) {
+        printf(" compass=%.1f%s", x.compass, x.flags & GNSS_CALIBRATED ? "" : " (not calibrated)");
+    }
+    printf("\n");
+    gnss_series_range(&gnss, x.t_us - 60000000, x.t_us, &r);
+    printf("Last minute: %u samples, %u with position", r.n, r.n_pos);
+    if (r.n_pos) {
+        printf(", lat %.7f to %.7f, lon %.7f to %.7f, hmsl %.1f to %.1f, max speed %.1f", r.lat_min, r.lat_max,
+               r.lon_min, r.lon_max, r.hmsl_min, r.hmsl_max, r.speed_max);
+    }
+    printf("\n\n");
+}
+
+// Slow consumer of threat updates. The queue keeps only the latest update of
+// each threat, so it never falls further behind than the number of threats.
+static struct threat_queue subscriber_queue;
+
+static void *subscriber_thread(void *arg) {
+    struct threat_event ev;
+    while (1) {
+        threat_queue_pop(&subscriber_queue, &ev, 1, -1);
+        if (ev.type == THREAT_STOPPED) {
+            printf("subscriber: threat %u stopped\n", ev.threat.id);
+        } else {
+            printf("subscriber: threat %u type_id=%u power=%.1f%s (%lu updates skipped)\n", ev.threat.id,
+                   ev.threat.type_id, ev.threat.power, ev.threat.flags & THREAT_MUTED ? " muted" : "",
+                   (unsigned long)__atomic_load_n(&subscriber_queue.conflated, __ATOMIC_RELAXED));
+        }
+        usleep(args.subscriber_ms * 1000);
+    }
+    return NULL;
+}
+
+// Reports the threats that stopped without a ThreatStoppedInd, also when no
+// indications arrive
+static void *expire_thread(void *arg) {
+    while (1) {
+        usleep(THREAT_TIMEOUT_MS / 4 * 1000);
+        expire_threats();
+    }
+    return NULL;
+}
+
+// Print the drone library, from the cache
+static void print_catalog(void) {
+    const struct drone_cache *cache = drone_catalog_cache(&drone_catalog);
+    if (!cache) {
+        printf("Drone catalog not loaded yet\n\n");
+        return;
+    }
+    for (uint32_t i = 0; i < cache->hdr->count; i++) {
+        struct drone_cache_info info;
+        drone_cache_get(cache, &cache->entries[i], &info);
+        printf("%10u  %-12s %-24s %s\n", info.type_id, info.vendor_id_name, info.drone_name, info.type_id_name);
+    }
+    printf("\n");
+}
+
+// Send request with device_rpc, so its response is matched to it. Requests of
+// different types are all sent at once, instead of one per round trip.
+static void call(uint8_t *req, uint32_t size, const char *name) {
+    if (mdif_rpc_call(&device_rpc, req, size, RPC_TIMEOUT_MS, rpc_done, (void *)name) == -1) {
+        perror(name);
+        mdif_buf_free(req);
+    }
+}
+
 void send_frame(const uint8_t *frame, uint32_t len) {
     if (mdif_socket != -1) {
-        mdif_socket_send(frame, len);
-        free((uint8_t*)frame);
+        mdif_socket_send_buf((uint8_t *)frame, len);
+        mdif_buf_free(frame);
+    } else if (mdif_shm_link) {
+        mdif_shm_link_send(frame, len);
+        mdif_buf_free(frame);
     } else {
         int ret = hdlc_send_frame(hdlc, frame, len);
         if (ret != 0) {
             printf("ERROR sending frame: %d\n\n", ret);
+            // Not queued, so hdlc_frame_sent_cb() will not return it to the pool
+            mdif_buf_free(frame);
         }
-        // free'd in hdlc_frame_sent_cb()
+        // Otherwise free'd in hdlc_frame_sent_cb()
+    }
+}
+
+// Like send_frame(), but on TCP the frame is not sent until flush_frames() or
+// send_frame(), so several requests go in one segment. HDLC has its own queue.
+void queue_frame(const uint8_t *frame, uint32_t len) {
+    if (mdif_socket != -1) {
+        mdif_socket_queue(frame, len);
+        mdif_buf_free(frame);
+    } else {
+        send_frame(frame, len);
+    }
+}
+
+void flush_frames(void) {
+    if (mdif_socket != -1) {
+        mdif_socket_flush();
     }
 }
 
@@ -170,13 +433,57 @@ int main(int argc, char **argv) {
     };
     log_set_level(hdlc_log_level);
 
+    // Before the transport, which may decode responses right away
+    mdif_rpc_wheel_init(&rpc_wheel, 10);
+    if (mdif_rpc_wheel_start(&rpc_wheel) == -1 || mdif_rpc_init(&device_rpc, &rpc_wheel, 4, 16, rpc_send, NULL) == -1) {
+        perror("mdif_rpc");
+        exit(1);
+    }
+    struct mdif_field_set only = {0};
+    if (args.only && codec_parse_fields(&only, args.only) == -1) {
+        fprintf(stderr, errno == E2BIG ? "Too many messages in %s\n" : "Unknown message in %s\n", args.only);
+        exit(1);
+    }
+    codec_init(args.only ? &only : NULL);
+    drone_catalog_init(&drone_catalog, &device_rpc, args.cache_dir);
+    if (threat_table_init(&threats, MAX_THREATS, THREAT_TIMEOUT_MS) == -1) {
+        perror("threat_table_init");
+        exit(1);
+    }
+    if (gnss_series_init(&gnss, GNSS_SAMPLES, GNSS_DOWNSAMPLE_NONE, 0, 0) == -1) {
+        perror("gnss_series_init");
+        exit(1);
+    }
+    if (args.subscriber_ms >= 0) {
+        pthread_t thread;
+        if (threat_queue_init(&subscriber_queue, 2 * MAX_THREATS) == -1 ||
+            pthread_create(&thread, NULL, subscriber_thread, NULL) != 0) {
+            perror("subscriber");
+            exit(1);
+        }
+        threat_table_on_removed(&threats, threat_queue_removed, &subscriber_queue);
+        threat_subscriber = &subscriber_queue;
+    }
+    pthread_t expire;
+    if (pthread_create(&expire, NULL, expire_thread, NULL) != 0) {
+        perror("expire");
+        exit(1);
+    }
+
     if (args.serial_device[0] == '/') {
-        int fd = serial_open(args.serial_device);
+        int fd = serial_open_config(args.serial_device, &args.serial);
+        hdlc_linux_set_rt_config(&args.rt);
         hdlc_linux_init(); // calls hdlc_init()
         start_rx_thread(fd);
+    } else if (strncmp(args.serial_device, "shm:", 4) == 0) {
+        mdif_shm_link_init(args.serial_device + 4);
     } else {
         mdif_socket_init(args.serial_device);
     }
+    if (args.serial_device[0] != '/') {
+        // With HDLC it is done by hdlc_connected_cb()
+        get_device_info();
+    }
 
     uint32_t size;
     uint8_t *req;
@@ -191,7 +498,13 @@ int main(int argc, char **argv) {
             printf(" S - stop\n");
             printf(" i - get info\n");
             printf(" b - get battery status\n");
+            printf(" a - get info and battery status (batched)\n");
+            printf(" A - get info, battery status and ping (pipelined)\n");
             printf(" r - reset\n");
+            printf(" n - print message counters\n");
+            printf(" g - start GNSS and compass stream\n");
+            printf(" G - stop GNSS and compass stream\n");
+            printf(" P - print position\n");
             printf("------------Drone info cmd.\n");
             printf("The following examples allows the user to see\n");
             printf("how the drone info is accessed from, start,\n");
@@ -200,6 +513,8 @@ int main(int argc, char **argv) {
             printf(" D - get drone info with type_id=-1 - the last in list\n");
             printf(" m - get drone info with type_id=1000404 - somewhere within in list\n");
             printf(" M - get drone info with corrupted type_id\n");
+            printf(" L - list drone catalog\n");
+            printf(" T - list active threats\n");
             printf("------------\n");
             printf("\n");
             break;
@@ -241,6 +556,14 @@ int main(int argc, char **argv) {
             send_frame(req, size);
             break;
 
+        case 'L':
+            print_catalog();
+            break;
+
+        case 'T':
+            print_threats();
+            break;
+
         case 'i':
             req = encode_core_get_device_info_req(&size);
             send_frame(req, size);
@@ -250,10 +573,43 @@ int main(int argc, char **argv) {
             req = encode_core_get_battery_status_req(&size);
             send_frame(req, size);
             break;
+        case 'a':
+            req = encode_core_get_device_info_req(&size);
+            queue_frame(req, size);
+            req = encode_core_get_battery_status_req(&size);
+            queue_frame(req, size);
+            flush_frames();
+            break;
+        case 'A':
+            req = encode_core_get_device_info_req(&size);
+            call(req, size, "GetDeviceInfo");
+            req = encode_core_get_battery_status_req(&size);
+            call(req, size, "GetBatteryStatus");
+            req = encode_core_ping_req(&size);
+            call(req, size, "Ping");
+            break;
         case 'r':
             req = encode_core_reset_req(&size);
             send_frame(req, size);
             break;
+
+        case 'n':
+            print_msg_counters();
+            break;
+
+        case 'g':
+            req = encode_core_gnss_compass_stream_req(&size, true, GNSS_PERIOD_MS);
+            send_frame(req, size);
+            break;
+
+        case 'G':
+            req = encode_core_gnss_compass_stream_req(&size, false, GNSS_PERIOD_MS);
+            send_frame(req, size);
+            break;
+
+        case 'P':
+            print_gnss();
+            break;
         }
         ch = getchar();
     }
@@ -0,0 +1,271 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : threat_queue.c                                               *
+ *                                                                             *
+ * Description  : Queue of threat updates that keeps only the latest state of  *
+ *              : each threat.                                                 *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "threat_queue.h"
+
+/*******************************************************************************
+ *                      Enumerations/Type definitions/Structs
+ *******************************************************************************/
+struct threat_queue_slot {
+    struct threat_event ev;
+    bool indexed;  // A waiting update, in a bucket
+    uint32_t next; // Next slot of the bucket, index + 1
+};
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static int push(struct threat_queue *q, enum threat_event_type type, const struct threat *threat);
+static uint32_t *bucket(struct threat_queue *q, uint32_t device, uint32_t id);
+static struct threat_queue_slot *find(struct threat_queue *q, uint32_t device, uint32_t id);
+static void unlink_slot(struct threat_queue *q, struct threat_queue_slot *s);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+int threat_queue_init(struct threat_queue *q, uint32_t size) {
+    memset(q, 0, sizeof(*q));
+    if (size == 0 || size > (1u << 30)) {
+        errno = EINVAL;
+        return -1;
+    }
+    uint32_t slots = 1;
+    while (slots < size) {
+        slots *= 2;
+    }
+    q->mask = slots - 1;
+    q->reserve = slots >= 4 ? slots / 4 : slots / 2;
+    q->buckets = calloc(slots, sizeof(*q->buckets));
+    q->slots = calloc(slots, sizeof(*q->slots));
+    if (!q->buckets || !q->slots) {
+        threat_queue_free(q);
+        errno = ENOMEM;
+        return -1;
+    }
+    // Timed waits on CLOCK_MONOTONIC
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&q->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&q->lock, NULL);
+    return 0;
+}
+
+void threat_queue_free(struct threat_queue *q) {
+    if (q->slots) {
+        pthread_cond_destroy(&q->cond);
+        pthread_mutex_destroy(&q->lock);
+    }
+    free(q->buckets);
+    free(q->slots);
+    memset(q, 0, sizeof(*q));
+}
+
+int threat_queue_update(struct threat_queue *q, const struct threat *threat) {
+    pthread_mutex_lock(&q->lock);
+    struct threat_queue_slot *s = find(q, threat->device, threat->id);
+    if (s) {
+        s->ev.threat = *threat;
+        q->conflated++;
+        pthread_mutex_unlock(&q->lock);
+        return 0;
+    }
+    int rtn = push(q, THREAT_UPDATE, threat);
+    pthread_mutex_unlock(&q->lock);
+    return rtn;
+}
+
+int threat_queue_stopped(struct threat_queue *q, uint32_t device, uint32_t id) {
+    pthread_mutex_lock(&q->lock);
+    // A waiting update stays before the stop, but later updates of a reused
+    // id go after it
+    struct threat_queue_slot *s = find(q, device, id);
+    if (s) {
+        unlink_slot(q, s);
+        if (q->tail - q->head > q->mask) {
+            // No room for the stop, so it takes the place of the update
+            s->ev.type = THREAT_STOPPED;
+            q->conflated++;
+            pthread_mutex_unlock(&q->lock);
+            return 0;
+        }
+    }
+    struct threat threat = {.device = device, .id = id};
+    int rtn = push(q, THREAT_STOPPED, &threat);
+    pthread_mutex_unlock(&q->lock);
+    return rtn;
+}
+
+void threat_queue_removed(uint32_t device, uint32_t id, void *ctx) {
+    threat_queue_stopped(ctx, device, id);
+}
+
+int threat_queue_apply(struct threat_queue *q, const struct threat_table *table, uint32_t device,
+                       const Mdif__Rfs__RfsMsg *msg, uint64_t now_ms) {
+    uint32_t id;
+    switch (msg->msg_case) {
+    case MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND:
+        id = msg->rfs_threat_ind->id;
+        break;
+    case MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND:
+        id = msg->wifi_threat_ind->id;
+        break;
+    case MDIF__RFS__RFS_MSG__MSG_MUTE_IND:
+        id = msg->mute_ind->id;
+        break;
+    default:
+        return 0;
+    }
+    struct threat threat;
+    if (!threat_table_get(table, device, id, now_ms, &threat)) {
+        // Not added, or muted by type
+        return 0;
+    }
+    return threat_queue_update(q, &threat);
+}
+
+uint32_t threat_queue_pop(struct threat_queue *q, struct threat_event *events, uint32_t max, int timeout_ms) {
+    struct timespec deadline;
+    if (timeout_ms > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&q->lock);
+    while (q->head == q->tail && timeout_ms != 0) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&q->cond, &q->lock);
+        } else if (pthread_cond_timedwait(&q->cond, &q->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t n = 0;
+    while (n < max && q->head != q->tail) {
+        struct threat_queue_slot *s = &q->slots[q->head++ & q->mask];
+        if (s->indexed) {
+            unlink_slot(q, s);
+        }
+        events[n++] = s->ev;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+// Append an event. Updates leave the reserve free for stops. Must be called
+// with the lock held.
+static int push(struct threat_queue *q, enum threat_event_type type, const struct threat *threat) {
+    uint32_t limit = type == THREAT_UPDATE ? q->mask - q->reserve : q->mask;
+    if (q->tail - q->head > limit) {
+        q->dropped++;
+        errno = ENOBUFS;
+        return -1;
+    }
+    uint32_t i = q->tail++ & q->mask;
+    struct threat_queue_slot *s = &q->slots[i];
+    s->ev.type = type;
+    s->ev.threat = *threat;
+    s->indexed = type == THREAT_UPDATE;
+    if (s->indexed) {
+        uint32_t *b = bucket(q, threat->device, threat->id);
+        s->next = *b;
+        *b = i + 1;
+    }
+    if (q->tail - q->head == 1) {
+        pthread_cond_signal(&q->cond);
+    }
+    return 0;
+}
+
+// Fibonacci hashing of device and id
+static uint32_t *bucket(struct threat_queue *q, uint32_t device, uint32_t id) {
+    uint64_t key = (uint64_t)device << 32 | id;
+    return &q->buckets[(uint32_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & q->mask];
+}
+
+// Waiting update of a threat, or NULL
+static struct threat_queue_slot *find(struct threat_queue *q, uint32_t device, uint32_t id) {
+    for (uint32_t i = *bucket(q, device, id); i; i = q->slots[i - 1].next) {
+        struct threat_queue_slot *s = &q->slots[i - 1];
+        if (s->ev.threat.id == id && s->ev.threat.device == device) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+// Remove a waiting update from its bucket
+static void unlink_slot(struct threat_queue *q, struct threat_queue_slot *s) {
+    uint32_t *p = bucket(q, s->ev.threat.device, s->ev.threat.id);
+    uint32_t i = (uint32_t)(s - q->slots) + 1;
+    while (*p != i) {
+        p = &q->slots[*p - 1].next;
+    }
+    *p = s->next;
+    s->indexed = false;
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : threat_queue.h                                               *
+ *                                                                             *
+ * Description  : Queue of threat updates that keeps only the latest state of  *
+ *              : each threat.                                                 *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _THREAT_QUEUE_H
+#define _THREAT_QUEUE_H
+
+// Delivers threat updates from the receiving thread to a consumer that may be
+// slower than the indications. While an update of a threat is waiting in the
+// queue, a newer one replaces it in place, keeping its position, so the
+// consumer only sees the latest state, and the queue never holds more than one
+// update per threat. Stops are never replaced, and the update before a stop
+// is kept, so the consumer sees the final state of each threat.
+//
+// A quarter of the slots is reserved for stops, so a queue filled with updates
+// still takes them. If the queue is full anyway, a stop takes the place of the
+// waiting update of its threat. Only a stop of a threat without a waiting
+// update can be lost, when more stops wait than the reserve holds.
+//
+// With threat_table_on_removed(table, threat_queue_removed, q), every threat
+// removed from the table is reported stopped, also when it expires.
+//
+// One producer and one consumer. The producer never blocks.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "threat_table.h"
+
+enum threat_event_type {
+    THREAT_UPDATE,
+    // Only device and id of threat are set, unless the stop took the place of
+    // a waiting update. Then threat has the final state, and updated_ms is not
+    // 0.
+    THREAT_STOPPED,
+};
+
+struct threat_event {
+    enum threat_event_type type;
+    struct threat threat;
+};
+
+struct threat_queue_slot;
+
+struct threat_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t mask; // Number of slots - 1
+    uint32_t reserve; // Slots only used by stops
+    uint32_t head; // Next to pop
+    uint32_t tail; // Next to push
+    // Slots of the updates waiting, by hash of device and id. Index + 1, 0
+    // if none.
+    uint32_t *buckets;
+    struct threat_queue_slot *slots;
+    uint64_t conflated; // Updates replaced by a newer one or a stop
+    uint64_t dropped;   // Events not queued because the queue was full
+};
+
+// Allocate a queue of `size` events. Updates take one slot per threat, so it
+// should be somewhat larger than the threat_table. Returns -1 with errno set
+// on failure.
+int threat_queue_init(struct threat_queue *q, uint32_t size);
+
+// Free the queue. Neither producer nor consumer may be using it.
+void threat_queue_free(struct threat_queue *q);
+
+// Queue the state of a threat, replacing its update if one is waiting.
+// Returns -1 with errno ENOBUFS if the slots not reserved for stops are full.
+int threat_queue_update(struct threat_queue *q, const struct threat *threat);
+
+// Queue the stop of threat (`device`, `id`). Returns -1 with errno ENOBUFS if
+// the queue is full and no update of the threat is waiting.
+int threat_queue_stopped(struct threat_queue *q, uint32_t device, uint32_t id);
+
+// threat_removed_cb_t queuing the stop of a threat to `ctx`, a threat_queue.
+// A stop that is lost is counted in `dropped`.
+void threat_queue_removed(uint32_t device, uint32_t id, void *ctx);
+
+// Queue the threat changed by `msg`, an indication of `device` already
+// applied to `table` at `now_ms`. Other messages are ignored. Muting by type
+// is not queued. Stops are queued by threat_queue_removed(), registered with
+// threat_table_on_removed(). Returns -1 with errno ENOBUFS if the queue is
+// full.
+int threat_queue_apply(struct threat_queue *q, const struct threat_table *table, uint32_t device,
+                       const Mdif__Rfs__RfsMsg *msg, uint64_t now_ms);
+
+// Pop up to `max` events into `events`, waiting up to `timeout_ms` for the
+// first one, or forever if negative. Returns the number popped, 0 on
+// timeout.
+uint32_t threat_queue_pop(struct threat_queue *q, struct threat_event *events, uint32_t max, int timeout_ms);
+
+#endif // _THREAT_QUEUE_H
@@ -0,0 +1,153 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : threat_queue_test.c                                          *
+ *                                                                             *
+ * Description  : Test of the threat queue: stops are kept when the queue is   *
+ *              : full, and threats removed from the table are queued as       *
+ *              : stops.                                                       *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+
+#include "threat_queue.h"
+#include "threat_table.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define TIMEOUT_MS 1000
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static int update(struct threat_queue *q, uint32_t id) {
+    struct threat t = {.device = 1, .id = id, .power = id, .updated_ms = 1000 + id};
+    return threat_queue_update(q, &t);
+}
+
+int main(void) {
+    int fails = 0;
+    struct threat_queue q;
+    struct threat_event ev[16];
+
+    // 8 slots, 2 of them for stops
+    threat_queue_init(&q, 8);
+    int rtn = 0;
+    for (uint32_t id = 1; id <= 6; id++) {
+        rtn |= update(&q, id);
+    }
+    CHECK("updates fill the slots not reserved", rtn == 0);
+    CHECK("update refused in the reserve", update(&q, 7) == -1 && errno == ENOBUFS);
+    CHECK("update replaced when full", update(&q, 3) == 0 && q.conflated == 1);
+    CHECK("stops use the reserve",
+          threat_queue_stopped(&q, 1, 10) == 0 && threat_queue_stopped(&q, 1, 11) == 0);
+    CHECK("stop takes the place of its update", threat_queue_stopped(&q, 1, 2) == 0);
+    CHECK("stop without update refused when full", threat_queue_stopped(&q, 1, 12) == -1 && errno == ENOBUFS);
+    CHECK("dropped counted", q.dropped == 2);
+    uint32_t n = threat_queue_pop(&q, ev, 16, 0);
+    CHECK("all queued popped", n == 8);
+    CHECK("coalesced stop in place of the update",
+          ev[1].type == THREAT_STOPPED && ev[1].threat.id == 2 && ev[1].threat.power == 2 && ev[1].threat.updated_ms);
+    CHECK("other updates kept", ev[0].type == THREAT_UPDATE && ev[2].type == THREAT_UPDATE && ev[2].threat.id == 3);
+    CHECK("stops after the updates", ev[6].type == THREAT_STOPPED && ev[6].threat.id == 10 &&
+                                         !ev[6].threat.updated_ms && ev[7].threat.id == 11);
+    CHECK("update of a stopped threat queued again", update(&q, 2) == 0 && threat_queue_pop(&q, ev, 16, 0) == 1 &&
+                                                         ev[0].type == THREAT_UPDATE);
+    threat_queue_free(&q);
+
+    // Removals from the table are queued as stops
+    struct threat_table table;
+    threat_table_init(&table, 16, TIMEOUT_MS);
+    threat_queue_init(&q, 16);
+    threat_table_on_removed(&table, threat_queue_removed, &q);
+    Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+    Mdif__Rfs__WifiThreatInd wifi = MDIF__RFS__WIFI_THREAT_IND__INIT;
+    Mdif__Rfs__ThreatStoppedInd stopped = MDIF__RFS__THREAT_STOPPED_IND__INIT;
+    msg.msg_case = MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND;
+    msg.wifi_threat_ind = &wifi;
+    uint64_t now = 1000000;
+    for (wifi.id = 1; wifi.id <= 3; wifi.id++) {
+        threat_table_apply(&table, 0, &msg, now);
+        threat_queue_apply(&q, &table, 0, &msg, now);
+    }
+    CHECK("table: updates queued", threat_queue_pop(&q, ev, 16, 0) == 3);
+
+    msg.msg_case = MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND;
+    msg.threat_stopped_ind = &stopped;
+    stopped.id = 2;
+    threat_table_apply(&table, 0, &msg, now);
+    threat_queue_apply(&q, &table, 0, &msg, now);
+    n = threat_queue_pop(&q, ev, 16, 0);
+    CHECK("table: ThreatStoppedInd queued once", n == 1 && ev[0].type == THREAT_STOPPED && ev[0].threat.id == 2);
+
+    threat_table_expire(&table, now + TIMEOUT_MS + 1);
+    n = threat_queue_pop(&q, ev, 16, 0);
+    CHECK("table: expired threats queued as stops",
+          n == 2 && ev[0].type == THREAT_STOPPED && ev[1].type == THREAT_STOPPED && ev[0].threat.id + ev[1].threat.id == 4);
+
+    wifi.id = 5;
+    msg.msg_case = MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND;
+    msg.wifi_threat_ind = &wifi;
+    threat_table_apply(&table, 0, &msg, now);
+    threat_queue_apply(&q, &table, 0, &msg, now);
+    threat_table_remove_device(&table, 0);
+    n = threat_queue_pop(&q, ev, 16, 0);
+    CHECK("table: removed device queued as stops",
+          n == 2 && ev[0].type == THREAT_UPDATE && ev[1].type == THREAT_STOPPED && ev[1].threat.id == 5);
+
+    threat_queue_free(&q);
+    threat_table_free(&table);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,433 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : threat_table.c                                               *
+ *                                                                             *
+ * Description  : Table of the active threats of RF sensors, with lock-free    *
+ *              : snapshots.                                                   *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threat_table.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define KEY(device, id) ((uint64_t)(device) << 32 | (id))
+#define KEY_DEVICE(key) ((uint32_t)((key) >> 32))
+#define KEY_ID(key) ((uint32_t)(key))
+// Threat in slot i not updated for the timeout at now_ms. Readers may have
+// taken now_ms before the writer, so updated_ms may be later.
+#define EXPIRED(t, i, now_ms) ((now_ms) > (t)->updated_ms[i] + (t)->timeout_ms)
+
+/*******************************************************************************
+ *                           Local Function prototypes
+ *******************************************************************************/
+static void rfs_threat(struct threat_table *t, uint32_t device, const Mdif__Rfs__RfsThreatInd *ind, uint64_t now_ms, bool *full);
+static void wifi_threat(struct threat_table *t, uint32_t device, const Mdif__Rfs__WifiThreatInd *ind, uint64_t now_ms, bool *full);
+static void mute(struct threat_table *t, uint32_t device, const Mdif__Rfs__MuteInd *ind);
+static void write_begin(struct threat_table *t);
+static void write_end(struct threat_table *t);
+static uint32_t home_slot(const struct threat_table *t, uint64_t key);
+static int find(const struct threat_table *t, uint64_t key);
+static int insert(struct threat_table *t, uint64_t key);
+static void remove_slot(struct threat_table *t, uint32_t i);
+static void removed(struct threat_table *t, uint32_t i);
+static void copy_slot(const struct threat_table *t, uint32_t i, struct threat *out);
+static int64_t ts_ms(const Google__Protobuf__Timestamp *ts);
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+int threat_table_init(struct threat_table *t, uint32_t max_threats, uint32_t timeout_ms) {
+    memset(t, 0, sizeof(*t));
+    if (max_threats == 0 || max_threats > (1u << 30)) {
+        errno = EINVAL;
+        return -1;
+    }
+    // At most half of the slots are used, to keep probe sequences short
+    uint32_t slots = 2;
+    while (slots < 2 * max_threats) {
+        slots *= 2;
+    }
+    t->mask = slots - 1;
+    t->max_count = max_threats;
+    t->timeout_ms = timeout_ms;
+    t->key = calloc(slots, sizeof(*t->key));
+    t->type_id = calloc(slots, sizeof(*t->type_id));
+    t->flags = calloc(slots, sizeof(*t->flags));
+    t->power = calloc(slots, sizeof(*t->power));
+    t->bearing = calloc(slots, sizeof(*t->bearing));
+    t->var_bearing = calloc(slots, sizeof(*t->var_bearing));
+    t->bands = calloc(slots, sizeof(*t->bands));
+    t->channel = calloc(slots, sizeof(*t->channel));
+    t->mac = calloc(slots, sizeof(*t->mac));
+    t->start_ms = calloc(slots, sizeof(*t->start_ms));
+    t->last_seen_ms = calloc(slots, sizeof(*t->last_seen_ms));
+    t->updated_ms = calloc(slots, sizeof(*t->updated_ms));
+    if (!t->key || !t->type_id || !t->flags || !t->power || !t->bearing || !t->var_bearing || !t->bands ||
+        !t->channel || !t->mac || !t->start_ms || !t->last_seen_ms || !t->updated_ms) {
+        threat_table_free(t);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void threat_table_free(struct threat_table *t) {
+    free(t->key);
+    free(t->type_id);
+    free(t->flags);
+    free(t->power);
+    free(t->bearing);
+    free(t->var_bearing);
+    free(t->bands);
+    free(t->channel);
+    free(t->mac);
+    free(t->start_ms);
+    free(t->last_seen_ms);
+    free(t->updated_ms);
+    memset(t, 0, sizeof(*t));
+}
+
+void threat_table_on_removed(struct threat_table *t, threat_removed_cb_t cb, void *ctx) {
+    t->removed_cb = cb;
+    t->removed_ctx = ctx;
+}
+
+bool threat_table_apply(struct threat_table *t, uint32_t device, const Mdif__Rfs__RfsMsg *msg, uint64_t now_ms) {
+    bool full = false;
+    switch (msg->msg_case) {
+    case MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND:
+        rfs_threat(t, device, msg->rfs_threat_ind, now_ms, &full);
+        break;
+    case MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND:
+        wifi_threat(t, device, msg->wifi_threat_ind, now_ms, &full);
+        break;
+    case MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND: {
+        int i = msg->threat_stopped_ind->id ? find(t, KEY(device, msg->threat_stopped_ind->id)) : -1;
+        if (i >= 0) {
+            write_begin(t);
+            removed(t, i);
+            remove_slot(t, i);
+            write_end(t);
+        }
+        break;
+    }
+    case MDIF__RFS__RFS_MSG__MSG_MUTE_IND:
+        mute(t, device, msg->mute_ind);
+        break;
+    default:
+        break;
+    }
+    if (now_ms >= t->next_expire_ms) {
+        threat_table_expire(t, now_ms);
+    }
+    return !full;
+}
+
+void threat_table_expire(struct threat_table *t, uint64_t now_ms) {
+    // Checked a few times per timeout, so a threat lives at most 25% longer
+    t->next_expire_ms = now_ms + t->timeout_ms / 4 + 1;
+    bool writing = false;
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        // remove_slot() may move another threat into slot i
+        while (t->key[i] && EXPIRED(t, i, now_ms)) {
+            if (!writing) {
+                write_begin(t);
+                writing = true;
+            }
+            removed(t, i);
+            remove_slot(t, i);
+        }
+    }
+    if (writing) {
+        write_end(t);
+    }
+}
+
+void threat_table_remove_device(struct threat_table *t, uint32_t device) {
+    write_begin(t);
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        while (t->key[i] && KEY_DEVICE(t->key[i]) == device) {
+            removed(t, i);
+            remove_slot(t, i);
+        }
+    }
+    write_end(t);
+}
+
+bool threat_table_get(const struct threat_table *t, uint32_t device, uint32_t id, uint64_t now_ms,
+                      struct threat *out) {
+    if (id == 0) {
+        return false;
+    }
+    uint32_t seq;
+    int i;
+    do {
+        seq = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+        i = find(t, KEY(device, id));
+        if (i >= 0 && EXPIRED(t, i, now_ms)) {
+            i = -1;
+        }
+        if (i >= 0) {
+            copy_slot(t, i, out);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&t->seq, __ATOMIC_RELAXED) != seq);
+    return i >= 0;
+}
+
+uint32_t threat_table_snapshot(const struct threat_table *t, uint64_t now_ms, struct threat *out, uint32_t max) {
+    uint32_t seq;
+    uint32_t n;
+    do {
+        seq = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+        n = 0;
+        for (uint32_t i = 0; i <= t->mask && n < max; i++) {
+            if (t->key[i] && !EXPIRED(t, i, now_ms)) {
+                copy_slot(t, i, &out[n++]);
+            }
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&t->seq, __ATOMIC_RELAXED) != seq);
+    return n;
+}
+
+static void rfs_threat(struct threat_table *t, uint32_t device, const Mdif__Rfs__RfsThreatInd *ind, uint64_t now_ms, bool *full) {
+    if (ind->id == 0) {
+        return;
+    }
+    write_begin(t);
+    int i = insert(t, KEY(device, ind->id));
+    if (i < 0) {
+        *full = true;
+    } else {
+        const Mdif__Rfs__RfsThreatInd__RelativeBearing *rb = ind->relative_bearing;
+        uint32_t bands = 0;
+        for (size_t b = 0; b < ind->n_current_band; b++) {
+            if ((unsigned)ind->current_band[b] < 32) {
+                bands |= 1u << ind->current_band[b];
+            }
+        }
+        t->type_id[i] = ind->type_id;
+        t->flags[i] = (ind->muted ? THREAT_MUTED : 0) | (rb && rb->valid ? THREAT_BEARING_VALID : 0);
+        t->power[i] = ind->power;
+        t->bearing[i] = rb ? rb->bearing : 0;
+        t->var_bearing[i] = rb ? rb->var_bearing : 0;
+        t->bands[i] = bands;
+        t->channel[i] = 0;
+        memset(t->mac[i], 0, sizeof(t->mac[i]));
+        t->start_ms[i] = ts_ms(ind->start_ts);
+        t->last_seen_ms[i] = ts_ms(ind->last_seen_ts);
+        t->updated_ms[i] = now_ms;
+    }
+    write_end(t);
+}
+
+static void wifi_threat(struct threat_table *t, uint32_t device, const Mdif__Rfs__WifiThreatInd *ind, uint64_t now_ms, bool *full) {
+    if (ind->id == 0) {
+        return;
+    }
+    write_begin(t);
+    int i = insert(t, KEY(device, ind->id));
+    if (i < 0) {
+        *full = true;
+    } else {
+        t->type_id[i] = ind->type_id;
+        t->flags[i] = THREAT_WIFI | (ind->muted ? THREAT_MUTED : 0);
+        t->power[i] = ind->power;
+        t->bearing[i] = 0;
+        t->var_bearing[i] = 0;
+        t->bands[i] = 0;
+        t->channel[i] = ind->channel;
+        memset(t->mac[i], 0, sizeof(t->mac[i]));
+        if (ind->mac_adr.data) {
+            memcpy(t->mac[i], ind->mac_adr.data, ind->mac_adr.len < 6 ? ind->mac_adr.len : 6);
+        }
+        t->start_ms[i] = ts_ms(ind->start_ts);
+        // WifiThreatInd has no last_seen_ts, it is sent when seen
+        t->last_seen_ms[i] = 0;
+        t->updated_ms[i] = now_ms;
+    }
+    write_end(t);
+}
+
+static void mute(struct threat_table *t, uint32_t device, const Mdif__Rfs__MuteInd *ind) {
+    write_begin(t);
+    if (ind->id != 0) {
+        int i = find(t, KEY(device, ind->id));
+        if (i >= 0) {
+            t->flags[i] = ind->muted ? t->flags[i] | THREAT_MUTED : t->flags[i] & ~THREAT_MUTED;
+        }
+    } else {
+        // By type. Rare, so a scan is fine
+        for (uint32_t i = 0; i <= t->mask; i++) {
+            if (t->key[i] && KEY_DEVICE(t->key[i]) == device && t->type_id[i] == ind->type_id) {
+                t->flags[i] = ind->muted ? t->flags[i] | THREAT_MUTED : t->flags[i] & ~THREAT_MUTED;
+            }
+        }
+    }
+    write_end(t);
+}
+
+// The sequence number is odd while the table is written. Readers that saw
+// it odd, or changed, retry.
+static void write_begin(struct threat_table *t) {
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void write_end(struct threat_table *t) {
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELEASE);
+}
+
+// Fibonacci hashing, the high bits of key * 2^64 / phi
+static uint32_t home_slot(const struct threat_table *t, uint64_t key) {
+    return (uint32_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & t->mask;
+}
+
+// Slot of `key`, or -1. Readers may see a table being written, so the probe
+// is bounded by the number of slots.
+static int find(const struct threat_table *t, uint64_t key) {
+    uint32_t i = home_slot(t, key);
+    for (uint32_t n = 0; n <= t->mask; n++, i = (i + 1) & t->mask) {
+        uint64_t k = t->key[i];
+        if (k == key) {
+            return i;
+        }
+        if (k == 0) {
+            break;
+        }
+    }
+    return -1;
+}
+
+// Slot of `key`, added if not present. -1 if the table is full.
+static int insert(struct threat_table *t, uint64_t key) {
+    uint32_t i = home_slot(t, key);
+    while (t->key[i]) {
+        if (t->key[i] == key) {
+            return i;
+        }
+        i = (i + 1) & t->mask;
+    }
+    if (t->count == t->max_count) {
+        return -1;
+    }
+    t->key[i] = key;
+    t->count++;
+    return i;
+}
+
+// Free slot i, moving later threats of its probe sequence back, so no
+// tombstones are needed
+static void remove_slot(struct threat_table *t, uint32_t i) {
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & t->mask;
+        if (!t->key[j]) {
+            break;
+        }
+        // The threat in j may move to i if i is not before its home slot
+        uint32_t home = home_slot(t, t->key[j]);
+        if (((j - home) & t->mask) < ((j - i) & t->mask)) {
+            continue;
+        }
+        t->key[i] = t->key[j];
+        t->type_id[i] = t->type_id[j];
+        t->flags[i] = t->flags[j];
+        t->power[i] = t->power[j];
+        t->bearing[i] = t->bearing[j];
+        t->var_bearing[i] = t->var_bearing[j];
+        t->bands[i] = t->bands[j];
+        t->channel[i] = t->channel[j];
+        memcpy(t->mac[i], t->mac[j], sizeof(t->mac[i]));
+        t->start_ms[i] = t->start_ms[j];
+        t->last_seen_ms[i] = t->last_seen_ms[j];
+        t->updated_ms[i] = t->updated_ms[j];
+        i = j;
+    }
+    t->key[i] = 0;
+    t->count--;
+}
+
+// Report the threat in slot i, about to be removed
+static void removed(struct threat_table *t, uint32_t i) {
+    if (t->removed_cb) {
+        t->removed_cb(KEY_DEVICE(t->key[i]), KEY_ID(t->key[i]), t->removed_ctx);
+    }
+}
+
+static void copy_slot(const struct threat_table *t, uint32_t i, struct threat *out) {
+    uint64_t key = t->key[i];
+    out->device = KEY_DEVICE(key);
+    out->id = KEY_ID(key);
+    out->type_id = t->type_id[i];
+    out->flags = t->flags[i];
+    out->power = t->power[i];
+    out->bearing = t->bearing[i];
+    out->var_bearing = t->var_bearing[i];
+    out->bands = t->bands[i];
+    out->channel = t->channel[i];
+    memcpy(out->mac, t->mac[i], sizeof(out->mac));
+    out->start_ms = t->start_ms[i];
+    out->last_seen_ms = t->last_seen_ms[i];
+    out->updated_ms = t->updated_ms[i];
+}
+
+static int64_t ts_ms(const Google__Protobuf__Timestamp *ts) {
+    return ts ? ts->seconds * 1000 + ts->nanos / 1000000 : 0;
+}
@@ -0,0 +1,165 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : threat_table.h                                               *
+ *                                                                             *
+ * Description  : Table of the active threats of RF sensors, with lock-free    *
+ *              : snapshots.                                                   *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+#ifndef _THREAT_TABLE_H
+#define _THREAT_TABLE_H
+
+// Active threats of one or more RF sensors, built from RfsThreatInd,
+// WifiThreatInd, ThreatStoppedInd and MuteInd. Threats are keyed by the
+// device, a number chosen by the caller, and the id of the detection, which
+// is only unique per device.
+//
+// The table is an open addressing hash table with its fields in separate
+// arrays, so lookups only touch the keys. It is written by one thread, the
+// one receiving the indications, and read by any number of threads without
+// locks: readers copy what they need and retry if a write happened
+// meanwhile (seqlock). The writer never waits for readers.
+//
+// Threats are removed on ThreatStoppedInd, or when no indication was
+// received for the timeout. Readers leave out expired threats the writer has
+// not removed yet, so a threat disappears on time even when no indications
+// arrive.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "_generated/mdif/rfs/rfs.pb-c.h"
+
+// Flags of a threat
+#define THREAT_WIFI 0x01          // From WifiThreatInd, else RfsThreatInd
+#define THREAT_MUTED 0x02         // Muted on the device
+#define THREAT_BEARING_VALID 0x04 // bearing and var_bearing are valid
+
+// Called by the writer for each threat removed from the table, by
+// ThreatStoppedInd, expiry or threat_table_remove_device(). Called while the
+// table is written, so it must not read the table.
+typedef void (*threat_removed_cb_t)(uint32_t device, uint32_t id, void *ctx);
+
+// Copy of a threat
+struct threat {
+    uint32_t device;
+    uint32_t id;
+    uint32_t type_id;
+    uint8_t flags;
+    float power;
+    float bearing;
+    float var_bearing;
+    uint32_t bands;   // Bit (1 << ScanBand) for each current_band
+    uint32_t channel; // Wifi only
+    uint8_t mac[6];   // Wifi only
+    int64_t start_ms; // Device time, ms since the epoch. 0 if not reported
+    int64_t last_seen_ms;
+    uint64_t updated_ms; // Time of the latest indication, see threat_table_apply()
+};
+
+struct threat_table {
+    uint32_t seq; // Odd while written
+    uint32_t mask; // Number of slots - 1
+    uint32_t count;
+    uint32_t max_count;
+    uint32_t timeout_ms;
+    uint64_t next_expire_ms;
+    threat_removed_cb_t removed_cb;
+    void *removed_ctx;
+    // Fields of the slots. key is device << 32 | id, 0 if free (id 0 is
+    // invalid).
+    uint64_t *key;
+    uint32_t *type_id;
+    uint8_t *flags;
+    float *power;
+    float *bearing;
+    float *var_bearing;
+    uint32_t *bands;
+    uint32_t *channel;
+    uint8_t (*mac)[6];
+    int64_t *start_ms;
+    int64_t *last_seen_ms;
+    uint64_t *updated_ms;
+};
+
+// Allocate a table for `max_threats` threats. A threat is removed when no
+// indication of it was received for `timeout_ms`. Returns -1 with errno set
+// on failure.
+int threat_table_init(struct threat_table *t, uint32_t max_threats, uint32_t timeout_ms);
+
+// Free the table. No readers may be using it.
+void threat_table_free(struct threat_table *t);
+
+// Call `cb` with `ctx` for each threat removed from now on, e.g.
+// threat_queue_removed(). Writer only.
+void threat_table_on_removed(struct threat_table *t, threat_removed_cb_t cb, void *ctx);
+
+// Apply an indication of `device`, received at `now_ms` (CLOCK_MONOTONIC).
+// Other messages are ignored. Returns false if the threat was not added,
+// because the table is full. Writer only.
+bool threat_table_apply(struct threat_table *t, uint32_t device, const Mdif__Rfs__RfsMsg *msg, uint64_t now_ms);
+
+// Remove the threats not updated for the timeout. threat_table_apply() does
+// it as indications arrive; call it when they might not, e.g. from a timer, to
+// free their slots. Writer only.
+void threat_table_expire(struct threat_table *t, uint64_t now_ms);
+
+// Remove all threats of `device`, e.g. when it disconnects. Writer only.
+void threat_table_remove_device(struct threat_table *t, uint32_t device);
+
+// Copy threat (`device`, `id`). Returns false if it is not active at `now_ms`
+// (CLOCK_MONOTONIC). From any thread.
+bool threat_table_get(const struct threat_table *t, uint32_t device, uint32_t id, uint64_t now_ms,
+                      struct threat *out);
+
+// Copy up to `max` threats active at `now_ms` to `out`, as they were at one
+// point in time. Returns the number copied. From any thread.
+uint32_t threat_table_snapshot(const struct threat_table *t, uint64_t now_ms, struct threat *out, uint32_t max);
+
+#endif // _THREAT_TABLE_H
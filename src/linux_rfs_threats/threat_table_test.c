@@ -0,0 +1,384 @@
+/*******************************************************************************
+ *                                                                             *
+ *                                                 ,,                          *
+ *                                                       ,,,,,                 *
+ *                                                           ,,,,,             *
+ *           ,,,,,,,,,,,,,,,,,,,,,,,,,,,,                        ,,,,          *
+ *          ,,,,,,,,,,,,,,,,,,,,,,,,,,,,,            ,,,,          ,,,,        *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,,,,        ,,,       *
+ *          ,,,,,       ,,,,,      ,,,,,,                   ,,,        ,,,     *
+ *          ,,,,,       ,,,,,      ,,,,,,       ,,,           ,,,        ,     *
+ *          ,,,,,       ,,,,,      ,,,,,,           ,,,         ,,        ,    *
+ *          ,,,,,       ,,,,,      ,,,,,,              ,,        ,,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                ,        ,            *
+ *          ,,,,,       ,,,,,      ,,,,,,                 ,                    *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *          ,,,,,       ,,,,,      ,,,,,,                                      *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *                                       ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *                                       ,,,,,                  ,,,,,,         *
+ *                     ,                 ,,,,,                  ,,,,,,         *
+ *             ,        ,,               ,,,,,                  ,,,,,,         *
+ *    ,        ,,        ,,,             ,,,,,                  ,,,,,,         *
+ *     ,        ,,,         ,,,          ,,,,,                  ,,,,,,         *
+ *     ,,,       ,,,                     ,,,,,                  ,,,,,,         *
+ *      ,,,        ,,,,                  ,,,,,                  ,,,,,,         *
+ *        ,,,         ,,,,               ,,,,,                  ,,,,,,         *
+ *         ,,,,,            ,,,,         ,,,,,,,,,,,,,,,,,,,,,,,,,,,,          *
+ *            ,,,,                       ,,,,,,,,,,,,,,,,,,,,,,,,,,            *
+ *               ,,,,,                                                         *
+ *                    ,,,,,                                                    *
+ *                                                                             *
+ * Program/file : threat_table_test.c                                          *
+ *                                                                             *
+ * Description  : Stress test of the threat table against a reference model.   *
+ *              :                                                              *
+ *                                                                             *
+ * Copyright 2026 MyDefence A/S.                                               *
+ *                                                                             *
+ * Licensed under the Apache License, Version 2.0 (the "License");             *
+ * you may not use this file except in compliance with the License.            *
+ * You may obtain a copy of the License at                                     *
+ *                                                                             *
+ * http://www.apache.org/licenses/LICENSE-2.0                                  *
+ *                                                                             *
+ * Unless required by applicable law or agreed to in writing, software         *
+ * distributed under the License is distributed on an "AS IS" BASIS,           *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.    *
+ * See the License for the specific language governing permissions and         *
+ * limitations under the License.                                              *
+ *                                                                             *
+ *                                                                             *
+ *                                                                             *
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                Include files
+ *******************************************************************************/
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threat_table.h"
+#include "test/mdif_test.h"
+
+/*******************************************************************************
+ *                               Macro definitions
+ *******************************************************************************/
+#define STEPS 200000
+#define MAX_THREATS 64
+#define TIMEOUT_MS 1000
+// Keys used, more than MAX_THREATS so the table fills up
+#define DEVICES 3
+#define IDS 40
+#define TYPES 8
+
+/*******************************************************************************
+ *                             Local variables/const
+ *******************************************************************************/
+static struct threat_table table;
+
+// Reference model: the threats in the table, and when it expires them
+static struct threat model[MAX_THREATS];
+static uint32_t n_model;
+static uint64_t model_next_expire;
+
+// Time of the writer, for the reader thread
+static uint64_t now_ms;
+static int done;
+static unsigned long reader_snapshots;
+static unsigned long reader_errors;
+
+// Removals reported by the table, and done to the model
+static unsigned long table_removed;
+static unsigned long model_removed;
+
+/*******************************************************************************
+ *                                 Implementation
+ *******************************************************************************/
+
+static int model_find(uint32_t device, uint32_t id) {
+    for (uint32_t i = 0; i < n_model; i++) {
+        if (model[i].device == device && model[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void model_remove(uint32_t i) {
+    model[i] = model[--n_model];
+    model_removed++;
+}
+
+static void on_removed(uint32_t device, uint32_t id, void *ctx) {
+    table_removed++;
+}
+
+static void model_expire(uint64_t now) {
+    model_next_expire = now + TIMEOUT_MS / 4 + 1;
+    for (uint32_t i = 0; i < n_model;) {
+        if (now > model[i].updated_ms + TIMEOUT_MS) {
+            model_remove(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+// Add or replace threat. Returns false if the model is full.
+static bool model_set(const struct threat *t) {
+    int i = model_find(t->device, t->id);
+    if (i < 0) {
+        if (n_model == MAX_THREATS) {
+            return false;
+        }
+        i = n_model++;
+    }
+    model[i] = *t;
+    return true;
+}
+
+static void model_mute(uint32_t device, uint32_t id, uint32_t type_id, bool muted) {
+    for (uint32_t i = 0; i < n_model; i++) {
+        if (model[i].device == device && (id ? model[i].id == id : model[i].type_id == type_id)) {
+            model[i].flags = muted ? model[i].flags | THREAT_MUTED : model[i].flags & ~THREAT_MUTED;
+        }
+    }
+}
+
+// Values a reader can check without knowing the writer's state
+static bool consistent(const struct threat *t) {
+    if (t->power != (float)t->type_id + 0.25f) {
+        return false;
+    }
+    return t->flags & THREAT_WIFI ? t->channel == t->id : t->var_bearing == (float)t->device;
+}
+
+static bool equal(const struct threat *a, const struct threat *b) {
+    return a->device == b->device && a->id == b->id && a->type_id == b->type_id && a->flags == b->flags &&
+           a->power == b->power && a->bearing == b->bearing && a->var_bearing == b->var_bearing &&
+           a->bands == b->bands && a->channel == b->channel && memcmp(a->mac, b->mac, sizeof(a->mac)) == 0 &&
+           a->start_ms == b->start_ms && a->last_seen_ms == b->last_seen_ms && a->updated_ms == b->updated_ms;
+}
+
+static int cmp_threat(const void *pa, const void *pb) {
+    const struct threat *a = pa;
+    const struct threat *b = pb;
+    uint64_t ka = (uint64_t)a->device << 32 | a->id;
+    uint64_t kb = (uint64_t)b->device << 32 | b->id;
+    return ka < kb ? -1 : ka > kb;
+}
+
+// Compare the table as readers see it at `now` with the model
+static bool compare(uint64_t now) {
+    static struct threat got[MAX_THREATS];
+    static struct threat want[MAX_THREATS];
+    uint32_t n_got = threat_table_snapshot(&table, now, got, MAX_THREATS);
+    uint32_t n_want = 0;
+    for (uint32_t i = 0; i < n_model; i++) {
+        if (now <= model[i].updated_ms + TIMEOUT_MS) {
+            want[n_want++] = model[i];
+        }
+    }
+    if (n_got != n_want || table.count != n_model) {
+        return false;
+    }
+    qsort(got, n_got, sizeof(got[0]), cmp_threat);
+    qsort(want, n_want, sizeof(want[0]), cmp_threat);
+    for (uint32_t i = 0; i < n_got; i++) {
+        struct threat t;
+        if (!equal(&got[i], &want[i]) || !threat_table_get(&table, want[i].device, want[i].id, now, &t) ||
+            !equal(&t, &want[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check snapshots taken while the writer runs
+static void *reader(void *arg) {
+    static struct threat list[MAX_THREATS];
+    while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+        uint32_t n = threat_table_snapshot(&table, __atomic_load_n(&now_ms, __ATOMIC_RELAXED), list, MAX_THREATS);
+        qsort(list, n, sizeof(list[0]), cmp_threat);
+        for (uint32_t i = 0; i < n; i++) {
+            if (!consistent(&list[i]) || (i > 0 && cmp_threat(&list[i - 1], &list[i]) == 0)) {
+                reader_errors++;
+            }
+        }
+        reader_snapshots++;
+    }
+    return NULL;
+}
+
+// Apply a random indication to table and model. Returns false if they
+// disagree on whether the table is full.
+static bool step(uint64_t now) {
+    uint32_t device = rand() % DEVICES;
+    // Id 0 is invalid, and ignored
+    uint32_t id = rand() % (IDS + 1);
+    uint32_t type_id = rand() % TYPES;
+    bool muted = rand() % 2;
+    Google__Protobuf__Timestamp start_ts = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+    Google__Protobuf__Timestamp last_seen_ts = GOOGLE__PROTOBUF__TIMESTAMP__INIT;
+    start_ts.seconds = 1700000000 + rand() % 1000;
+    start_ts.nanos = rand() % 1000000000;
+    last_seen_ts.seconds = start_ts.seconds + rand() % 100;
+    last_seen_ts.nanos = rand() % 1000000000;
+
+    struct threat want = {
+        .device = device,
+        .id = id,
+        .type_id = type_id,
+        .power = (float)type_id + 0.25f,
+        .start_ms = start_ts.seconds * 1000 + start_ts.nanos / 1000000,
+        .updated_ms = now,
+    };
+    Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+    Mdif__Rfs__RfsThreatInd rfs = MDIF__RFS__RFS_THREAT_IND__INIT;
+    Mdif__Rfs__RfsThreatInd__RelativeBearing rb = MDIF__RFS__RFS_THREAT_IND__RELATIVE_BEARING__INIT;
+    Mdif__Rfs__ScanBand bands[2] = {rand() % 7, rand() % 7};
+    Mdif__Rfs__WifiThreatInd wifi = MDIF__RFS__WIFI_THREAT_IND__INIT;
+    uint8_t mac[6];
+    Mdif__Rfs__ThreatStoppedInd stopped = MDIF__RFS__THREAT_STOPPED_IND__INIT;
+    Mdif__Rfs__MuteInd mute = MDIF__RFS__MUTE_IND__INIT;
+    bool full = false;
+
+    int op = rand() % 100;
+    if (op < 40) {
+        rfs.id = id;
+        rfs.type_id = type_id;
+        rfs.muted = muted;
+        rfs.power = want.power;
+        rfs.n_current_band = 2;
+        rfs.current_band = bands;
+        rfs.start_ts = &start_ts;
+        rfs.last_seen_ts = &last_seen_ts;
+        rb.valid = rand() % 2;
+        rb.bearing = rand() % 360;
+        rb.var_bearing = device;
+        rfs.relative_bearing = &rb;
+        msg.msg_case = MDIF__RFS__RFS_MSG__MSG_RFS_THREAT_IND;
+        msg.rfs_threat_ind = &rfs;
+        want.flags = (muted ? THREAT_MUTED : 0) | (rb.valid ? THREAT_BEARING_VALID : 0);
+        want.bearing = rb.bearing;
+        want.var_bearing = rb.var_bearing;
+        want.bands = 1u << bands[0] | 1u << bands[1];
+        want.last_seen_ms = last_seen_ts.seconds * 1000 + last_seen_ts.nanos / 1000000;
+        full = id && !model_set(&want);
+    } else if (op < 60) {
+        for (int i = 0; i < 6; i++) {
+            mac[i] = rand();
+        }
+        wifi.id = id;
+        wifi.type_id = type_id;
+        wifi.muted = muted;
+        wifi.power = want.power;
+        wifi.channel = id;
+        wifi.mac_adr.len = sizeof(mac);
+        wifi.mac_adr.data = mac;
+        wifi.start_ts = &start_ts;
+        msg.msg_case = MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND;
+        msg.wifi_threat_ind = &wifi;
+        want.flags = THREAT_WIFI | (muted ? THREAT_MUTED : 0);
+        want.channel = id;
+        memcpy(want.mac, mac, sizeof(mac));
+        full = id && !model_set(&want);
+    } else if (op < 75) {
+        stopped.id = id;
+        msg.msg_case = MDIF__RFS__RFS_MSG__MSG_THREAT_STOPPED_IND;
+        msg.threat_stopped_ind = &stopped;
+        int i = id ? model_find(device, id) : -1;
+        if (i >= 0) {
+            model_remove(i);
+        }
+    } else if (op < 95) {
+        // Mostly by id, sometimes by type
+        mute.id = op < 90 ? id : 0;
+        mute.type_id = type_id;
+        mute.muted = muted;
+        msg.msg_case = MDIF__RFS__RFS_MSG__MSG_MUTE_IND;
+        msg.mute_ind = &mute;
+        model_mute(device, mute.id, type_id, muted);
+    } else {
+        // Not a threat indication
+        msg.msg_case = MDIF__RFS__RFS_MSG__MSG_START_RES;
+    }
+    if (now >= model_next_expire) {
+        model_expire(now);
+    }
+    return threat_table_apply(&table, device, &msg, now) == !full;
+}
+
+int main(void) {
+    int fails = 0;
+    srand(1);
+    threat_table_init(&table, MAX_THREATS, TIMEOUT_MS);
+    threat_table_on_removed(&table, on_removed, NULL);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, reader, NULL);
+
+    uint64_t now = 1000000;
+    unsigned long bad_full = 0;
+    unsigned long bad_compare = 0;
+    unsigned long fulls = 0;
+    for (int s = 0; s < STEPS; s++) {
+        // Mostly a steady stream, sometimes a pause longer than the timeout
+        now += rand() % 100 == 0 ? rand() % (2 * TIMEOUT_MS) : rand() % 4;
+        __atomic_store_n(&now_ms, now, __ATOMIC_RELAXED);
+        int r = rand() % 100;
+        if (r < 2) {
+            uint32_t device = rand() % DEVICES;
+            threat_table_remove_device(&table, device);
+            for (uint32_t i = 0; i < n_model;) {
+                if (model[i].device == device) {
+                    model_remove(i);
+                } else {
+                    i++;
+                }
+            }
+        } else if (r < 4) {
+            threat_table_expire(&table, now);
+            model_expire(now);
+        } else {
+            bad_full += !step(now);
+            fulls += n_model == MAX_THREATS;
+        }
+        // Readers see expiry before the writer removes the threats
+        uint64_t read_at = now + rand() % (TIMEOUT_MS / 2);
+        bad_compare += !compare(read_at);
+    }
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+
+    printf("%d steps, table full in %lu, %lu concurrent snapshots\n", STEPS, fulls, reader_snapshots);
+    CHECK("table full when model is", bad_full == 0);
+    CHECK("table equals model", bad_compare == 0);
+    CHECK("table was filled", fulls > 0);
+    CHECK("concurrent snapshots consistent", reader_errors == 0);
+    CHECK("every removal reported", table_removed == model_removed);
+
+    // Without indications, readers stop seeing threats after the timeout
+    threat_table_remove_device(&table, 0);
+    threat_table_remove_device(&table, 1);
+    threat_table_remove_device(&table, 2);
+    n_model = 0;
+    now += 2 * TIMEOUT_MS;
+    Mdif__Rfs__WifiThreatInd wifi = MDIF__RFS__WIFI_THREAT_IND__INIT;
+    Mdif__Rfs__RfsMsg msg = MDIF__RFS__RFS_MSG__INIT;
+    wifi.id = 7;
+    msg.msg_case = MDIF__RFS__RFS_MSG__MSG_WIFI_THREAT_IND;
+    msg.wifi_threat_ind = &wifi;
+    threat_table_apply(&table, 0, &msg, now);
+    struct threat t;
+    CHECK("read: active before timeout", threat_table_get(&table, 0, 7, now + TIMEOUT_MS, &t));
+    CHECK("read: expired after timeout", !threat_table_get(&table, 0, 7, now + TIMEOUT_MS + 1, &t) &&
+                                             threat_table_snapshot(&table, now + TIMEOUT_MS + 1, &t, 1) == 0);
+    CHECK("read: not removed by readers", table.count == 1);
+
+    threat_table_free(&table);
+    return fails ? 1 : 0;
+}
@@ -67,12 +67,17 @@ do
 
                 local tag = get_tag(data_len, tvb(offset + 4, data_len):bytes())
 
-                if tag < 0x20 then
+                -- Same field number ranges as linux_core_codec/mdif_router.c
+                if tag < 0x20 or (tag >= 0x100 and tag < 0x200) then
                     msgtype = "mdif.core.CoreMsg"
                 elseif tag < 0x30 then
                     msgtype = "mdif.fwu.FwuMsg"
                 elseif tag < 0x50 then
                     msgtype = "mdif.core_dev.CoreDevMsg"
+                elseif tag >= 0x80 and tag < 0xA0 then
+                    msgtype = "mdif.rfs.RfsMsg"
+                elseif tag >= 0xC0 and tag < 0xE0 then
+                    msgtype = "mdif.rfe.RfeMsg"
                 end
                 if msgtype ~= nil then
                     pinfo.private["pb_msg_type"] = "message," .. msgtype